@@ -0,0 +1,895 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/* NOTE: Respecting header order is important for portability.
+ * Always put system first, then EFL, then your public header,
+ * and finally your private one. */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include <clang-c/Index.h>
+#include <clang-c/Documentation.h>
+
+#include <Ecore_Getopt.h>
+
+#include "edi_clang_protocol.h"
+
+#include "edi_private.h"
+
+#define COPYRIGHT "Copyright © 2014-2017 Andy Williams <andy@andyilliams.me> and various contributors (see AUTHORS)."
+
+int _edi_log_dom = -1;
+
+/* A file parsed for edi, identified by the id edi gave it */
+typedef struct _Edi_Clang_Unit
+{
+   unsigned int id;
+   char *path;
+   char **args;
+   unsigned int argc;
+   CXTranslationUnit unit;
+   /* The length of the file as it was last parsed */
+   unsigned long length;
+
+   /* The tokens of the file, lexed when it is first highlighted after a parse */
+   CXToken *tokens;
+   CXCursor *cursors;
+   unsigned int token_count;
+} Edi_Clang_Unit;
+
+typedef struct _Edi_Clang_Document
+{
+   Eina_Strbuf *title;
+   Eina_Strbuf *detail;
+   Eina_Strbuf *param;
+   Eina_Strbuf *ret;
+   Eina_Strbuf *see;
+} Edi_Clang_Document;
+
+static CXIndex _edi_clang_index = NULL;
+static Eina_Hash *_edi_clang_units = NULL;
+
+static const Ecore_Getopt optdesc = {
+  "edi_clang",
+  "%prog [options]",
+  PACKAGE_VERSION,
+  COPYRIGHT,
+  "BSD with advertisement clause",
+  "Parses C files for the EFL IDE, talking to edi over its standard input and output",
+  EINA_TRUE,
+  {
+    ECORE_GETOPT_STORE_UINT('m', "memory-limit", "the most memory in megabytes this process may use"),
+    ECORE_GETOPT_LICENSE('L', "license"),
+    ECORE_GETOPT_COPYRIGHT('C', "copyright"),
+    ECORE_GETOPT_VERSION('V', "version"),
+    ECORE_GETOPT_HELP('h', "help"),
+    ECORE_GETOPT_SENTINEL
+  }
+};
+
+static void
+_edi_clang_tokens_free(Edi_Clang_Unit *unit)
+{
+   if (unit->tokens)
+     clang_disposeTokens(unit->unit, unit->tokens, unit->token_count);
+   free(unit->cursors);
+
+   unit->tokens = NULL;
+   unit->cursors = NULL;
+   unit->token_count = 0;
+}
+
+static void
+_edi_clang_unit_args_free(Edi_Clang_Unit *unit)
+{
+   unsigned int i;
+
+   for (i = 0; i < unit->argc; i++)
+     free(unit->args[i]);
+   free(unit->args);
+
+   unit->args = NULL;
+   unit->argc = 0;
+}
+
+static void
+_edi_clang_unit_free_cb(void *data)
+{
+   Edi_Clang_Unit *unit = data;
+
+   _edi_clang_tokens_free(unit);
+   if (unit->unit)
+     clang_disposeTranslationUnit(unit->unit);
+   _edi_clang_unit_args_free(unit);
+   free(unit->path);
+   free(unit);
+}
+
+static unsigned long
+_edi_clang_unit_size_get(CXTranslationUnit unit)
+{
+   CXTUResourceUsage usage;
+   unsigned long size = 0;
+   unsigned int i;
+
+   usage = clang_getCXTUResourceUsage(unit);
+   for (i = 0; i < usage.numEntries; i++)
+     size += usage.entries[i].amount;
+   clang_disposeCXTUResourceUsage(usage);
+
+   return size;
+}
+
+static void
+_edi_clang_includes_cb(CXFile included_file, CXSourceLocation *inclusion_stack EINA_UNUSED,
+                       unsigned include_len, CXClientData data)
+{
+   Eina_Hash *includes = data;
+   CXString name;
+   const char *filename;
+   char path[PATH_MAX];
+   long long *mtime;
+
+   // The file itself is visited first, with nothing including it
+   if (!include_len)
+     return;
+
+   name = clang_getFileName(included_file);
+   filename = clang_getCString(name);
+   if (filename && realpath(filename, path) && !eina_hash_find(includes, path))
+     {
+        // The time of the file as it was read, so a save during the parse shows as newer
+        mtime = malloc(sizeof(long long));
+        *mtime = clang_getFileTime(included_file);
+        eina_hash_add(includes, path, mtime);
+     }
+
+   clang_disposeString(name);
+}
+
+/* The real paths of the files the unit includes, so edi knows which saves affect it */
+static void
+_edi_clang_includes_append(Edi_Clang_Unit *unit, Eina_Binbuf *reply)
+{
+   Eina_Hash *includes;
+   Eina_Iterator *it;
+   Eina_Hash_Tuple *tuple;
+
+   includes = eina_hash_string_superfast_new(free);
+   clang_getInclusions(unit->unit, _edi_clang_includes_cb, includes);
+
+   edi_clang_message_uint_append(reply, eina_hash_population(includes));
+   it = eina_hash_iterator_tuple_new(includes);
+   EINA_ITERATOR_FOREACH(it, tuple)
+     {
+        edi_clang_message_string_append(reply, tuple->key);
+        edi_clang_message_data_append(reply, tuple->data, sizeof(long long));
+     }
+   eina_iterator_free(it);
+
+   eina_hash_free(includes);
+}
+
+static Eina_Bool
+_edi_clang_unit_args_read(Edi_Clang_Unit *unit, Edi_Clang_Message_Reader *reader)
+{
+   char **args;
+   unsigned int argc, i;
+   Eina_Bool changed;
+
+   if (!edi_clang_message_uint_get(reader, &argc) || argc > 65536)
+     return EINA_FALSE;
+
+   args = calloc(argc + 1, sizeof(char *));
+   for (i = 0; i < argc; i++)
+     {
+        args[i] = edi_clang_message_string_get(reader);
+        if (!args[i])
+          break;
+     }
+
+   changed = (argc != unit->argc);
+   for (i = 0; i < argc && !changed; i++)
+     changed = !args[i] || strcmp(args[i], unit->args[i]);
+
+   if (!changed)
+     {
+        for (i = 0; i < argc; i++)
+          free(args[i]);
+        free(args);
+        return EINA_TRUE;
+     }
+
+   // Another set of flags needs a new unit rather than a reparse
+   _edi_clang_tokens_free(unit);
+   if (unit->unit)
+     clang_disposeTranslationUnit(unit->unit);
+   unit->unit = NULL;
+   _edi_clang_unit_args_free(unit);
+
+   unit->args = args;
+   unit->argc = argc;
+   for (i = 0; i < argc; i++)
+     {
+        if (!args[i])
+          return EINA_FALSE;
+     }
+
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edi_clang_parse(unsigned int id, Edi_Clang_Message_Reader *reader, Eina_Binbuf *reply)
+{
+   Edi_Clang_Unit *unit;
+   struct CXUnsavedFile unsaved_file;
+   struct stat st;
+   const char *contents = NULL;
+   char *path;
+   unsigned int has_contents, length = 0, count;
+   int ret;
+
+   path = edi_clang_message_string_get(reader);
+   if (!path)
+     return EINA_FALSE;
+
+   unit = eina_hash_find(_edi_clang_units, &id);
+   if (!unit)
+     {
+        unit = calloc(1, sizeof(Edi_Clang_Unit));
+        unit->id = id;
+        unit->path = path;
+        eina_hash_add(_edi_clang_units, &id, unit);
+     }
+   else
+     free(path);
+
+   if (!_edi_clang_unit_args_read(unit, reader) ||
+       !edi_clang_message_uint_get(reader, &has_contents) ||
+       (has_contents && !edi_clang_message_data_get(reader, &contents, &length)))
+     return EINA_FALSE;
+
+   _edi_clang_tokens_free(unit);
+   count = has_contents ? 1 : 0;
+   unsaved_file.Filename = unit->path;
+   unsaved_file.Contents = contents;
+   unsaved_file.Length = length;
+
+   if (unit->unit)
+     {
+        ret = clang_reparseTranslationUnit(unit->unit, count, &unsaved_file,
+                                           clang_defaultReparseOptions(unit->unit));
+        if (ret)
+          {
+             // A failed reparse leaves the unit unusable, start again
+             WRN("Could not reparse %s (%d)", unit->path, ret);
+             clang_disposeTranslationUnit(unit->unit);
+             unit->unit = NULL;
+          }
+     }
+
+   // Keep the parsed headers so a reparse only needs to look at the file itself
+   if (!unit->unit)
+     unit->unit = clang_parseTranslationUnit(_edi_clang_index, unit->path,
+                                  (const char * const *) unit->args, unit->argc, &unsaved_file, count,
+                                  clang_defaultEditingTranslationUnitOptions() | CXTranslationUnit_PrecompiledPreamble |
+                                  CXTranslationUnit_DetailedPreprocessingRecord | CXTranslationUnit_KeepGoing);
+   if (!unit->unit)
+     {
+        ERR("Could not parse %s", unit->path);
+        return EINA_FALSE;
+     }
+
+   if (has_contents)
+     unit->length = length;
+   else
+     unit->length = stat(unit->path, &st) ? 0 : st.st_size;
+
+   edi_clang_message_uint_append(reply, EINA_TRUE);
+   edi_clang_message_uint_append(reply, _edi_clang_unit_size_get(unit->unit) / 1024);
+   _edi_clang_includes_append(unit, reply);
+
+   return EINA_TRUE;
+}
+
+static void
+_edi_clang_tokens_load(Edi_Clang_Unit *unit)
+{
+   CXFile cfile;
+   CXSourceRange range;
+
+   if (unit->tokens)
+     return;
+
+   cfile = clang_getFile(unit->unit, unit->path);
+   range = clang_getRange(clang_getLocationForOffset(unit->unit, cfile, 0),
+                          clang_getLocationForOffset(unit->unit, cfile, unit->length));
+
+   // Lexing is cheap, the tokens are annotated a range of lines at a time when shown
+   clang_tokenize(unit->unit, range, &unit->tokens, &unit->token_count);
+   unit->cursors = calloc(unit->token_count + 1, sizeof(CXCursor));
+}
+
+/* The first token that starts on or after a line. */
+static unsigned int
+_edi_clang_token_for_line_get(Edi_Clang_Unit *unit, unsigned int line)
+{
+   CXSourceRange tkrange;
+   unsigned int low = 0, high = unit->token_count, mid, number;
+
+   while (low < high)
+     {
+        mid = low + (high - low) / 2;
+        tkrange = clang_getTokenExtent(unit->unit, unit->tokens[mid]);
+        clang_getSpellingLocation(clang_getRangeStart(tkrange), NULL, &number, NULL, NULL);
+
+        if (number < line)
+          low = mid + 1;
+        else
+          high = mid;
+     }
+
+   return low;
+}
+
+static unsigned int
+_edi_clang_highlight_kind_get(CXToken token, CXCursor cursor)
+{
+   /* FIXME: Should probably do something fancier, this is only a limited
+    * number of types. */
+   if (clang_getTokenKind(token) != CXToken_Identifier)
+     return 0;
+
+   if (cursor.kind < CXCursor_FirstRef)
+     return EDI_CLANG_HIGHLIGHT_CLASS;
+
+   switch (cursor.kind)
+     {
+      case CXCursor_DeclRefExpr:
+         /* Handle different ref kinds */
+         return EDI_CLANG_HIGHLIGHT_FUNCTION;
+      case CXCursor_MacroDefinition:
+      case CXCursor_InclusionDirective:
+      case CXCursor_PreprocessingDirective:
+      case CXCursor_MacroExpansion:
+         return EDI_CLANG_HIGHLIGHT_PREPROCESSOR;
+      case CXCursor_TypeRef:
+         return EDI_CLANG_HIGHLIGHT_TYPE;
+      default:
+         return 0;
+     }
+}
+
+static Eina_Bool
+_edi_clang_highlight(Edi_Clang_Unit *unit, Edi_Clang_Message_Reader *reader, Eina_Binbuf *reply)
+{
+   CXSourceRange tkrange;
+   Eina_Binbuf *ranges;
+   unsigned int first_line, last_line, first, last, i, count = 0, kind;
+   unsigned int start_line, start_col, end_line, end_col;
+
+   if (!edi_clang_message_uint_get(reader, &first_line) ||
+       !edi_clang_message_uint_get(reader, &last_line))
+     return EINA_FALSE;
+
+   _edi_clang_tokens_load(unit);
+   first = _edi_clang_token_for_line_get(unit, first_line);
+   last = _edi_clang_token_for_line_get(unit, last_line + 1);
+   if (last > first)
+     clang_annotateTokens(unit->unit, unit->tokens + first, last - first, unit->cursors + first);
+
+   ranges = eina_binbuf_new();
+   for (i = first; i < last; i++)
+     {
+        kind = _edi_clang_highlight_kind_get(unit->tokens[i], unit->cursors[i]);
+        if (!kind)
+          continue;
+
+        tkrange = clang_getTokenExtent(unit->unit, unit->tokens[i]);
+        clang_getSpellingLocation(clang_getRangeStart(tkrange), NULL, &start_line, &start_col, NULL);
+        clang_getSpellingLocation(clang_getRangeEnd(tkrange), NULL, &end_line, &end_col, NULL);
+
+        edi_clang_message_uint_append(ranges, start_line);
+        edi_clang_message_uint_append(ranges, start_col);
+        edi_clang_message_uint_append(ranges, end_line);
+        edi_clang_message_uint_append(ranges, end_col);
+        edi_clang_message_uint_append(ranges, kind);
+        count++;
+     }
+
+   edi_clang_message_uint_append(reply, EINA_TRUE);
+   edi_clang_message_uint_append(reply, count);
+   eina_binbuf_append_buffer(reply, ranges);
+   eina_binbuf_free(ranges);
+
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edi_clang_diagnostics(Edi_Clang_Unit *unit, Eina_Binbuf *reply)
+{
+   CXDiagnostic diag;
+   CXFile file;
+   CXString path, str;
+   Eina_Binbuf *diagnostics;
+   unsigned int i, n, line, count = 0;
+
+   diagnostics = eina_binbuf_new();
+   for (i = 0, n = clang_getNumDiagnostics(unit->unit); i != n; ++i)
+     {
+        diag = clang_getDiagnostic(unit->unit, i);
+
+        // the parameter after line would be a caret position but we're just highlighting for now
+        clang_getSpellingLocation(clang_getDiagnosticLocation(diag), &file, &line, NULL, NULL);
+
+        path = clang_getFileName(file);
+        if (clang_getCString(path) && !strcmp(unit->path, clang_getCString(path)))
+          {
+             /* FIXME: Also handle ranges and fix suggestions. */
+             str = clang_getDiagnosticSpelling(diag);
+             edi_clang_message_uint_append(diagnostics, line);
+             edi_clang_message_uint_append(diagnostics, clang_getDiagnosticSeverity(diag));
+             edi_clang_message_string_append(diagnostics, clang_getCString(str));
+             clang_disposeString(str);
+             count++;
+          }
+
+        clang_disposeString(path);
+        clang_disposeDiagnostic(diag);
+     }
+
+   edi_clang_message_uint_append(reply, EINA_TRUE);
+   edi_clang_message_uint_append(reply, count);
+   eina_binbuf_append_buffer(reply, diagnostics);
+   eina_binbuf_free(diagnostics);
+
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edi_clang_complete(Edi_Clang_Unit *unit, Edi_Clang_Message_Reader *reader, Eina_Binbuf *reply)
+{
+   CXCodeCompleteResults *res;
+   struct CXUnsavedFile unsaved_file;
+   const char *contents;
+   unsigned int row, col, length, i, j;
+
+   if (!edi_clang_message_uint_get(reader, &row) ||
+       !edi_clang_message_uint_get(reader, &col) ||
+       !edi_clang_message_data_get(reader, &contents, &length))
+     return EINA_FALSE;
+
+   unsaved_file.Filename = unit->path;
+   unsaved_file.Contents = contents;
+   unsaved_file.Length = length;
+
+   res = clang_codeCompleteAt(unit->unit, unit->path, row, col, &unsaved_file, 1,
+                              CXCodeComplete_IncludeMacros |
+                              CXCodeComplete_IncludeCodePatterns);
+   if (!res)
+     return EINA_FALSE;
+
+   clang_sortCodeCompletionResults(res->Results, res->NumResults);
+
+   edi_clang_message_uint_append(reply, EINA_TRUE);
+   edi_clang_message_uint_append(reply, res->NumResults);
+   for (i = 0; i < res->NumResults; i++)
+     {
+        const CXCompletionString str = res->Results[i].CompletionString;
+        const char *name = NULL, *ret = NULL;
+        Eina_Strbuf *param;
+
+        param = eina_strbuf_new();
+        for (j = 0; j < clang_getNumCompletionChunks(str); j++)
+          {
+             const CXString str_out = clang_getCompletionChunkText(str, j);
+
+             switch (clang_getCompletionChunkKind(str, j))
+               {
+                case CXCompletionChunk_ResultType:
+                   ret = clang_getCString(str_out);
+                   break;
+                case CXCompletionChunk_TypedText:
+                case CXCompletionChunk_Text:
+                   name = clang_getCString(str_out);
+                   break;
+                case CXCompletionChunk_LeftParen:
+                case CXCompletionChunk_Placeholder:
+                case CXCompletionChunk_Comma:
+                case CXCompletionChunk_CurrentParameter:
+                case CXCompletionChunk_RightParen:
+                   eina_strbuf_append(param, clang_getCString(str_out));
+                   break;
+                default:
+                   break;
+               }
+          }
+
+        edi_clang_message_string_append(reply, name);
+        edi_clang_message_string_append(reply, ret);
+        edi_clang_message_string_append(reply, eina_strbuf_string_get(param));
+        eina_strbuf_free(param);
+     }
+   clang_disposeCodeCompleteResults(res);
+
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edi_clang_doc_newline_check(Eina_Strbuf *strbuf)
+{
+   const char *str;
+
+   str = eina_strbuf_string_get(strbuf);
+
+   if (strlen(str) < 4)
+     return EINA_TRUE;
+
+   str = str + strlen(str) - 4;
+
+   if (!strcmp(str, "<br>"))
+     return EINA_FALSE;
+   else
+     return EINA_TRUE;
+}
+
+static void
+_edi_clang_doc_trim(Eina_Strbuf *strbuf)
+{
+   const char *str;
+   int cmp_strlen, ori_strlen;
+
+   str = eina_strbuf_string_get(strbuf);
+   ori_strlen = strlen(str);
+
+   if (strlen(str) < 8)
+     return;
+
+   cmp_strlen = strlen(str) - 8;
+   str += cmp_strlen;
+
+   if (!strcmp(str, "<br><br>"))
+     {
+        eina_strbuf_remove(strbuf, cmp_strlen, ori_strlen);
+        _edi_clang_doc_trim(strbuf);
+     }
+   else
+     return;
+}
+
+static void
+_edi_clang_doc_title_get(CXCursor cursor, Eina_Strbuf *strbuf)
+{
+   CXCompletionString str;
+   int chunk_num;
+
+   str = clang_getCursorCompletionString(cursor);
+   chunk_num = clang_getNumCompletionChunks(str);
+
+   for (int i = 0; i < chunk_num; i++)
+     {
+        enum CXCompletionChunkKind kind = clang_getCompletionChunkKind(str, i);
+        switch (kind)
+          {
+           case CXCompletionChunk_ResultType:
+             eina_strbuf_append_printf(strbuf, "<color=#31d12f><b>%s</b></color><br>",
+                        clang_getCString(clang_getCompletionChunkText(str, i)));
+             break;
+           case CXCompletionChunk_Placeholder:
+             eina_strbuf_append_printf(strbuf, "<color=#edd400><b>%s</b></color>",
+                        clang_getCString(clang_getCompletionChunkText(str, i)));
+             break;
+           default:
+             eina_strbuf_append(strbuf,
+                        clang_getCString(clang_getCompletionChunkText(str, i)));
+             break;
+          }
+     }
+}
+
+static void
+_edi_clang_doc_dump(Edi_Clang_Document *doc, CXComment comment, Eina_Strbuf *strbuf)
+{
+   const char *str ,*tag;
+   enum CXCommentKind kind = clang_Comment_getKind(comment);
+
+   if (kind == CXComment_Null) return;
+
+   switch (kind)
+     {
+      case CXComment_Text:
+        str = clang_getCString(clang_TextComment_getText(comment));
+
+        if (doc->see == strbuf)
+          {
+             eina_strbuf_append_printf(strbuf, "   %s", str);
+             break;
+          }
+        if (clang_Comment_isWhitespace(comment))
+          {
+             if (_edi_clang_doc_newline_check(strbuf))
+               {
+                  if (strbuf == doc->detail)
+                    eina_strbuf_append(strbuf, "<br><br>");
+                  else
+                    eina_strbuf_append(strbuf, "<br>");
+               }
+             break;
+          }
+        eina_strbuf_append(strbuf, str);
+        break;
+      case CXComment_InlineCommand:
+        str = clang_getCString(clang_InlineCommandComment_getCommandName(comment));
+
+        if (str[0] == 'p')
+          eina_strbuf_append_printf(strbuf, "<font_style=italic>%s</font_style>",
+             clang_getCString(clang_InlineCommandComment_getArgText(comment, 0)));
+        else if (str[0] == 'c')
+          eina_strbuf_append_printf(strbuf, "<b>%s</b>",
+             clang_getCString(clang_InlineCommandComment_getArgText(comment, 0)));
+        else
+          eina_strbuf_append_printf(strbuf, "@%s", str);
+        break;
+      case CXComment_BlockCommand:
+        tag = clang_getCString(clang_BlockCommandComment_getCommandName(comment));
+
+        if (!strcmp(tag, "return"))
+          strbuf = doc->ret;
+        else if (!strcmp(tag, "see"))
+          strbuf = doc->see;
+
+        break;
+      case CXComment_ParamCommand:
+        str = clang_getCString(clang_ParamCommandComment_getParamName(comment));
+        strbuf = doc->param;
+
+        eina_strbuf_append_printf(strbuf, "<color=#edd400><b>   %s</b></color>",
+                                  str);
+        break;
+      case CXComment_VerbatimBlockLine:
+        str = clang_getCString(clang_VerbatimBlockLineComment_getText(comment));
+
+        if (str[0] == 10)
+          {
+             eina_strbuf_append(strbuf, "<br>");
+             break;
+          }
+        eina_strbuf_append_printf(strbuf, "%s<br>", str);
+        break;
+      case CXComment_VerbatimLine:
+        str = clang_getCString(clang_VerbatimLineComment_getText(comment));
+
+        if (doc->see == strbuf)
+          eina_strbuf_append(strbuf, str);
+        break;
+      default:
+        break;
+     }
+   for (unsigned i = 0; i < clang_Comment_getNumChildren(comment); i++)
+     _edi_clang_doc_dump(doc, clang_Comment_getChild(comment, i), strbuf);
+}
+
+static CXCursor
+_edi_clang_cursor_get(Edi_Clang_Unit *unit, Edi_Clang_Message_Reader *reader)
+{
+   CXFile cxfile;
+   CXSourceLocation location;
+   CXCursor cursor;
+   unsigned int row, col;
+
+   if (!edi_clang_message_uint_get(reader, &row) ||
+       !edi_clang_message_uint_get(reader, &col))
+     return clang_getNullCursor();
+
+   cxfile = clang_getFile(unit->unit, unit->path);
+   location = clang_getLocation(unit->unit, cxfile, row, col);
+   cursor = clang_getCursor(unit->unit, location);
+
+   return clang_getCursorReferenced(cursor);
+}
+
+static Eina_Bool
+_edi_clang_document(Edi_Clang_Unit *unit, Edi_Clang_Message_Reader *reader, Eina_Binbuf *reply)
+{
+   Edi_Clang_Document doc;
+   CXCursor cursor;
+   CXComment comment;
+
+   cursor = _edi_clang_cursor_get(unit, reader);
+   comment = clang_Cursor_getParsedComment(cursor);
+   if (clang_Comment_getKind(comment) == CXComment_Null)
+     return EINA_FALSE;
+
+   doc.title = eina_strbuf_new();
+   doc.detail = eina_strbuf_new();
+   doc.param = eina_strbuf_new();
+   doc.ret = eina_strbuf_new();
+   doc.see = eina_strbuf_new();
+
+   _edi_clang_doc_dump(&doc, comment, doc.detail);
+   _edi_clang_doc_title_get(cursor, doc.title);
+   _edi_clang_doc_trim(doc.detail);
+
+   edi_clang_message_uint_append(reply, EINA_TRUE);
+   edi_clang_message_string_append(reply, eina_strbuf_string_get(doc.title));
+   edi_clang_message_string_append(reply, eina_strbuf_string_get(doc.detail));
+   edi_clang_message_string_append(reply, eina_strbuf_string_get(doc.param));
+   edi_clang_message_string_append(reply, eina_strbuf_string_get(doc.ret));
+   edi_clang_message_string_append(reply, eina_strbuf_string_get(doc.see));
+
+   eina_strbuf_free(doc.title);
+   eina_strbuf_free(doc.detail);
+   eina_strbuf_free(doc.param);
+   eina_strbuf_free(doc.ret);
+   eina_strbuf_free(doc.see);
+
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edi_clang_symbol(Edi_Clang_Unit *unit, Edi_Clang_Message_Reader *reader, Eina_Binbuf *reply)
+{
+   CXCursor cursor;
+   CXString str;
+   Eina_Bool found;
+
+   cursor = _edi_clang_cursor_get(unit, reader);
+   if (clang_Cursor_isNull(cursor))
+     return EINA_FALSE;
+
+   str = clang_getCursorUSR(cursor);
+   found = clang_getCString(str) && clang_getCString(str)[0];
+   if (found)
+     {
+        edi_clang_message_uint_append(reply, EINA_TRUE);
+        edi_clang_message_string_append(reply, clang_getCString(str));
+     }
+   clang_disposeString(str);
+
+   return found;
+}
+
+/* Handle one request, returning the reply to send or NULL if there is none */
+static Eina_Binbuf *
+_edi_clang_request(const Edi_Clang_Message_Header *header, const Eina_Binbuf *payload)
+{
+   Edi_Clang_Message_Reader reader;
+   Edi_Clang_Unit *unit;
+   Eina_Binbuf *reply;
+   Eina_Bool ok = EINA_FALSE;
+
+   if (header->type == EDI_CLANG_MESSAGE_FREE)
+     {
+        eina_hash_del_by_key(_edi_clang_units, &header->unit);
+        return NULL;
+     }
+
+   edi_clang_message_reader_init(&reader, payload);
+   reply = eina_binbuf_new();
+
+   if (header->type == EDI_CLANG_MESSAGE_PARSE)
+     {
+        ok = _edi_clang_parse(header->unit, &reader, reply);
+     }
+   else
+     {
+        unit = eina_hash_find(_edi_clang_units, &header->unit);
+        if (unit && unit->unit)
+          {
+             switch (header->type)
+               {
+                case EDI_CLANG_MESSAGE_HIGHLIGHT:
+                   ok = _edi_clang_highlight(unit, &reader, reply);
+                   break;
+                case EDI_CLANG_MESSAGE_DIAGNOSTICS:
+                   ok = _edi_clang_diagnostics(unit, reply);
+                   break;
+                case EDI_CLANG_MESSAGE_COMPLETE:
+                   ok = _edi_clang_complete(unit, &reader, reply);
+                   break;
+                case EDI_CLANG_MESSAGE_DOCUMENT:
+                   ok = _edi_clang_document(unit, &reader, reply);
+                   break;
+                case EDI_CLANG_MESSAGE_SYMBOL:
+                   ok = _edi_clang_symbol(unit, &reader, reply);
+                   break;
+                default:
+                   WRN("Unknown request %u", header->type);
+                   break;
+               }
+          }
+     }
+
+   // A failed request may have written part of its reply
+   if (!ok)
+     {
+        eina_binbuf_reset(reply);
+        edi_clang_message_uint_append(reply, EINA_FALSE);
+     }
+
+   return reply;
+}
+
+EAPI_MAIN int
+main(int argc, char **argv)
+{
+   Edi_Clang_Message_Header header;
+   Eina_Binbuf *payload, *reply;
+   struct rlimit limit;
+   unsigned int memory_limit = 0;
+   int args, out;
+   Eina_Bool quit_option = EINA_FALSE;
+
+   Ecore_Getopt_Value values[] = {
+     ECORE_GETOPT_VALUE_UINT(memory_limit),
+     ECORE_GETOPT_VALUE_BOOL(quit_option),
+     ECORE_GETOPT_VALUE_BOOL(quit_option),
+     ECORE_GETOPT_VALUE_BOOL(quit_option),
+     ECORE_GETOPT_VALUE_BOOL(quit_option),
+     ECORE_GETOPT_VALUE_NONE
+   };
+
+   if (!eina_init())
+     return EXIT_FAILURE;
+
+   _edi_log_dom = eina_log_domain_register("edi_clang", EINA_COLOR_CYAN);
+
+   args = ecore_getopt_parse(&optdesc, values, argc, argv);
+   if (args < 0)
+     {
+        EINA_LOG_CRIT("Could not parse arguments.");
+        goto end;
+     }
+   else if (quit_option)
+     {
+        goto end;
+     }
+
+   // Running out of memory ends this process, edi starts another one
+   if (memory_limit)
+     {
+        limit.rlim_cur = limit.rlim_max = (rlim_t) memory_limit * 1024 * 1024;
+        if (setrlimit(RLIMIT_AS, &limit))
+          WRN("Could not limit memory to %u MB", memory_limit);
+     }
+
+   // Keep anything libclang prints out of the replies
+   out = dup(STDOUT_FILENO);
+   dup2(STDERR_FILENO, STDOUT_FILENO);
+
+   _edi_clang_index = clang_createIndex(0, 0);
+   _edi_clang_units = eina_hash_int32_new(_edi_clang_unit_free_cb);
+
+   // Requests are handled in order until edi closes the pipe
+   while ((payload = edi_clang_message_read(STDIN_FILENO, &header)))
+     {
+        reply = _edi_clang_request(&header, payload);
+        eina_binbuf_free(payload);
+        if (!reply)
+          continue;
+
+        if (!edi_clang_message_write(out, EDI_CLANG_MESSAGE_REPLY, header.id, header.unit, reply))
+          {
+             eina_binbuf_free(reply);
+             break;
+          }
+        eina_binbuf_free(reply);
+     }
+
+   eina_hash_free(_edi_clang_units);
+   clang_disposeIndex(_edi_clang_index);
+   close(out);
+
+end:
+   eina_log_domain_unregister(_edi_log_dom);
+   _edi_log_dom = -1;
+   eina_shutdown();
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,160 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <Eina.h>
+
+#include "edi_clang_protocol.h"
+
+void
+edi_clang_message_uint_append(Eina_Binbuf *buf, unsigned int value)
+{
+   eina_binbuf_append_length(buf, (unsigned char *) &value, sizeof(value));
+}
+
+void
+edi_clang_message_data_append(Eina_Binbuf *buf, const char *data, unsigned int length)
+{
+   edi_clang_message_uint_append(buf, length);
+   if (length)
+     eina_binbuf_append_length(buf, (const unsigned char *) data, length);
+}
+
+void
+edi_clang_message_string_append(Eina_Binbuf *buf, const char *str)
+{
+   edi_clang_message_data_append(buf, str, str ? strlen(str) : 0);
+}
+
+void
+edi_clang_message_reader_init(Edi_Clang_Message_Reader *reader, const Eina_Binbuf *buf)
+{
+   reader->ptr = eina_binbuf_string_get(buf);
+   reader->end = reader->ptr + eina_binbuf_length_get(buf);
+}
+
+Eina_Bool
+edi_clang_message_uint_get(Edi_Clang_Message_Reader *reader, unsigned int *value)
+{
+   if ((size_t)(reader->end - reader->ptr) < sizeof(unsigned int))
+     return EINA_FALSE;
+
+   memcpy(value, reader->ptr, sizeof(unsigned int));
+   reader->ptr += sizeof(unsigned int);
+   return EINA_TRUE;
+}
+
+Eina_Bool
+edi_clang_message_data_get(Edi_Clang_Message_Reader *reader, const char **data, unsigned int *length)
+{
+   if (!edi_clang_message_uint_get(reader, length) ||
+       (size_t)(reader->end - reader->ptr) < *length)
+     return EINA_FALSE;
+
+   *data = (const char *) reader->ptr;
+   reader->ptr += *length;
+   return EINA_TRUE;
+}
+
+char *
+edi_clang_message_string_get(Edi_Clang_Message_Reader *reader)
+{
+   const char *data;
+   unsigned int length;
+
+   if (!edi_clang_message_data_get(reader, &data, &length))
+     return NULL;
+
+   return strndup(data, length);
+}
+
+static Eina_Bool
+_edi_clang_message_write_all(int fd, const void *data, size_t length)
+{
+   const char *ptr = data;
+   ssize_t written;
+
+   while (length)
+     {
+        written = write(fd, ptr, length);
+        if (written < 0 && errno == EINTR)
+          continue;
+        if (written <= 0)
+          return EINA_FALSE;
+
+        ptr += written;
+        length -= written;
+     }
+
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edi_clang_message_read_all(int fd, void *data, size_t length)
+{
+   char *ptr = data;
+   ssize_t count;
+
+   while (length)
+     {
+        count = read(fd, ptr, length);
+        if (count < 0 && errno == EINTR)
+          continue;
+        if (count <= 0)
+          return EINA_FALSE;
+
+        ptr += count;
+        length -= count;
+     }
+
+   return EINA_TRUE;
+}
+
+Eina_Bool
+edi_clang_message_write(int fd, unsigned int type, unsigned int id, unsigned int unit,
+                        const Eina_Binbuf *payload)
+{
+   Edi_Clang_Message_Header header;
+
+   header.length = payload ? eina_binbuf_length_get(payload) : 0;
+   header.type = type;
+   header.id = id;
+   header.unit = unit;
+
+   if (!_edi_clang_message_write_all(fd, &header, sizeof(header)))
+     return EINA_FALSE;
+   if (!header.length)
+     return EINA_TRUE;
+
+   return _edi_clang_message_write_all(fd, eina_binbuf_string_get(payload), header.length);
+}
+
+Eina_Binbuf *
+edi_clang_message_read(int fd, Edi_Clang_Message_Header *header)
+{
+   Eina_Binbuf *payload;
+   unsigned char chunk[65536];
+   size_t remaining, length;
+
+   if (!_edi_clang_message_read_all(fd, header, sizeof(*header)) ||
+       header->length > EDI_CLANG_MESSAGE_SIZE_MAX)
+     return NULL;
+
+   payload = eina_binbuf_new();
+   for (remaining = header->length; remaining; remaining -= length)
+     {
+        length = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
+        if (!_edi_clang_message_read_all(fd, chunk, length))
+          {
+             eina_binbuf_free(payload);
+             return NULL;
+          }
+        eina_binbuf_append_length(payload, chunk, length);
+     }
+
+   return payload;
+}
@@ -0,0 +1,196 @@
+#ifndef EDI_CLANG_PROTOCOL_H_
+# define EDI_CLANG_PROTOCOL_H_
+
+#include <Eina.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief The messages exchanged with the edi_clang helper processes.
+ *
+ * Each message is a header followed by a payload of unsigned integers and
+ * length prefixed strings, in the byte order of the machine. Requests carry
+ * the id of the parsed file they are for, the helper answers each request
+ * except EDI_CLANG_MESSAGE_FREE with an EDI_CLANG_MESSAGE_REPLY of the same id.
+ * A reply payload starts with EINA_TRUE if the request succeeded.
+ */
+
+/** The largest payload accepted, anything bigger is taken as a broken stream */
+#define EDI_CLANG_MESSAGE_SIZE_MAX (256 * 1024 * 1024)
+
+typedef enum _Edi_Clang_Message_Type
+{
+   /* path, argc, args, has_contents[, contents] -> size, count, count * (include, mtime) */
+   EDI_CLANG_MESSAGE_PARSE = 1,
+   /* first line, last line -> count, count * (start line, start col, end line, end col, kind) */
+   EDI_CLANG_MESSAGE_HIGHLIGHT,
+   /* -> count, count * (line, severity, text) */
+   EDI_CLANG_MESSAGE_DIAGNOSTICS,
+   /* row, col, contents -> count, count * (name, return, parameters) */
+   EDI_CLANG_MESSAGE_COMPLETE,
+   /* row, col -> title, detail, param, ret, see */
+   EDI_CLANG_MESSAGE_DOCUMENT,
+   /* row, col -> usr */
+   EDI_CLANG_MESSAGE_SYMBOL,
+   /* no reply, the parsed file is released */
+   EDI_CLANG_MESSAGE_FREE,
+   EDI_CLANG_MESSAGE_REPLY,
+} Edi_Clang_Message_Type;
+
+/* How a highlighted token is shown, mapped to the editor colours by edi */
+typedef enum _Edi_Clang_Highlight_Kind
+{
+   EDI_CLANG_HIGHLIGHT_CLASS = 1,
+   EDI_CLANG_HIGHLIGHT_FUNCTION,
+   EDI_CLANG_HIGHLIGHT_PREPROCESSOR,
+   EDI_CLANG_HIGHLIGHT_TYPE,
+} Edi_Clang_Highlight_Kind;
+
+/* The severity of a diagnostic, the same as the libclang CXDiagnosticSeverity values */
+typedef enum _Edi_Clang_Severity
+{
+   EDI_CLANG_SEVERITY_IGNORED = 0,
+   EDI_CLANG_SEVERITY_NOTE,
+   EDI_CLANG_SEVERITY_WARNING,
+   EDI_CLANG_SEVERITY_ERROR,
+   EDI_CLANG_SEVERITY_FATAL,
+} Edi_Clang_Severity;
+
+typedef struct _Edi_Clang_Message_Header
+{
+   unsigned int length; /**< The size of the payload that follows */
+   unsigned int type; /**< An Edi_Clang_Message_Type */
+   unsigned int id; /**< Chosen by edi for a request, repeated in the reply */
+   unsigned int unit; /**< The parsed file the request is for */
+} Edi_Clang_Message_Header;
+
+/* Reads the fields of a payload in order, each get fails once the payload is used up */
+typedef struct _Edi_Clang_Message_Reader
+{
+   const unsigned char *ptr;
+   const unsigned char *end;
+} Edi_Clang_Message_Reader;
+
+/**
+ * @brief Helper protocol functions.
+ * @defgroup Protocol
+ *
+ * @{
+ *
+ * Encoding and decoding of the messages sent over the helper pipes.
+ *
+ */
+
+/**
+ * Append an unsigned integer to a payload.
+ *
+ * @param buf The payload to append to.
+ * @param value The value to append.
+ *
+ * @ingroup Protocol
+ */
+void edi_clang_message_uint_append(Eina_Binbuf *buf, unsigned int value);
+
+/**
+ * Append a string to a payload.
+ *
+ * @param buf The payload to append to.
+ * @param str The string to append, NULL is sent as an empty string.
+ *
+ * @ingroup Protocol
+ */
+void edi_clang_message_string_append(Eina_Binbuf *buf, const char *str);
+
+/**
+ * Append a block of text to a payload.
+ *
+ * @param buf The payload to append to.
+ * @param data The text to append.
+ * @param length The length of the text.
+ *
+ * @ingroup Protocol
+ */
+void edi_clang_message_data_append(Eina_Binbuf *buf, const char *data, unsigned int length);
+
+/**
+ * Start reading a payload.
+ *
+ * @param reader The reader to set up.
+ * @param buf The payload to read, which must outlive the reader.
+ *
+ * @ingroup Protocol
+ */
+void edi_clang_message_reader_init(Edi_Clang_Message_Reader *reader, const Eina_Binbuf *buf);
+
+/**
+ * Read the next unsigned integer of a payload.
+ *
+ * @param reader The reader of the payload.
+ * @param value Set to the value read.
+ * @return EINA_FALSE if the payload is too short.
+ *
+ * @ingroup Protocol
+ */
+Eina_Bool edi_clang_message_uint_get(Edi_Clang_Message_Reader *reader, unsigned int *value);
+
+/**
+ * Read the next string or block of text of a payload without copying it.
+ *
+ * @param reader The reader of the payload.
+ * @param data Set to the start of the text, which is not nul terminated.
+ * @param length Set to the length of the text.
+ * @return EINA_FALSE if the payload is too short.
+ *
+ * @ingroup Protocol
+ */
+Eina_Bool edi_clang_message_data_get(Edi_Clang_Message_Reader *reader, const char **data, unsigned int *length);
+
+/**
+ * Read the next string of a payload.
+ *
+ * @param reader The reader of the payload.
+ * @return A new string that must be freed, or NULL if the payload is too short.
+ *
+ * @ingroup Protocol
+ */
+char *edi_clang_message_string_get(Edi_Clang_Message_Reader *reader);
+
+/**
+ * Write a message, blocking until all of it is written.
+ *
+ * @param fd The pipe to write to.
+ * @param type The Edi_Clang_Message_Type of the message.
+ * @param id The id of the request.
+ * @param unit The parsed file the message is for.
+ * @param payload The payload, may be NULL.
+ * @return EINA_FALSE if the pipe was closed.
+ *
+ * @ingroup Protocol
+ */
+Eina_Bool edi_clang_message_write(int fd, unsigned int type, unsigned int id, unsigned int unit,
+                                  const Eina_Binbuf *payload);
+
+/**
+ * Read a message, blocking until all of it has arrived.
+ *
+ * @param fd The pipe to read from.
+ * @param header Set to the header of the message.
+ * @return The payload, to be freed with eina_binbuf_free(),
+ *         or NULL if the pipe was closed or the message is broken.
+ *
+ * @ingroup Protocol
+ */
+Eina_Binbuf *edi_clang_message_read(int fd, Edi_Clang_Message_Header *header);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_CLANG_PROTOCOL_H_ */
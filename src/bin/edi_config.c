@@ -37,12 +37,12 @@
    EET_DATA_DESCRIPTOR_ADD_HASH(edd, type, #member, member, eddtype)
 
 #  define EDI_CONFIG_FILE_EPOCH 0x0003
-#  define EDI_CONFIG_FILE_GENERATION 0x000c
+#  define EDI_CONFIG_FILE_GENERATION 0x000d
 #  define EDI_CONFIG_FILE_VERSION \
    ((EDI_CONFIG_FILE_EPOCH << 16) | EDI_CONFIG_FILE_GENERATION)
 
 #  define EDI_PROJECT_CONFIG_FILE_EPOCH 0x0002
-#  define EDI_PROJECT_CONFIG_FILE_GENERATION 0x0004
+#  define EDI_PROJECT_CONFIG_FILE_GENERATION 0x0005
 #  define EDI_PROJECT_CONFIG_FILE_VERSION \
    ((EDI_PROJECT_CONFIG_FILE_EPOCH << 16) | EDI_PROJECT_CONFIG_FILE_GENERATION)
 
@@ -234,6 +234,7 @@ _edi_config_init(void)
    EDI_CONFIG_VAL(D, T, version, EET_T_INT);
    EDI_CONFIG_VAL(D, T, autosave, EET_T_UCHAR);
    EDI_CONFIG_VAL(D, T, trim_whitespace, EET_T_UCHAR);
+   EDI_CONFIG_VAL(D, T, clang_cache_size, EET_T_UINT);
 
    EDI_CONFIG_LIST(D, T, projects, _edi_cfg_proj_edd);
    EDI_CONFIG_LIST(D, T, mime_assocs, _edi_cfg_mime_edd);
@@ -276,6 +277,7 @@ _edi_config_init(void)
    EDI_CONFIG_VAL(D, T, gui.toolbar_hidden, EET_T_UCHAR);
    EDI_CONFIG_VAL(D, T, gui.tab_inserts_spaces, EET_T_UCHAR);
 
+   EDI_CONFIG_VAL(D, T, tasks.markers, EET_T_STRING);
    EDI_CONFIG_VAL(D, T, launch.path, EET_T_STRING);
    EDI_CONFIG_VAL(D, T, launch.args, EET_T_STRING);
    EDI_CONFIG_VAL(D, T, user_fullname, EET_T_STRING);
@@ -352,6 +354,10 @@ _edi_config_load(void)
    _edi_config->mime_assocs = NULL;
    IFCFGEND;
 
+   IFCFG(0x000d);
+   _edi_config->clang_cache_size = 512;
+   IFCFGEND;
+
    _edi_config->version = EDI_CONFIG_FILE_VERSION;
 
    if (save) _edi_config_save();
@@ -517,6 +523,10 @@ _edi_project_config_load()
    _edi_project_config->gui.tab_inserts_spaces = EINA_TRUE;
    IFPCFGEND;
 
+   IFPCFG(0x0005);
+   _edi_project_config->tasks.markers = eina_stringshare_add("TODO FIXME XXX HACK");
+   IFPCFGEND;
+
    /* limit config values so they are sane */
    EDI_CONFIG_LIMIT(_edi_project_config->font.size, EDI_FONT_MIN, EDI_FONT_MAX);
    EDI_CONFIG_LIMIT(_edi_project_config->gui.width, 150, 10000);
@@ -41,6 +41,7 @@ struct _Edi_Config
 
    Eina_Bool autosave;
    Eina_Bool trim_whitespace;
+   unsigned int clang_cache_size;
 
    Eina_List *projects;
    Eina_List *mime_assocs;
@@ -87,6 +88,11 @@ struct _Edi_Project_Config
         Eina_Bool tab_inserts_spaces;
      } gui;
 
+   struct
+     {
+        Eina_Stringshare *markers;
+     } tasks;
+
    Edi_Project_Config_Launch launch;
    Eina_Stringshare *user_fullname;
    Eina_Stringshare *user_email;
@@ -117,6 +123,7 @@ const char* _edi_config_mime_search(const char *mime);
 
 // Project based configuration handling
 
+const char *_edi_project_config_dir_get(void);
 void _edi_project_config_load(void);
 void _edi_project_config_save(void);
 
@@ -1,3 +1,8 @@
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
 #include "Edi.h"
 #include "edi_file.h"
 #include "edi_config.h"
@@ -18,110 +23,82 @@ edi_file_path_hidden(const char *path)
    return EINA_FALSE;
 }
 
-void
-edi_file_text_replace(const char *path, const char *search, const char *replace)
+Eina_Bool
+edi_file_write_all(int fd, const char *data, size_t length)
 {
-   char *map, *found;
-   FILE *tempfile;
-   Eina_File *f;
-   char *tempfiledir, *tempfilepath;
-   unsigned long long len, idx;
-   unsigned int slen;
-
-   tempfiledir = edi_path_append(_edi_config_dir_get(), ".tmp");
+   ssize_t written;
 
-   ecore_file_mkdir(tempfiledir);
-
-   f = eina_file_open(path, EINA_FALSE);
-   if (!f) return;
-
-   map = eina_file_map_all(f, EINA_FILE_POPULATE);
-   if (!map)
+   while (length)
      {
-        eina_file_close(f);
-        return;
+        written = write(fd, data, length);
+        if (written < 0)
+          {
+             if (errno == EINTR)
+               continue;
+             return EINA_FALSE;
+          }
+        data += written;
+        length -= written;
      }
 
-   len = eina_file_size_get(f);
-   if (!len)
-     {
-        eina_file_close(f);
-        return;
-     }
+   return EINA_TRUE;
+}
 
-   tempfilepath = edi_path_append(tempfiledir, ecore_file_file_get(path));
+/*
+ * The new content goes to a hidden file beside the original which is then
+ * renamed over it, so the file is either untouched or fully replaced.
+ */
+int
+edi_file_atomic_open(const char *path, char **temppath)
+{
+   char *dir, *tempfilepath;
+   struct stat st;
+   int fd;
 
-   tempfile = fopen(tempfilepath, "wb");
-   if (!tempfile) goto done;
+   *temppath = NULL;
+   if (stat(path, &st))
+     return -1;
 
-   idx = 0;
+   dir = ecore_file_dir_get(path);
+   tempfilepath = malloc(strlen(dir) + strlen(ecore_file_file_get(path)) + 10);
+   sprintf(tempfilepath, "%s/.%s.XXXXXX", dir, ecore_file_file_get(path));
+   free(dir);
 
-   found = strstr(&map[idx], search);
-   if (!found)
+   fd = mkstemp(tempfilepath);
+   if (fd < 0)
      {
-        fclose(tempfile);
-        unlink(tempfilepath);
-        goto done;
+        ERR("Unable to create a temporary file for %s", path);
+        free(tempfilepath);
+        return -1;
      }
 
-   slen = strlen(search);
-
-   while (idx < len)
+   if (fchmod(fd, st.st_mode & 07777))
      {
-         if (!found || &map[idx] < found)
-           {
-              fprintf(tempfile, "%c", map[idx]);
-              idx++;
-           }
-         else
-           {
-              fprintf(tempfile, "%s", replace);
-              idx += slen;
-              found = strstr(&map[idx], search);
-           }
+        close(fd);
+        unlink(tempfilepath);
+        free(tempfilepath);
+        return -1;
      }
 
-   fclose(tempfile);
-   ecore_file_mv(tempfilepath, path);
-   free(tempfilepath);
-done:
-   eina_file_map_free(f, map);
-   eina_file_close(f);
-   free(tempfiledir);
+   *temppath = tempfilepath;
+   return fd;
 }
 
-static void
-_edi_file_text_replace_all(const char *directory, const char *search, const char *replace)
+Eina_Bool
+edi_file_atomic_close(int fd, char *temppath, const char *path, Eina_Bool ok)
 {
-   char *path, *file;
-   Eina_List *files;
-
-   files = ecore_file_ls(directory);
+   if (ok)
+     ok = !fsync(fd);
+   if (close(fd))
+     ok = EINA_FALSE;
 
-   EINA_LIST_FREE(files, file)
+   if (!ok || rename(temppath, path))
      {
-        path = edi_path_append(directory, file);
-        if (!edi_file_path_hidden(path))
-          {
-             if (ecore_file_is_dir(path))
-               {
-                  _edi_file_text_replace_all(path, search, replace);
-               }
-             else
-               {
-                  edi_file_text_replace(path, search, replace);
-               }
-          }
-        free(path);
-        free(file);
+        ERR("Unable to write %s", path);
+        unlink(temppath);
+        ok = EINA_FALSE;
      }
 
-   if (files)
-     eina_list_free(files);
-}
-
-void
-edi_file_text_replace_all(const char *search, const char *replace)
-{
-   _edi_file_text_replace_all(edi_project_get(), search, replace);
+   free(temppath);
+   return ok;
 }
@@ -32,25 +32,42 @@ extern "C" {
 Eina_Bool edi_file_path_hidden(const char *path);
 
 /**
- * Replace all occurences of text within whole project.
+ * Write all of a block of memory to a file descriptor.
  *
- * @param search The text to be replaced.
- * @param replace The text that will replace.
+ * @param fd The file descriptor to write to.
+ * @param data The memory to write.
+ * @param length The number of bytes to write.
+ * @return EINA_TRUE if everything was written.
  *
  * @ingroup Lookup
  */
-void edi_file_text_replace_all(const char *search, const char *replace);
+Eina_Bool edi_file_write_all(int fd, const char *data, size_t length);
 
 /**
- * Replace all occurences of text within given file.
+ * Start replacing the content of a file. A hidden temporary file is created
+ * beside it with the same permissions, the new content is written to the
+ * descriptor returned and edi_file_atomic_close() moves it into place.
  *
- * @param path The path of the file to replace all occurences of the text.
- * @param search The text to be replaced.
- * @param replace The text that will replace.
+ * @param path The path of the existing file to replace.
+ * @param temppath Set to the path of the temporary file, passed to edi_file_atomic_close().
+ * @return The descriptor of the temporary file, or -1 on failure.
  *
  * @ingroup Lookup
  */
-void edi_file_text_replace(const char *path, const char *search, const char *replace);
+int edi_file_atomic_open(const char *path, char **temppath);
+
+/**
+ * Finish replacing the content of a file started with edi_file_atomic_open().
+ *
+ * @param fd The descriptor returned by edi_file_atomic_open().
+ * @param temppath The temporary path set by edi_file_atomic_open(), this is freed.
+ * @param path The path of the file to replace.
+ * @param ok EINA_FALSE if writing failed and the original should be kept.
+ * @return EINA_TRUE if the file was replaced.
+ *
+ * @ingroup Lookup
+ */
+Eina_Bool edi_file_atomic_close(int fd, char *temppath, const char *path, Eina_Bool ok);
 
 /**
  * @}
@@ -22,6 +22,9 @@
 #include "mainview/edi_mainview.h"
 #include "screens/edi_screens.h"
 #include "screens/edi_file_screens.h"
+#include "search/edi_search_index.h"
+#include "language/edi_language_provider.h"
+#include "language/edi_language_index.h"
 #include "screens/edi_screens.h"
 
 #include "edi_private.h"
@@ -941,6 +944,13 @@ _edi_menu_find_replace_project_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_
    edi_mainview_project_replace_popup_show();
 }
 
+static void
+_edi_menu_undo_replace_project_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
+                      void *event_info EINA_UNUSED)
+{
+   edi_replace_undo(_edi_main_win);
+}
+
 static void
 _edi_menu_findfile_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
                       void *event_info EINA_UNUSED)
@@ -955,6 +965,27 @@ _edi_menu_goto_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
    edi_mainview_goto_popup_show();
 }
 
+static void
+_edi_menu_definition_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
+                        void *event_info EINA_UNUSED)
+{
+   edi_mainview_definition_goto();
+}
+
+static void
+_edi_menu_references_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
+                        void *event_info EINA_UNUSED)
+{
+   edi_mainview_references_find();
+}
+
+static void
+_edi_menu_find_symbol_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
+                         void *event_info EINA_UNUSED)
+{
+   edi_mainview_symbol_popup_show();
+}
+
 static void
 _edi_menu_view_open_window_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
                          void *event_info EINA_UNUSED)
@@ -1177,6 +1208,11 @@ _edi_menu_setup(Evas_Object *win)
    elm_menu_item_separator_add(menu, menu_it);
    elm_menu_item_add(menu, menu_it, "edit-find", _("Find in project ..."), _edi_menu_find_project_cb, NULL);
    elm_menu_item_add(menu, menu_it, "edit-find-replace", _("Replace in project ..."), _edi_menu_find_replace_project_cb, NULL);
+   elm_menu_item_add(menu, menu_it, "edit-undo", _("Undo replace in project"), _edi_menu_undo_replace_project_cb, NULL);
+   elm_menu_item_separator_add(menu, menu_it);
+   elm_menu_item_add(menu, menu_it, "go-jump", _("Go to definition"), _edi_menu_definition_cb, NULL);
+   elm_menu_item_add(menu, menu_it, "edit-find", _("Find references"), _edi_menu_references_cb, NULL);
+   elm_menu_item_add(menu, menu_it, "edit-find", _("Find symbol in project ..."), _edi_menu_find_symbol_cb, NULL);
 
    menu_it = elm_menu_item_add(menu, NULL, NULL, _("View"), NULL, NULL);
    elm_menu_item_add(menu, menu_it, "window-new", _("New Window"), _edi_menu_view_open_window_cb, NULL);
@@ -1494,6 +1530,8 @@ edi_open(const char *inputpath)
    _edi_config_project_add(path);
    _edi_open_tabs();
    edi_scm_init();
+   edi_search_index_init(path);
+   edi_language_index_init(path);
    _edi_icon_update();
 
    evas_object_smart_callback_add(win, "delete,request", _win_delete_cb, NULL);
@@ -1671,6 +1709,10 @@ elm_main(int argc EINA_UNUSED, char **argv EINA_UNUSED)
    elm_run();
 
  end:
+   edi_language_index_shutdown();
+   edi_search_index_shutdown();
+   // Providers wait for threads and remove handlers and monitors, so go before the libraries
+   edi_language_provider_shutdown();
    _edi_log_shutdown();
    elm_shutdown();
    edi_scm_shutdown();
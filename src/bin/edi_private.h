@@ -40,6 +40,7 @@ extern int _edi_log_dom;
 
 extern int EDI_EVENT_TAB_CHANGED;
 extern int EDI_EVENT_FILE_CHANGED;
+/* The event info is the stringshared path of the file that was saved */
 extern int EDI_EVENT_FILE_SAVED;
 
 #define EDI_CONTENT_SAVE_TIMEOUT 1
@@ -5,29 +5,121 @@
 #include <Eo.h>
 #include <Eina.h>
 #include <Elementary.h>
+#include <Eio.h>
 
 #include <string.h>
 #include "edi_file.h"
 #include "edi_searchpanel.h"
 #include "edi_config.h"
 #include "mainview/edi_mainview.h"
+#include "search/edi_search.h"
+#include "search/edi_search_scanner.h"
+#include "search/edi_search_multi.h"
+#include "search/edi_search_regex.h"
+#include "search/edi_search_index.h"
+#include "search/edi_search_results.h"
+#include "language/edi_language_index.h"
 
 #include "edi_private.h"
 
-static Evas_Object *_info_widget, *_tasks_widget;
-static Elm_Code *_elm_code, *_tasks_code;
+#define EDI_SEARCHPANEL_BATCH_INTERVAL 0.016
+#define EDI_SEARCHPANEL_EXPAND_MAX 1000
+#define EDI_SEARCHPANEL_UPDATE_DELAY 0.2
+#define EDI_TASKSPANEL_UPDATE_DELAY 0.2
+#define EDI_TASKSPANEL_MARKERS_DELAY 0.5
 
-static Ecore_Thread *_search_thread = NULL;
-static Eina_Bool _searching = EINA_FALSE;
-static char *_search_text = NULL;
+typedef struct _Edi_Searchpanel_Batch_File
+{
+   char *path;
+   Eina_List *matches;
+} Edi_Searchpanel_Batch_File;
 
-static Eina_Bool
-_edi_searchpanel_config_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *event EINA_UNUSED)
+/* Files found by a search thread, taken by the main loop on each tick of the timer */
+typedef struct _Edi_Searchpanel_Batch
 {
-   elm_code_widget_font_set(_info_widget, _edi_project_config->font.name, _edi_project_config->font.size);
+   Eina_Lock lock;
+   Eina_List *files;
+   Ecore_Timer *timer;
+   void *data;
+} Edi_Searchpanel_Batch;
+
+/* A line that matched the last search, to be checked again when the query is extended */
+typedef struct _Edi_Searchpanel_Candidate
+{
+   size_t offset;
+   unsigned int line;
+} Edi_Searchpanel_Candidate;
 
-   return ECORE_CALLBACK_RENEW;
-}
+typedef struct _Edi_Searchpanel_Candidate_File
+{
+   char *path;
+   Edi_Searchpanel_Candidate *lines;
+   unsigned int count;
+} Edi_Searchpanel_Candidate_File;
+
+typedef struct _Edi_Searchpanel_Candidates
+{
+   char *text;
+   Edi_Search_Regex_Flags flags;
+   Eina_List *files;
+   Eina_Hash *paths;
+} Edi_Searchpanel_Candidates;
+
+typedef struct _Edi_Searchpanel_Job
+{
+   char *text;
+   Edi_Search_Regex_Flags flags;
+
+   /* Read only while the job runs, owned by the main loop */
+   const Edi_Searchpanel_Candidates *previous;
+   /* Set by the search thread once every file has been searched */
+   Edi_Searchpanel_Candidates *found;
+   /* The changed files to search again, or NULL to search the whole project */
+   Eina_List *paths;
+
+   Edi_Searchpanel_Batch *batch;
+} Edi_Searchpanel_Job;
+
+typedef struct _Edi_Searchpanel_Search
+{
+   Ecore_Thread *thread;
+   Edi_Searchpanel_Batch *batch;
+   Edi_Search_Scanner *scanner;
+   Edi_Search_Regex *regex;
+   const Edi_Search_Multi *multi;
+   const Edi_Searchpanel_Candidates *previous;
+   Edi_Searchpanel_Candidates *found;
+   /* Render the text of each match in the thread, for panels that show it as it is */
+   Eina_Bool summary;
+} Edi_Searchpanel_Search;
+
+static Evas_Object *_info_widget, *_tasks_widget;
+static Elm_Code *_tasks_code;
+
+static Edi_Search_Results *_search_results = NULL;
+static Elm_Genlist_Item_Class *_search_file_itc, *_search_result_itc;
+static unsigned int _search_expanded = 0;
+static Eina_Inarray *_search_items = NULL;
+static Edi_Walker *_search_walker = NULL;
+static Eina_Hash *_search_queued = NULL;
+static Ecore_Timer *_search_timer = NULL;
+
+static Ecore_Thread *_search_thread = NULL;
+static Eina_Bool _search_pending = EINA_FALSE;
+static Eina_Bool _search_stale = EINA_FALSE;
+static char *_search_text = NULL;
+static Edi_Search_Regex_Flags _search_flags = EDI_SEARCH_REGEX_LITERAL;
+static Edi_Searchpanel_Candidates *_search_candidates = NULL;
+
+static Ecore_Thread *_tasks_thread = NULL;
+static Eina_Bool _tasks_rescan = EINA_FALSE;
+static Eina_Stringshare *_tasks_markers_text = NULL;
+static Eina_List *_tasks_markers = NULL;
+static Edi_Search_Multi *_tasks_multi = NULL;
+static Edi_Walker *_tasks_walker = NULL;
+static Eina_Hash *_tasks_queued = NULL;
+static Ecore_Timer *_tasks_timer = NULL;
+static Ecore_Timer *_tasks_markers_timer = NULL;
 
 static void
 _edi_searchpanel_line_clicked_cb(void *data EINA_UNUSED, const Efl_Event *event)
@@ -69,15 +161,13 @@ _edi_searchpanel_line_clicked_cb(void *data EINA_UNUSED, const Efl_Event *event)
    free(numstr);
 }
 
-char *
-_edi_searchpanel_line_render(Elm_Code_Line *line, const char *path)
+static char *
+_edi_searchpanel_line_render(const char *text, unsigned int len, unsigned int number, const char *path)
 {
-   unsigned int len, trim = 0;
-   const char *text;
-   static char buf[1024];
-   static char str[1016];
+   unsigned int trim = 0;
+   char buf[1024];
+   const unsigned int maxlen = 1015;
 
-   text = elm_code_line_text_get(line, &len);
    if (!text)
      return NULL;
 
@@ -89,230 +179,1346 @@ _edi_searchpanel_line_render(Elm_Code_Line *line, const char *path)
      }
    text += trim;
    len -= trim;
-   if (len > sizeof(str) - 1)
-     len = sizeof(str) - 1;
+   if (len > maxlen)
+     len = maxlen;
 
-   snprintf(str, len + 1, "%s", text);
-   snprintf(buf, sizeof(buf), "%s:%d ->\t%s", ecore_file_file_get(path), line->number, str);
+   if (path)
+     snprintf(buf, sizeof(buf), "%s:%d ->\t%.*s", ecore_file_file_get(path), number, (int) len, text);
+   else
+     snprintf(buf, sizeof(buf), "%d ->\t%.*s", number, (int) len, text);
 
    return strdup(buf);
 }
 
-void
-_edi_searchpanel_search_project_file(const char *path, const char *search_term, Elm_Code *logger)
+typedef struct _Edi_Searchpanel_File
 {
-   Elm_Code *code;
-   Elm_Code_File *code_file;
-   Eina_List *item;
-   Elm_Code_Line *line;
-   char *text;
+   const char *path;
+   Eina_List *matches;
+   Eina_Bool summary;
 
-   code = elm_code_create();
-   code_file = elm_code_file_open(code, path);
+   /* The mapped file and the line number that scanned text starts after */
+   const char *base;
+   unsigned int number;
+} Edi_Searchpanel_File;
+
+static Eina_Bool
+_edi_searchpanel_search_project_line_cb(void *data, const char *line, unsigned int length,
+                                        unsigned int number, unsigned int col)
+{
+   Edi_Searchpanel_File *file = data;
+   Edi_Search_Match *match;
+
+   number += file->number;
+   match = malloc(sizeof(Edi_Search_Match));
+   match->line = number;
+   match->col = col;
+   match->offset = file->base ? (size_t) (line - file->base) : 0;
+   match->text = NULL;
+   if (file->summary)
+     match->text = _edi_searchpanel_line_render(line, length, number, file->path);
+   file->matches = eina_list_append(file->matches, match);
+
+   return EINA_TRUE;
+}
+
+static void
+_edi_searchpanel_search_text(Edi_Searchpanel_Search *ctx, Edi_Searchpanel_File *file,
+                             const char *text, size_t length)
+{
+   if (ctx->regex)
+     edi_search_regex_scan(ctx->regex, text, length, _edi_searchpanel_search_project_line_cb, file);
+   else if (ctx->multi)
+     edi_search_multi_scan(ctx->multi, text, length, _edi_searchpanel_search_project_line_cb, file);
+   else
+     edi_search_scanner_scan(ctx->scanner, text, length, _edi_searchpanel_search_project_line_cb, file);
+}
+
+/* Only the lines that matched the previous query can match one that extends it. */
+static void
+_edi_searchpanel_search_refine(Edi_Searchpanel_Search *ctx, Edi_Searchpanel_File *file,
+                               const Edi_Searchpanel_Candidate_File *candidates,
+                               const char *map, size_t length)
+{
+   const Edi_Searchpanel_Candidate *candidate;
+   const char *end;
+   unsigned int i;
 
-   EINA_LIST_FOREACH(code->file->lines, item, line)
+   for (i = 0; i < candidates->count; i++)
      {
-        int found = elm_code_line_text_strpos(line, search_term, 0);
-        if (found != ELM_CODE_TEXT_NOT_FOUND)
-          {
-             text = _edi_searchpanel_line_render(line, path);
-             ecore_thread_main_loop_begin();
-             elm_code_file_line_append(logger->file, text, strlen(text), strdup(path));
-             ecore_thread_main_loop_end();
-             free(text);
-          }
+        candidate = &candidates->lines[i];
+        if (candidate->offset >= length)
+          break;
+
+        end = memchr(map + candidate->offset, '\n', length - candidate->offset);
+        if (!end)
+          end = map + length;
+
+        file->number = candidate->line - 1;
+        _edi_searchpanel_search_text(ctx, file, map + candidate->offset,
+                                     end - (map + candidate->offset));
      }
+}
 
-    elm_code_file_close(code_file);
-}
-
-Eina_Bool
-_file_ignore(const char *filename)
-{
-   if ((eina_str_has_extension(filename, ".png")   ||
-        eina_str_has_extension(filename, ".PNG")   ||
-        eina_str_has_extension(filename, ".jpg")   ||
-        eina_str_has_extension(filename, ".jpeg")  ||
-        eina_str_has_extension(filename, ".JPG")   ||
-        eina_str_has_extension(filename, ".JPEG")  ||
-        eina_str_has_extension(filename, ".bmp")   ||
-        eina_str_has_extension(filename, ".dds")   ||
-        eina_str_has_extension(filename, ".tgv")   ||
-        eina_str_has_extension(filename, ".eet")   ||
-        eina_str_has_extension(filename, ".edj")   ||
-        eina_str_has_extension(filename, ".gz")    ||
-        eina_str_has_extension(filename, ".bz2")   ||
-        eina_str_has_extension(filename, ".xz")    ||
-        eina_str_has_extension(filename, ".lzma")  ||
-        eina_str_has_extension(filename, ".core")  ||
-        eina_str_has_extension(filename, ".zip")
-       ))
-     return EINA_TRUE;
+static Eina_List *
+_edi_searchpanel_search_project_file(const char *path, void *data)
+{
+   Edi_Searchpanel_Search *ctx = data;
+   const Edi_Searchpanel_Candidate_File *candidates = NULL;
+   Edi_Searchpanel_File file;
+   Eina_File *f;
+   const char *map;
+   size_t length;
+
+   memset(&file, 0, sizeof(Edi_Searchpanel_File));
+   file.path = path;
+   file.summary = ctx->summary;
+
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return NULL;
 
-   return EINA_FALSE;
+   length = eina_file_size_get(f);
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (map && !edi_walker_binary_is(map, length))
+     {
+        file.base = map;
+        if (ctx->previous)
+          candidates = eina_hash_find(ctx->previous->paths, path);
+
+        if (candidates)
+          _edi_searchpanel_search_refine(ctx, &file, candidates, map, length);
+        else
+          _edi_searchpanel_search_text(ctx, &file, map, length);
+     }
+
+   if (map)
+     eina_file_map_free(f, (void *) map);
+   eina_file_close(f);
+
+   return file.matches;
 }
 
-void
-_edi_searchpanel_search_project(const char *directory, const char *search_term, Elm_Code *logger)
+static void
+_edi_searchpanel_candidate_file_free(void *data)
 {
-   Eina_List *files, *item;
-   char *file;
-   char *path;
+   Edi_Searchpanel_Candidate_File *file = data;
 
-   files = ecore_file_ls(directory);
+   free(file->lines);
+   free(file->path);
+   free(file);
+}
 
-   EINA_LIST_FOREACH(files, item, file)
+static Edi_Searchpanel_Candidates *
+_edi_searchpanel_candidates_new(const char *text, Edi_Search_Regex_Flags flags)
+{
+   Edi_Searchpanel_Candidates *candidates;
+
+   candidates = calloc(1, sizeof(Edi_Searchpanel_Candidates));
+   candidates->text = strdup(text);
+   candidates->flags = flags;
+   candidates->paths = eina_hash_string_superfast_new(_edi_searchpanel_candidate_file_free);
+
+   return candidates;
+}
+
+static void
+_edi_searchpanel_candidates_free(Edi_Searchpanel_Candidates *candidates)
+{
+   if (!candidates)
+     return;
+
+   eina_list_free(candidates->files);
+   eina_hash_free(candidates->paths);
+   free(candidates->text);
+   free(candidates);
+}
+
+static void
+_edi_searchpanel_candidates_add(Edi_Searchpanel_Candidates *candidates, const char *path,
+                                Eina_List *matches)
+{
+   Edi_Searchpanel_Candidate_File *file;
+   Edi_Search_Match *match;
+   Eina_List *item;
+
+   file = malloc(sizeof(Edi_Searchpanel_Candidate_File));
+   file->path = strdup(path);
+   file->count = 0;
+   file->lines = malloc(sizeof(Edi_Searchpanel_Candidate) * eina_list_count(matches));
+   EINA_LIST_FOREACH(matches, item, match)
      {
-        if (_file_ignore(file)) continue;
+        file->lines[file->count].offset = match->offset;
+        file->lines[file->count].line = match->line;
+        file->count++;
+     }
 
-        path = edi_path_append(directory, file);
-        if (!edi_file_path_hidden(path))
-          {
-             if (ecore_file_is_dir(path))
-               _edi_searchpanel_search_project(path, search_term, logger);
-             else
-               _edi_searchpanel_search_project_file(path, search_term, logger);
-          }
+   candidates->files = eina_list_append(candidates->files, file);
+   eina_hash_add(candidates->paths, path, file);
+}
+
+/*
+ * Every match of a plain text query is also a match of any query it contains,
+ * so the last results can be refined. Whole word matching breaks that rule.
+ */
+static Eina_Bool
+_edi_searchpanel_candidates_refine(const Edi_Searchpanel_Candidates *candidates,
+                                   const char *text, Edi_Search_Regex_Flags flags)
+{
+   size_t length;
+
+   if (!candidates || candidates->flags != flags || !(flags & EDI_SEARCH_REGEX_LITERAL) ||
+       (flags & EDI_SEARCH_REGEX_WORD))
+     return EINA_FALSE;
+
+   if (!(flags & EDI_SEARCH_REGEX_CASELESS))
+     return strstr(text, candidates->text) != NULL;
 
-        free (path);
-        if (ecore_thread_check(_search_thread)) return;
+   length = strlen(candidates->text);
+   for (; *text; text++)
+     {
+        if (!strncasecmp(text, candidates->text, length))
+          return EINA_TRUE;
      }
+
+   return EINA_FALSE;
 }
 
 static void
-_search_end_cb(void *data EINA_UNUSED, Ecore_Thread *thread EINA_UNUSED)
+_edi_searchpanel_batch_files_free(Eina_List *files)
 {
-   _search_thread = NULL;
-   _searching = EINA_FALSE;
+   Edi_Searchpanel_Batch_File *file;
+
+   EINA_LIST_FREE(files, file)
+     {
+        edi_search_matches_free(file->matches);
+        free(file->path);
+        free(file);
+     }
+}
+
+/* The main loop takes what is pending on its own timer, which is passed the batch,
+ * so results show up steadily however far apart the matches are. */
+static Edi_Searchpanel_Batch *
+_edi_searchpanel_batch_new(Ecore_Task_Cb cb, void *data)
+{
+   Edi_Searchpanel_Batch *batch;
+
+   batch = calloc(1, sizeof(Edi_Searchpanel_Batch));
+   eina_lock_new(&batch->lock);
+   batch->timer = ecore_timer_add(EDI_SEARCHPANEL_BATCH_INTERVAL, cb, batch);
+   batch->data = data;
+
+   return batch;
 }
 
 static void
-_search_cancel_cb(void *data EINA_UNUSED, Ecore_Thread *thread EINA_UNUSED)
+_edi_searchpanel_batch_free(Edi_Searchpanel_Batch *batch)
 {
-   while ((ecore_thread_wait(_search_thread, 0.1)) != EINA_TRUE);
-   _searching = EINA_FALSE;
+   ecore_timer_del(batch->timer);
+   _edi_searchpanel_batch_files_free(batch->files);
+   eina_lock_free(&batch->lock);
+   free(batch);
 }
 
 static void
-_search_begin_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+_edi_searchpanel_batch_add(Edi_Searchpanel_Batch *batch, const char *path, Eina_List *matches)
 {
-   const char *path = data;
+   Edi_Searchpanel_Batch_File *file;
 
-   _searching = EINA_TRUE;
+   file = malloc(sizeof(Edi_Searchpanel_Batch_File));
+   file->path = strdup(path);
+   file->matches = matches;
+
+   eina_lock_take(&batch->lock);
+   batch->files = eina_list_append(batch->files, file);
+   eina_lock_release(&batch->lock);
+}
+
+static Eina_List *
+_edi_searchpanel_batch_take(Edi_Searchpanel_Batch *batch)
+{
+   Eina_List *files;
 
-   _edi_searchpanel_search_project(path, _search_text, _elm_code);
+   eina_lock_take(&batch->lock);
+   files = batch->files;
+   batch->files = NULL;
+   eina_lock_release(&batch->lock);
 
-   if (ecore_thread_check(_search_thread)) return;
+   return files;
 }
 
-void
-edi_searchpanel_find(const char *text)
+static void
+_edi_searchpanel_result_cb(void *data, const char *path, Eina_List *matches)
 {
-   const char *path;
+   Edi_Searchpanel_Search *ctx = data;
 
-   if (!text || strlen(text) == 0) return;
+   if (ctx->found)
+     _edi_searchpanel_candidates_add(ctx->found, path, matches);
 
-   if (_searching) _search_cancel_cb(NULL, _search_thread);
+   _edi_searchpanel_batch_add(ctx->batch, path, matches);
+}
 
-   if (_search_text) free(_search_text);
-   _search_text = strdup(text);
+/* Run a prepared search over the candidate files, or the whole directory if there are none. */
+static Eina_Bool
+_edi_searchpanel_search_run(Edi_Searchpanel_Search *ctx, const char *directory,
+                            Eina_Bool indexed, Eina_List *files)
+{
+   Edi_Search *search;
+   Eina_Bool complete;
+
+   search = edi_search_add(ctx->thread, _edi_searchpanel_search_project_file,
+                           _edi_searchpanel_result_cb, ctx);
+   if (indexed)
+     complete = edi_search_files_run(search, files);
+   else
+     complete = edi_search_project_run(search, directory);
+   edi_search_free(search);
+
+   return complete;
+}
 
-   path = edi_project_get();
+/* Set up the matcher for a job, returning the literal text an index lookup can use. */
+static Eina_Bool
+_edi_searchpanel_search_prepare(Edi_Searchpanel_Search *ctx, Ecore_Thread *thread,
+                                Edi_Searchpanel_Job *job, const char **literal)
+{
+   memset(ctx, 0, sizeof(Edi_Searchpanel_Search));
+   ctx->thread = thread;
+   ctx->batch = job->batch;
+   *literal = job->text;
+
+   /* Plain text goes straight to the scanner, anything else needs the automaton. */
+   if (job->flags == EDI_SEARCH_REGEX_LITERAL)
+     ctx->scanner = edi_search_scanner_new(job->text);
+   else if (job->flags == (EDI_SEARCH_REGEX_LITERAL | EDI_SEARCH_REGEX_CASELESS))
+     ctx->scanner = edi_search_scanner_caseless_new(job->text);
+   else
+     {
+        ctx->regex = edi_search_regex_new(job->text, job->flags);
+        if (ctx->regex)
+          *literal = edi_search_regex_literal_get(ctx->regex);
+     }
 
-   elm_code_file_clear(_elm_code->file);
+   return ctx->scanner || ctx->regex;
+}
 
-   _search_thread = ecore_thread_feedback_run(_search_begin_cb, NULL,
-                                      _search_end_cb, _search_cancel_cb,
-                                      path, EINA_FALSE);
+static void
+_edi_searchpanel_search_release(Edi_Searchpanel_Search *ctx)
+{
+   if (ctx->regex)
+     edi_search_regex_free(ctx->regex);
+   if (ctx->scanner)
+     edi_search_scanner_free(ctx->scanner);
 }
 
-void
-edi_searchpanel_add(Evas_Object *parent)
+static void
+_edi_searchpanel_search_project(Ecore_Thread *thread, const char *directory,
+                                Edi_Searchpanel_Job *job)
 {
-   Elm_Code_Widget *widget;
-   Elm_Code *code;
-   code = elm_code_create();
-   widget = elm_code_widget_add(parent, code);
-   elm_obj_code_widget_font_set(widget, _edi_project_config->font.name, _edi_project_config->font.size);
-   elm_obj_code_widget_gravity_set(widget, 0.0, 1.0);
-   efl_event_callback_add(widget, ELM_OBJ_CODE_WIDGET_EVENT_LINE_CLICKED, _edi_searchpanel_line_clicked_cb, NULL);
-   evas_object_size_hint_weight_set(widget, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
-   evas_object_size_hint_align_set(widget, EVAS_HINT_FILL, EVAS_HINT_FILL);
-   evas_object_show(widget);
+   Edi_Searchpanel_Search ctx;
+   const Edi_Searchpanel_Candidate_File *candidate;
+   Eina_List *files = NULL, *item;
+   const char *literal;
+   Eina_Bool indexed;
 
-   _elm_code = code;
-   _info_widget = widget;
+   if (!_edi_searchpanel_search_prepare(&ctx, thread, job, &literal))
+     return;
 
-   elm_box_pack_end(parent, widget);
-   ecore_event_handler_add(EDI_EVENT_CONFIG_CHANGED, _edi_searchpanel_config_changed_cb, NULL);
+   ctx.previous = job->previous;
+   ctx.found = _edi_searchpanel_candidates_new(job->text, job->flags);
+
+   if (ctx.previous)
+     {
+        EINA_LIST_FOREACH(ctx.previous->files, item, candidate)
+          files = eina_list_append(files, strdup(candidate->path));
+        indexed = EINA_TRUE;
+     }
+   else
+     indexed = literal && edi_search_index_candidates_get(literal, &files);
+
+   if (_edi_searchpanel_search_run(&ctx, directory, indexed, files))
+     job->found = ctx.found;
+   else
+     _edi_searchpanel_candidates_free(ctx.found);
+
+   _edi_searchpanel_search_release(&ctx);
 }
 
+/* Search the changed files again, reporting each one even if it no longer matches. */
 static void
-_edi_taskspanel_line_cb(void *data EINA_UNUSED, const Efl_Event *event)
+_edi_searchpanel_search_update(Ecore_Thread *thread, Edi_Searchpanel_Job *job)
 {
-   Elm_Code_Line *line;
+   Edi_Searchpanel_Search ctx;
+   Eina_List *item, *matches;
+   const char *literal, *path;
 
-   line = (Elm_Code_Line *)event->info;
+   if (!_edi_searchpanel_search_prepare(&ctx, thread, job, &literal))
+     return;
 
-   line->status = ELM_CODE_STATUS_TYPE_TODO;
+   EINA_LIST_FOREACH(job->paths, item, path)
+     {
+        if (ecore_thread_check(thread))
+          break;
+
+        matches = NULL;
+        if (ecore_file_exists(path) && !ecore_file_is_dir(path) &&
+            !edi_walker_path_ignored(_search_walker, path, EINA_FALSE))
+          matches = _edi_searchpanel_search_project_file(path, &ctx);
+
+        _edi_searchpanel_batch_add(ctx.batch, path, matches);
+     }
+
+   _edi_searchpanel_search_release(&ctx);
+}
+
+static void
+_edi_searchpanel_file_rows_add(Elm_Object_Item *it)
+{
+   const Edi_Search_Result_File *file;
+   unsigned int index;
+
+   file = edi_search_results_file_get(_search_results, (uintptr_t) elm_object_item_data_get(it));
+   if (!file)
+     return;
+
+   for (index = file->first; index < file->first + file->count; index++)
+     elm_genlist_item_append(_info_widget, _search_result_itc, (void *)(uintptr_t) index,
+                             it, ELM_GENLIST_ITEM_NONE, NULL, NULL);
+}
+
+static void
+_edi_searchpanel_file_add(const char *path, Eina_List *matches)
+{
+   Edi_Search_Match *match;
+   Elm_Object_Item *it;
+   Eina_List *item;
+   unsigned int id;
+
+   id = edi_search_results_file_add(_search_results, path);
+   EINA_LIST_FOREACH(matches, item, match)
+     edi_search_results_add(_search_results, match->line, match->col, match->offset);
+
+   it = elm_genlist_item_append(_info_widget, _search_file_itc, (void *)(uintptr_t) id,
+                                NULL, ELM_GENLIST_ITEM_TREE, NULL, NULL);
+   eina_inarray_push(_search_items, &it);
+
+   /* Only open the first few files, rows are cheap but not free. */
+   if (_search_expanded < EDI_SEARCHPANEL_EXPAND_MAX)
+     {
+        _search_expanded += eina_list_count(matches);
+        elm_genlist_item_expanded_set(it, EINA_TRUE);
+     }
+}
+
+/* Replace the results of one file, keeping its place in the list. */
+static void
+_edi_searchpanel_file_update(const char *path, Eina_List *matches)
+{
+   Edi_Search_Match *match;
+   Elm_Object_Item **it;
+   Eina_List *item;
+   int id;
+
+   id = edi_search_results_file_find(_search_results, path);
+   if (id < 0)
+     {
+        if (matches)
+          _edi_searchpanel_file_add(path, matches);
+        return;
+     }
+
+   edi_search_results_file_reset(_search_results, id);
+   EINA_LIST_FOREACH(matches, item, match)
+     edi_search_results_add(_search_results, match->line, match->col, match->offset);
+
+   it = eina_inarray_nth(_search_items, id);
+   if (!matches)
+     {
+        if (*it)
+          elm_object_item_del(*it);
+        *it = NULL;
+        return;
+     }
+
+   if (!*it)
+     {
+        *it = elm_genlist_item_append(_info_widget, _search_file_itc, (void *)(uintptr_t) id,
+                                      NULL, ELM_GENLIST_ITEM_TREE, NULL, NULL);
+        return;
+     }
+
+   elm_genlist_item_update(*it);
+   if (elm_genlist_item_expanded_get(*it))
+     {
+        elm_genlist_item_subitems_clear(*it);
+        _edi_searchpanel_file_rows_add(*it);
+     }
+}
+
+/* Rows hold result indices, so after the store moves them each open file is filled again. */
+static void
+_edi_searchpanel_results_compact(void)
+{
+   Elm_Object_Item **it;
+
+   if (!edi_search_results_compact(_search_results))
+     return;
+
+   EINA_INARRAY_FOREACH(_search_items, it)
+     {
+        if (!*it || !elm_genlist_item_expanded_get(*it))
+          continue;
+
+        elm_genlist_item_subitems_clear(*it);
+        _edi_searchpanel_file_rows_add(*it);
+     }
+}
+
+/* Show the files the search thread has found since the last time. */
+static void
+_edi_searchpanel_batch_show(Edi_Searchpanel_Job *job)
+{
+   Edi_Searchpanel_Batch_File *file;
+   Eina_List *files, *item;
+
+   files = _edi_searchpanel_batch_take(job->batch);
+   if (!files)
+     return;
+
+   EINA_LIST_FOREACH(files, item, file)
+     {
+        if (job->paths)
+          _edi_searchpanel_file_update(file->path, file->matches);
+        else
+          _edi_searchpanel_file_add(file->path, file->matches);
+     }
+
+   if (job->paths)
+     _edi_searchpanel_results_compact();
+
+   _edi_searchpanel_batch_files_free(files);
 }
 
 static Eina_Bool
-_edi_taskspanel_config_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *event EINA_UNUSED)
+_edi_searchpanel_batch_timer_cb(void *data)
 {
-   elm_code_widget_font_set(_tasks_widget, _edi_project_config->font.name, _edi_project_config->font.size);
+   Edi_Searchpanel_Batch *batch = data;
+   Edi_Searchpanel_Job *job = batch->data;
+
+   if (_search_thread && !ecore_thread_check(_search_thread))
+     _edi_searchpanel_batch_show(job);
 
    return ECORE_CALLBACK_RENEW;
 }
 
-#define _edi_taskspanel_line_clicked_cb _edi_searchpanel_line_clicked_cb
+static Edi_Searchpanel_Job *
+_edi_searchpanel_job_new(void)
+{
+   Edi_Searchpanel_Job *job;
+
+   job = calloc(1, sizeof(Edi_Searchpanel_Job));
+   job->text = strdup(_search_text);
+   job->flags = _search_flags;
+   job->batch = _edi_searchpanel_batch_new(_edi_searchpanel_batch_timer_cb, job);
+
+   return job;
+}
 
 static void
-_tasks_begin_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+_edi_searchpanel_job_free(Edi_Searchpanel_Job *job)
 {
-   const char *path = data;
+   char *path;
 
-   _edi_searchpanel_search_project(path, "TODO", _tasks_code);
-   if (ecore_thread_check(_search_thread)) return;
-   _edi_searchpanel_search_project(path, "FIXME", _tasks_code);
-   if (ecore_thread_check(_search_thread)) return;
+   _edi_searchpanel_batch_free(job->batch);
+   EINA_LIST_FREE(job->paths, path)
+     free(path);
+   _edi_searchpanel_candidates_free(job->found);
+   free(job->text);
+   free(job);
 }
 
-void
-edi_taskspanel_find(void)
+static void _edi_searchpanel_search_start(void);
+static Eina_Bool _edi_searchpanel_update_timer_cb(void *data);
+
+static void
+_edi_searchpanel_search_done(Edi_Searchpanel_Job *job)
 {
-   const char *path;
-   if (_searching) return;
+   _search_thread = NULL;
 
-   elm_code_file_clear(_tasks_code->file);
+   /* Results gathered while files were changing cannot be trusted for refining. */
+   if (_search_stale)
+     {
+        _edi_searchpanel_candidates_free(_search_candidates);
+        _search_candidates = NULL;
+        _search_stale = EINA_FALSE;
+     }
+   else if (job->found)
+     {
+        _edi_searchpanel_candidates_free(_search_candidates);
+        _search_candidates = job->found;
+        job->found = NULL;
+     }
+   _edi_searchpanel_job_free(job);
+
+   if (_search_pending)
+     _edi_searchpanel_search_start();
+   else if (eina_hash_population(_search_queued) && !_search_timer)
+     _search_timer = ecore_timer_add(EDI_SEARCHPANEL_UPDATE_DELAY, _edi_searchpanel_update_timer_cb, NULL);
+}
 
-   path = edi_project_get();
+static void
+_search_end_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Searchpanel_Job *job = data;
 
-   _search_thread = ecore_thread_feedback_run(_tasks_begin_cb, NULL,
-                                             _search_end_cb, _search_cancel_cb,
-                                             path, EINA_FALSE);
+   _edi_searchpanel_batch_show(job);
+   _edi_searchpanel_search_done(job);
 }
 
-void
-edi_taskspanel_add(Evas_Object *parent)
+static void
+_search_cancel_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
 {
-   Elm_Code_Widget *widget;
-   Elm_Code *code;
-   code = elm_code_create();
-   widget = elm_code_widget_add(parent, code);
-   elm_obj_code_widget_font_set(widget, _edi_project_config->font.name, _edi_project_config->font.size);
-   elm_obj_code_widget_gravity_set(widget, 0.0, 1.0);
-   efl_event_callback_add(widget, &ELM_CODE_EVENT_LINE_LOAD_DONE, _edi_taskspanel_line_cb, NULL);
-   efl_event_callback_add(widget, ELM_OBJ_CODE_WIDGET_EVENT_LINE_CLICKED, _edi_taskspanel_line_clicked_cb, NULL);
-   evas_object_size_hint_weight_set(widget, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
-   evas_object_size_hint_align_set(widget, EVAS_HINT_FILL, EVAS_HINT_FILL);
-   evas_object_show(widget);
+   _edi_searchpanel_search_done(data);
+}
 
-   _tasks_code = code;
-   _tasks_widget = widget;
+static void
+_search_begin_cb(void *data, Ecore_Thread *thread)
+{
+   Edi_Searchpanel_Job *job = data;
+
+   if (job->paths)
+     _edi_searchpanel_search_update(thread, job);
+   else
+     _edi_searchpanel_search_project(thread, edi_project_get(), job);
+}
+
+static void
+_edi_searchpanel_search_start(void)
+{
+   Edi_Searchpanel_Job *job;
+
+   _search_pending = EINA_FALSE;
+
+   job = _edi_searchpanel_job_new();
+   if (_edi_searchpanel_candidates_refine(_search_candidates, job->text, job->flags))
+     job->previous = _search_candidates;
+
+   /* A full search picks up any changes still waiting to be applied. */
+   eina_hash_free_buckets(_search_queued);
+   if (_search_timer)
+     {
+        ecore_timer_del(_search_timer);
+        _search_timer = NULL;
+     }
+
+   elm_genlist_clear(_info_widget);
+   edi_search_results_clear(_search_results);
+   eina_inarray_flush(_search_items);
+   _search_expanded = 0;
+
+   _search_thread = ecore_thread_run(_search_begin_cb, _search_end_cb, _search_cancel_cb, job);
+}
+
+static Eina_Bool
+_edi_searchpanel_update_timer_cb(void *data EINA_UNUSED)
+{
+   Edi_Searchpanel_Job *job;
+   Eina_Iterator *it;
+   const char *path;
+
+   _search_timer = NULL;
+   if (_search_thread || !_search_text)
+     return ECORE_CALLBACK_CANCEL;
+
+   job = _edi_searchpanel_job_new();
+
+   it = eina_hash_iterator_key_new(_search_queued);
+   EINA_ITERATOR_FOREACH(it, path)
+     job->paths = eina_list_append(job->paths, strdup(path));
+   eina_iterator_free(it);
+   eina_hash_free_buckets(_search_queued);
+
+   _search_thread = ecore_thread_run(_search_begin_cb, _search_end_cb, _search_cancel_cb, job);
+
+   return ECORE_CALLBACK_CANCEL;
+}
+
+static void
+_edi_searchpanel_file_queue(const char *path)
+{
+   const char *project;
+   size_t length;
+
+   project = edi_project_get();
+   length = strlen(project);
+   if (!path || strncmp(path, project, length) || path[length] != '/')
+     return;
+
+   /* Any file in the project may now match, or no longer match. */
+   if (_search_thread)
+     {
+        _search_stale = EINA_TRUE;
+     }
+   else
+     {
+        _edi_searchpanel_candidates_free(_search_candidates);
+        _search_candidates = NULL;
+     }
+
+   if (!strcmp(ecore_file_file_get(path), ".gitignore"))
+     {
+        edi_walker_reset(_search_walker);
+        return;
+     }
+
+   /* Nothing to keep current until there has been a search. */
+   if (!_search_text)
+     return;
+
+   if (!eina_hash_find(_search_queued, path))
+     eina_hash_add(_search_queued, path, _search_queued);
+
+   if (_search_timer)
+     ecore_timer_reset(_search_timer);
+   else if (!_search_thread)
+     _search_timer = ecore_timer_add(EDI_SEARCHPANEL_UPDATE_DELAY, _edi_searchpanel_update_timer_cb, NULL);
+}
+
+static Eina_Bool
+_edi_searchpanel_file_saved_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *event)
+{
+   _edi_searchpanel_file_queue(event);
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+static Eina_Bool
+_edi_searchpanel_file_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *event)
+{
+   Eio_Monitor_Event *ev = event;
+
+   _edi_searchpanel_file_queue(ev->filename);
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+void
+edi_searchpanel_find_full(const char *text, Edi_Search_Regex_Flags flags)
+{
+   if (!text || strlen(text) == 0) return;
+
+   if (_search_text) free(_search_text);
+   _search_text = strdup(text);
+   _search_flags = flags;
+
+   /* Start again once the running search has noticed it was cancelled. */
+   if (_search_thread)
+     {
+        _search_pending = EINA_TRUE;
+        ecore_thread_cancel(_search_thread);
+        return;
+     }
+
+   _edi_searchpanel_search_start();
+}
+
+void
+edi_searchpanel_find(const char *text)
+{
+   edi_searchpanel_find_full(text, EDI_SEARCH_REGEX_LITERAL);
+}
+
+void
+edi_searchpanel_locations_show(Eina_List *locations)
+{
+   Edi_Language_Index_Location *location;
+   Edi_Search_Match *match;
+   Eina_List *item, *matches = NULL;
+   const char *path = NULL;
+
+   /* There is no text to search for again when files change. */
+   free(_search_text);
+   _search_text = NULL;
+   _search_pending = EINA_FALSE;
+   if (_search_thread)
+     ecore_thread_cancel(_search_thread);
+
+   eina_hash_free_buckets(_search_queued);
+   if (_search_timer)
+     {
+        ecore_timer_del(_search_timer);
+        _search_timer = NULL;
+     }
+
+   elm_genlist_clear(_info_widget);
+   edi_search_results_clear(_search_results);
+   eina_inarray_flush(_search_items);
+   _search_expanded = 0;
+
+   EINA_LIST_FOREACH(locations, item, location)
+     {
+        if (path && strcmp(path, location->path))
+          {
+             _edi_searchpanel_file_add(path, matches);
+             edi_search_matches_free(matches);
+             matches = NULL;
+          }
+        path = location->path;
+
+        match = calloc(1, sizeof(Edi_Search_Match));
+        match->line = location->line;
+        match->col = location->col;
+        match->offset = location->offset;
+        matches = eina_list_append(matches, match);
+     }
+
+   if (path)
+     _edi_searchpanel_file_add(path, matches);
+   edi_search_matches_free(matches);
+}
+
+static char *
+_edi_searchpanel_file_text_get(void *data, Evas_Object *obj EINA_UNUSED, const char *source EINA_UNUSED)
+{
+   const Edi_Search_Result_File *file;
+   const char *path, *project;
+   char buf[PATH_MAX + 32];
+   size_t length;
+
+   file = edi_search_results_file_get(_search_results, (uintptr_t) data);
+   if (!file)
+     return NULL;
+
+   path = file->path;
+   project = edi_project_get();
+   length = strlen(project);
+   if (!strncmp(path, project, length) && path[length] == '/')
+     path += length + 1;
+
+   snprintf(buf, sizeof(buf), "%s (%u)", path, file->count);
+   return strdup(buf);
+}
+
+/* Only rows on screen are asked for, so the line is read from the file here. */
+static char *
+_edi_searchpanel_result_text_get(void *data, Evas_Object *obj EINA_UNUSED, const char *source EINA_UNUSED)
+{
+   const Edi_Search_Result *result;
+   unsigned int index = (uintptr_t) data, length;
+   char *text, *render;
+
+   result = edi_search_results_get(_search_results, index);
+   if (!result)
+     return NULL;
+
+   text = edi_search_results_text_get(_search_results, index, &length);
+   if (!text)
+     return NULL;
+
+   render = _edi_searchpanel_line_render(text, length, result->line, NULL);
+   free(text);
+
+   return render;
+}
+
+static void
+_edi_searchpanel_expand_request_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info)
+{
+   elm_genlist_item_expanded_set(event_info, EINA_TRUE);
+}
+
+static void
+_edi_searchpanel_contract_request_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info)
+{
+   elm_genlist_item_expanded_set(event_info, EINA_FALSE);
+}
+
+static void
+_edi_searchpanel_expanded_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info)
+{
+   _edi_searchpanel_file_rows_add(event_info);
+}
+
+static void
+_edi_searchpanel_contracted_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info)
+{
+   elm_genlist_item_subitems_clear(event_info);
+}
+
+static void
+_edi_searchpanel_selected_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info)
+{
+   const Edi_Search_Result_File *file;
+   const Edi_Search_Result *result;
+   Elm_Object_Item *it = event_info;
+
+   if (elm_genlist_item_item_class_get(it) == _search_file_itc)
+     {
+        elm_genlist_item_expanded_set(it, !elm_genlist_item_expanded_get(it));
+        return;
+     }
+
+   result = edi_search_results_get(_search_results, (uintptr_t) elm_object_item_data_get(it));
+   if (!result)
+     return;
+   file = edi_search_results_file_get(_search_results, result->file);
+
+   edi_mainview_open_path(file->path);
+   edi_mainview_goto(result->line);
+}
+
+void
+edi_searchpanel_add(Evas_Object *parent)
+{
+   Evas_Object *list;
+
+   _search_results = edi_search_results_new();
+   _search_items = eina_inarray_new(sizeof(Elm_Object_Item *), 64);
+   _search_walker = edi_walker_new(edi_project_get());
+   _search_queued = eina_hash_string_superfast_new(NULL);
+
+   _search_file_itc = elm_genlist_item_class_new();
+   _search_file_itc->item_style = "default";
+   _search_file_itc->func.text_get = _edi_searchpanel_file_text_get;
+
+   _search_result_itc = elm_genlist_item_class_new();
+   _search_result_itc->item_style = "default";
+   _search_result_itc->func.text_get = _edi_searchpanel_result_text_get;
+
+   list = elm_genlist_add(parent);
+   elm_genlist_homogeneous_set(list, EINA_TRUE);
+   elm_genlist_mode_set(list, ELM_LIST_COMPRESS);
+   elm_genlist_select_mode_set(list, ELM_OBJECT_SELECT_MODE_ALWAYS);
+   evas_object_size_hint_weight_set(list, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+   evas_object_size_hint_align_set(list, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   evas_object_smart_callback_add(list, "expand,request", _edi_searchpanel_expand_request_cb, NULL);
+   evas_object_smart_callback_add(list, "contract,request", _edi_searchpanel_contract_request_cb, NULL);
+   evas_object_smart_callback_add(list, "expanded", _edi_searchpanel_expanded_cb, NULL);
+   evas_object_smart_callback_add(list, "contracted", _edi_searchpanel_contracted_cb, NULL);
+   evas_object_smart_callback_add(list, "selected", _edi_searchpanel_selected_cb, NULL);
+   evas_object_show(list);
+
+   _info_widget = list;
+
+   elm_box_pack_end(parent, list);
+   ecore_event_handler_add(EDI_EVENT_FILE_SAVED, _edi_searchpanel_file_saved_cb, NULL);
+   ecore_event_handler_add(EIO_MONITOR_FILE_CREATED, _edi_searchpanel_file_changed_cb, NULL);
+   ecore_event_handler_add(EIO_MONITOR_FILE_MODIFIED, _edi_searchpanel_file_changed_cb, NULL);
+   ecore_event_handler_add(EIO_MONITOR_FILE_DELETED, _edi_searchpanel_file_changed_cb, NULL);
+}
+
+static void
+_edi_taskspanel_line_cb(void *data EINA_UNUSED, const Efl_Event *event)
+{
+   Elm_Code_Line *line;
+
+   line = (Elm_Code_Line *)event->info;
+
+   line->status = ELM_CODE_STATUS_TYPE_TODO;
+}
+
+static Eina_Bool _edi_taskspanel_markers_timer_cb(void *data);
+
+static Eina_Bool
+_edi_taskspanel_config_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *event EINA_UNUSED)
+{
+   elm_code_widget_font_set(_tasks_widget, _edi_project_config->font.name, _edi_project_config->font.size);
+
+   /* The markers are edited a key at a time so wait for typing to pause. */
+   if (_tasks_markers_text != _edi_project_config->tasks.markers)
+     {
+        if (_tasks_markers_timer)
+          ecore_timer_reset(_tasks_markers_timer);
+        else
+          _tasks_markers_timer = ecore_timer_add(EDI_TASKSPANEL_MARKERS_DELAY, _edi_taskspanel_markers_timer_cb, NULL);
+     }
+
+   return ECORE_CALLBACK_RENEW;
+}
+
+#define _edi_taskspanel_line_clicked_cb _edi_searchpanel_line_clicked_cb
+
+/* Rebuild the matcher from the configured markers, only while no tasks thread is using it. */
+static void
+_edi_taskspanel_markers_update(void)
+{
+   const char *markers;
+   char *marker;
+   size_t length;
+
+   if (_tasks_markers_text == _edi_project_config->tasks.markers)
+     return;
+
+   eina_stringshare_replace(&_tasks_markers_text, _edi_project_config->tasks.markers);
+   EINA_LIST_FREE(_tasks_markers, marker)
+     free(marker);
+   edi_search_multi_free(_tasks_multi);
+   _tasks_multi = NULL;
+
+   markers = _tasks_markers_text;
+   while (markers && *markers)
+     {
+        markers += strspn(markers, " \t,");
+        length = strcspn(markers, " \t,");
+        if (!length)
+          break;
+
+        marker = malloc(length + 1);
+        memcpy(marker, markers, length);
+        marker[length] = '\0';
+        _tasks_markers = eina_list_append(_tasks_markers, marker);
+        markers += length;
+     }
+
+   _tasks_multi = edi_search_multi_new(_tasks_markers);
+}
+
+/* Narrow the scan to files the index says may contain any marker. */
+static Eina_Bool
+_edi_taskspanel_candidates_get(Eina_List **files)
+{
+   Eina_List *item, *found, *all = NULL;
+   const char *marker;
+   char *path, *previous = NULL;
+
+   EINA_LIST_FOREACH(_tasks_markers, item, marker)
+     {
+        if (!edi_search_index_candidates_get(marker, &found))
+          {
+             EINA_LIST_FREE(all, path)
+               free(path);
+             return EINA_FALSE;
+          }
+        all = eina_list_merge(all, found);
+     }
+
+   *files = NULL;
+   all = eina_list_sort(all, 0, EINA_COMPARE_CB(strcmp));
+   EINA_LIST_FREE(all, path)
+     {
+        if (previous && !strcmp(previous, path))
+          {
+             free(path);
+             continue;
+          }
+        *files = eina_list_append(*files, path);
+        previous = path;
+     }
+
+   return EINA_TRUE;
+}
+
+static void
+_tasks_begin_cb(void *data, Ecore_Thread *thread)
+{
+   Edi_Searchpanel_Search ctx;
+   Eina_List *files = NULL;
+   Eina_Bool indexed;
+
+   memset(&ctx, 0, sizeof(Edi_Searchpanel_Search));
+   ctx.thread = thread;
+   ctx.batch = data;
+   ctx.multi = _tasks_multi;
+   ctx.summary = EINA_TRUE;
+
+   indexed = _edi_taskspanel_candidates_get(&files);
+   _edi_searchpanel_search_run(&ctx, edi_project_get(), indexed, files);
+}
+
+static void
+_edi_taskspanel_batch_show(Edi_Searchpanel_Batch *batch)
+{
+   Edi_Searchpanel_Batch_File *file;
+   Edi_Search_Match *match;
+   Eina_List *files, *item, *match_item;
+
+   files = _edi_searchpanel_batch_take(batch);
+   EINA_LIST_FOREACH(files, item, file)
+     {
+        EINA_LIST_FOREACH(file->matches, match_item, match)
+          elm_code_file_line_append(_tasks_code->file, match->text, strlen(match->text),
+                                    strdup(file->path));
+     }
+
+   _edi_searchpanel_batch_files_free(files);
+}
+
+static Eina_Bool
+_edi_taskspanel_batch_timer_cb(void *data)
+{
+   if (_tasks_thread && !ecore_thread_check(_tasks_thread))
+     _edi_taskspanel_batch_show(data);
+
+   return ECORE_CALLBACK_RENEW;
+}
+
+typedef struct _Edi_Taskspanel_Update
+{
+   char *path;
+   Eina_List *matches;
+} Edi_Taskspanel_Update;
+
+static void
+_tasks_update_cb(void *data, Ecore_Thread *thread)
+{
+   Eina_List *paths = data, *item;
+   Edi_Taskspanel_Update *update;
+   Edi_Searchpanel_File file;
+   const char *path;
+
+   EINA_LIST_FOREACH(paths, item, path)
+     {
+        if (ecore_thread_check(thread))
+          break;
+
+        memset(&file, 0, sizeof(Edi_Searchpanel_File));
+        file.path = path;
+        file.summary = EINA_TRUE;
+        edi_search_multi_file_scan(_tasks_multi, path, _edi_searchpanel_search_project_line_cb, &file);
+
+        update = malloc(sizeof(Edi_Taskspanel_Update));
+        update->path = strdup(path);
+        update->matches = file.matches;
+        if (!ecore_thread_feedback(thread, update))
+          {
+             edi_search_matches_free(update->matches);
+             free(update->path);
+             free(update);
+          }
+     }
+}
+
+/* Swap the entries of one file for its new matches, keeping their place in the list. */
+static void
+_tasks_update_feedback_cb(void *data EINA_UNUSED, Ecore_Thread *thread EINA_UNUSED, void *msg)
+{
+   Edi_Taskspanel_Update *update = msg;
+   Elm_Code_File *file = _tasks_code->file;
+   Elm_Code_Line *line;
+   Edi_Search_Match *match;
+   Eina_List *item;
+   unsigned int row = 0, count = 0;
+
+   EINA_LIST_FOREACH(file->lines, item, line)
+     {
+        if (!line->data || strcmp(line->data, update->path))
+          continue;
+
+        if (!row)
+          row = line->number;
+        count++;
+     }
+
+   while (count--)
+     {
+        line = elm_code_file_line_get(file, row);
+        free(line->data);
+        line->data = NULL;
+        elm_code_file_line_remove(file, row);
+     }
+
+   if (!row)
+     row = elm_code_file_lines_get(file) + 1;
+
+   EINA_LIST_FOREACH(update->matches, item, match)
+     elm_code_file_line_insert(file, row++, match->text, strlen(match->text), strdup(update->path));
+
+   edi_search_matches_free(update->matches);
+   free(update->path);
+   free(update);
+}
+
+static Eina_Bool _edi_taskspanel_update_timer_cb(void *data);
+
+static void
+_edi_taskspanel_done(void)
+{
+   _tasks_thread = NULL;
+   if (_tasks_rescan)
+     edi_taskspanel_find();
+   else if (eina_hash_population(_tasks_queued) && !_tasks_timer)
+     _tasks_timer = ecore_timer_add(EDI_TASKSPANEL_UPDATE_DELAY, _edi_taskspanel_update_timer_cb, NULL);
+}
+
+static void
+_tasks_end_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Eina_List *paths = data;
+   char *path;
+
+   EINA_LIST_FREE(paths, path)
+     free(path);
+
+   _edi_taskspanel_done();
+}
+
+static void
+_tasks_scan_end_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Searchpanel_Batch *batch = data;
+
+   _edi_taskspanel_batch_show(batch);
+   _edi_searchpanel_batch_free(batch);
+   _edi_taskspanel_done();
+}
+
+static void
+_tasks_scan_cancel_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   _edi_searchpanel_batch_free(data);
+   _edi_taskspanel_done();
+}
+
+static Eina_Bool
+_edi_taskspanel_update_timer_cb(void *data EINA_UNUSED)
+{
+   Eina_Iterator *it;
+   Eina_List *paths = NULL;
+   const char *path;
+
+   _tasks_timer = NULL;
+   if (_tasks_thread || !_tasks_multi)
+     return ECORE_CALLBACK_CANCEL;
+
+   it = eina_hash_iterator_key_new(_tasks_queued);
+   EINA_ITERATOR_FOREACH(it, path)
+     paths = eina_list_append(paths, strdup(path));
+   eina_iterator_free(it);
+   eina_hash_free_buckets(_tasks_queued);
+
+   _tasks_thread = ecore_thread_feedback_run(_tasks_update_cb, _tasks_update_feedback_cb,
+                                             _tasks_end_cb, _tasks_end_cb,
+                                             paths, EINA_FALSE);
+
+   return ECORE_CALLBACK_CANCEL;
+}
+
+static Eina_Bool
+_edi_taskspanel_markers_timer_cb(void *data EINA_UNUSED)
+{
+   _tasks_markers_timer = NULL;
+   edi_taskspanel_find();
+
+   return ECORE_CALLBACK_CANCEL;
+}
+
+static void
+_edi_taskspanel_file_queue(const char *path)
+{
+   const char *project;
+   size_t length;
+
+   project = edi_project_get();
+   length = strlen(project);
+   if (strncmp(path, project, length) || path[length] != '/')
+     return;
+
+   /* Ignore rules can change which files are scanned anywhere below them. */
+   if (!strcmp(ecore_file_file_get(path), ".gitignore"))
+     {
+        edi_walker_reset(_tasks_walker);
+        edi_taskspanel_find();
+        return;
+     }
+
+   if (edi_walker_path_ignored(_tasks_walker, path, EINA_FALSE))
+     return;
+
+   if (!eina_hash_find(_tasks_queued, path))
+     eina_hash_add(_tasks_queued, path, _tasks_queued);
+
+   if (_tasks_timer)
+     ecore_timer_reset(_tasks_timer);
+   else if (!_tasks_thread)
+     _tasks_timer = ecore_timer_add(EDI_TASKSPANEL_UPDATE_DELAY, _edi_taskspanel_update_timer_cb, NULL);
+}
+
+static Eina_Bool
+_edi_taskspanel_file_saved_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *event)
+{
+   const char *path = event;
+
+   if (path)
+     _edi_taskspanel_file_queue(path);
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+static Eina_Bool
+_edi_taskspanel_file_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *event)
+{
+   Eio_Monitor_Event *ev = event;
+
+   _edi_taskspanel_file_queue(ev->filename);
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+void
+edi_taskspanel_find(void)
+{
+   Edi_Searchpanel_Batch *batch;
+   Elm_Code_Line *line;
+   Eina_List *item;
+
+   if (_tasks_thread)
+     {
+        _tasks_rescan = EINA_TRUE;
+        ecore_thread_cancel(_tasks_thread);
+        return;
+     }
+
+   _tasks_rescan = EINA_FALSE;
+   _edi_taskspanel_markers_update();
+
+   /* A full scan picks up any changes still waiting to be applied. */
+   eina_hash_free_buckets(_tasks_queued);
+   if (_tasks_timer)
+     {
+        ecore_timer_del(_tasks_timer);
+        _tasks_timer = NULL;
+     }
+
+   EINA_LIST_FOREACH(_tasks_code->file->lines, item, line)
+     {
+        free(line->data);
+        line->data = NULL;
+     }
+   elm_code_file_clear(_tasks_code->file);
+   if (!_tasks_multi)
+     return;
+
+   batch = _edi_searchpanel_batch_new(_edi_taskspanel_batch_timer_cb, NULL);
+   _tasks_thread = ecore_thread_run(_tasks_begin_cb, _tasks_scan_end_cb, _tasks_scan_cancel_cb, batch);
+}
+
+void
+edi_taskspanel_add(Evas_Object *parent)
+{
+   Elm_Code_Widget *widget;
+   Elm_Code *code;
+   code = elm_code_create();
+   widget = elm_code_widget_add(parent, code);
+   elm_obj_code_widget_font_set(widget, _edi_project_config->font.name, _edi_project_config->font.size);
+   elm_obj_code_widget_gravity_set(widget, 0.0, 1.0);
+   efl_event_callback_add(widget, &ELM_CODE_EVENT_LINE_LOAD_DONE, _edi_taskspanel_line_cb, NULL);
+   efl_event_callback_add(widget, ELM_OBJ_CODE_WIDGET_EVENT_LINE_CLICKED, _edi_taskspanel_line_clicked_cb, NULL);
+   evas_object_size_hint_weight_set(widget, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+   evas_object_size_hint_align_set(widget, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   evas_object_show(widget);
+
+   _tasks_code = code;
+   _tasks_widget = widget;
+
+   _tasks_walker = edi_walker_new(edi_project_get());
+   _tasks_queued = eina_hash_string_superfast_new(NULL);
 
    elm_box_pack_end(parent, widget);
    ecore_event_handler_add(EDI_EVENT_CONFIG_CHANGED, _edi_taskspanel_config_changed_cb, NULL);
+   ecore_event_handler_add(EDI_EVENT_FILE_SAVED, _edi_taskspanel_file_saved_cb, NULL);
+   ecore_event_handler_add(EIO_MONITOR_FILE_CREATED, _edi_taskspanel_file_changed_cb, NULL);
+   ecore_event_handler_add(EIO_MONITOR_FILE_MODIFIED, _edi_taskspanel_file_changed_cb, NULL);
+   ecore_event_handler_add(EIO_MONITOR_FILE_DELETED, _edi_taskspanel_file_changed_cb, NULL);
 
    edi_taskspanel_find();
 }
@@ -3,6 +3,8 @@
 
 #include <Elementary.h>
 
+#include "search/edi_search_regex.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -48,6 +50,26 @@ void edi_searchpanel_show();
  */
 void edi_searchpanel_find(const char *text);
 
+/**
+ * Search in project for a pattern and print results to the panel.
+ *
+ * @param text The pattern to use when parsing project files.
+ * @param flags Options for how the pattern is matched.
+ *
+ * @ingroup UI
+ */
+void edi_searchpanel_find_full(const char *text, Edi_Search_Regex_Flags flags);
+
+/**
+ * Replace the results in the panel with a list of symbol locations.
+ * These are not kept up to date as files change.
+ *
+ * @param locations A list of Edi_Language_Index_Location sorted by file, the caller keeps ownership.
+ *
+ * @ingroup UI
+ */
+void edi_searchpanel_locations_show(Eina_List *locations);
+
 /**
  * Initialise a new Edi taskspanel and add it to the parent pane.
  *
@@ -14,9 +14,15 @@
 #include "edi_config.h"
 
 #include "language/edi_language_provider.h"
+#include "language/edi_language_cache.h"
+#include "search/edi_search_replace.h"
 
 #include "edi_private.h"
 
+#define EDI_EDITOR_SUGGEST_PAGE 50
+#define EDI_EDITOR_HIGHLIGHT_LINES 200
+#define EDI_EDITOR_HIGHLIGHT_MARGIN 50
+
 static Evas_Object *_suggest_hint;
 
 static void _suggest_popup_show(Edi_Editor *editor);
@@ -118,6 +124,12 @@ _edi_editor_file_change_popup(Evas_Object *parent, Edi_Editor *editor)
    evas_object_show(editor->popup);
 }
 
+static void
+_edi_editor_file_saved_free_cb(void *data EINA_UNUSED, void *event)
+{
+   eina_stringshare_del(event);
+}
+
 void
 edi_editor_save(Edi_Editor *editor)
 {
@@ -146,7 +158,8 @@ edi_editor_save(Edi_Editor *editor)
    if (edi_language_provider_has(editor))
      edi_language_provider_get(editor)->refresh(editor);
 
-   ecore_event_add(EDI_EVENT_FILE_SAVED, NULL, NULL, NULL);
+   ecore_event_add(EDI_EVENT_FILE_SAVED, (void *) eina_stringshare_add(filename),
+                   _edi_editor_file_saved_free_cb, NULL);
 }
 
 static Eina_Bool
@@ -169,6 +182,7 @@ _changed_cb(void *data, Evas_Object *obj EINA_UNUSED, void *event_info EINA_UNUS
    Edi_Editor *editor = data;
 
    editor->modified = EINA_TRUE;
+   editor->revision++;
 
    if (editor->save_timer)
      ecore_timer_reset(editor->save_timer);
@@ -266,33 +280,47 @@ _suggest_list_cb_selected(void *data, Evas_Object *obj EINA_UNUSED, void *event_
 }
 
 static void
-_suggest_list_update(Edi_Editor *editor, char *word)
+_suggest_list_more(Edi_Editor *editor)
 {
    Edi_Language_Suggest_Item *suggest_it;
-   Eina_List *l;
    Elm_Genlist_Item_Class *ic;
-   Elm_Object_Item *item;
+   unsigned int i, count;
 
-   elm_genlist_clear(editor->suggest_genlist);
+   count = elm_genlist_items_count(editor->suggest_genlist);
+   if (count >= editor->suggest_count)
+     return;
 
    ic = elm_genlist_item_class_new();
    ic->item_style = "full";
    ic->func.content_get = _suggest_list_content_get;
 
-   EINA_LIST_FOREACH(editor->suggest_list, l, suggest_it)
+   for (i = count; i < editor->suggest_count && i < count + EDI_EDITOR_SUGGEST_PAGE; i++)
      {
-        if (eina_str_has_prefix(suggest_it->summary, word))
-          {
-             elm_genlist_item_append(editor->suggest_genlist,
-                                     ic,
-                                     suggest_it,
-                                     NULL,
-                                     ELM_GENLIST_ITEM_NONE,
-                                     NULL,
-                                     NULL);
-          }
+        suggest_it = edi_language_suggest_index_match_get(editor->suggest_index, i);
+        elm_genlist_item_append(editor->suggest_genlist,
+                                ic,
+                                suggest_it,
+                                NULL,
+                                ELM_GENLIST_ITEM_NONE,
+                                NULL,
+                                NULL);
      }
    elm_genlist_item_class_free(ic);
+}
+
+static void
+_suggest_list_update(Edi_Editor *editor, char *word)
+{
+   Elm_Object_Item *item;
+
+   elm_genlist_clear(editor->suggest_genlist);
+
+   editor->suggest_count = 0;
+   if (editor->suggest_index)
+     editor->suggest_count = edi_language_suggest_index_match(editor->suggest_index, word);
+
+   // Only the best matches are added, more follow as the list is scrolled
+   _suggest_list_more(editor);
 
    item = elm_genlist_first_item_get(editor->suggest_genlist);
    if (item)
@@ -305,9 +333,87 @@ _suggest_list_update(Edi_Editor *editor, char *word)
      evas_object_hide(editor->suggest_bg);
 }
 
+typedef struct _Edi_Editor_Suggest_Job
+{
+   Edi_Editor *editor;
+   Edi_Language_Provider *provider;
+   unsigned int generation;
+   unsigned int row, col;
+   Eina_Bool show;
+
+   Eina_List *items;
+} Edi_Editor_Suggest_Job;
+
+static void _suggest_list_load(Edi_Editor *editor, Eina_Bool show);
+
+static void
+_suggest_list_load_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Editor_Suggest_Job *job = data;
+
+   job->items = job->provider->lookup(job->editor, job->row, job->col);
+}
+
+static void
+_suggest_list_load_cancel_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Editor_Suggest_Job *job = data;
+   Edi_Language_Suggest_Item *suggest_it;
+
+   EINA_LIST_FREE(job->items, suggest_it)
+     edi_language_suggest_item_free(suggest_it);
+
+   free(job);
+}
+
 static void
-_suggest_list_load(Edi_Editor *editor)
+_suggest_list_load_end_cb(void *data, Ecore_Thread *thread)
 {
+   Edi_Editor_Suggest_Job *job = data;
+   Edi_Editor *editor = job->editor;
+   char *curword;
+   unsigned int row, col;
+   Eina_Bool show;
+
+   editor->suggest_thread = NULL;
+
+   elm_code_widget_cursor_position_get(editor->entry, &row, &col);
+   curword = _edi_editor_word_at_position_get(editor, row, col);
+
+   // Drop the results if they were asked for again or the cursor has moved to another word
+   if (job->generation != editor->suggest_generation ||
+       row != job->row || col - strlen(curword) != job->col)
+     {
+        free(curword);
+        _suggest_list_load_cancel_cb(job, thread);
+     }
+   else
+     {
+        edi_language_suggest_index_free(editor->suggest_index);
+        editor->suggest_index = edi_language_suggest_index_new(job->items);
+        editor->suggest_count = 0;
+
+        if (job->show)
+          _suggest_list_update(editor, curword);
+        free(curword);
+        free(job);
+     }
+
+   if (editor->suggest_pending)
+     {
+        show = editor->suggest_pending_show;
+        editor->suggest_pending = EINA_FALSE;
+        editor->suggest_pending_show = EINA_FALSE;
+        _suggest_list_load(editor, show);
+     }
+}
+
+/* Look up the suggestions at the cursor in a thread, with show set the list
+ * is popped up when they arrive. Only the latest request is shown. */
+static void
+_suggest_list_load(Edi_Editor *editor, Eina_Bool show)
+{
+   Edi_Editor_Suggest_Job *job;
    Edi_Language_Provider *provider;
    char *curword;
    unsigned int row, col;
@@ -319,21 +425,29 @@ _suggest_list_load(Edi_Editor *editor)
    if (!provider || !provider->lookup)
      return;
 
-   if (editor->suggest_list)
+   editor->suggest_generation++;
+   if (editor->suggest_thread)
      {
-        Edi_Language_Suggest_Item *suggest_it;
-
-        EINA_LIST_FREE(editor->suggest_list, suggest_it)
-          edi_language_suggest_item_free(suggest_it);
-
-        editor->suggest_list = NULL;
+        // Looked up again for the cursor at the time the running lookup ends
+        editor->suggest_pending = EINA_TRUE;
+        editor->suggest_pending_show |= show;
+        return;
      }
 
    elm_code_widget_cursor_position_get(editor->entry, &row, &col);
-
    curword = _edi_editor_word_at_position_get(editor, row, col);
-   editor->suggest_list = provider->lookup(editor, row, col - strlen(curword));
+
+   job = calloc(1, sizeof(Edi_Editor_Suggest_Job));
+   job->editor = editor;
+   job->provider = provider;
+   job->generation = editor->suggest_generation;
+   job->row = row;
+   job->col = col - strlen(curword);
+   job->show = show;
    free(curword);
+
+   editor->suggest_thread = ecore_thread_run(_suggest_list_load_cb, _suggest_list_load_end_cb,
+                                             _suggest_list_load_cancel_cb, job);
 }
 
 static void
@@ -393,6 +507,11 @@ _suggest_list_cb_key_down(void *data, Evas *e EINA_UNUSED, Evas_Object *obj,
    else if (!strcmp(ev->key, "Down"))
      {
         it = elm_genlist_item_next_get(elm_genlist_selected_item_get(genlist));
+        if (!it)
+          {
+             _suggest_list_more(editor);
+             it = elm_genlist_item_next_get(elm_genlist_selected_item_get(genlist));
+          }
         if(!it) it = elm_genlist_first_item_get(genlist);
 
         elm_genlist_item_selected_set(it, EINA_TRUE);
@@ -414,6 +533,15 @@ _suggest_list_cb_clicked_double(void *data, Evas_Object *obj EINA_UNUSED,
    evas_object_hide(editor->suggest_bg);
 }
 
+static void
+_suggest_list_cb_edge_bottom(void *data, Evas_Object *obj EINA_UNUSED,
+                             void *event_info EINA_UNUSED)
+{
+   Edi_Editor *editor = (Edi_Editor *)data;
+
+   _suggest_list_more(editor);
+}
+
 static void
 _suggest_popup_show(Edi_Editor *editor)
 {
@@ -561,6 +689,8 @@ _suggest_popup_setup(Edi_Editor *editor)
                                   _suggest_list_cb_key_down, editor);
    evas_object_smart_callback_add(genlist, "clicked,double",
                                   _suggest_list_cb_clicked_double, editor);
+   evas_object_smart_callback_add(genlist, "edge,bottom",
+                                  _suggest_list_cb_edge_bottom, editor);
    evas_object_show(genlist);
    elm_box_pack_end(box, genlist);
 
@@ -705,21 +835,10 @@ _suggest_hint_show_snippet(Edi_Editor *editor, const char *word)
 Edi_Language_Suggest_Item *
 _suggest_match_get(Edi_Editor *editor, const char *word)
 {
-   Edi_Language_Suggest_Item *suggest_it;
-   unsigned int wordlen;
-
-   Eina_List *l, *list = editor->suggest_list;
-
-   wordlen = strlen(word);
-   EINA_LIST_FOREACH(list, l, suggest_it)
-     {
-        if (strlen(suggest_it->summary) <= wordlen)
-          continue;
-        if (eina_str_has_prefix(suggest_it->summary, word))
-          return suggest_it;
-     }
+   if (!editor->suggest_index)
+     return NULL;
 
-   return NULL;
+   return edi_language_suggest_index_prefix_find(editor->suggest_index, word);
 }
 
 static void
@@ -802,8 +921,7 @@ _smart_cb_key_down(void *data EINA_UNUSED, Evas *e EINA_UNUSED,
           }
         else if (edi_language_provider_has(editor) && !strcmp(ev->key, "space"))
           {
-             _suggest_list_load(editor);
-             _suggest_list_update(editor, _edi_editor_current_word_get(editor));
+             _suggest_list_load(editor, EINA_TRUE);
           }
      }
    else if ((!alt) && (ctrl) && (shift))
@@ -813,6 +931,14 @@ _smart_cb_key_down(void *data EINA_UNUSED, Evas *e EINA_UNUSED,
              edi_editor_doc_open(editor);
           }
      }
+   else if ((!alt) && (!ctrl) && edi_language_provider_has(editor) && !strcmp(ev->key, "F12"))
+     {
+        if (shift)
+          edi_editor_references_find(editor);
+        else
+          edi_editor_definition_goto(editor);
+        return;
+     }
 
    if (alt || ctrl)
      return;
@@ -959,26 +1085,145 @@ _edi_editor_statusbar_add(Evas_Object *panel, Edi_Editor *editor, Edi_Mainview_I
 }
 
 #if HAVE_LIBCLANG
+typedef struct
+{
+   Edi_Range range;
+   Elm_Code_Token_Type type;
+} Edi_Range_Color;
+
+/* Whether a token was added by a clang pass rather than the syntax parser or a search */
+static Eina_Bool
+_clang_token_is(Elm_Code_Line *line, Elm_Code_Token *token)
+{
+   const char *text;
+   unsigned int length;
+
+   switch (token->type)
+     {
+      case ELM_CODE_TOKEN_TYPE_CLASS:
+      case ELM_CODE_TOKEN_TYPE_FUNCTION:
+      case ELM_CODE_TOKEN_TYPE_TYPE:
+         return EINA_TRUE;
+      case ELM_CODE_TOKEN_TYPE_PREPROCESSOR:
+         // The syntax parser marks directives from their '#', clang marks the names in them
+         text = elm_code_line_text_get(line, &length);
+         return token->start >= 0 && (unsigned int) token->start < length && text[token->start] != '#';
+      default:
+         return EINA_FALSE;
+     }
+}
+
+/* Drop the colours an earlier clang pass gave a line, returns whether there were any */
+static Eina_Bool
+_clang_line_tokens_clear(Elm_Code_Line *line)
+{
+   Elm_Code_Token *token;
+   Eina_List *item, *next;
+   Eina_Bool cleared = EINA_FALSE;
+
+   EINA_LIST_FOREACH_SAFE(line->tokens, item, next, token)
+     {
+        if (!_clang_token_is(line, token))
+          continue;
+
+        line->tokens = eina_list_remove_list(line->tokens, item);
+        free(token);
+        cleared = EINA_TRUE;
+     }
+
+   return cleared;
+}
+
+/* Colour the ranges, replacing the clang colours of the lines from clear_first
+ * to clear_last so that a new pass does not pile up on the last one. */
 static void
-_edi_range_color_set(Edi_Editor *editor, Edi_Range range, Elm_Code_Token_Type type)
+_edi_range_colors_apply(Edi_Editor *editor, Eina_Inarray *colors, unsigned int clear_first,
+                        unsigned int clear_last)
 {
    Elm_Code *code;
-   Elm_Code_Line *line, *extra_line;
-   unsigned int number;
+   Elm_Code_Line *line;
+   Edi_Range_Color *color;
+   unsigned int number, first = 0, last = 0;
+
+   if (!eina_inarray_count(colors) && !clear_first)
+     return;
 
    ecore_thread_main_loop_begin();
 
+   // An edit has reset the lines, these colours are out of date
+   if (editor->highlight_cancel)
+     {
+        ecore_thread_main_loop_end();
+        eina_inarray_flush(colors);
+        return;
+     }
+
    code = elm_code_widget_code_get(editor->entry);
-   line = elm_code_file_line_get(code->file, range.start.line);
+   for (number = clear_first; clear_first && number <= clear_last; number++)
+     {
+        line = elm_code_file_line_get(code->file, number);
+        if (!line || !_clang_line_tokens_clear(line))
+          continue;
 
-   elm_code_line_token_add(line, range.start.col - 1, range.end.col - 2,
-                           range.end.line - range.start.line + 1, type);
+        if (!first || number < first)
+          first = number;
+        if (number > last)
+          last = number;
+     }
 
-   elm_code_widget_line_refresh(editor->entry, line);
-   for (number = line->number + 1; number <= range.end.line; number++)
+   EINA_INARRAY_FOREACH(colors, color)
+     {
+        line = elm_code_file_line_get(code->file, color->range.start.line);
+        if (!line)
+          continue;
+
+        elm_code_line_token_add(line, color->range.start.col - 1, color->range.end.col - 2,
+                                color->range.end.line - color->range.start.line + 1, color->type);
+
+        if (!first || color->range.start.line < first)
+          first = color->range.start.line;
+        if (color->range.end.line > last)
+          last = color->range.end.line;
+     }
+
+   // Redraw each line once, however many tokens it gained
+   for (number = first; first && number <= last; number++)
+     {
+        line = elm_code_file_line_get(code->file, number);
+        if (line)
+          elm_code_widget_line_refresh(editor->entry, line);
+     }
+
+   ecore_thread_main_loop_end();
+   eina_inarray_flush(colors);
+}
+
+/* Clear the diagnostics an earlier clang pass left on the lines, keeping other statuses such as TODO */
+static void
+_clang_line_statuses_clear(Edi_Editor *editor)
+{
+   Elm_Code *code;
+   Elm_Code_Line *line;
+   Eina_List *item;
+
+   ecore_thread_main_loop_begin();
+
+   code = elm_code_widget_code_get(editor->entry);
+   EINA_LIST_FOREACH(code->file->lines, item, line)
      {
-        extra_line = elm_code_file_line_get(code->file, number);
-        elm_code_widget_line_refresh(editor->entry, extra_line);
+        switch (line->status)
+          {
+           case ELM_CODE_STATUS_TYPE_IGNORED:
+           case ELM_CODE_STATUS_TYPE_NOTE:
+           case ELM_CODE_STATUS_TYPE_WARNING:
+           case ELM_CODE_STATUS_TYPE_ERROR:
+           case ELM_CODE_STATUS_TYPE_FATAL:
+              elm_code_line_status_clear(line);
+              elm_code_widget_line_refresh(editor->entry, line);
+              break;
+           default:
+              break;
+          }
      }
 
    ecore_thread_main_loop_end();
@@ -1014,142 +1259,193 @@ _edi_line_status_set(Edi_Editor *editor, unsigned int number, Elm_Code_Status_Ty
 }
 
 static void
-_clang_load_highlighting(const char *path, Edi_Editor *editor)
+_clang_viewport_get(Edi_Editor *editor, unsigned int *top, unsigned int *bottom)
 {
-        CXFile cfile = clang_getFile(editor->clang_unit, path);
+   Evas_Coord x, y, w, h;
+   int col;
 
-        CXSourceRange range = clang_getRange(
-              clang_getLocationForOffset(editor->clang_unit, cfile, 0),
-              clang_getLocationForOffset(editor->clang_unit, cfile, ecore_file_size(path)));
+   ecore_thread_main_loop_begin();
+
+   evas_object_geometry_get(editor->entry, &x, &y, &w, &h);
+   if (!elm_code_widget_position_at_coordinates_get(editor->entry, x + 1, y + 1, top, &col))
+     *top = 1;
+   if (!elm_code_widget_position_at_coordinates_get(editor->entry, x + 1, y + h - 1, bottom, &col))
+     *bottom = *top;
 
-        clang_tokenize(editor->clang_unit, range, &editor->tokens, &editor->token_count);
-        editor->cursors = (CXCursor *) malloc(editor->token_count * sizeof(CXCursor));
-        clang_annotateTokens(editor->clang_unit, editor->tokens, editor->token_count, editor->cursors);
+   ecore_thread_main_loop_end();
 }
 
+static unsigned int
+_clang_line_count_get(Edi_Editor *editor)
+{
+   Elm_Code *code;
+   unsigned int count;
+
+   ecore_thread_main_loop_begin();
+
+   code = elm_code_widget_code_get(editor->entry);
+   count = elm_code_file_lines_get(code->file);
+
+   ecore_thread_main_loop_end();
+
+   return count;
+}
+
+/* Colour the tokens that were added to the results after the first ones,
+ * in place of what the last pass found on the lines from first_line to last_line */
 static void
-_clang_show_highlighting(Edi_Editor *editor)
+_clang_show_tokens(Edi_Editor *editor, Edi_Language_Cache *results, unsigned int first,
+                   unsigned int first_line, unsigned int last_line, Eina_Inarray *colors)
 {
-   unsigned int i = 0;
+   Edi_Language_Cache_Token *token;
+   Edi_Range_Color color;
+   unsigned int i;
 
-   for (i = 0 ; i < editor->token_count ; i++)
+   for (i = first; i < eina_inarray_count(results->tokens); i++)
      {
-        Edi_Range range;
-        Elm_Code_Token_Type type = ELM_CODE_TOKEN_TYPE_DEFAULT;
-
-        CXSourceRange tkrange = clang_getTokenExtent(editor->clang_unit, editor->tokens[i]);
-        clang_getSpellingLocation(clang_getRangeStart(tkrange), NULL,
-              &range.start.line, &range.start.col, NULL);
-        clang_getSpellingLocation(clang_getRangeEnd(tkrange), NULL,
-              &range.end.line, &range.end.col, NULL);
-        /* FIXME: Should probably do something fancier, this is only a limited
-         * number of types. */
-        switch (clang_getTokenKind(editor->tokens[i]))
-          {
-             case CXToken_Punctuation:
-                break;
-             case CXToken_Identifier:
-                if (editor->cursors[i].kind < CXCursor_FirstRef)
-                  {
-                      type = ELM_CODE_TOKEN_TYPE_CLASS;
-                      break;
-                  }
-                switch (editor->cursors[i].kind)
-                  {
-                   case CXCursor_DeclRefExpr:
-                      /* Handle different ref kinds */
-                      type = ELM_CODE_TOKEN_TYPE_FUNCTION;
-                      break;
-                   case CXCursor_MacroDefinition:
-                   case CXCursor_InclusionDirective:
-                   case CXCursor_PreprocessingDirective:
-                   case CXCursor_MacroExpansion:
-                      type = ELM_CODE_TOKEN_TYPE_PREPROCESSOR;
-                      break;
-                   case CXCursor_TypeRef:
-                      type = ELM_CODE_TOKEN_TYPE_TYPE;
-                      break;
-                   default:
-                      break;
-                  }
-                break;
-             case CXToken_Keyword:
-             case CXToken_Literal:
-             case CXToken_Comment:
-                break;
-          }
+        token = eina_inarray_nth(results->tokens, i);
+        color.range.start.line = token->start_line;
+        color.range.start.col = token->start_col;
+        color.range.end.line = token->end_line;
+        color.range.end.col = token->end_col;
+        color.type = token->type;
+        eina_inarray_push(colors, &color);
+     }
 
-        if (editor->highlight_cancel)
-          break;
-        if (type != ELM_CODE_TOKEN_TYPE_DEFAULT)
-          _edi_range_color_set(editor, range, type);
+   _edi_range_colors_apply(editor, colors, first_line, last_line);
+}
+
+static void
+_clang_show_highlighting_chunk(Edi_Editor *editor, unsigned int chunk, Eina_Inarray *colors,
+                               Edi_Language_Cache *results)
+{
+   unsigned int count, first_line, last_line;
+
+   count = eina_inarray_count(results->tokens);
+   first_line = chunk * EDI_EDITOR_HIGHLIGHT_LINES + 1;
+   last_line = (chunk + 1) * EDI_EDITOR_HIGHLIGHT_LINES;
+   if (!edi_language_c_highlight_get(editor, first_line, last_line, results))
+     return;
+
+   if (!editor->highlight_cancel)
+     _clang_show_tokens(editor, results, count, first_line, last_line, colors);
+}
+
+/* The chunk still to be shown that is closest to the viewport, looking down first. */
+static int
+_clang_highlighting_chunk_next(Edi_Editor *editor, const Eina_Bool *done, unsigned int chunks)
+{
+   unsigned int top, bottom, start, distance;
+
+   _clang_viewport_get(editor, &top, &bottom);
+   start = (top - 1) / EDI_EDITOR_HIGHLIGHT_LINES;
+
+   // The viewport can start past the last line, look up from the last chunk then
+   if (start >= chunks)
+     start = chunks - 1;
+
+   for (distance = 0; distance < chunks; distance++)
+     {
+        if (start + distance < chunks && !done[start + distance])
+          return start + distance;
+        if (distance && distance <= start && !done[start - distance])
+          return start - distance;
      }
+
+   return -1;
 }
 
 static void
-_clang_free_highlighting(Edi_Editor *editor)
+_clang_show_highlighting(Edi_Editor *editor, Edi_Language_Cache *results)
 {
-   free(editor->cursors);
-   clang_disposeTokens(editor->clang_unit, editor->tokens, editor->token_count);
+   Eina_Inarray *colors;
+   Eina_Bool *done;
+   unsigned int lines, chunks, chunk, first, last, top, bottom;
+   int next;
+
+   lines = _clang_line_count_get(editor);
+   if (!lines)
+     return;
+
+   _clang_viewport_get(editor, &top, &bottom);
+
+   colors = eina_inarray_new(sizeof(Edi_Range_Color), 256);
+   chunks = (lines + EDI_EDITOR_HIGHLIGHT_LINES - 1) / EDI_EDITOR_HIGHLIGHT_LINES;
+   done = calloc(chunks, sizeof(Eina_Bool));
+
+   // The lines being looked at, plus a margin either side, are coloured first
+   first = top > EDI_EDITOR_HIGHLIGHT_MARGIN ? top - EDI_EDITOR_HIGHLIGHT_MARGIN : 1;
+   last = bottom + EDI_EDITOR_HIGHLIGHT_MARGIN;
+   if (last > lines)
+     last = lines;
+
+   for (chunk = (first - 1) / EDI_EDITOR_HIGHLIGHT_LINES;
+        first <= last && chunk <= (last - 1) / EDI_EDITOR_HIGHLIGHT_LINES && !editor->highlight_cancel; chunk++)
+     {
+        _clang_show_highlighting_chunk(editor, chunk, colors, results);
+        done[chunk] = EINA_TRUE;
+     }
+
+   while (!editor->highlight_cancel)
+     {
+        next = _clang_highlighting_chunk_next(editor, done, chunks);
+        if (next < 0)
+          break;
+
+        _clang_show_highlighting_chunk(editor, next, colors, results);
+        done[next] = EINA_TRUE;
+     }
+
+   free(done);
+   eina_inarray_free(colors);
 }
 
 static void
-_clang_load_errors(Edi_Editor *editor)
+_clang_load_errors(Edi_Editor *editor, Edi_Language_Cache *results)
 {
-   Elm_Code *code;
-   const char *filename;
-   unsigned n = clang_getNumDiagnostics(editor->clang_unit);
-   unsigned i = 0;
+   Edi_Language_Cache_Status *status;
+   unsigned int i, first;
 
-   ecore_thread_main_loop_begin();
-   code = elm_code_widget_code_get(editor->entry);
-   filename = elm_code_file_path_get(code->file);
-   ecore_thread_main_loop_end();
+   first = eina_inarray_count(results->statuses);
+   if (!edi_language_c_diagnostics_get(editor, results))
+     return;
 
-   for(i = 0, n = clang_getNumDiagnostics(editor->clang_unit); i != n; ++i)
+   _clang_line_statuses_clear(editor);
+   for (i = first; i < eina_inarray_count(results->statuses); i++)
      {
-        CXDiagnostic diag = clang_getDiagnostic(editor->clang_unit, i);
-        CXFile file;
-        unsigned int line;
-        CXString path;
+        if (editor->highlight_cancel)
+          break;
 
-        // the parameter after line would be a caret position but we're just highlighting for now
-        clang_getSpellingLocation(clang_getDiagnosticLocation(diag), &file, &line, NULL, NULL);
+        status = eina_inarray_nth(results->statuses, i);
+        _edi_line_status_set(editor, status->line, status->type, status->text);
+     }
+}
 
-        path = clang_getFileName(file);
-        if (!clang_getCString(path) || strcmp(filename, clang_getCString(path)))
-          continue;
+/* Show the results saved the last time the file was parsed, while it is parsed again */
+static void
+_clang_show_cached(Edi_Editor *editor, const char *path, const char *args)
+{
+   Edi_Language_Cache *cache;
+   Edi_Language_Cache_Status *status;
+   Eina_Inarray *colors;
 
-        /* FIXME: Also handle ranges and fix suggestions. */
-        Elm_Code_Status_Type status = ELM_CODE_STATUS_TYPE_DEFAULT;
+   cache = edi_language_cache_load(path, args);
+   if (!cache)
+     return;
 
-        switch (clang_getDiagnosticSeverity(diag))
-          {
-           case CXDiagnostic_Ignored:
-              status = ELM_CODE_STATUS_TYPE_IGNORED;
-              break;
-           case CXDiagnostic_Note:
-              status = ELM_CODE_STATUS_TYPE_NOTE;
-              break;
-           case CXDiagnostic_Warning:
-              status = ELM_CODE_STATUS_TYPE_WARNING;
-              break;
-           case CXDiagnostic_Error:
-              status = ELM_CODE_STATUS_TYPE_ERROR;
-              break;
-           case CXDiagnostic_Fatal:
-              status = ELM_CODE_STATUS_TYPE_FATAL;
-              break;
-          }
-        CXString str = clang_getDiagnosticSpelling(diag);
-        if (status != ELM_CODE_STATUS_TYPE_DEFAULT)
-          _edi_line_status_set(editor, line, status, clang_getCString(str));
-        clang_disposeString(str);
+   colors = eina_inarray_new(sizeof(Edi_Range_Color), eina_inarray_count(cache->tokens) + 1);
+   _clang_show_tokens(editor, cache, 0, 1, _clang_line_count_get(editor), colors);
+   eina_inarray_free(colors);
 
-        clang_disposeDiagnostic(diag);
+   _clang_line_statuses_clear(editor);
+   EINA_INARRAY_FOREACH(cache->statuses, status)
+     {
         if (editor->highlight_cancel)
           break;
+        _edi_line_status_set(editor, status->line, status->type, status->text);
      }
+
+   edi_language_cache_free(cache);
 }
 
 static void
@@ -1157,19 +1453,53 @@ _edi_clang_setup(void *data, Ecore_Thread *thread EINA_UNUSED)
 {
    Edi_Editor *editor;
    Elm_Code *code;
-   const char *path;
+   Edi_Language_Cache *results;
+   Eina_List *includes = NULL;
+   const char *path, *args = NULL;
+   unsigned int revision;
+   Eina_Bool ready, save;
 
    ecore_thread_main_loop_begin();
 
    editor = (Edi_Editor *)data;
    code = elm_code_widget_code_get(editor->entry);
    path = elm_code_file_path_get(code->file);
+   ready = edi_language_c_unit_ready(editor);
+   revision = editor->revision;
+
+   // Results are only kept for the file as it is on disk
+   if (!editor->modified && (ready || !editor->clang_cache_loaded) &&
+       edi_language_c_unit_depends_get(editor, &args, ready ? &includes : NULL))
+     editor->clang_cache_loaded = EINA_TRUE;
 
    ecore_thread_main_loop_end();
 
-   _clang_load_errors(editor);
-   _clang_load_highlighting(path, editor);
-   _clang_show_highlighting(editor);
+   // The file is still being parsed, this runs again once it is ready
+   if (!ready)
+     {
+        if (args)
+          _clang_show_cached(editor, path, args);
+        eina_stringshare_del(args);
+        return;
+     }
+
+   results = edi_language_cache_new();
+   _clang_show_highlighting(editor, results);
+   _clang_load_errors(editor, results);
+
+   if (args)
+     {
+        ecore_thread_main_loop_begin();
+        save = !editor->highlight_cancel && !editor->modified && editor->revision == revision;
+        ecore_thread_main_loop_end();
+
+        if (save)
+          edi_language_cache_save(path, args, includes, results);
+     }
+   edi_language_cache_free(results);
+
+   eina_stringshare_del(args);
+   edi_language_cache_includes_free(includes);
 }
 
 static void
@@ -1177,10 +1507,14 @@ _edi_clang_dispose(void *data, Ecore_Thread *thread EINA_UNUSED)
 {
    Edi_Editor *editor = (Edi_Editor *)data;
 
-   _clang_free_highlighting(editor);
-
    editor->highlight_thread = NULL;
    editor->highlight_cancel = EINA_FALSE;
+
+   if (editor->highlight_again)
+     {
+        editor->highlight_again = EINA_FALSE;
+        editor->highlight_thread = ecore_thread_run(_edi_clang_setup, _edi_clang_dispose, NULL, editor);
+     }
 }
 #endif
 
@@ -1272,6 +1606,8 @@ _edi_editor_parse_line_cb(Elm_Code_Line *line EINA_UNUSED, void *data)
 {
    Edi_Editor *editor = (Edi_Editor *)data;
 
+   editor->revision++;
+
    // We have caused a reset in the file parser, if it is active
    if (!editor->highlight_thread)
      return;
@@ -1294,7 +1630,28 @@ _edi_editor_parse_file_cb(Elm_Code_File *file EINA_UNUSED, void *data)
 #endif
 
    if (edi_language_provider_has(editor))
-     _suggest_list_load(editor);
+     _suggest_list_load(editor, EINA_FALSE);
+}
+
+void
+edi_editor_language_parsed(Edi_Editor *editor)
+{
+#if HAVE_LIBCLANG
+   if (editor->highlight_thread)
+     {
+        // Start again once the current pass has stopped
+        editor->highlight_cancel = EINA_TRUE;
+        editor->highlight_again = EINA_TRUE;
+     }
+   else
+     {
+        editor->highlight_cancel = EINA_FALSE;
+        editor->highlight_thread = ecore_thread_run(_edi_clang_setup, _edi_clang_dispose, NULL, editor);
+     }
+#endif
+
+   if (edi_language_provider_has(editor))
+     _suggest_list_load(editor, EINA_FALSE);
 }
 
 static Eina_Bool
@@ -1331,8 +1688,14 @@ _editor_del_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *o, void *event_info
 
    ecore_event_handler_del(ev_handler);
 
+   if (editor->suggest_thread)
+     ecore_thread_cancel(editor->suggest_thread);
+
    if (edi_language_provider_has(editor))
      edi_language_provider_get(editor)->del(editor);
+
+   edi_language_suggest_index_free(editor->suggest_index);
+   editor->suggest_index = NULL;
 }
 
 void
@@ -1360,6 +1723,108 @@ edi_editor_reload(Edi_Editor *editor)
    ecore_thread_main_loop_end();
 }
 
+static size_t
+_edi_editor_line_length(const char *text)
+{
+   size_t length;
+
+   length = strlen(text);
+   if (length && text[length - 1] == '\r')
+     length--;
+
+   return length;
+}
+
+static Eina_Bool
+_edi_editor_line_matches(Elm_Code_Line *line, const char *expected, unsigned int expected_length)
+{
+   const char *text;
+   unsigned int length;
+
+   text = elm_code_line_text_get(line, &length);
+   return length == expected_length && (!length || !memcmp(text, expected, length));
+}
+
+/* The line holding the text that is closest to the line number, edits may have moved it */
+static Elm_Code_Line *
+_edi_editor_line_find(Elm_Code_File *file, unsigned int number, const char *expected)
+{
+   Elm_Code_Line *line;
+   unsigned int distance, count, length;
+
+   length = _edi_editor_line_length(expected);
+   count = elm_code_file_lines_get(file);
+   for (distance = 0; distance < count; distance++)
+     {
+        if (number + distance <= count)
+          {
+             line = elm_code_file_line_get(file, number + distance);
+             if (line && _edi_editor_line_matches(line, expected, length))
+               return line;
+          }
+        if (distance && distance < number)
+          {
+             line = elm_code_file_line_get(file, number - distance);
+             if (line && _edi_editor_line_matches(line, expected, length))
+               return line;
+          }
+        if (number + distance > count && distance >= number)
+          break;
+     }
+
+   return NULL;
+}
+
+unsigned int
+edi_editor_line_replace(Edi_Editor *editor, unsigned int number, const char *before, const char *after)
+{
+   Elm_Code *code;
+   Elm_Code_Line *line;
+   const char *text;
+   char *insert;
+   unsigned int length, after_length;
+   unsigned int row, col, start;
+   size_t prefix, suffix;
+
+   code = elm_code_widget_code_get(editor->entry);
+   line = _edi_editor_line_find(code->file, number, before);
+   if (!line)
+     return 0;
+
+   number = line->number;
+   text = elm_code_line_text_get(line, &length);
+
+   // Only touch the part of the line that differs, so the undo step is small
+   after_length = _edi_editor_line_length(after);
+   edi_search_replace_line_diff(text, length, after, after_length, &prefix, &suffix);
+
+   if (prefix == length && prefix == after_length)
+     return number;
+
+   elm_code_widget_cursor_position_get(editor->entry, &row, &col);
+   elm_code_widget_selection_clear(editor->entry);
+
+   start = elm_code_widget_line_text_column_width_to_position(editor->entry, line, prefix);
+   if (length - suffix > prefix)
+     {
+        elm_code_widget_selection_start(editor->entry, number, start);
+        elm_code_widget_selection_end(editor->entry, number,
+           elm_code_widget_line_text_column_width_to_position(editor->entry, line, length - suffix) - 1);
+        elm_code_widget_selection_delete(editor->entry);
+     }
+
+   if (after_length - suffix > prefix)
+     {
+        insert = strndup(after + prefix, after_length - suffix - prefix);
+        elm_code_widget_cursor_position_set(editor->entry, number, start);
+        elm_code_widget_text_at_cursor_insert(editor->entry, insert);
+        free(insert);
+     }
+
+   elm_code_widget_cursor_position_set(editor->entry, row, col);
+   return number;
+}
+
 Evas_Object *
 edi_editor_add(Evas_Object *parent, Edi_Mainview_Item *item)
 {
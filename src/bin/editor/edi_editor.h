@@ -1,15 +1,12 @@
 #ifndef _EDI_EDITOR_H
 #define _EDI_EDITOR_H
 
-#if HAVE_LIBCLANG
-#include <clang-c/Index.h>
-#include <clang-c/Documentation.h>
-#endif
 #include <time.h>
 
 #include <Evas.h>
 
 #include "mainview/edi_mainview_item.h"
+#include "language/edi_language_suggest.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -44,24 +41,30 @@ struct _Edi_Editor
    Evas_Object *doc_popup; /**< The popup for documentation */
    Evas_Object *popup;
    Eina_List *undo_stack; /**< The list of operations that can be undone */
-   Eina_List *suggest_list; /**< The list of all possible suggestions for the file */
+   Edi_Language_Suggest_Index *suggest_index; /**< All possible suggestions at the cursor, ranked as the word is typed */
 
    /* Private */
    Edi_Editor_Search *search;
+   unsigned int suggest_count;
+   Ecore_Thread *suggest_thread;
+   unsigned int suggest_generation;
+   Eina_Bool suggest_pending;
+   Eina_Bool suggest_pending_show;
+   unsigned int revision;
    Eina_Bool modified;
    Ecore_Timer *save_timer;
 
 #if HAVE_LIBCLANG
    /* Clang */
-   CXIndex clang_idx;
-   CXTranslationUnit clang_unit;
-   CXToken *tokens;
-   CXCursor *cursors;
-   unsigned int token_count;
+   Eina_Strbuf *clang_contents;
+   unsigned int clang_revision;
+   /* The results saved by an earlier session have been looked up */
+   Eina_Bool clang_cache_loaded;
 #endif
 
    Ecore_Thread *highlight_thread;
    Eina_Bool highlight_cancel;
+   Eina_Bool highlight_again;
    time_t save_time;
 
    const char *mimetype;
@@ -97,6 +100,31 @@ Evas_Object *edi_editor_add(Evas_Object *parent, Edi_Mainview_Item *item);
  */
 void edi_editor_reload(Edi_Editor *editor);
 
+/**
+ * Replace the content of a line in an editor as an edit that can be undone.
+ * Edits may have moved the line, so the line holding the expected content
+ * that is closest to the line number is changed.
+ *
+ * @param editor the editor instance to change.
+ * @param number the line number the content was found at, starting at 1.
+ * @param before the content the line is expected to have.
+ * @param after the new content of the line.
+ * @return the number of the line that was changed, or 0 if no line holds the expected content.
+ *
+ * @ingroup Editor
+ */
+unsigned int edi_editor_line_replace(Edi_Editor *editor, unsigned int number, const char *before, const char *after);
+
+/**
+ * Tell an editor that its language provider has finished parsing the file,
+ * so that highlighting, errors and suggestions can be shown.
+ *
+ * @param editor the editor instance that was parsed.
+ *
+ * @ingroup Editor
+ */
+void edi_editor_language_parsed(Edi_Editor *editor);
+
 /**
  * @}
  *
@@ -144,6 +172,26 @@ void edi_editor_save(Edi_Editor *editor);
  */
 void edi_editor_doc_open(Edi_Editor *editor);
 
+/**
+ * Go to where the symbol under the cursor is defined, or list the
+ * definitions in the search panel if there is more than one.
+ *
+ * @param editor the text editor instance to look up the symbol in.
+ *
+ * @ingroup Widgets
+ */
+void edi_editor_definition_goto(Edi_Editor *editor);
+
+/**
+ * List everywhere in the project that the symbol under the cursor
+ * is defined, declared or used in the search panel.
+ *
+ * @param editor the text editor instance to look up the symbol in.
+ *
+ * @ingroup Widgets
+ */
+void edi_editor_references_find(Edi_Editor *editor);
+
 /**
  * Get global configuration values for code editor and
  * apply them to an Elm_Code_Widget instance.
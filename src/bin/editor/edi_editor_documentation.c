@@ -102,11 +102,9 @@ _edi_doc_popup_cb_del(void *data, Evas *e EINA_UNUSED,
    edi_language_doc_free(doc);
 }
 
-void
-edi_editor_doc_open(Edi_Editor *editor)
+static void
+_edi_doc_popup_show(Edi_Editor *editor, Edi_Language_Document *doc)
 {
-   Edi_Language_Document *doc = NULL;
-   Edi_Language_Provider *provider;
    Evas_Object *label;
    const char *detail, *param, *ret, *see;
    char *display;
@@ -115,15 +113,6 @@ edi_editor_doc_open(Edi_Editor *editor)
    const char *font;
    int font_size;
 
-   provider = edi_language_provider_get(editor);
-   if (provider && provider->lookup_doc)
-     {
-        unsigned int row, col;
-
-        elm_code_widget_cursor_position_get(editor->entry, &row, &col);
-        doc = edi_language_provider_get(editor)->lookup_doc(editor, row, col);
-     }
-
    //Popup
    editor->doc_popup = elm_popup_add(editor->entry);
    evas_object_smart_callback_add(editor->doc_popup, "block,clicked",
@@ -212,3 +201,26 @@ edi_editor_doc_open(Edi_Editor *editor)
 
    free(display);
 }
+
+static void
+_edi_doc_lookup_cb(void *data, Edi_Language_Document *doc)
+{
+   _edi_doc_popup_show(data, doc);
+}
+
+void
+edi_editor_doc_open(Edi_Editor *editor)
+{
+   Edi_Language_Provider *provider;
+   unsigned int row, col;
+
+   provider = edi_language_provider_get(editor);
+   if (provider && provider->lookup_doc)
+     {
+        elm_code_widget_cursor_position_get(editor->entry, &row, &col);
+        if (provider->lookup_doc(editor, row, col, _edi_doc_lookup_cb, editor))
+          return;
+     }
+
+   _edi_doc_popup_show(editor, NULL);
+}
@@ -0,0 +1,188 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <ctype.h>
+
+#include <Elementary.h>
+
+#include "edi_editor.h"
+#include "edi_searchpanel.h"
+#include "mainview/edi_mainview.h"
+
+#include "language/edi_language_provider.h"
+#include "language/edi_language_index.h"
+
+#include "edi_private.h"
+
+static Eina_Bool
+_edi_editor_symbols_word_char(char c)
+{
+   return isalnum((unsigned char) c) || c == '_';
+}
+
+/* The whole word around a position, not only the part before it */
+static char *
+_edi_editor_symbols_word_get(Edi_Editor *editor, unsigned int row, unsigned int col)
+{
+   Elm_Code *code;
+   Elm_Code_Line *line;
+   const char *text;
+   unsigned int length, start, end;
+
+   code = elm_code_widget_code_get(editor->entry);
+   line = elm_code_file_line_get(code->file, row);
+   if (!line)
+     return NULL;
+
+   text = elm_code_line_text_get(line, &length);
+   if (!text || !length)
+     return NULL;
+
+   start = col > 1 ? col - 1 : 0;
+   if (start > length)
+     start = length;
+   end = start;
+   while (start > 0 && _edi_editor_symbols_word_char(text[start - 1]))
+     start--;
+   while (end < length && _edi_editor_symbols_word_char(text[end]))
+     end++;
+
+   if (start == end)
+     return NULL;
+
+   return strndup(text + start, end - start);
+}
+
+static Eina_List *
+_edi_editor_symbols_find(Edi_Editor *editor, const char *usr, Edi_Language_Index_Kind kinds)
+{
+   Eina_List *locations;
+   unsigned int row, col;
+   char *word;
+
+   if (usr)
+     return edi_language_index_usr_find(usr, kinds);
+
+   // Until the file has been parsed anything with the same name will do
+   elm_code_widget_cursor_position_get(editor->entry, &row, &col);
+   word = _edi_editor_symbols_word_get(editor, row, col);
+   if (!word)
+     return NULL;
+
+   locations = edi_language_index_name_find(word, kinds, EINA_TRUE);
+   free(word);
+
+   return locations;
+}
+
+/* Look up the symbol under the cursor, the callback is given NULL if the provider cannot */
+static void
+_edi_editor_symbols_lookup(Edi_Editor *editor, Edi_Language_Symbol_Cb cb)
+{
+   Edi_Language_Provider *provider;
+   unsigned int row, col;
+
+   provider = edi_language_provider_get(editor);
+   if (provider && provider->symbol_get)
+     {
+        elm_code_widget_cursor_position_get(editor->entry, &row, &col);
+        if (provider->symbol_get(editor, row, col, cb, editor))
+          return;
+     }
+
+   cb(editor, NULL);
+}
+
+static void
+_edi_editor_symbols_popup_timeout_cb(void *data EINA_UNUSED, Evas_Object *obj,
+                                     void *event_info EINA_UNUSED)
+{
+   evas_object_del(obj);
+}
+
+static void
+_edi_editor_symbols_message_show(Edi_Editor *editor, const char *message)
+{
+   Evas_Object *popup, *label;
+
+   popup = elm_popup_add(editor->entry);
+   elm_popup_timeout_set(popup, 1.5);
+   elm_object_style_set(popup, "transparent");
+   evas_object_smart_callback_add(popup, "timeout", _edi_editor_symbols_popup_timeout_cb, NULL);
+
+   label = elm_label_add(popup);
+   elm_object_text_set(label, message);
+   evas_object_show(label);
+   elm_object_content_set(popup, label);
+   evas_object_show(popup);
+}
+
+static void
+_edi_editor_symbols_show(Eina_List *locations)
+{
+   Edi_Language_Index_Location *location;
+
+   if (eina_list_count(locations) == 1)
+     {
+        location = eina_list_data_get(locations);
+        edi_mainview_open_path(location->path);
+        edi_mainview_goto_position(location->line, location->col);
+        return;
+     }
+
+   edi_searchpanel_show();
+   edi_searchpanel_locations_show(locations);
+}
+
+static void
+_edi_editor_symbols_definition_cb(void *data, char *usr)
+{
+   Edi_Editor *editor = data;
+   Eina_List *locations;
+
+   locations = _edi_editor_symbols_find(editor, usr, EDI_LANGUAGE_INDEX_DEFINITION);
+   if (!locations)
+     locations = _edi_editor_symbols_find(editor, usr, EDI_LANGUAGE_INDEX_DECLARATION);
+   free(usr);
+
+   if (!locations)
+     {
+        _edi_editor_symbols_message_show(editor, _("No definition found for this term"));
+        return;
+     }
+
+   _edi_editor_symbols_show(locations);
+   edi_language_index_locations_free(locations);
+}
+
+static void
+_edi_editor_symbols_references_cb(void *data, char *usr)
+{
+   Edi_Editor *editor = data;
+   Eina_List *locations;
+
+   locations = _edi_editor_symbols_find(editor, usr, EDI_LANGUAGE_INDEX_ALL);
+   free(usr);
+
+   if (!locations)
+     {
+        _edi_editor_symbols_message_show(editor, _("No references found for this term"));
+        return;
+     }
+
+   _edi_editor_symbols_show(locations);
+   edi_language_index_locations_free(locations);
+}
+
+void
+edi_editor_definition_goto(Edi_Editor *editor)
+{
+   _edi_editor_symbols_lookup(editor, _edi_editor_symbols_definition_cb);
+}
+
+void
+edi_editor_references_find(Edi_Editor *editor)
+{
+   _edi_editor_symbols_lookup(editor, _edi_editor_symbols_references_cb);
+}
@@ -0,0 +1,319 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <sys/stat.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <Eina.h>
+#include <Ecore_File.h>
+#include <Eet.h>
+
+#include "md5.h"
+#include "edi_language_cache.h"
+#include "edi_config.h"
+
+#include "edi_private.h"
+
+#define EDI_LANGUAGE_CACHE_NAME "highlight"
+#define EDI_LANGUAGE_CACHE_VERSION 1
+
+Edi_Language_Cache *
+edi_language_cache_new(void)
+{
+   Edi_Language_Cache *cache;
+
+   cache = calloc(1, sizeof(Edi_Language_Cache));
+   cache->tokens = eina_inarray_new(sizeof(Edi_Language_Cache_Token), 1024);
+   cache->statuses = eina_inarray_new(sizeof(Edi_Language_Cache_Status), 16);
+
+   return cache;
+}
+
+void
+edi_language_cache_free(Edi_Language_Cache *cache)
+{
+   Edi_Language_Cache_Status *status;
+
+   if (!cache)
+     return;
+
+   EINA_INARRAY_FOREACH(cache->statuses, status)
+     eina_stringshare_del(status->text);
+
+   eina_inarray_free(cache->tokens);
+   eina_inarray_free(cache->statuses);
+   free(cache);
+}
+
+void
+edi_language_cache_token_add(Edi_Language_Cache *cache, unsigned int start_line, unsigned int start_col,
+                             unsigned int end_line, unsigned int end_col, unsigned int type)
+{
+   Edi_Language_Cache_Token token;
+
+   token.start_line = start_line;
+   token.start_col = start_col;
+   token.end_line = end_line;
+   token.end_col = end_col;
+   token.type = type;
+   eina_inarray_push(cache->tokens, &token);
+}
+
+void
+edi_language_cache_status_add(Edi_Language_Cache *cache, unsigned int line, unsigned int type,
+                              const char *text)
+{
+   Edi_Language_Cache_Status status;
+
+   status.line = line;
+   status.type = type;
+   status.text = eina_stringshare_add(text);
+   eina_inarray_push(cache->statuses, &status);
+}
+
+/* Each file has its own entry, named after a digest of its path */
+static void
+_edi_language_cache_path_get(const char *path, char *out, size_t size, const char *ext)
+{
+   MD5_CTX ctx;
+   char name[(2 * MD5_HASHBYTES) + 1];
+   unsigned char hash[MD5_HASHBYTES];
+   static const char hex[] = "0123456789abcdef";
+   int n;
+
+   MD5Init(&ctx);
+   MD5Update(&ctx, (const unsigned char *) path, strlen(path));
+   MD5Final(hash, &ctx);
+
+   for (n = 0; n < MD5_HASHBYTES; n++)
+     {
+        name[2 * n] = hex[hash[n] >> 4];
+        name[2 * n + 1] = hex[hash[n] & 0x0f];
+     }
+   name[2 * MD5_HASHBYTES] = '\0';
+
+   snprintf(out, size, "%s/%s/%s.%s", _edi_project_config_dir_get(), EDI_LANGUAGE_CACHE_NAME, name, ext);
+}
+
+/* A digest of the content of a file and the flags it is compiled with */
+static Eina_Bool
+_edi_language_cache_hash_get(const char *path, const char *args, unsigned char *hash)
+{
+   MD5_CTX ctx;
+   Eina_File *f;
+   const char *map;
+
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return EINA_FALSE;
+
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (!map)
+     {
+        eina_file_close(f);
+        return EINA_FALSE;
+     }
+
+   MD5Init(&ctx);
+   MD5Update(&ctx, (const unsigned char *) map, eina_file_size_get(f));
+   MD5Update(&ctx, (const unsigned char *) args, strlen(args) + 1);
+   MD5Final(hash, &ctx);
+
+   eina_file_map_free(f, (void *) map);
+   eina_file_close(f);
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edi_language_cache_read(const char **ptr, const char *end, void *out, size_t length)
+{
+   if ((size_t)(end - *ptr) < length)
+     return EINA_FALSE;
+
+   memcpy(out, *ptr, length);
+   *ptr += length;
+   return EINA_TRUE;
+}
+
+/* Whether none of the included files has been modified since the results were saved */
+static Eina_Bool
+_edi_language_cache_includes_current(const char *ptr, const char *end)
+{
+   struct stat st;
+   char path[PATH_MAX];
+   unsigned int length;
+   long long mtime;
+
+   while (ptr < end)
+     {
+        if (!_edi_language_cache_read(&ptr, end, &length, sizeof(length)) || length >= sizeof(path) ||
+            !_edi_language_cache_read(&ptr, end, path, length) ||
+            !_edi_language_cache_read(&ptr, end, &mtime, sizeof(mtime)))
+          return EINA_FALSE;
+        path[length] = '\0';
+
+        if (stat(path, &st) || st.st_mtime != mtime)
+          return EINA_FALSE;
+     }
+
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edi_language_cache_statuses_read(Edi_Language_Cache *cache, const char *ptr, const char *end)
+{
+   unsigned int line, type, length;
+   const char *text;
+
+   while (ptr < end)
+     {
+        if (!_edi_language_cache_read(&ptr, end, &line, sizeof(line)) ||
+            !_edi_language_cache_read(&ptr, end, &type, sizeof(type)) ||
+            !_edi_language_cache_read(&ptr, end, &length, sizeof(length)) ||
+            (size_t)(end - ptr) < length)
+          return EINA_FALSE;
+
+        text = eina_stringshare_add_length(ptr, length);
+        edi_language_cache_status_add(cache, line, type, text);
+        eina_stringshare_del(text);
+        ptr += length;
+     }
+
+   return EINA_TRUE;
+}
+
+Edi_Language_Cache *
+edi_language_cache_load(const char *path, const char *args)
+{
+   Edi_Language_Cache *cache = NULL;
+   Eet_File *ef;
+   char file[PATH_MAX];
+   unsigned char hash[MD5_HASHBYTES];
+   char *saved = NULL, *includes = NULL, *tokens = NULL, *statuses = NULL;
+   int *version, size, includes_size = 0, tokens_size = 0, statuses_size = 0;
+   unsigned int i;
+
+   _edi_language_cache_path_get(path, file, sizeof(file), "eet");
+   ef = eet_open(file, EET_FILE_MODE_READ);
+   if (!ef)
+     return NULL;
+
+   version = eet_read(ef, "version", &size);
+   if (!version || size != sizeof(int) || *version != EDI_LANGUAGE_CACHE_VERSION)
+     goto done;
+
+   saved = eet_read(ef, "hash", &size);
+   if (!saved || size != MD5_HASHBYTES || !_edi_language_cache_hash_get(path, args, hash) ||
+       memcmp(saved, hash, MD5_HASHBYTES))
+     goto done;
+
+   includes = eet_read(ef, "includes", &includes_size);
+   if (includes && !_edi_language_cache_includes_current(includes, includes + includes_size))
+     goto done;
+
+   tokens = eet_read(ef, "tokens", &tokens_size);
+   statuses = eet_read(ef, "statuses", &statuses_size);
+   if ((size_t) tokens_size % sizeof(Edi_Language_Cache_Token))
+     goto done;
+
+   cache = edi_language_cache_new();
+   for (i = 0; i < (size_t) tokens_size / sizeof(Edi_Language_Cache_Token); i++)
+     eina_inarray_push(cache->tokens, (Edi_Language_Cache_Token *) tokens + i);
+   if (statuses && !_edi_language_cache_statuses_read(cache, statuses, statuses + statuses_size))
+     {
+        edi_language_cache_free(cache);
+        cache = NULL;
+     }
+
+done:
+   free(version);
+   free(saved);
+   free(includes);
+   free(tokens);
+   free(statuses);
+   eet_close(ef);
+
+   return cache;
+}
+
+void
+edi_language_cache_save(const char *path, const char *args, Eina_List *includes,
+                        const Edi_Language_Cache *cache)
+{
+   Edi_Language_Cache_Status *status;
+   Edi_Language_Cache_Include *include;
+   Eina_Binbuf *files, *statuses;
+   Eina_List *item;
+   Eet_File *ef;
+   char file[PATH_MAX], tmp[PATH_MAX], ext[64];
+   unsigned char hash[MD5_HASHBYTES];
+   char *dir;
+   unsigned int length;
+   int version = EDI_LANGUAGE_CACHE_VERSION;
+
+   if (!_edi_language_cache_hash_get(path, args, hash))
+     return;
+
+   _edi_language_cache_path_get(path, file, sizeof(file), "eet");
+   // Saves of the same file from other threads or instances each write their own copy
+   snprintf(ext, sizeof(ext), "%d.%lu.tmp", (int) getpid(), (unsigned long) eina_thread_self());
+   _edi_language_cache_path_get(path, tmp, sizeof(tmp), ext);
+   dir = ecore_file_dir_get(file);
+   if (!ecore_file_exists(dir))
+     ecore_file_mkpath(dir);
+   free(dir);
+
+   files = eina_binbuf_new();
+   // The times the parse saw, a file changed since then leaves the results unused
+   EINA_LIST_FOREACH(includes, item, include)
+     {
+        length = strlen(include->path);
+        eina_binbuf_append_length(files, (unsigned char *) &length, sizeof(length));
+        eina_binbuf_append_length(files, (unsigned char *) include->path, length);
+        eina_binbuf_append_length(files, (unsigned char *) &include->mtime, sizeof(include->mtime));
+     }
+
+   statuses = eina_binbuf_new();
+   EINA_INARRAY_FOREACH(cache->statuses, status)
+     {
+        length = status->text ? strlen(status->text) : 0;
+        eina_binbuf_append_length(statuses, (unsigned char *) &status->line, sizeof(status->line));
+        eina_binbuf_append_length(statuses, (unsigned char *) &status->type, sizeof(status->type));
+        eina_binbuf_append_length(statuses, (unsigned char *) &length, sizeof(length));
+        if (length)
+          eina_binbuf_append_length(statuses, (unsigned char *) status->text, length);
+     }
+
+   ef = eet_open(tmp, EET_FILE_MODE_WRITE);
+   if (ef)
+     {
+        eet_write(ef, "version", &version, sizeof(version), 0);
+        eet_write(ef, "hash", hash, MD5_HASHBYTES, 0);
+        eet_write(ef, "includes", eina_binbuf_string_get(files), eina_binbuf_length_get(files), 1);
+        eet_write(ef, "tokens", cache->tokens->members,
+                  eina_inarray_count(cache->tokens) * sizeof(Edi_Language_Cache_Token), 1);
+        eet_write(ef, "statuses", eina_binbuf_string_get(statuses), eina_binbuf_length_get(statuses), 1);
+        if (eet_close(ef) != EET_ERROR_NONE || !ecore_file_mv(tmp, file))
+          {
+             ERR("Could not save parse results to %s", file);
+             ecore_file_unlink(tmp);
+          }
+     }
+
+   eina_binbuf_free(files);
+   eina_binbuf_free(statuses);
+}
+
+void
+edi_language_cache_includes_free(Eina_List *includes)
+{
+   Edi_Language_Cache_Include *include;
+
+   EINA_LIST_FREE(includes, include)
+     {
+        eina_stringshare_del(include->path);
+        free(include);
+     }
+}
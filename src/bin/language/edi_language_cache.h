@@ -0,0 +1,159 @@
+#ifndef EDI_LANGUAGE_CACHE_H_
+# define EDI_LANGUAGE_CACHE_H_
+
+#include <Eina.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief These routines are used for keeping the highlighting and diagnostics of files between sessions.
+ */
+
+/**
+ * @struct _Edi_Language_Cache_Token
+ * A highlighted range of a file.
+ */
+typedef struct _Edi_Language_Cache_Token
+{
+   unsigned int start_line, start_col;
+   unsigned int end_line, end_col;
+   unsigned int type; /**< The Elm_Code_Token_Type of the range */
+} Edi_Language_Cache_Token;
+
+/**
+ * @struct _Edi_Language_Cache_Status
+ * A diagnostic shown against a line of a file.
+ */
+typedef struct _Edi_Language_Cache_Status
+{
+   unsigned int line;
+   unsigned int type; /**< The Elm_Code_Status_Type of the line */
+   const char *text; /**< The message, a stringshare */
+} Edi_Language_Cache_Status;
+
+/**
+ * @struct _Edi_Language_Cache_Include
+ * A file included by a parsed file.
+ */
+typedef struct _Edi_Language_Cache_Include
+{
+   const char *path; /**< The real path of the file, a stringshare */
+   long long mtime; /**< The modification time of the file when the parse read it */
+} Edi_Language_Cache_Include;
+
+/**
+ * @struct _Edi_Language_Cache
+ * The results of parsing a file.
+ */
+typedef struct _Edi_Language_Cache
+{
+   Eina_Inarray *tokens; /**< Edi_Language_Cache_Token in the order they were found */
+   Eina_Inarray *statuses; /**< Edi_Language_Cache_Status in the order they were found */
+} Edi_Language_Cache;
+
+/**
+ * @brief Parse result cache functions.
+ * @defgroup Cache
+ *
+ * @{
+ *
+ * The results of parsing a file are saved in the project config directory so
+ * that opening it again can show them straight away, while the file is still
+ * being parsed. Results are only used if the file content and compile flags
+ * are the same and none of the files it includes has been modified since.
+ * These functions only touch the filesystem so can be called from any thread.
+ *
+ */
+
+/**
+ * Create an empty set of results.
+ *
+ * @return A new cache entry that must be freed with edi_language_cache_free().
+ *
+ * @ingroup Cache
+ */
+Edi_Language_Cache *edi_language_cache_new(void);
+
+/**
+ * Free a set of results.
+ *
+ * @param cache The cache entry to free.
+ *
+ * @ingroup Cache
+ */
+void edi_language_cache_free(Edi_Language_Cache *cache);
+
+/**
+ * Add a highlighted range to a set of results.
+ *
+ * @param cache The cache entry to add to.
+ * @param start_line The line the range starts on.
+ * @param start_col The column the range starts at.
+ * @param end_line The line the range ends on.
+ * @param end_col The column the range ends at.
+ * @param type The Elm_Code_Token_Type of the range.
+ *
+ * @ingroup Cache
+ */
+void edi_language_cache_token_add(Edi_Language_Cache *cache, unsigned int start_line, unsigned int start_col,
+                                  unsigned int end_line, unsigned int end_col, unsigned int type);
+
+/**
+ * Add a line diagnostic to a set of results.
+ *
+ * @param cache The cache entry to add to.
+ * @param line The line the diagnostic is shown against.
+ * @param type The Elm_Code_Status_Type of the line.
+ * @param text The message of the diagnostic, may be NULL.
+ *
+ * @ingroup Cache
+ */
+void edi_language_cache_status_add(Edi_Language_Cache *cache, unsigned int line, unsigned int type,
+                                   const char *text);
+
+/**
+ * Load the results saved for a file if they are still current.
+ *
+ * @param path The path of the file.
+ * @param args The compile flags the file is parsed with.
+ * @return The saved results, to be freed with edi_language_cache_free(),
+ *         or NULL if there are none or they are out of date.
+ *
+ * @ingroup Cache
+ */
+Edi_Language_Cache *edi_language_cache_load(const char *path, const char *args);
+
+/**
+ * Save the results of parsing a file as it is on disk.
+ *
+ * @param path The path of the file.
+ * @param args The compile flags the file was parsed with.
+ * @param includes The Edi_Language_Cache_Include list of the files the parse read.
+ * @param cache The results to save.
+ *
+ * @ingroup Cache
+ */
+void edi_language_cache_save(const char *path, const char *args, Eina_List *includes,
+                             const Edi_Language_Cache *cache);
+
+/**
+ * Free a list of included files.
+ *
+ * @param includes The Edi_Language_Cache_Include list to free.
+ *
+ * @ingroup Cache
+ */
+void edi_language_cache_includes_free(Eina_List *includes);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_LANGUAGE_CACHE_H_ */
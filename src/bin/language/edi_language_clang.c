@@ -0,0 +1,583 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <Eina.h>
+#include <Ecore.h>
+#include <Ecore_File.h>
+
+#include "edi_language_clang.h"
+#include "edi_config.h"
+
+#include "edi_private.h"
+
+#define EDI_LANGUAGE_CLANG_WORKERS_MAX 4
+/* The memory a helper may use on top of the parsed file budget, for libclang itself and a parse in progress */
+#define EDI_LANGUAGE_CLANG_MEMORY_OVERHEAD 1024
+/* A helper that keeps stopping before it answers anything is not started again */
+#define EDI_LANGUAGE_CLANG_FAILURES_MAX 3
+
+typedef struct _Edi_Language_Clang_Request
+{
+   unsigned int id;
+   unsigned int unit;
+   Edi_Language_Clang_Reply_Cb cb;
+   const void *data;
+   Eina_Binbuf *reply;
+
+   /* A caller is blocked in edi_language_clang_call() until this is done */
+   Eina_Bool waiting;
+   Eina_Bool done;
+   Eina_Condition cond;
+} Edi_Language_Clang_Request;
+
+typedef struct _Edi_Language_Clang_Message
+{
+   unsigned int type;
+   unsigned int id;
+   unsigned int unit;
+   Eina_Binbuf *payload;
+} Edi_Language_Clang_Message;
+
+struct _Edi_Language_Clang_Worker
+{
+   pid_t pid;
+   /* Requests are written to in and replies read from out, each by its own thread */
+   int in, out;
+   Ecore_Thread *reader;
+   Ecore_Thread *writer;
+
+   /* Held around everything below, which the threads share */
+   Eina_Lock lock;
+   Eina_Condition queued;
+   Eina_List *queue;
+   /* The requests waiting for a reply, the oldest first */
+   Eina_List *requests;
+   unsigned int next_id;
+   Eina_Bool running;
+   Eina_Bool answered;
+
+   /* The number of files parsed in this helper */
+   unsigned int units;
+   unsigned int failures;
+   Eina_Bool disabled;
+};
+
+static Eina_List *_edi_language_clang_workers = NULL;
+static Edi_Language_Clang_Restart_Cb _edi_language_clang_restart_cb = NULL;
+static const void *_edi_language_clang_restart_data = NULL;
+static Eina_Bool _edi_language_clang_shutting_down = EINA_FALSE;
+
+static void _edi_language_clang_reader_cb(void *data, Ecore_Thread *thread);
+static void _edi_language_clang_reader_notify_cb(void *data, Ecore_Thread *thread, void *msg);
+static void _edi_language_clang_reader_end_cb(void *data, Ecore_Thread *thread);
+static void _edi_language_clang_writer_cb(void *data, Ecore_Thread *thread);
+static void _edi_language_clang_writer_end_cb(void *data, Ecore_Thread *thread);
+
+static void
+_edi_language_clang_request_free(Edi_Language_Clang_Request *request)
+{
+   if (request->reply)
+     eina_binbuf_free(request->reply);
+   free(request);
+}
+
+/* The payload of a successful reply without its success flag */
+static Eina_Binbuf *
+_edi_language_clang_reply_get(Eina_Binbuf *payload)
+{
+   Edi_Clang_Message_Reader reader;
+   unsigned int ok;
+
+   edi_clang_message_reader_init(&reader, payload);
+   if (!edi_clang_message_uint_get(&reader, &ok) || !ok)
+     {
+        eina_binbuf_free(payload);
+        return NULL;
+     }
+
+   eina_binbuf_remove(payload, 0, sizeof(unsigned int));
+   return payload;
+}
+
+/* Must be called with the worker lock held */
+static Edi_Language_Clang_Request *
+_edi_language_clang_request_take(Edi_Language_Clang_Worker *worker, unsigned int id)
+{
+   Edi_Language_Clang_Request *request;
+   Eina_List *item;
+
+   EINA_LIST_FOREACH(worker->requests, item, request)
+     {
+        if (request->id == id)
+          {
+             worker->requests = eina_list_remove_list(worker->requests, item);
+             return request;
+          }
+     }
+
+   return NULL;
+}
+
+/* Must be called with the worker lock held */
+static void
+_edi_language_clang_queue(Edi_Language_Clang_Worker *worker, unsigned int type, unsigned int id,
+                          unsigned int unit, Eina_Binbuf *payload)
+{
+   Edi_Language_Clang_Message *message;
+
+   message = malloc(sizeof(Edi_Language_Clang_Message));
+   message->type = type;
+   message->id = id;
+   message->unit = unit;
+   message->payload = payload;
+
+   worker->queue = eina_list_append(worker->queue, message);
+   eina_condition_signal(&worker->queued);
+}
+
+static void
+_edi_language_clang_queue_free(Eina_List *queue)
+{
+   Edi_Language_Clang_Message *message;
+
+   EINA_LIST_FREE(queue, message)
+     {
+        if (message->payload)
+          eina_binbuf_free(message->payload);
+        free(message);
+     }
+}
+
+static void
+_edi_language_clang_reader_cb(void *data, Ecore_Thread *thread)
+{
+   Edi_Language_Clang_Worker *worker = data;
+   Edi_Language_Clang_Request *request;
+   Edi_Clang_Message_Header header;
+   Eina_Binbuf *payload;
+
+   while ((payload = edi_clang_message_read(worker->out, &header)))
+     {
+        payload = _edi_language_clang_reply_get(payload);
+
+        eina_lock_take(&worker->lock);
+        worker->answered = EINA_TRUE;
+        request = _edi_language_clang_request_take(worker, header.id);
+        if (request && request->waiting)
+          {
+             request->reply = payload;
+             request->done = EINA_TRUE;
+             eina_condition_signal(&request->cond);
+             eina_lock_release(&worker->lock);
+             continue;
+          }
+        eina_lock_release(&worker->lock);
+
+        // The caller gave up waiting for it
+        if (!request)
+          {
+             if (payload)
+               eina_binbuf_free(payload);
+             continue;
+          }
+
+        request->reply = payload;
+        ecore_thread_feedback(thread, request);
+     }
+}
+
+static void
+_edi_language_clang_reader_notify_cb(void *data EINA_UNUSED, Ecore_Thread *thread EINA_UNUSED, void *msg)
+{
+   Edi_Language_Clang_Request *request = msg;
+
+   if (!_edi_language_clang_shutting_down)
+     request->cb((void *) request->data, request->reply);
+
+   _edi_language_clang_request_free(request);
+}
+
+static void
+_edi_language_clang_writer_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Language_Clang_Worker *worker = data;
+   Edi_Language_Clang_Message *message;
+   Eina_Bool ok;
+
+   while (1)
+     {
+        eina_lock_take(&worker->lock);
+        while (worker->running && !worker->queue)
+          eina_condition_wait(&worker->queued);
+        if (!worker->running)
+          {
+             eina_lock_release(&worker->lock);
+             return;
+          }
+
+        message = eina_list_data_get(worker->queue);
+        worker->queue = eina_list_remove_list(worker->queue, worker->queue);
+        eina_lock_release(&worker->lock);
+
+        ok = edi_clang_message_write(worker->in, message->type, message->id, message->unit, message->payload);
+        _edi_language_clang_queue_free(eina_list_append(NULL, message));
+
+        // The helper has gone, the reader finds out too
+        if (!ok)
+          return;
+     }
+}
+
+static void
+_edi_language_clang_writer_end_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Language_Clang_Worker *worker = data;
+
+   worker->writer = NULL;
+}
+
+static Eina_Bool
+_edi_language_clang_worker_start(Edi_Language_Clang_Worker *worker)
+{
+   char path[PATH_MAX], limit[16];
+   char *argv[] = { path, "--memory-limit", limit, NULL };
+   int in[2], out[2], i;
+   pid_t pid;
+
+   snprintf(path, sizeof(path), "%s/edi_clang", PACKAGE_BIN_DIR);
+   if (!ecore_file_can_exec(path))
+     snprintf(path, sizeof(path), "edi_clang");
+   snprintf(limit, sizeof(limit), "%u", _edi_config->clang_cache_size + EDI_LANGUAGE_CLANG_MEMORY_OVERHEAD);
+
+   if (pipe(in))
+     return EINA_FALSE;
+   if (pipe(out))
+     {
+        close(in[0]);
+        close(in[1]);
+        return EINA_FALSE;
+     }
+
+   // Other programs that edi runs must not keep the pipes open
+   for (i = 0; i < 2; i++)
+     {
+        fcntl(in[i], F_SETFD, FD_CLOEXEC);
+        fcntl(out[i], F_SETFD, FD_CLOEXEC);
+     }
+
+   pid = fork();
+   if (pid == 0)
+     {
+        dup2(in[0], STDIN_FILENO);
+        dup2(out[1], STDOUT_FILENO);
+        execvp(path, argv);
+        _exit(127);
+     }
+
+   close(in[0]);
+   close(out[1]);
+   if (pid < 0)
+     {
+        ERR("Could not start %s: %s", path, strerror(errno));
+        close(in[1]);
+        close(out[0]);
+        return EINA_FALSE;
+     }
+
+   worker->pid = pid;
+   worker->in = in[1];
+   worker->out = out[0];
+   worker->running = EINA_TRUE;
+   worker->answered = EINA_FALSE;
+
+   worker->reader = ecore_thread_feedback_run(_edi_language_clang_reader_cb, _edi_language_clang_reader_notify_cb,
+                                              _edi_language_clang_reader_end_cb, _edi_language_clang_reader_end_cb,
+                                              worker, EINA_TRUE);
+   worker->writer = ecore_thread_feedback_run(_edi_language_clang_writer_cb, NULL,
+                                              _edi_language_clang_writer_end_cb, _edi_language_clang_writer_end_cb,
+                                              worker, EINA_TRUE);
+
+   return EINA_TRUE;
+}
+
+/* End the helper process and fail whatever it was asked to do.
+ * Returns the file whose request was running when it stopped, or 0. */
+static unsigned int
+_edi_language_clang_worker_stop(Edi_Language_Clang_Worker *worker)
+{
+   Edi_Language_Clang_Request *request;
+   Eina_List *requests, *queue, *item, *next;
+   unsigned int unit = 0;
+   int status = 0;
+
+   if (worker->pid > 0)
+     {
+        kill(worker->pid, SIGKILL);
+        while (waitpid(worker->pid, &status, 0) < 0 && errno == EINTR);
+
+        if (!_edi_language_clang_shutting_down && WIFSIGNALED(status) && WTERMSIG(status) != SIGKILL)
+          ERR("The C parsing helper crashed with signal %d", WTERMSIG(status));
+        else if (!_edi_language_clang_shutting_down && WIFEXITED(status))
+          WRN("The C parsing helper exited with status %d", WEXITSTATUS(status));
+        worker->pid = 0;
+     }
+
+   eina_lock_take(&worker->lock);
+   worker->running = EINA_FALSE;
+   eina_condition_signal(&worker->queued);
+   eina_lock_release(&worker->lock);
+
+   if (worker->writer)
+     while ((ecore_thread_wait(worker->writer, 0.1)) != EINA_TRUE);
+   if (worker->in >= 0)
+     close(worker->in);
+   worker->in = -1;
+
+   eina_lock_take(&worker->lock);
+   queue = worker->queue;
+   worker->queue = NULL;
+   requests = worker->requests;
+   worker->requests = NULL;
+
+   // The helper handles requests in order, so the oldest one is what it was doing
+   request = eina_list_data_get(requests);
+   if (request)
+     unit = request->unit;
+
+   EINA_LIST_FOREACH_SAFE(requests, item, next, request)
+     {
+        if (!request->waiting)
+          continue;
+
+        request->done = EINA_TRUE;
+        eina_condition_signal(&request->cond);
+        requests = eina_list_remove_list(requests, item);
+     }
+   eina_lock_release(&worker->lock);
+
+   _edi_language_clang_queue_free(queue);
+   EINA_LIST_FREE(requests, request)
+     {
+        if (!_edi_language_clang_shutting_down)
+          request->cb((void *) request->data, NULL);
+        _edi_language_clang_request_free(request);
+     }
+
+   return unit;
+}
+
+static void
+_edi_language_clang_reader_end_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Language_Clang_Worker *worker = data;
+   unsigned int unit;
+
+   worker->reader = NULL;
+   unit = _edi_language_clang_worker_stop(worker);
+   close(worker->out);
+   worker->out = -1;
+
+   if (_edi_language_clang_shutting_down)
+     return;
+
+   if (worker->answered)
+     worker->failures = 0;
+   else
+     worker->failures++;
+
+   if (worker->failures >= EDI_LANGUAGE_CLANG_FAILURES_MAX || !_edi_language_clang_worker_start(worker))
+     {
+        ERR("Not starting the C parsing helper again, C files will not be parsed");
+        worker->disabled = EINA_TRUE;
+        return;
+     }
+
+   if (_edi_language_clang_restart_cb)
+     _edi_language_clang_restart_cb((void *) _edi_language_clang_restart_data, worker, unit);
+}
+
+Edi_Language_Clang_Worker *
+edi_language_clang_worker_get(void)
+{
+   Edi_Language_Clang_Worker *worker, *best = NULL;
+   Eina_List *item;
+   unsigned int max;
+
+   if (_edi_language_clang_shutting_down)
+     return NULL;
+
+   EINA_LIST_FOREACH(_edi_language_clang_workers, item, worker)
+     {
+        if (!worker->disabled && (!best || worker->units < best->units))
+          best = worker;
+     }
+
+   max = eina_cpu_count();
+   if (max > EDI_LANGUAGE_CLANG_WORKERS_MAX)
+     max = EDI_LANGUAGE_CLANG_WORKERS_MAX;
+
+   // Files are spread over the helpers so they are parsed in parallel
+   if ((!best || best->units) && eina_list_count(_edi_language_clang_workers) < max)
+     {
+        // A helper that stopped must not take edi with it when it is written to
+        if (!_edi_language_clang_workers)
+          signal(SIGPIPE, SIG_IGN);
+
+        worker = calloc(1, sizeof(Edi_Language_Clang_Worker));
+        worker->in = worker->out = -1;
+        eina_lock_new(&worker->lock);
+        eina_condition_new(&worker->queued, &worker->lock);
+
+        if (_edi_language_clang_worker_start(worker))
+          {
+             _edi_language_clang_workers = eina_list_append(_edi_language_clang_workers, worker);
+             best = worker;
+          }
+        else
+          {
+             eina_condition_free(&worker->queued);
+             eina_lock_free(&worker->lock);
+             free(worker);
+          }
+     }
+
+   if (best)
+     best->units++;
+
+   return best;
+}
+
+void
+edi_language_clang_worker_put(Edi_Language_Clang_Worker *worker)
+{
+   if (worker && worker->units)
+     worker->units--;
+}
+
+Eina_Bool
+edi_language_clang_send(Edi_Language_Clang_Worker *worker, unsigned int type, unsigned int unit,
+                        Eina_Binbuf *payload, Edi_Language_Clang_Reply_Cb cb, const void *data)
+{
+   Edi_Language_Clang_Request *request = NULL;
+
+   eina_lock_take(&worker->lock);
+   if (!worker->running)
+     {
+        eina_lock_release(&worker->lock);
+        if (payload)
+          eina_binbuf_free(payload);
+        return EINA_FALSE;
+     }
+
+   if (++worker->next_id == 0)
+     worker->next_id++;
+   if (cb)
+     {
+        request = calloc(1, sizeof(Edi_Language_Clang_Request));
+        request->id = worker->next_id;
+        request->unit = unit;
+        request->cb = cb;
+        request->data = data;
+        worker->requests = eina_list_append(worker->requests, request);
+     }
+
+   _edi_language_clang_queue(worker, type, worker->next_id, unit, payload);
+   eina_lock_release(&worker->lock);
+
+   return EINA_TRUE;
+}
+
+Eina_Binbuf *
+edi_language_clang_call(Edi_Language_Clang_Worker *worker, unsigned int type, unsigned int unit,
+                        Eina_Binbuf *payload, double timeout)
+{
+   Edi_Language_Clang_Request request;
+   double end = ecore_time_get() + timeout;
+
+   memset(&request, 0, sizeof(request));
+   request.unit = unit;
+   request.waiting = EINA_TRUE;
+
+   eina_lock_take(&worker->lock);
+   if (!worker->running)
+     {
+        eina_lock_release(&worker->lock);
+        if (payload)
+          eina_binbuf_free(payload);
+        return NULL;
+     }
+
+   if (++worker->next_id == 0)
+     worker->next_id++;
+   request.id = worker->next_id;
+   eina_condition_new(&request.cond, &worker->lock);
+   worker->requests = eina_list_append(worker->requests, &request);
+   _edi_language_clang_queue(worker, type, request.id, unit, payload);
+
+   while (!request.done)
+     {
+        if (timeout <= 0)
+          eina_condition_wait(&request.cond);
+        else if (ecore_time_get() >= end || !eina_condition_timedwait(&request.cond, end - ecore_time_get()))
+          break;
+     }
+
+   // A late reply is dropped by the reader
+   if (!request.done)
+     {
+        worker->requests = eina_list_remove(worker->requests, &request);
+        DBG("No reply to a C parsing request after %.1f seconds", timeout);
+     }
+   eina_lock_release(&worker->lock);
+   eina_condition_free(&request.cond);
+
+   return request.reply;
+}
+
+void
+edi_language_clang_restart_cb_set(Edi_Language_Clang_Restart_Cb cb, const void *data)
+{
+   _edi_language_clang_restart_cb = cb;
+   _edi_language_clang_restart_data = data;
+}
+
+void
+edi_language_clang_stop(void)
+{
+   Edi_Language_Clang_Worker *worker;
+   Eina_List *item;
+
+   _edi_language_clang_shutting_down = EINA_TRUE;
+   EINA_LIST_FOREACH(_edi_language_clang_workers, item, worker)
+     {
+        _edi_language_clang_worker_stop(worker);
+        if (worker->reader)
+          while ((ecore_thread_wait(worker->reader, 0.1)) != EINA_TRUE);
+     }
+}
+
+void
+edi_language_clang_shutdown(void)
+{
+   Edi_Language_Clang_Worker *worker;
+
+   edi_language_clang_stop();
+   EINA_LIST_FREE(_edi_language_clang_workers, worker)
+     {
+        eina_condition_free(&worker->queued);
+        eina_lock_free(&worker->lock);
+        free(worker);
+     }
+   _edi_language_clang_shutting_down = EINA_FALSE;
+}
@@ -0,0 +1,142 @@
+#ifndef EDI_LANGUAGE_CLANG_H_
+# define EDI_LANGUAGE_CLANG_H_
+
+#include <Eina.h>
+
+#include "edi_clang_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief These routines are used for running C parsing in edi_clang helper processes.
+ */
+
+typedef struct _Edi_Language_Clang_Worker Edi_Language_Clang_Worker;
+
+/**
+ * @typedef Edi_Language_Clang_Reply_Cb
+ * Called on the main loop with the reply to a request.
+ *
+ * @param data The data passed with the request.
+ * @param reply The reply payload after its success flag, or NULL if the request
+ *        failed or the helper stopped before answering.
+ */
+typedef void (*Edi_Language_Clang_Reply_Cb)(void *data, const Eina_Binbuf *reply);
+
+/**
+ * @typedef Edi_Language_Clang_Restart_Cb
+ * Called on the main loop when a helper has been started again after it stopped,
+ * all the files it had parsed are gone.
+ *
+ * @param data The data passed to edi_language_clang_restart_cb_set().
+ * @param worker The helper that was restarted.
+ * @param unit The file whose request was running when it stopped, or 0.
+ */
+typedef void (*Edi_Language_Clang_Restart_Cb)(void *data, Edi_Language_Clang_Worker *worker, unsigned int unit);
+
+/**
+ * @brief Helper process functions.
+ * @defgroup Clang
+ *
+ * @{
+ *
+ * Each parsed file lives in one of a small pool of helper processes, which
+ * handle their requests in order. A helper that crashes, or runs out of the
+ * memory it is allowed, only loses the files it had parsed and is restarted.
+ *
+ */
+
+/**
+ * Get the helper to parse a new file in, starting one if they are all in use.
+ * This must be called from the main loop.
+ *
+ * @return The least used helper, or NULL if none can be run.
+ *         Release it with edi_language_clang_worker_put() once the file is freed.
+ *
+ * @ingroup Clang
+ */
+Edi_Language_Clang_Worker *edi_language_clang_worker_get(void);
+
+/**
+ * Stop counting a file against a helper.
+ *
+ * @param worker The helper returned by edi_language_clang_worker_get().
+ *
+ * @ingroup Clang
+ */
+void edi_language_clang_worker_put(Edi_Language_Clang_Worker *worker);
+
+/**
+ * Send a request and call back with its reply.
+ * This must be called from the main loop.
+ *
+ * @param worker The helper to send to.
+ * @param type The Edi_Clang_Message_Type of the request.
+ * @param unit The file the request is for.
+ * @param payload The payload of the request, which is taken over.
+ * @param cb Called with the reply, or NULL for requests that have none.
+ * @param data Passed to the callback.
+ * @return EINA_FALSE if the helper is not running, the callback is then not called.
+ *
+ * @ingroup Clang
+ */
+Eina_Bool edi_language_clang_send(Edi_Language_Clang_Worker *worker, unsigned int type, unsigned int unit,
+                                  Eina_Binbuf *payload, Edi_Language_Clang_Reply_Cb cb, const void *data);
+
+/**
+ * Send a request and wait for its reply.
+ * This may be called from any thread.
+ *
+ * @param worker The helper to send to.
+ * @param type The Edi_Clang_Message_Type of the request.
+ * @param unit The file the request is for.
+ * @param payload The payload of the request, which is taken over.
+ * @param timeout The number of seconds to wait for, or 0 to wait until the helper answers or stops.
+ * @return The reply payload after its success flag, to be freed with eina_binbuf_free(),
+ *         or NULL if the request failed or timed out.
+ *
+ * @ingroup Clang
+ */
+Eina_Binbuf *edi_language_clang_call(Edi_Language_Clang_Worker *worker, unsigned int type, unsigned int unit,
+                                     Eina_Binbuf *payload, double timeout);
+
+/**
+ * Set the function called when a helper has been restarted.
+ *
+ * @param cb The function to call.
+ * @param data Passed to the function.
+ *
+ * @ingroup Clang
+ */
+void edi_language_clang_restart_cb_set(Edi_Language_Clang_Restart_Cb cb, const void *data);
+
+/**
+ * Stop all the helpers without freeing them. Requests still waiting for a
+ * reply are dropped without calling back, or fail if a thread is waiting for
+ * them, and new requests fail. This lets threads that use the helpers be
+ * waited for before edi_language_clang_shutdown().
+ *
+ * @ingroup Clang
+ */
+void edi_language_clang_stop(void);
+
+/**
+ * Stop all the helpers if they are still running and free them.
+ * Nothing may be using them from another thread.
+ *
+ * @ingroup Clang
+ */
+void edi_language_clang_shutdown(void);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_LANGUAGE_CLANG_H_ */
@@ -0,0 +1,1340 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <sys/stat.h>
+#include <string.h>
+#include <strings.h>
+
+#if HAVE_LIBCLANG
+#include <clang-c/Index.h>
+#endif
+
+#include <Eina.h>
+#include <Ecore.h>
+#include <Ecore_File.h>
+#include <Eio.h>
+
+#include "Edi.h"
+#include "md5.h"
+#include "edi_language_index.h"
+#include "edi_language_provider.h"
+#include "edi_config.h"
+
+#include "edi_private.h"
+
+void
+edi_language_index_locations_free(Eina_List *locations)
+{
+   Edi_Language_Index_Location *location;
+
+   EINA_LIST_FREE(locations, location)
+     {
+        eina_stringshare_del(location->path);
+        eina_stringshare_del(location->name);
+        free(location);
+     }
+}
+
+#if HAVE_LIBCLANG
+
+#define EDI_LANGUAGE_INDEX_NAME "symbols"
+#define EDI_LANGUAGE_INDEX_VERSION 2
+#define EDI_LANGUAGE_INDEX_UPDATE_DELAY 0.5
+
+/* The strings are stringshares, or point into the mapped index file for units loaded from it */
+typedef struct _Edi_Language_Index_Symbol
+{
+   const char *usr;
+   const char *name;
+   const char *path;
+   unsigned int line, col;
+   unsigned int offset;
+   unsigned int kind;
+} Edi_Language_Index_Symbol;
+
+typedef struct _Edi_Language_Index_Include
+{
+   const char *path;
+   long long mtime;
+} Edi_Language_Index_Include;
+
+/* Everything one file of the compile database saw within the project, including its headers */
+typedef struct _Edi_Language_Index_Unit
+{
+   const char *path;
+   unsigned char hash[MD5_HASHBYTES];
+
+   Edi_Language_Index_Include *includes;
+   unsigned int include_count;
+   Edi_Language_Index_Symbol *symbols;
+   unsigned int symbol_count;
+   /* The strings of the symbols are in the mapped index file rather than stringshares */
+   Eina_Bool mapped;
+} Edi_Language_Index_Unit;
+
+typedef struct _Edi_Language_Index
+{
+   char *directory;
+   char *cache;
+
+   /* Held while the workers change units and lookups read them */
+   Eina_Lock lock;
+   Eina_Hash *units;
+   /* The Edi_Language_Index_Symbol list of each USR and of each name, across every unit */
+   Eina_Hash *usrs;
+   Eina_Hash *names;
+   Eina_Bool dirty;
+   /* The files still to index, taken one at a time by the workers */
+   Eina_List *queue;
+   unsigned int active;
+
+   /* The compile database shared by the C provider, set before a scan and read only while it and the workers run */
+   Eina_Hash *commands;
+   Eina_Bool loaded;
+   /* The index file loaded units point into, mapped until shutdown */
+   Eina_File *file;
+   const char *map;
+
+   /* Only accessed from the main loop */
+   Ecore_Thread *scan;
+   Eina_List *workers;
+   Ecore_Timer *timer;
+   Eina_Hash *queued;
+   /* A new compile database, waiting for the running scan or workers to finish */
+   Eina_Hash *reload;
+   Eina_List *handlers;
+} Edi_Language_Index;
+
+typedef struct _Edi_Language_Index_Parse
+{
+   Edi_Language_Index *index;
+   Ecore_Thread *thread;
+
+   /* The project path of each file clang opened, by CXFile */
+   Eina_Hash *files;
+   Eina_Inarray *includes;
+   Eina_Inarray *symbols;
+} Edi_Language_Index_Parse;
+
+static Edi_Language_Index *_edi_language_index = NULL;
+
+/* Marks files outside of the project, which are not recorded */
+static const char _edi_language_index_outside[] = "";
+
+static void
+_edi_language_index_symbols_free(Edi_Language_Index_Symbol *symbols, unsigned int count)
+{
+   unsigned int i;
+
+   for (i = 0; i < count; i++)
+     {
+        eina_stringshare_del(symbols[i].usr);
+        eina_stringshare_del(symbols[i].name);
+        eina_stringshare_del(symbols[i].path);
+     }
+}
+
+static void
+_edi_language_index_includes_free(Edi_Language_Index_Include *includes, unsigned int count)
+{
+   unsigned int i;
+
+   for (i = 0; i < count; i++)
+     eina_stringshare_del(includes[i].path);
+}
+
+static void
+_edi_language_index_unit_free(Edi_Language_Index_Unit *unit)
+{
+   _edi_language_index_includes_free(unit->includes, unit->include_count);
+   if (!unit->mapped)
+     _edi_language_index_symbols_free(unit->symbols, unit->symbol_count);
+
+   free(unit->includes);
+   free(unit->symbols);
+   eina_stringshare_del(unit->path);
+   free(unit);
+}
+
+static void
+_edi_language_index_unit_free_cb(void *data)
+{
+   _edi_language_index_unit_free(data);
+}
+
+static void
+_edi_language_index_symbol_link(Eina_Hash *hash, const char *key, Edi_Language_Index_Symbol *symbol)
+{
+   Eina_List *list;
+
+   list = eina_hash_find(hash, key);
+   if (list)
+     eina_hash_modify(hash, key, eina_list_append(list, symbol));
+   else
+     eina_hash_add(hash, key, eina_list_append(NULL, symbol));
+}
+
+static void
+_edi_language_index_symbol_unlink(Eina_Hash *hash, const char *key, Edi_Language_Index_Symbol *symbol)
+{
+   Eina_List *list;
+
+   list = eina_list_remove(eina_hash_find(hash, key), symbol);
+   if (list)
+     eina_hash_modify(hash, key, list);
+   else
+     eina_hash_del_by_key(hash, key);
+}
+
+/* Lookups find symbols through the USR and name tables, these are kept up to date with the lock held */
+static void
+_edi_language_index_unit_link(Edi_Language_Index *index, Edi_Language_Index_Unit *unit)
+{
+   unsigned int i;
+
+   for (i = 0; i < unit->symbol_count; i++)
+     {
+        _edi_language_index_symbol_link(index->usrs, unit->symbols[i].usr, &unit->symbols[i]);
+        _edi_language_index_symbol_link(index->names, unit->symbols[i].name, &unit->symbols[i]);
+     }
+}
+
+static void
+_edi_language_index_unit_unlink(Edi_Language_Index *index, Edi_Language_Index_Unit *unit)
+{
+   unsigned int i;
+
+   for (i = 0; i < unit->symbol_count; i++)
+     {
+        _edi_language_index_symbol_unlink(index->usrs, unit->symbols[i].usr, &unit->symbols[i]);
+        _edi_language_index_symbol_unlink(index->names, unit->symbols[i].name, &unit->symbols[i]);
+     }
+}
+
+/* The unit replaces any earlier one of its path, which is returned to be freed */
+static Edi_Language_Index_Unit *
+_edi_language_index_unit_set(Edi_Language_Index *index, Edi_Language_Index_Unit *unit)
+{
+   Edi_Language_Index_Unit *previous;
+
+   eina_lock_take(&index->lock);
+   previous = eina_hash_set(index->units, unit->path, unit);
+   if (previous)
+     _edi_language_index_unit_unlink(index, previous);
+   _edi_language_index_unit_link(index, unit);
+   eina_lock_release(&index->lock);
+
+   return previous;
+}
+
+static void
+_edi_language_index_symbols_table_free(Eina_Hash *hash)
+{
+   Eina_Iterator *it;
+   Eina_List *list;
+
+   it = eina_hash_iterator_data_new(hash);
+   EINA_ITERATOR_FOREACH(it, list)
+     eina_list_free(list);
+   eina_iterator_free(it);
+
+   eina_hash_free(hash);
+}
+
+/* A digest of the content of a file and the flags it is compiled with */
+static Eina_Bool
+_edi_language_index_hash_get(const char *path, const Edi_Clang_Command *command,
+                             unsigned char *hash)
+{
+   MD5_CTX ctx;
+   Eina_File *f;
+   const char *map;
+   unsigned int i;
+
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return EINA_FALSE;
+
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (!map)
+     {
+        eina_file_close(f);
+        return EINA_FALSE;
+     }
+
+   MD5Init(&ctx);
+   MD5Update(&ctx, (const unsigned char *) map, eina_file_size_get(f));
+   for (i = 0; i < command->argc; i++)
+     MD5Update(&ctx, (const unsigned char *) command->args[i], strlen(command->args[i]) + 1);
+   MD5Final(hash, &ctx);
+
+   eina_file_map_free(f, (void *) map);
+   eina_file_close(f);
+   return EINA_TRUE;
+}
+
+/* Whether a unit was indexed from the same content and flags and no project header it includes has changed */
+static Eina_Bool
+_edi_language_index_unit_current(const Edi_Language_Index_Unit *unit, const unsigned char *hash)
+{
+   struct stat st;
+   unsigned int i;
+
+   if (memcmp(unit->hash, hash, MD5_HASHBYTES))
+     return EINA_FALSE;
+
+   for (i = 0; i < unit->include_count; i++)
+     {
+        if (stat(unit->includes[i].path, &st) || st.st_mtime != unit->includes[i].mtime)
+          return EINA_FALSE;
+     }
+
+   return EINA_TRUE;
+}
+
+static void
+_edi_language_index_file_free_cb(void *data)
+{
+   if (data != _edi_language_index_outside)
+     eina_stringshare_del(data);
+}
+
+/* The real path of a file if it is within the project, otherwise NULL */
+static const char *
+_edi_language_index_file_get(Edi_Language_Index_Parse *parse, CXFile file)
+{
+   const char *path;
+   CXString name;
+   char *real = NULL;
+   size_t length;
+
+   if (!file)
+     return NULL;
+
+   path = eina_hash_find(parse->files, &file);
+   if (path)
+     return path == _edi_language_index_outside ? NULL : path;
+
+   name = clang_getFileName(file);
+   if (clang_getCString(name))
+     real = ecore_file_realpath(clang_getCString(name));
+   clang_disposeString(name);
+
+   length = strlen(parse->index->directory);
+   if (real && !strncmp(real, parse->index->directory, length) && real[length] == '/')
+     path = eina_stringshare_add(real);
+   else
+     path = _edi_language_index_outside;
+   free(real);
+
+   eina_hash_add(parse->files, &file, path);
+   return path == _edi_language_index_outside ? NULL : path;
+}
+
+static int
+_edi_language_index_abort_cb(CXClientData data, void *reserved EINA_UNUSED)
+{
+   Edi_Language_Index_Parse *parse = data;
+
+   return ecore_thread_check(parse->thread);
+}
+
+static CXIdxClientFile
+_edi_language_index_included_cb(CXClientData data, const CXIdxIncludedFileInfo *info)
+{
+   Edi_Language_Index_Parse *parse = data;
+   Edi_Language_Index_Include include;
+   const char *path;
+
+   // A header guard only stops the content being seen again, not the directive
+   if (!info->file || eina_hash_find(parse->files, &info->file))
+     return NULL;
+
+   path = _edi_language_index_file_get(parse, info->file);
+   if (!path)
+     return NULL;
+
+   include.path = eina_stringshare_ref(path);
+   include.mtime = clang_getFileTime(info->file);
+   eina_inarray_push(parse->includes, &include);
+
+   return NULL;
+}
+
+static void
+_edi_language_index_symbol_add(Edi_Language_Index_Parse *parse, const CXIdxEntityInfo *entity,
+                               CXIdxLoc loc, Edi_Language_Index_Kind kind)
+{
+   Edi_Language_Index_Symbol symbol;
+   CXFile file;
+   unsigned int line, col, offset;
+   const char *path;
+
+   // Local and anonymous entities have nothing to find them by
+   if (!entity || !entity->USR || !entity->USR[0] || !entity->name || !entity->name[0])
+     return;
+
+   clang_indexLoc_getFileLocation(loc, NULL, &file, &line, &col, &offset);
+   path = _edi_language_index_file_get(parse, file);
+   if (!path || !line || !col || offset < col - 1)
+     return;
+
+   symbol.usr = eina_stringshare_add(entity->USR);
+   symbol.name = eina_stringshare_add(entity->name);
+   symbol.path = eina_stringshare_ref(path);
+   symbol.line = line;
+   symbol.col = col;
+   symbol.offset = offset - (col - 1);
+   symbol.kind = kind;
+   eina_inarray_push(parse->symbols, &symbol);
+}
+
+static void
+_edi_language_index_declaration_cb(CXClientData data, const CXIdxDeclInfo *info)
+{
+   _edi_language_index_symbol_add(data, info->entityInfo, info->loc,
+                                  info->isDefinition ? EDI_LANGUAGE_INDEX_DEFINITION :
+                                                       EDI_LANGUAGE_INDEX_DECLARATION);
+}
+
+static void
+_edi_language_index_reference_cb(CXClientData data, const CXIdxEntityRefInfo *info)
+{
+   _edi_language_index_symbol_add(data, info->referencedEntity, info->loc,
+                                  EDI_LANGUAGE_INDEX_REFERENCE);
+}
+
+static IndexerCallbacks _edi_language_index_callbacks =
+{
+   .abortQuery = _edi_language_index_abort_cb,
+   .ppIncludedFile = _edi_language_index_included_cb,
+   .indexDeclaration = _edi_language_index_declaration_cb,
+   .indexEntityReference = _edi_language_index_reference_cb,
+};
+
+static void
+_edi_language_index_unit_remove(Edi_Language_Index *index, const char *path)
+{
+   Edi_Language_Index_Unit *unit;
+
+   eina_lock_take(&index->lock);
+   unit = eina_hash_find(index->units, path);
+   if (unit)
+     {
+        _edi_language_index_unit_unlink(index, unit);
+        eina_hash_del_by_key(index->units, path);
+        index->dirty = EINA_TRUE;
+     }
+   eina_lock_release(&index->lock);
+}
+
+/* Index a file of the compile database, unless nothing it depends on has changed */
+static void
+_edi_language_index_source(Edi_Language_Index *index, CXIndexAction action, Ecore_Thread *thread,
+                           const char *path)
+{
+   Edi_Clang_Command *command;
+   Edi_Language_Index_Unit *unit, *previous;
+   Edi_Language_Index_Parse parse;
+   unsigned char hash[MD5_HASHBYTES];
+   int ret;
+
+   command = eina_hash_find(index->commands, path);
+   if (!command || !_edi_language_index_hash_get(path, command, hash))
+     {
+        _edi_language_index_unit_remove(index, path);
+        return;
+     }
+
+   // Only this worker changes the unit of this path, so it can be checked unlocked
+   eina_lock_take(&index->lock);
+   previous = eina_hash_find(index->units, path);
+   eina_lock_release(&index->lock);
+   if (previous && _edi_language_index_unit_current(previous, hash))
+     return;
+
+   parse.index = index;
+   parse.thread = thread;
+   parse.files = eina_hash_pointer_new(_edi_language_index_file_free_cb);
+   parse.includes = eina_inarray_new(sizeof(Edi_Language_Index_Include), 16);
+   parse.symbols = eina_inarray_new(sizeof(Edi_Language_Index_Symbol), 256);
+
+   ret = clang_indexSourceFile(action, &parse, &_edi_language_index_callbacks,
+                               sizeof(_edi_language_index_callbacks), CXIndexOpt_SuppressWarnings,
+                               path, command->args, command->argc, NULL, 0, NULL,
+                               CXTranslationUnit_None);
+
+   if (ret || ecore_thread_check(thread))
+     {
+        if (ret)
+          WRN("Could not index %s", path);
+        _edi_language_index_includes_free(parse.includes->members, eina_inarray_count(parse.includes));
+        _edi_language_index_symbols_free(parse.symbols->members, eina_inarray_count(parse.symbols));
+     }
+   else
+     {
+        unit = calloc(1, sizeof(Edi_Language_Index_Unit));
+        unit->path = eina_stringshare_add(path);
+        memcpy(unit->hash, hash, MD5_HASHBYTES);
+
+        unit->include_count = eina_inarray_count(parse.includes);
+        unit->includes = malloc(sizeof(Edi_Language_Index_Include) * (unit->include_count + 1));
+        memcpy(unit->includes, parse.includes->members, sizeof(Edi_Language_Index_Include) * unit->include_count);
+        unit->symbol_count = eina_inarray_count(parse.symbols);
+        unit->symbols = malloc(sizeof(Edi_Language_Index_Symbol) * (unit->symbol_count + 1));
+        memcpy(unit->symbols, parse.symbols->members, sizeof(Edi_Language_Index_Symbol) * unit->symbol_count);
+
+        previous = _edi_language_index_unit_set(index, unit);
+        eina_lock_take(&index->lock);
+        index->dirty = EINA_TRUE;
+        eina_lock_release(&index->lock);
+
+        if (previous)
+          _edi_language_index_unit_free(previous);
+     }
+
+   eina_inarray_free(parse.includes);
+   eina_inarray_free(parse.symbols);
+   eina_hash_free(parse.files);
+}
+
+/* Strings are nul terminated so that loaded symbols can point straight at them */
+static unsigned int
+_edi_language_index_string_write(Eina_Binbuf *strings, Eina_Hash *ids, unsigned int *count,
+                                 const char *string)
+{
+   uintptr_t id;
+   unsigned int length;
+
+   id = (uintptr_t) eina_hash_find(ids, string);
+   if (id)
+     return id - 1;
+
+   length = strlen(string);
+   eina_binbuf_append_length(strings, (unsigned char *) &length, sizeof(length));
+   eina_binbuf_append_length(strings, (unsigned char *) string, length + 1);
+
+   eina_hash_add(ids, string, (void *)(uintptr_t) ++(*count));
+   return *count - 1;
+}
+
+static void
+_edi_language_index_uint_write(Eina_Binbuf *buf, unsigned int value)
+{
+   eina_binbuf_append_length(buf, (unsigned char *) &value, sizeof(value));
+}
+
+/*
+ * The file holds the version, the size of the string table, the strings and then the units.
+ * Strings are written once to the table and referred to by number.
+ * Nothing is compressed so that the file is used straight from its mapping.
+ */
+static void
+_edi_language_index_save(Edi_Language_Index *index)
+{
+   Edi_Language_Index_Unit *unit;
+   Edi_Language_Index_Symbol *symbol;
+   Eina_Binbuf *strings, *units;
+   Eina_Iterator *it;
+   Eina_Hash *ids;
+   FILE *f;
+   char path[PATH_MAX], tmp[PATH_MAX];
+   unsigned int i, count = 0, header[2];
+   Eina_Bool ok;
+
+   if (!ecore_file_exists(index->cache))
+     ecore_file_mkpath(index->cache);
+
+   ids = eina_hash_string_superfast_new(NULL);
+   strings = eina_binbuf_new();
+   units = eina_binbuf_new();
+
+   eina_lock_take(&index->lock);
+   it = eina_hash_iterator_data_new(index->units);
+   EINA_ITERATOR_FOREACH(it, unit)
+     {
+        _edi_language_index_uint_write(units, _edi_language_index_string_write(strings, ids, &count, unit->path));
+        eina_binbuf_append_length(units, unit->hash, MD5_HASHBYTES);
+
+        _edi_language_index_uint_write(units, unit->include_count);
+        for (i = 0; i < unit->include_count; i++)
+          {
+             _edi_language_index_uint_write(units, _edi_language_index_string_write(strings, ids, &count,
+                                                                                    unit->includes[i].path));
+             eina_binbuf_append_length(units, (unsigned char *) &unit->includes[i].mtime,
+                                       sizeof(unit->includes[i].mtime));
+          }
+
+        _edi_language_index_uint_write(units, unit->symbol_count);
+        for (i = 0; i < unit->symbol_count; i++)
+          {
+             symbol = &unit->symbols[i];
+             _edi_language_index_uint_write(units, _edi_language_index_string_write(strings, ids, &count, symbol->usr));
+             _edi_language_index_uint_write(units, _edi_language_index_string_write(strings, ids, &count, symbol->name));
+             _edi_language_index_uint_write(units, _edi_language_index_string_write(strings, ids, &count, symbol->path));
+             _edi_language_index_uint_write(units, symbol->line);
+             _edi_language_index_uint_write(units, symbol->col);
+             _edi_language_index_uint_write(units, symbol->offset);
+             _edi_language_index_uint_write(units, symbol->kind);
+          }
+     }
+   eina_iterator_free(it);
+   index->dirty = EINA_FALSE;
+   eina_lock_release(&index->lock);
+   eina_hash_free(ids);
+
+   // The new file is moved over the old one, which stays mapped for the units loaded from it
+   snprintf(tmp, sizeof(tmp), "%s/%s.tmp", index->cache, EDI_LANGUAGE_INDEX_NAME);
+   snprintf(path, sizeof(path), "%s/%s.idx", index->cache, EDI_LANGUAGE_INDEX_NAME);
+   header[0] = EDI_LANGUAGE_INDEX_VERSION;
+   header[1] = eina_binbuf_length_get(strings);
+
+   f = fopen(tmp, "wb");
+   ok = f && fwrite(header, sizeof(header), 1, f) == 1 &&
+        fwrite(eina_binbuf_string_get(strings), 1, header[1], f) == header[1] &&
+        fwrite(eina_binbuf_string_get(units), 1, eina_binbuf_length_get(units), f) == eina_binbuf_length_get(units);
+   if (f && fclose(f))
+     ok = EINA_FALSE;
+
+   if (!ok || !ecore_file_mv(tmp, path))
+     {
+        ERR("Could not save symbol index to %s", path);
+        ecore_file_unlink(tmp);
+        eina_lock_take(&index->lock);
+        index->dirty = EINA_TRUE;
+        eina_lock_release(&index->lock);
+     }
+
+   eina_binbuf_free(strings);
+   eina_binbuf_free(units);
+}
+
+static Eina_Bool
+_edi_language_index_read(const char **ptr, const char *end, void *out, size_t length)
+{
+   if ((size_t)(end - *ptr) < length)
+     return EINA_FALSE;
+
+   memcpy(out, *ptr, length);
+   *ptr += length;
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edi_language_index_string_read(const char **ptr, const char *end, const char **table,
+                                unsigned int count, const char **out)
+{
+   unsigned int id;
+
+   if (!_edi_language_index_read(ptr, end, &id, sizeof(id)) || id >= count)
+     return EINA_FALSE;
+
+   *out = table[id];
+   return EINA_TRUE;
+}
+
+static Edi_Language_Index_Unit *
+_edi_language_index_unit_read(const char **ptr, const char *end, const char **table, unsigned int count)
+{
+   Edi_Language_Index_Unit *unit;
+   Edi_Language_Index_Symbol *symbol;
+   Edi_Language_Index_Include *include;
+   const char *string;
+   unsigned int i;
+
+   // The symbols point into the mapping, the paths that are kept track of are shared
+   unit = calloc(1, sizeof(Edi_Language_Index_Unit));
+   unit->mapped = EINA_TRUE;
+   if (!_edi_language_index_string_read(ptr, end, table, count, &string))
+     goto error;
+   unit->path = eina_stringshare_add(string);
+   if (!_edi_language_index_read(ptr, end, unit->hash, MD5_HASHBYTES) ||
+       !_edi_language_index_read(ptr, end, &i, sizeof(i)) ||
+       (size_t)(end - *ptr) / (sizeof(unsigned int) + sizeof(long long)) < i)
+     goto error;
+
+   unit->includes = calloc(i + 1, sizeof(Edi_Language_Index_Include));
+   for (unit->include_count = 0; unit->include_count < i; unit->include_count++)
+     {
+        include = &unit->includes[unit->include_count];
+        if (!_edi_language_index_string_read(ptr, end, table, count, &string))
+          goto error;
+        include->path = eina_stringshare_add(string);
+        if (!_edi_language_index_read(ptr, end, &include->mtime, sizeof(include->mtime)))
+          {
+             unit->include_count++;
+             goto error;
+          }
+     }
+
+   if (!_edi_language_index_read(ptr, end, &i, sizeof(i)) ||
+       (size_t)(end - *ptr) / (sizeof(unsigned int) * 7) < i)
+     goto error;
+
+   unit->symbols = calloc(i + 1, sizeof(Edi_Language_Index_Symbol));
+   for (unit->symbol_count = 0; unit->symbol_count < i; unit->symbol_count++)
+     {
+        symbol = &unit->symbols[unit->symbol_count];
+        if (!_edi_language_index_string_read(ptr, end, table, count, &symbol->usr) ||
+            !_edi_language_index_string_read(ptr, end, table, count, &symbol->name) ||
+            !_edi_language_index_string_read(ptr, end, table, count, &symbol->path) ||
+            !_edi_language_index_read(ptr, end, &symbol->line, sizeof(symbol->line)) ||
+            !_edi_language_index_read(ptr, end, &symbol->col, sizeof(symbol->col)) ||
+            !_edi_language_index_read(ptr, end, &symbol->offset, sizeof(symbol->offset)) ||
+            !_edi_language_index_read(ptr, end, &symbol->kind, sizeof(symbol->kind)))
+          goto error;
+     }
+
+   return unit;
+
+error:
+   _edi_language_index_unit_free(unit);
+   return NULL;
+}
+
+static void
+_edi_language_index_load(Edi_Language_Index *index)
+{
+   Edi_Language_Index_Unit *unit;
+   Eina_File *f;
+   char path[PATH_MAX];
+   const char *map, *ptr, *end, *strings;
+   const char **table = NULL;
+   unsigned int version, size, length, count = 0, table_size = 0;
+
+   snprintf(path, sizeof(path), "%s/%s.idx", index->cache, EDI_LANGUAGE_INDEX_NAME);
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return;
+
+   map = eina_file_map_all(f, EINA_FILE_RANDOM);
+   if (!map)
+     {
+        eina_file_close(f);
+        return;
+     }
+
+   ptr = map;
+   end = map + eina_file_size_get(f);
+   if (!_edi_language_index_read(&ptr, end, &version, sizeof(version)) ||
+       version != EDI_LANGUAGE_INDEX_VERSION ||
+       !_edi_language_index_read(&ptr, end, &size, sizeof(size)) || (size_t)(end - ptr) < size)
+     {
+        INF("Discarding symbol index with an unknown version");
+        eina_file_map_free(f, (void *) map);
+        eina_file_close(f);
+        return;
+     }
+
+   // Only where each string starts is noted, the strings themselves stay in the mapping
+   strings = ptr;
+   ptr += size;
+   while (strings < ptr)
+     {
+        if (!_edi_language_index_read(&strings, ptr, &length, sizeof(length)) ||
+            (size_t)(ptr - strings) <= length || strings[length])
+          break;
+
+        if (count == table_size)
+          {
+             table_size = table_size ? table_size * 2 : 4096;
+             table = realloc(table, sizeof(char *) * table_size);
+          }
+        table[count++] = strings;
+        strings += length + 1;
+     }
+
+   while (ptr < end)
+     {
+        unit = _edi_language_index_unit_read(&ptr, end, table, count);
+        if (!unit)
+          break;
+
+        unit = _edi_language_index_unit_set(index, unit);
+        if (unit)
+          _edi_language_index_unit_free(unit);
+     }
+   free(table);
+
+   index->file = f;
+   index->map = map;
+
+   INF("Loaded symbol index of %d files", eina_hash_population(index->units));
+}
+
+/* Queue every file of the compile database that is not up to date */
+static void
+_edi_language_index_scan_cb(void *data, Ecore_Thread *thread)
+{
+   Edi_Language_Index *index = data;
+   Edi_Language_Index_Unit *unit;
+   Eina_Hash_Tuple *tuple;
+   Eina_Iterator *it;
+   Eina_List *removed = NULL;
+   unsigned char hash[MD5_HASHBYTES];
+   char *path;
+
+   if (!index->loaded)
+     {
+        _edi_language_index_load(index);
+        index->loaded = EINA_TRUE;
+     }
+
+   it = eina_hash_iterator_key_new(index->units);
+   EINA_ITERATOR_FOREACH(it, path)
+     {
+        if (!eina_hash_find(index->commands, path))
+          removed = eina_list_append(removed, strdup(path));
+     }
+   eina_iterator_free(it);
+
+   EINA_LIST_FREE(removed, path)
+     {
+        _edi_language_index_unit_remove(index, path);
+        free(path);
+     }
+
+   it = eina_hash_iterator_tuple_new(index->commands);
+   EINA_ITERATOR_FOREACH(it, tuple)
+     {
+        if (ecore_thread_check(thread))
+          break;
+
+        unit = eina_hash_find(index->units, tuple->key);
+        if (unit && _edi_language_index_hash_get(tuple->key, tuple->data, hash) &&
+            _edi_language_index_unit_current(unit, hash))
+          continue;
+
+        index->queue = eina_list_append(index->queue, strdup(tuple->key));
+     }
+   eina_iterator_free(it);
+
+   INF("Symbol index has %d files, %d to index", eina_hash_population(index->commands),
+       eina_list_count(index->queue));
+}
+
+static void
+_edi_language_index_worker_cb(void *data, Ecore_Thread *thread)
+{
+   Edi_Language_Index *index = data;
+   CXIndex cxindex;
+   CXIndexAction action;
+   char *path;
+   Eina_Bool last;
+
+   cxindex = clang_createIndex(0, 0);
+   action = clang_IndexAction_create(cxindex);
+   while (!ecore_thread_check(thread))
+     {
+        eina_lock_take(&index->lock);
+        path = eina_list_data_get(index->queue);
+        index->queue = eina_list_remove_list(index->queue, index->queue);
+        eina_lock_release(&index->lock);
+
+        if (!path)
+          break;
+
+        _edi_language_index_source(index, action, thread, path);
+        free(path);
+     }
+   clang_IndexAction_dispose(action);
+   clang_disposeIndex(cxindex);
+
+   eina_lock_take(&index->lock);
+   last = !--index->active;
+   eina_lock_release(&index->lock);
+
+   // The last worker to finish saves what they found between them
+   if (last && index->dirty && !ecore_thread_check(thread))
+     _edi_language_index_save(index);
+}
+
+static Eina_Bool _edi_language_index_update_timer_cb(void *data);
+
+static void
+_edi_language_index_idle(Edi_Language_Index *index)
+{
+   if ((index->reload || eina_hash_population(index->queued)) && !index->timer)
+     index->timer = ecore_timer_add(EDI_LANGUAGE_INDEX_UPDATE_DELAY, _edi_language_index_update_timer_cb, index);
+}
+
+static void
+_edi_language_index_worker_end_cb(void *data, Ecore_Thread *thread)
+{
+   Edi_Language_Index *index = data;
+
+   index->workers = eina_list_remove(index->workers, thread);
+   if (!index->workers)
+     _edi_language_index_idle(index);
+}
+
+static void
+_edi_language_index_worker_cancel_cb(void *data, Ecore_Thread *thread)
+{
+   Edi_Language_Index *index = data;
+
+   index->workers = eina_list_remove(index->workers, thread);
+}
+
+/* Index the queued files, one on each core */
+static void
+_edi_language_index_workers_start(Edi_Language_Index *index)
+{
+   Ecore_Thread *thread;
+   unsigned int i, count;
+
+   count = eina_list_count(index->queue);
+   if (!count)
+     {
+        _edi_language_index_idle(index);
+        return;
+     }
+
+   if (count > (unsigned int) eina_cpu_count())
+     count = eina_cpu_count();
+   if (count < 1)
+     count = 1;
+
+   index->active = count;
+   for (i = 0; i < count; i++)
+     {
+        thread = ecore_thread_run(_edi_language_index_worker_cb, _edi_language_index_worker_end_cb,
+                                  _edi_language_index_worker_cancel_cb, index);
+        if (thread)
+          index->workers = eina_list_append(index->workers, thread);
+     }
+}
+
+static void
+_edi_language_index_scan_end_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Language_Index *index = data;
+
+   index->scan = NULL;
+   _edi_language_index_workers_start(index);
+}
+
+static void
+_edi_language_index_scan_cancel_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Language_Index *index = data;
+
+   index->scan = NULL;
+}
+
+static void
+_edi_language_index_scan(Edi_Language_Index *index)
+{
+   if (index->commands)
+     eina_hash_free(index->commands);
+   index->commands = index->reload;
+   index->reload = NULL;
+
+   index->scan = ecore_thread_run(_edi_language_index_scan_cb, _edi_language_index_scan_end_cb,
+                                  _edi_language_index_scan_cancel_cb, index);
+}
+
+static void
+_edi_language_index_dependents_free_cb(void *data)
+{
+   eina_list_free(data);
+}
+
+/* The files that include each project header, by the path of the header */
+static Eina_Hash *
+_edi_language_index_dependents_get(Edi_Language_Index *index)
+{
+   Edi_Language_Index_Unit *unit;
+   Eina_Iterator *it;
+   Eina_Hash *dependents;
+   Eina_List *list;
+   unsigned int i;
+
+   dependents = eina_hash_string_superfast_new(_edi_language_index_dependents_free_cb);
+   it = eina_hash_iterator_data_new(index->units);
+   EINA_ITERATOR_FOREACH(it, unit)
+     {
+        for (i = 0; i < unit->include_count; i++)
+          {
+             list = eina_hash_find(dependents, unit->includes[i].path);
+             if (list)
+               eina_hash_modify(dependents, unit->includes[i].path, eina_list_append(list, unit->path));
+             else
+               eina_hash_add(dependents, unit->includes[i].path, eina_list_append(NULL, unit->path));
+          }
+     }
+   eina_iterator_free(it);
+
+   return dependents;
+}
+
+static void
+_edi_language_index_queue(Edi_Language_Index *index, const char *path, Eina_Hash *queued)
+{
+   if (eina_hash_find(queued, path))
+     return;
+
+   eina_hash_add(queued, path, index);
+   index->queue = eina_list_append(index->queue, strdup(path));
+}
+
+static Eina_Bool
+_edi_language_index_update_timer_cb(void *data)
+{
+   Edi_Language_Index *index = data;
+   Eina_Iterator *it;
+   Eina_Hash *queued, *dependents;
+   Eina_List *item;
+   const char *path, *dependent;
+   char *real;
+
+   index->timer = NULL;
+   if (index->scan || index->workers)
+     return ECORE_CALLBACK_CANCEL;
+
+   // A new compile database checks every file anyway
+   if (index->reload)
+     {
+        eina_hash_free_buckets(index->queued);
+        _edi_language_index_scan(index);
+        return ECORE_CALLBACK_CANCEL;
+     }
+
+   if (!index->commands)
+     return ECORE_CALLBACK_CANCEL;
+
+   // Queue each changed file of the database and every file that includes a changed header
+   queued = eina_hash_string_superfast_new(NULL);
+   dependents = _edi_language_index_dependents_get(index);
+   it = eina_hash_iterator_key_new(index->queued);
+   EINA_ITERATOR_FOREACH(it, path)
+     {
+        real = ecore_file_realpath(path);
+        if (real && real[0])
+          path = real;
+
+        if (eina_hash_find(index->commands, path))
+          _edi_language_index_queue(index, path, queued);
+        EINA_LIST_FOREACH(eina_hash_find(dependents, path), item, dependent)
+          _edi_language_index_queue(index, dependent, queued);
+        free(real);
+     }
+   eina_iterator_free(it);
+   eina_hash_free_buckets(index->queued);
+   eina_hash_free(dependents);
+   eina_hash_free(queued);
+
+   _edi_language_index_workers_start(index);
+
+   return ECORE_CALLBACK_CANCEL;
+}
+
+static Eina_Bool
+_edi_language_index_file_saved_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *event)
+{
+   edi_language_index_file_update(event);
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+/* The project directories are monitored by the search index, the compile database by the C provider */
+static Eina_Bool
+_edi_language_index_monitor_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *event)
+{
+   Edi_Language_Index *index = _edi_language_index;
+   Eio_Monitor_Event *ev = event;
+   size_t length;
+
+   if (!index)
+     return ECORE_CALLBACK_PASS_ON;
+
+   length = strlen(index->directory);
+   if (!strncmp(ev->filename, index->directory, length) && ev->filename[length] == '/')
+     edi_language_index_file_update(ev->filename);
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+static void
+_edi_language_index_update_timer_start(Edi_Language_Index *index)
+{
+   if (index->timer)
+     ecore_timer_reset(index->timer);
+   else if (!index->scan && !index->workers)
+     index->timer = ecore_timer_add(EDI_LANGUAGE_INDEX_UPDATE_DELAY, _edi_language_index_update_timer_cb, index);
+}
+
+/* The C provider has (re)loaded the compile database, every file is checked against it */
+static void
+_edi_language_index_commands_cb(void *data, Eina_Hash *commands)
+{
+   Edi_Language_Index *index = data;
+
+   if (index->reload)
+     eina_hash_free(index->reload);
+   index->reload = commands;
+
+   _edi_language_index_update_timer_start(index);
+}
+
+static int
+_edi_language_index_location_cmp(const void *a, const void *b)
+{
+   const Edi_Language_Index_Location *location1 = a, *location2 = b;
+   int ret;
+
+   ret = strcmp(location1->path, location2->path);
+   if (ret)
+     return ret;
+
+   if (location1->line != location2->line)
+     return location1->line < location2->line ? -1 : 1;
+
+   return (int) location1->col - (int) location2->col;
+}
+
+/* Headers are seen by every file that includes them, so each location is only added once */
+static Eina_List *
+_edi_language_index_location_add(Eina_List *locations, Eina_Hash *seen, const Edi_Language_Index_Symbol *symbol)
+{
+   Edi_Language_Index_Location *location;
+   char key[PATH_MAX + 64];
+
+   snprintf(key, sizeof(key), "%s:%u:%u:%u", symbol->path, symbol->line, symbol->col, symbol->kind);
+   if (eina_hash_find(seen, key))
+     return locations;
+   eina_hash_add(seen, key, seen);
+
+   location = calloc(1, sizeof(Edi_Language_Index_Location));
+   location->path = eina_stringshare_add(symbol->path);
+   location->name = eina_stringshare_add(symbol->name);
+   location->line = symbol->line;
+   location->col = symbol->col;
+   location->offset = symbol->offset;
+   location->kind = symbol->kind;
+
+   return eina_list_append(locations, location);
+}
+
+static Eina_Bool
+_edi_language_index_name_match(const char *name, const char *text, size_t length)
+{
+   for (; *name; name++)
+     {
+        if (!strncasecmp(name, text, length))
+          return EINA_TRUE;
+     }
+
+   return EINA_FALSE;
+}
+#endif
+
+void
+edi_language_index_file_update(const char *path)
+{
+#if HAVE_LIBCLANG
+   Edi_Language_Index *index = _edi_language_index;
+
+   if (!index || !path)
+     return;
+
+   if (!eina_hash_find(index->queued, path))
+     eina_hash_add(index->queued, path, index);
+
+   _edi_language_index_update_timer_start(index);
+#else
+   (void) path;
+#endif
+}
+
+Eina_List *
+edi_language_index_usr_find(const char *usr, Edi_Language_Index_Kind kinds)
+{
+   Eina_List *locations = NULL;
+#if HAVE_LIBCLANG
+   Edi_Language_Index *index = _edi_language_index;
+   Edi_Language_Index_Symbol *symbol;
+   Eina_List *item;
+   Eina_Hash *seen;
+
+   if (!index || !usr || !usr[0])
+     return NULL;
+
+   seen = eina_hash_string_superfast_new(NULL);
+
+   eina_lock_take(&index->lock);
+   EINA_LIST_FOREACH(eina_hash_find(index->usrs, usr), item, symbol)
+     {
+        if (symbol->kind & kinds)
+          locations = _edi_language_index_location_add(locations, seen, symbol);
+     }
+   eina_lock_release(&index->lock);
+
+   eina_hash_free(seen);
+
+   locations = eina_list_sort(locations, 0, _edi_language_index_location_cmp);
+#else
+   (void) usr; (void) kinds;
+#endif
+
+   return locations;
+}
+
+Eina_List *
+edi_language_index_name_find(const char *name, Edi_Language_Index_Kind kinds, Eina_Bool exact)
+{
+   Eina_List *locations = NULL;
+#if HAVE_LIBCLANG
+   Edi_Language_Index *index = _edi_language_index;
+   Edi_Language_Index_Symbol *symbol;
+   Eina_Hash_Tuple *tuple;
+   Eina_Iterator *it;
+   Eina_List *item;
+   Eina_Hash *seen;
+   size_t length;
+
+   if (!index || !name || !name[0])
+     return NULL;
+
+   length = strlen(name);
+   seen = eina_hash_string_superfast_new(NULL);
+
+   eina_lock_take(&index->lock);
+   if (exact)
+     {
+        EINA_LIST_FOREACH(eina_hash_find(index->names, name), item, symbol)
+          {
+             if (symbol->kind & kinds)
+               locations = _edi_language_index_location_add(locations, seen, symbol);
+          }
+     }
+   else
+     {
+        // Each distinct name is matched once, not every symbol that has it
+        it = eina_hash_iterator_tuple_new(index->names);
+        EINA_ITERATOR_FOREACH(it, tuple)
+          {
+             if (!_edi_language_index_name_match(tuple->key, name, length))
+               continue;
+
+             EINA_LIST_FOREACH(tuple->data, item, symbol)
+               {
+                  if (symbol->kind & kinds)
+                    locations = _edi_language_index_location_add(locations, seen, symbol);
+               }
+          }
+        eina_iterator_free(it);
+     }
+   eina_lock_release(&index->lock);
+
+   eina_hash_free(seen);
+
+   locations = eina_list_sort(locations, 0, _edi_language_index_location_cmp);
+#else
+   (void) name; (void) kinds; (void) exact;
+#endif
+
+   return locations;
+}
+
+void
+edi_language_index_init(const char *directory)
+{
+#if HAVE_LIBCLANG
+   Edi_Language_Index *index;
+   int types[] = { EIO_MONITOR_FILE_CREATED, EIO_MONITOR_FILE_MODIFIED, EIO_MONITOR_FILE_DELETED };
+   unsigned int i;
+
+   if (_edi_language_index)
+     edi_language_index_shutdown();
+
+   index = calloc(1, sizeof(Edi_Language_Index));
+   // Clang reports real paths, so the project must be compared as one
+   index->directory = ecore_file_realpath(directory);
+   if (!index->directory || !index->directory[0])
+     {
+        free(index->directory);
+        index->directory = strdup(directory);
+     }
+   index->cache = strdup(_edi_project_config_dir_get());
+
+   eina_lock_new(&index->lock);
+   index->units = eina_hash_string_superfast_new(_edi_language_index_unit_free_cb);
+   index->usrs = eina_hash_string_superfast_new(NULL);
+   index->names = eina_hash_string_superfast_new(NULL);
+   index->queued = eina_hash_string_superfast_new(NULL);
+
+   index->handlers = eina_list_append(index->handlers,
+                                      ecore_event_handler_add(EDI_EVENT_FILE_SAVED, _edi_language_index_file_saved_cb, NULL));
+   for (i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+     index->handlers = eina_list_append(index->handlers,
+                                        ecore_event_handler_add(types[i], _edi_language_index_monitor_cb, NULL));
+
+   // The first scan starts once the C provider has the compile database
+   _edi_language_index = index;
+   edi_language_c_commands_listen(_edi_language_index_commands_cb, index);
+#else
+   (void) directory;
+#endif
+}
+
+void
+edi_language_index_shutdown(void)
+{
+#if HAVE_LIBCLANG
+   Edi_Language_Index *index = _edi_language_index;
+   Ecore_Event_Handler *handler;
+   Ecore_Thread *thread;
+   Eina_List *workers, *item;
+   char *path;
+
+   if (!index)
+     return;
+
+   _edi_language_index = NULL;
+   edi_language_c_commands_unlisten(_edi_language_index_commands_cb, index);
+   if (index->timer)
+     ecore_timer_del(index->timer);
+
+   if (index->scan)
+     {
+        ecore_thread_cancel(index->scan);
+        while ((ecore_thread_wait(index->scan, 0.1)) != EINA_TRUE);
+     }
+
+   // Waiting runs the cancel callback, which removes the worker from the list
+   workers = eina_list_clone(index->workers);
+   EINA_LIST_FOREACH(workers, item, thread)
+     ecore_thread_cancel(thread);
+   EINA_LIST_FREE(workers, thread)
+     while ((ecore_thread_wait(thread, 0.1)) != EINA_TRUE);
+
+   if (index->loaded && index->dirty)
+     _edi_language_index_save(index);
+
+   EINA_LIST_FREE(index->handlers, handler)
+     ecore_event_handler_del(handler);
+
+   EINA_LIST_FREE(index->queue, path)
+     free(path);
+   eina_hash_free(index->queued);
+   if (index->commands)
+     eina_hash_free(index->commands);
+   if (index->reload)
+     eina_hash_free(index->reload);
+   _edi_language_index_symbols_table_free(index->usrs);
+   _edi_language_index_symbols_table_free(index->names);
+   eina_hash_free(index->units);
+   eina_lock_free(&index->lock);
+   if (index->file)
+     {
+        eina_file_map_free(index->file, (void *) index->map);
+        eina_file_close(index->file);
+     }
+
+   free(index->cache);
+   free(index->directory);
+   free(index);
+#endif
+}
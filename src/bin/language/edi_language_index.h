@@ -0,0 +1,129 @@
+#ifndef EDI_LANGUAGE_INDEX_H_
+# define EDI_LANGUAGE_INDEX_H_
+
+#include <Eina.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief These routines are used for finding symbols across the whole project.
+ */
+
+/**
+ * @typedef Edi_Language_Index_Kind
+ * How a symbol appears at a location, these can be combined when searching.
+ */
+typedef enum _Edi_Language_Index_Kind
+{
+   EDI_LANGUAGE_INDEX_DEFINITION = 1 << 0,
+   EDI_LANGUAGE_INDEX_DECLARATION = 1 << 1,
+   EDI_LANGUAGE_INDEX_REFERENCE = 1 << 2,
+} Edi_Language_Index_Kind;
+
+#define EDI_LANGUAGE_INDEX_ALL (EDI_LANGUAGE_INDEX_DEFINITION | EDI_LANGUAGE_INDEX_DECLARATION | \
+                                EDI_LANGUAGE_INDEX_REFERENCE)
+
+/**
+ * @struct _Edi_Language_Index_Location
+ * A place in the project where a symbol appears.
+ */
+typedef struct _Edi_Language_Index_Location
+{
+   const char *path; /**< The file containing the symbol, a stringshare */
+   const char *name; /**< The name of the symbol, a stringshare */
+   unsigned int line; /**< The line number of the symbol, starting at 1 */
+   unsigned int col; /**< The column of the symbol within the line, starting at 1 */
+   size_t offset; /**< The byte offset of the start of the line within the file */
+   Edi_Language_Index_Kind kind;
+} Edi_Language_Index_Location;
+
+/**
+ * @brief Symbol index functions.
+ * @defgroup Symbols
+ *
+ * @{
+ *
+ * Every file in the compile database of a C project is indexed in the
+ * background, a file on each core, recording where each symbol within the
+ * project is defined, declared and referenced. Symbols are identified by
+ * the unique name clang gives them so that a lookup finds exactly the
+ * uses of the symbol under the cursor rather than anything with the same name.
+ * The index is saved in the project config directory. When it is loaded a
+ * file is only indexed again if its content, flags or included project
+ * files have changed.
+ *
+ */
+
+/**
+ * Load or build the symbol index for a project in the background.
+ *
+ * @param directory The root directory of the project.
+ *
+ * @ingroup Symbols
+ */
+void edi_language_index_init(const char *directory);
+
+/**
+ * Stop indexing, save any changes and free the index.
+ *
+ * @ingroup Symbols
+ */
+void edi_language_index_shutdown(void);
+
+/**
+ * Request that the files affected by a change be indexed again.
+ * Requests are batched and processed in the background.
+ *
+ * @param path The path of the file that changed.
+ *
+ * @ingroup Symbols
+ */
+void edi_language_index_file_update(const char *path);
+
+/**
+ * Find where a symbol appears in the project.
+ *
+ * @param usr The unique name of the symbol, as returned by the language provider.
+ * @param kinds The kinds of location to return.
+ * @return A list of Edi_Language_Index_Location sorted by file and position,
+ *         to be freed with edi_language_index_locations_free().
+ *
+ * @ingroup Symbols
+ */
+Eina_List *edi_language_index_usr_find(const char *usr, Edi_Language_Index_Kind kinds);
+
+/**
+ * Find symbols in the project by name.
+ *
+ * @param name The name to look for.
+ * @param kinds The kinds of location to return.
+ * @param exact EINA_TRUE to only match the whole name, otherwise any name
+ *        containing it, ignoring case, is matched.
+ * @return A list of Edi_Language_Index_Location sorted by file and position,
+ *         to be freed with edi_language_index_locations_free().
+ *
+ * @ingroup Symbols
+ */
+Eina_List *edi_language_index_name_find(const char *name, Edi_Language_Index_Kind kinds, Eina_Bool exact);
+
+/**
+ * Free a list of locations returned by a lookup.
+ *
+ * @param locations The list of Edi_Language_Index_Location to free.
+ *
+ * @ingroup Symbols
+ */
+void edi_language_index_locations_free(Eina_List *locations);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_LANGUAGE_INDEX_H_ */
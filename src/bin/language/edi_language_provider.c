@@ -17,21 +17,21 @@ static Edi_Language_Provider _edi_language_provider_registry[] =
    {
       "c", _edi_language_c_add, _edi_language_c_refresh, _edi_language_c_del,
       _edi_language_c_mime_name, _edi_language_c_snippet_get,
-      _edi_language_c_lookup, _edi_language_c_lookup_doc
+      _edi_language_c_lookup, _edi_language_c_lookup_doc, _edi_language_c_symbol_get
    },
    {
       "python", _edi_language_python_add, _edi_language_python_refresh, _edi_language_python_del,
       _edi_language_python_mime_name, _edi_language_python_snippet_get,
-      NULL, NULL
+      NULL, NULL, NULL
    },
    {
       "rust", _edi_language_rust_add, _edi_language_rust_refresh, _edi_language_rust_del,
       _edi_language_rust_mime_name, _edi_language_rust_snippet_get,
-      NULL, NULL
+      NULL, NULL, NULL
    },
 
 
-   {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL}
+   {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL}
 };
 
 Edi_Language_Provider *edi_language_provider_get(Edi_Editor *editor)
@@ -78,12 +78,9 @@ edi_language_provider_has(Edi_Editor *editor)
 }
 
 void
-edi_language_suggest_item_free(Edi_Language_Suggest_Item *item)
+edi_language_provider_shutdown(void)
 {
-   free((char *)item->summary);
-   free((char *)item->detail);
-
-   free(item);
+   _edi_language_c_shutdown();
 }
 
 void
@@ -2,6 +2,8 @@
 # define EDI_EDITOR_SUGGEST_PROVIDER_H_
 
 #include "editor/edi_editor.h"
+#include "language/edi_language_suggest.h"
+#include "language/edi_language_cache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,16 +15,6 @@ extern "C" {
  * i.e. like autosuggest in visual studio.
  */
 
-/**
- * @typedef Edi_Editor_Suggest_Item
- * A handle for passing a suggest item to the ui and back
- */
-typedef struct _Edi_Language_Suggest_Item
-{
-   const char *summary;
-   const char *detail;
-} Edi_Language_Suggest_Item;
-
 typedef struct _Edi_Language_Document
 {
    Eina_Strbuf *title;
@@ -31,6 +23,25 @@ typedef struct _Edi_Language_Document
    Eina_Strbuf *ret;
    Eina_Strbuf *see;
 } Edi_Language_Document;
+
+/**
+ * @typedef Edi_Language_Document_Cb
+ * Receive the documentation looked up at a position, called in the main loop.
+ *
+ * @param data The data passed with the lookup.
+ * @param doc The documentation, owned by the receiver, or NULL if there is none.
+ */
+typedef void (*Edi_Language_Document_Cb)(void *data, Edi_Language_Document *doc);
+
+/**
+ * @typedef Edi_Language_Symbol_Cb
+ * Receive the symbol looked up at a position, called in the main loop.
+ *
+ * @param data The data passed with the lookup.
+ * @param usr The unique name of the symbol, owned by the receiver, or NULL if there is none.
+ */
+typedef void (*Edi_Language_Symbol_Cb)(void *data, char *usr);
+
 /**
  * @struct Edi_Editor_Suggest_Provider
  * A description of the requirements for a suggestion provider.
@@ -46,8 +57,14 @@ typedef struct _Edi_Language_Provider
    void (*del)(Edi_Editor *editor);
    const char *(*mime_name)(const char *mime);
    const char *(*snippet_get)(const char *key);
+   /* Runs in a thread, the editor must only be used between ecore_thread_main_loop_begin() and _end() */
    Eina_List *(*lookup)(Edi_Editor *editor, unsigned int row, unsigned int col);
-   Edi_Language_Document *(*lookup_doc)(Edi_Editor *editor, unsigned int row, unsigned int col);
+   /* Lookups call back from the main loop, or not at all if they return EINA_FALSE or the editor is closed first */
+   Eina_Bool (*lookup_doc)(Edi_Editor *editor, unsigned int row, unsigned int col,
+                           Edi_Language_Document_Cb cb, const void *data);
+   /* The unique name of the symbol at a position, for finding it in the project index */
+   Eina_Bool (*symbol_get)(Edi_Editor *editor, unsigned int row, unsigned int col,
+                           Edi_Language_Symbol_Cb cb, const void *data);
 } Edi_Language_Provider;
 
 /**
@@ -87,13 +104,108 @@ Edi_Language_Provider *edi_language_provider_for_mime_get(const char *mime);
 Eina_Bool edi_language_provider_has(Edi_Editor *editor);
 
 /**
- * Free a suggest item.
+ * Release the state that providers share between editors, such as parsed files.
  *
- * @param item the suggest item to free
+ * @ingroup Lookup
+ */
+void edi_language_provider_shutdown(void);
+
+#if HAVE_LIBCLANG
+/**
+ * @typedef Edi_Clang_Command
+ * The flags to parse a C file with, the arguments are stringshares.
+ */
+typedef struct _Edi_Clang_Command
+{
+   const char **args;
+   unsigned int argc;
+} Edi_Clang_Command;
+
+/**
+ * Receive the compile database of the project, called in the main loop.
+ *
+ * @param data The data passed to edi_language_c_commands_listen().
+ * @param commands The Edi_Clang_Command of each file, by real path, owned by the receiver.
+ */
+typedef void (*Edi_Language_C_Commands_Cb)(void *data, Eina_Hash *commands);
+
+/**
+ * Share the compile database the C provider loads, rather than reading it again.
+ * The callback is called once the database is loaded, at once if it already is,
+ * and again each time it is reloaded.
+ *
+ * @param cb the function to call with the database
+ * @param data passed to the callback
  *
  * @ingroup Lookup
  */
-void edi_language_suggest_item_free(Edi_Language_Suggest_Item *item);
+void edi_language_c_commands_listen(Edi_Language_C_Commands_Cb cb, const void *data);
+
+/**
+ * Stop receiving the compile database.
+ *
+ * @param cb the function passed to edi_language_c_commands_listen()
+ * @param data the data passed to edi_language_c_commands_listen()
+ *
+ * @ingroup Lookup
+ */
+void edi_language_c_commands_unlisten(Edi_Language_C_Commands_Cb cb, const void *data);
+
+/**
+ * Query whether the C file of an editor is parsed, so its highlighting and
+ * diagnostics can be looked up.
+ *
+ * @param editor the editor session for a C file, this must be called from the main loop
+ *
+ * @return EINA_FALSE if the file is being parsed or could not be
+ *
+ * @ingroup Lookup
+ */
+Eina_Bool edi_language_c_unit_ready(Edi_Editor *editor);
+
+/**
+ * Look up the highlighting of a range of lines of a C file.
+ * This waits for the helper process that parsed the file so must be called from a thread.
+ *
+ * @param editor the editor session for a C file
+ * @param first_line the first line to highlight
+ * @param last_line the last line to highlight
+ * @param results the highlighted ranges found are appended to the tokens of this
+ *
+ * @return EINA_FALSE if the file is not parsed or the helper stopped
+ *
+ * @ingroup Lookup
+ */
+Eina_Bool edi_language_c_highlight_get(Edi_Editor *editor, unsigned int first_line, unsigned int last_line,
+                                       Edi_Language_Cache *results);
+
+/**
+ * Look up the diagnostics of a C file.
+ * This waits for the helper process that parsed the file so must be called from a thread.
+ *
+ * @param editor the editor session for a C file
+ * @param results the line statuses found are appended to the statuses of this
+ *
+ * @return EINA_FALSE if the file is not parsed or the helper stopped
+ *
+ * @ingroup Lookup
+ */
+Eina_Bool edi_language_c_diagnostics_get(Edi_Editor *editor, Edi_Language_Cache *results);
+
+/**
+ * Get what parsing the C file of an editor depends on, other than its content.
+ *
+ * @param editor the editor session for a C file, this must be called from the main loop
+ * @param args set to the flags the file is compiled with, a stringshare to release
+ * @param includes if not NULL, set to a list of the Edi_Language_Cache_Include the last
+ *        parse read, to free with edi_language_cache_includes_free()
+ *
+ * @return EINA_FALSE if the flags of the file are not known yet
+ *
+ * @ingroup Lookup
+ */
+Eina_Bool edi_language_c_unit_depends_get(Edi_Editor *editor, const char **args, Eina_List **includes);
+#endif
 
 /**
  * Free a suggest document.
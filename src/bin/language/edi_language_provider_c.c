@@ -8,113 +8,1330 @@
 #endif
 
 #include <Eina.h>
+#include <Eio.h>
 #include <Elementary.h>
 
 #include "edi_language_provider.h"
+#if HAVE_LIBCLANG
+#include "edi_language_cache.h"
+#include "edi_language_clang.h"
+#endif
 
 #include "edi_config.h"
 
-#include "edi_private.h"
+#include "edi_private.h"
+
+#if HAVE_LIBCLANG
+
+#define EDI_CLANG_COMMANDS_RELOAD_DELAY 1.0
+#define EDI_CLANG_COMMANDS_HEADER_CANDIDATES 16
+
+/* A compile database being read in a thread */
+typedef struct _Edi_Clang_Commands_Load
+{
+   char *directory;
+   Eina_Hash *commands;
+} Edi_Clang_Commands_Load;
+
+typedef struct _Edi_Clang_Header_Candidate
+{
+   const char *path;
+   Edi_Clang_Command *command;
+   int score;
+} Edi_Clang_Header_Candidate;
+
+typedef struct _Edi_Clang_Header_Candidates
+{
+   const char *header;
+   Eina_Inarray *list;
+} Edi_Clang_Header_Candidates;
+
+typedef struct _Edi_Clang_Commands_Listener
+{
+   Edi_Language_C_Commands_Cb cb;
+   void *data;
+} Edi_Clang_Commands_Listener;
+
+/* The compile database of the project, by absolute file path */
+static Eina_Hash *_clang_commands = NULL;
+/* Headers that are not in the database, pointing at the command they inherit */
+static Eina_Hash *_clang_commands_headers = NULL;
+static char *_clang_commands_directory = NULL;
+static Ecore_Thread *_clang_commands_thread = NULL;
+static Ecore_Timer *_clang_commands_timer = NULL;
+static Eina_List *_clang_commands_monitors = NULL;
+static Eina_List *_clang_commands_handlers = NULL;
+/* Editors that were opened while the database was loading */
+static Eina_List *_clang_commands_pending = NULL;
+/* The Edi_Clang_Commands_Listener told each time the database loads */
+static Eina_List *_clang_commands_listeners = NULL;
+
+static void
+_clang_command_free(Edi_Clang_Command *command)
+{
+   unsigned int i;
+
+   for (i = 0; i < command->argc; i++)
+     eina_stringshare_del(command->args[i]);
+
+   free(command->args);
+   free(command);
+}
+
+static void
+_clang_command_free_cb(void *data)
+{
+   _clang_command_free(data);
+}
+
+static Edi_Clang_Command *
+_clang_command_copy(const Edi_Clang_Command *command)
+{
+   Edi_Clang_Command *copy;
+   unsigned int i;
+
+   copy = calloc(1, sizeof(Edi_Clang_Command));
+   copy->args = malloc(sizeof(char *) * (command->argc + 1));
+   for (i = 0; i < command->argc; i++)
+     copy->args[i] = eina_stringshare_ref(command->args[i]);
+   copy->argc = command->argc;
+
+   return copy;
+}
+
+static Edi_Clang_Command *
+_clang_command_fallback_get(void)
+{
+   Edi_Clang_Command *command;
+   char **split;
+   unsigned int i, count;
+
+   split = eina_str_split_full("-I/usr/include/ " EFL_CFLAGS " " CLANG_INCLUDES " -Wall -Wextra",
+                               " ", 0, &count);
+
+   command = calloc(1, sizeof(Edi_Clang_Command));
+   command->args = malloc(sizeof(char *) * (count + 1));
+   for (i = 0; i < count; i++)
+     {
+        if (split[i][0])
+          command->args[command->argc++] = eina_stringshare_add(split[i]);
+     }
+
+   free(split[0]);
+   free(split);
+
+   return command;
+}
+
+/* Only the include paths and definitions are kept, relative to the directory of the command */
+static Edi_Clang_Command *
+_clang_command_new(CXCompileCommand compile, const char *directory)
+{
+   Edi_Clang_Command *command;
+   unsigned int i, numargs;
+
+   numargs = clang_CompileCommand_getNumArgs(compile);
+
+   command = calloc(1, sizeof(Edi_Clang_Command));
+   command->args = malloc(sizeof(char *) * (numargs + 2));
+   command->args[command->argc++] = eina_stringshare_add(CLANG_INCLUDES);
+   for (i = 1; i < numargs; i++)
+     {
+        const char *argstr;
+        CXString argument = clang_CompileCommand_getArg(compile, i);
+        argstr = clang_getCString(argument);
+
+        if (argstr && strlen(argstr) > 2 && argstr[0] == '-' &&
+            (argstr[1] == 'I' || argstr[1] == 'D'))
+          command->args[command->argc++] = eina_stringshare_add(argstr);
+
+        clang_disposeString(argument);
+     }
+   command->args[command->argc++] = eina_stringshare_printf("-working-directory=%s", directory);
+
+   return command;
+}
+
+static char *
+_clang_commands_directory_get(void)
+{
+   if (edi_project_file_exists("build/compile_commands.json"))
+     return edi_project_file_path_get("build");
+
+   return strdup(edi_project_get());
+}
+
+static void
+_clang_commands_load_cb(void *data, Ecore_Thread *thread)
+{
+   Edi_Clang_Commands_Load *load = data;
+   CXCompilationDatabase_Error error;
+   CXCompilationDatabase database;
+   CXCompileCommands commands;
+   CXCompileCommand compile;
+   CXString filename, directory;
+   char *path, *real;
+   unsigned int i, count;
+
+   database = clang_CompilationDatabase_fromDirectory(load->directory, &error);
+   if (database == NULL || error == CXCompilationDatabase_CanNotLoadDatabase)
+     {
+        INF("Could not load compile_commands.json in %s", load->directory);
+        return;
+     }
+
+   commands = clang_CompilationDatabase_getAllCompileCommands(database);
+   count = clang_CompileCommands_getSize(commands);
+   for (i = 0; i < count && !ecore_thread_check(thread); i++)
+     {
+        compile = clang_CompileCommands_getCommand(commands, i);
+        filename = clang_CompileCommand_getFilename(compile);
+        directory = clang_CompileCommand_getDirectory(compile);
+
+        if (clang_getCString(filename)[0] == '/')
+          path = strdup(clang_getCString(filename));
+        else
+          path = edi_path_append(clang_getCString(directory), clang_getCString(filename));
+
+        // Match the paths the editors use, not ../src/file.c
+        real = ecore_file_realpath(path);
+        if (real && real[0])
+          eina_hash_set(load->commands, real, _clang_command_new(compile, clang_getCString(directory)));
+        free(real);
+        free(path);
+
+        clang_disposeString(filename);
+        clang_disposeString(directory);
+     }
+
+   INF("Loaded %u compile commands from %s", count, load->directory);
+   clang_CompileCommands_dispose(commands);
+   clang_CompilationDatabase_dispose(database);
+}
+
+static void _clang_commands_load(void);
+static void _clang_commands_loaded(void);
+
+static Eina_Bool
+_clang_commands_copy_cb(const Eina_Hash *hash EINA_UNUSED, const void *key, void *data, void *fdata)
+{
+   eina_hash_add(fdata, key, _clang_command_copy(data));
+   return EINA_TRUE;
+}
+
+static void
+_clang_commands_listener_call(Edi_Clang_Commands_Listener *listener)
+{
+   Eina_Hash *commands;
+
+   commands = eina_hash_string_superfast_new(_clang_command_free_cb);
+   eina_hash_foreach(_clang_commands, _clang_commands_copy_cb, commands);
+   listener->cb(listener->data, commands);
+}
+
+static void
+_clang_commands_load_end_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Clang_Commands_Load *load = data;
+   Edi_Clang_Commands_Listener *listener;
+   Eina_List *item;
+
+   _clang_commands_thread = NULL;
+
+   if (_clang_commands)
+     eina_hash_free(_clang_commands);
+   _clang_commands = load->commands;
+   eina_hash_free_buckets(_clang_commands_headers);
+
+   free(_clang_commands_directory);
+   _clang_commands_directory = load->directory;
+   free(load);
+
+   EINA_LIST_FOREACH(_clang_commands_listeners, item, listener)
+     _clang_commands_listener_call(listener);
+
+   _clang_commands_loaded();
+}
+
+static void
+_clang_commands_load_cancel_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Clang_Commands_Load *load = data;
+
+   _clang_commands_thread = NULL;
+
+   eina_hash_free(load->commands);
+   free(load->directory);
+   free(load);
+}
+
+static Eina_Bool
+_clang_commands_reload_cb(void *data EINA_UNUSED)
+{
+   if (_clang_commands_thread)
+     return ECORE_CALLBACK_RENEW;
+
+   _clang_commands_timer = NULL;
+   _clang_commands_load();
+
+   return ECORE_CALLBACK_CANCEL;
+}
+
+static Eina_Bool
+_clang_commands_monitor_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *event)
+{
+   Eio_Monitor_Event *ev = event;
+   const char *name;
+
+   if (!eina_list_data_find(_clang_commands_monitors, ev->monitor))
+     return ECORE_CALLBACK_PASS_ON;
+
+   // The build directory may be created after the project was opened
+   name = ecore_file_file_get(ev->filename);
+   if (strcmp(name, "compile_commands.json") && strcmp(name, "build"))
+     return ECORE_CALLBACK_PASS_ON;
+
+   // Build tools write it a piece at a time, wait for them to finish
+   if (_clang_commands_timer)
+     ecore_timer_reset(_clang_commands_timer);
+   else
+     _clang_commands_timer = ecore_timer_add(EDI_CLANG_COMMANDS_RELOAD_DELAY,
+                                             _clang_commands_reload_cb, NULL);
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+static void
+_clang_commands_monitors_add(void)
+{
+   int types[] = { EIO_MONITOR_FILE_CREATED, EIO_MONITOR_FILE_MODIFIED, EIO_MONITOR_FILE_DELETED,
+                   EIO_MONITOR_DIRECTORY_CREATED };
+   Eio_Monitor *monitor;
+   char *build;
+   unsigned int i;
+
+   if (!_clang_commands_handlers)
+     {
+        for (i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+          _clang_commands_handlers = eina_list_append(_clang_commands_handlers,
+                                                      ecore_event_handler_add(types[i], _clang_commands_monitor_cb, NULL));
+     }
+
+   // The project or its build directory may have changed since the last load
+   EINA_LIST_FREE(_clang_commands_monitors, monitor)
+     eio_monitor_del(monitor);
+
+   _clang_commands_monitors = eina_list_append(_clang_commands_monitors, eio_monitor_add(edi_project_get()));
+   build = edi_project_file_path_get("build");
+   if (ecore_file_is_dir(build))
+     _clang_commands_monitors = eina_list_append(_clang_commands_monitors, eio_monitor_add(build));
+   free(build);
+}
+
+static void
+_clang_commands_load(void)
+{
+   Edi_Clang_Commands_Load *load;
+
+   if (!_clang_commands_headers)
+     _clang_commands_headers = eina_hash_string_superfast_new(NULL);
+   _clang_commands_monitors_add();
+
+   load = calloc(1, sizeof(Edi_Clang_Commands_Load));
+   load->directory = _clang_commands_directory_get();
+   load->commands = eina_hash_string_superfast_new(_clang_command_free_cb);
+
+   _clang_commands_thread = ecore_thread_run(_clang_commands_load_cb, _clang_commands_load_end_cb,
+                                             _clang_commands_load_cancel_cb, load);
+}
+
+static int
+_clang_header_candidate_cmp(const void *a, const void *b)
+{
+   const Edi_Clang_Header_Candidate *candidate1 = a, *candidate2 = b;
+
+   return candidate2->score - candidate1->score;
+}
+
+static Eina_Bool
+_clang_header_candidates_cb(const Eina_Hash *hash EINA_UNUSED, const void *key,
+                            void *data, void *fdata)
+{
+   Edi_Clang_Header_Candidates *candidates = fdata;
+   Edi_Clang_Header_Candidate candidate;
+   const char *path = key, *name, *ext;
+   int i;
+
+   candidate.path = path;
+   candidate.command = data;
+   candidate.score = 0;
+
+   // Closer sources share more of the directory with the header
+   for (i = 0; path[i] && path[i] == candidates->header[i]; i++)
+     if (path[i] == '/')
+       candidate.score++;
+
+   // file.h is most likely parsed as part of file.c
+   name = ecore_file_file_get(candidates->header);
+   ext = strrchr(name, '.');
+   if (ext && !strncmp(ecore_file_file_get(path), name, ext - name + 1))
+     candidate.score += 1000;
+
+   eina_inarray_push(candidates->list, &candidate);
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_clang_header_included(const char *path, const char *name)
+{
+   Eina_File *f;
+   const char *map, *pos, *end;
+   size_t length;
+   Eina_Bool found = EINA_FALSE;
+
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return EINA_FALSE;
+
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (map)
+     {
+        length = strlen(name);
+        end = map + eina_file_size_get(f);
+        for (pos = map; pos + length <= end && !found; pos++)
+          {
+             pos = memchr(pos, name[0], end - pos);
+             if (!pos)
+               break;
+
+             // The name as it is written in an #include, not part of a longer one
+             if (pos + length <= end && !memcmp(pos, name, length) && pos > map &&
+                 (pos[-1] == '"' || pos[-1] == '/' || pos[-1] == '<'))
+               found = EINA_TRUE;
+          }
+        eina_file_map_free(f, (void *) map);
+     }
+   eina_file_close(f);
+
+   return found;
+}
+
+/* A header takes the flags of the nearest source that includes it */
+static Edi_Clang_Command *
+_clang_header_command_get(const char *path)
+{
+   Edi_Clang_Header_Candidates candidates;
+   Edi_Clang_Header_Candidate *candidate;
+   Edi_Clang_Command *command;
+   unsigned int i, count;
+
+   command = eina_hash_find(_clang_commands_headers, path);
+   if (command)
+     return command;
+
+   candidates.header = path;
+   candidates.list = eina_inarray_new(sizeof(Edi_Clang_Header_Candidate), 0);
+   eina_hash_foreach(_clang_commands, _clang_header_candidates_cb, &candidates);
+
+   count = eina_inarray_count(candidates.list);
+   if (count)
+     {
+        qsort(candidates.list->members, count, sizeof(Edi_Clang_Header_Candidate),
+              _clang_header_candidate_cmp);
+
+        command = ((Edi_Clang_Header_Candidate *) eina_inarray_nth(candidates.list, 0))->command;
+        for (i = 0; i < count && i < EDI_CLANG_COMMANDS_HEADER_CANDIDATES; i++)
+          {
+             candidate = eina_inarray_nth(candidates.list, i);
+             if (_clang_header_included(candidate->path, ecore_file_file_get(path)))
+               {
+                  command = candidate->command;
+                  break;
+               }
+          }
+        eina_hash_add(_clang_commands_headers, path, command);
+     }
+
+   eina_inarray_free(candidates.list);
+   return command;
+}
+
+static Eina_Bool
+_clang_header_is(const char *path)
+{
+   return eina_str_has_extension(path, ".h") || eina_str_has_extension(path, ".hh") ||
+          eina_str_has_extension(path, ".hpp") || eina_str_has_extension(path, ".hxx");
+}
+
+/* The flags to parse a file with, which must be freed. NULL if the database is still loading */
+static Edi_Clang_Command *
+_clang_commands_get(const char *path)
+{
+   Edi_Clang_Command *command;
+   char *directory;
+
+   if (_clang_commands_thread)
+     return NULL;
+
+   directory = _clang_commands_directory_get();
+   if (!_clang_commands || strcmp(directory, _clang_commands_directory))
+     {
+        free(directory);
+        _clang_commands_load();
+        return NULL;
+     }
+   free(directory);
+
+   command = eina_hash_find(_clang_commands, path);
+   if (!command && _clang_header_is(path))
+     command = _clang_header_command_get(path);
+   if (command)
+     return _clang_command_copy(command);
+
+   INF("File %s not found in compile_commands.json", path);
+   return _clang_command_fallback_get();
+}
+
+static void
+_clang_commands_shutdown(void)
+{
+   Edi_Clang_Commands_Listener *listener;
+   Ecore_Event_Handler *handler;
+   Eio_Monitor *monitor;
+
+   if (_clang_commands_thread)
+     {
+        ecore_thread_cancel(_clang_commands_thread);
+        while ((ecore_thread_wait(_clang_commands_thread, 0.1)) != EINA_TRUE);
+     }
+   if (_clang_commands_timer)
+     ecore_timer_del(_clang_commands_timer);
+   _clang_commands_timer = NULL;
+
+   EINA_LIST_FREE(_clang_commands_handlers, handler)
+     ecore_event_handler_del(handler);
+   EINA_LIST_FREE(_clang_commands_monitors, monitor)
+     eio_monitor_del(monitor);
+   _clang_commands_pending = eina_list_free(_clang_commands_pending);
+   EINA_LIST_FREE(_clang_commands_listeners, listener)
+     free(listener);
+
+   if (_clang_commands_headers)
+     eina_hash_free(_clang_commands_headers);
+   _clang_commands_headers = NULL;
+   if (_clang_commands)
+     eina_hash_free(_clang_commands);
+   _clang_commands = NULL;
+   free(_clang_commands_directory);
+   _clang_commands_directory = NULL;
+}
+
+void
+edi_language_c_commands_listen(Edi_Language_C_Commands_Cb cb, const void *data)
+{
+   Edi_Clang_Commands_Listener *listener;
+   char *directory;
+
+   listener = calloc(1, sizeof(Edi_Clang_Commands_Listener));
+   listener->cb = cb;
+   listener->data = (void *) data;
+   _clang_commands_listeners = eina_list_append(_clang_commands_listeners, listener);
+
+   if (_clang_commands_thread)
+     return;
+
+   // Nothing may have needed the database yet, or it is of another project
+   directory = _clang_commands_directory_get();
+   if (!_clang_commands || strcmp(directory, _clang_commands_directory))
+     _clang_commands_load();
+   else
+     _clang_commands_listener_call(listener);
+   free(directory);
+}
+
+void
+edi_language_c_commands_unlisten(Edi_Language_C_Commands_Cb cb, const void *data)
+{
+   Edi_Clang_Commands_Listener *listener;
+   Eina_List *item, *next;
+
+   EINA_LIST_FOREACH_SAFE(_clang_commands_listeners, item, next, listener)
+     {
+        if (listener->cb == cb && listener->data == data)
+          {
+             _clang_commands_listeners = eina_list_remove_list(_clang_commands_listeners, item);
+             free(listener);
+          }
+     }
+}
+
+/* The text of an editor, as it is parsed instead of the file on disk */
+static Eina_Strbuf *
+_clang_contents_get(Edi_Editor *editor)
+{
+   Elm_Code *code;
+   Elm_Code_Line *line;
+   Eina_Strbuf *buf;
+   Eina_List *item;
+   const char *text;
+   unsigned int length;
+
+   code = elm_code_widget_code_get(editor->entry);
+   buf = eina_strbuf_new();
+   EINA_LIST_FOREACH(code->file->lines, item, line)
+     {
+        text = elm_code_line_text_get(line, &length);
+        if (length)
+          eina_strbuf_append_length(buf, text, length);
+        eina_strbuf_append_char(buf, '\n');
+     }
+
+   return buf;
+}
+
+/* A file parsed in one of the edi_clang helpers, shared by all the editors open
+ * on it. Once they are all closed it is kept, in least recently used order,
+ * until the memory budget is exceeded so that opening it again only needs a reparse. */
+typedef struct _Edi_Clang_Unit
+{
+   unsigned int id;
+   const char *path;
+   const char *args;
+   Edi_Clang_Command *command;
+   Edi_Language_Clang_Worker *worker;
+   Eina_List *editors;
+   unsigned long size;
+   /* The real paths of the files the unit includes, to know which saves affect it */
+   Eina_Hash *includes;
+
+   /* A parse has been sent to the helper, requests wait for it to finish */
+   Eina_Bool parsing;
+   /* The parse is of the file on disk rather than the contents of an editor */
+   Eina_Bool parsing_disk;
+   /* The helper holds a parse of the file that requests can use */
+   Eina_Bool parsed;
+   /* The file was changed while it was being parsed */
+   Eina_Bool dirty;
+   /* The number of times the helper stopped while it was working on the file */
+   unsigned int crashes;
+   /* The file crashes the helper, it is not parsed again until it is saved */
+   Eina_Bool broken;
+} Edi_Clang_Unit;
+
+/* A request about the symbol at a position, sent from the main loop for an
+ * editor that may be closed before the reply comes back */
+typedef struct _Edi_Clang_Lookup
+{
+   Edi_Editor *editor;
+   Edi_Language_Document_Cb doc_cb;
+   Edi_Language_Symbol_Cb symbol_cb;
+   const void *data;
+} Edi_Clang_Lookup;
+
+/* A unit that keeps crashing its helper is given up on after this many restarts */
+#define EDI_CLANG_UNIT_CRASHES_MAX 2
+/* How long a completion may wait for a helper, in seconds */
+#define EDI_CLANG_COMPLETE_TIMEOUT 10.0
+
+static Ecore_Event_Handler *_clang_file_saved_handler = NULL;
+/* Most recently used first */
+static Eina_List *_clang_units = NULL;
+static unsigned int _clang_unit_next_id = 0;
+/* The lookups waiting for a reply */
+static Eina_List *_clang_lookups = NULL;
+
+static const char *
+_clang_args_key_get(const Edi_Clang_Command *command)
+{
+   Eina_Strbuf *buf;
+   const char *key;
+   unsigned int i;
+
+   buf = eina_strbuf_new();
+   for (i = 0; i < command->argc; i++)
+     {
+        eina_strbuf_append(buf, command->args[i]);
+        eina_strbuf_append_char(buf, ' ');
+     }
+
+   key = eina_stringshare_add(eina_strbuf_string_get(buf));
+   eina_strbuf_free(buf);
+
+   return key;
+}
+
+static void
+_clang_unit_free(Edi_Clang_Unit *cache)
+{
+   _clang_units = eina_list_remove(_clang_units, cache);
+
+   if (cache->worker)
+     {
+        edi_language_clang_send(cache->worker, EDI_CLANG_MESSAGE_FREE, cache->id, NULL, NULL, NULL);
+        edi_language_clang_worker_put(cache->worker);
+     }
+   if (cache->includes)
+     eina_hash_free(cache->includes);
+   eina_stringshare_del(cache->path);
+   eina_stringshare_del(cache->args);
+   _clang_command_free(cache->command);
+   free(cache);
+}
+
+static void
+_clang_units_trim(void)
+{
+   Edi_Clang_Unit *cache;
+   Eina_List *item, *prev;
+   unsigned long total = 0, budget;
+
+   EINA_LIST_FOREACH(_clang_units, item, cache)
+     total += cache->size;
+
+   budget = (unsigned long) _edi_config->clang_cache_size * 1024 * 1024;
+   EINA_LIST_REVERSE_FOREACH_SAFE(_clang_units, item, prev, cache)
+     {
+        if (total <= budget)
+          break;
+        if (cache->editors || cache->parsing)
+          continue;
+
+        INF("Dropping parsed %s from the cache", cache->path);
+        total -= cache->size;
+        _clang_unit_free(cache);
+     }
+}
+
+static Edi_Clang_Unit *
+_clang_unit_for_editor_get(Edi_Editor *editor)
+{
+   Edi_Clang_Unit *cache;
+   Eina_List *item;
+
+   EINA_LIST_FOREACH(_clang_units, item, cache)
+     {
+        if (eina_list_data_find(cache->editors, editor))
+          return cache;
+     }
+
+   return NULL;
+}
+
+/* The unit of an editor if requests can be sent for it now, not while it is being parsed */
+static Edi_Clang_Unit *
+_clang_unit_ready_get(Edi_Editor *editor)
+{
+   Edi_Clang_Unit *cache;
+
+   cache = _clang_unit_for_editor_get(editor);
+   if (!cache || cache->parsing || !cache->parsed)
+     return NULL;
+
+   return cache;
+}
+
+/* The included files, each with the modification time it had when it was parsed */
+static Eina_Hash *
+_clang_unit_includes_read(Edi_Clang_Message_Reader *reader)
+{
+   Eina_Hash *includes;
+   long long *mtime;
+   const char *data;
+   char *path;
+   unsigned int count, length, i;
+
+   if (!edi_clang_message_uint_get(reader, &count))
+     return NULL;
+
+   includes = eina_hash_string_superfast_new(free);
+   for (i = 0; i < count; i++)
+     {
+        path = edi_clang_message_string_get(reader);
+        if (!path)
+          break;
+        if (!edi_clang_message_data_get(reader, &data, &length) || length != sizeof(long long))
+          {
+             free(path);
+             break;
+          }
+
+        if (path[0] && !eina_hash_find(includes, path))
+          {
+             mtime = malloc(sizeof(long long));
+             memcpy(mtime, data, sizeof(long long));
+             eina_hash_add(includes, path, mtime);
+          }
+        free(path);
+     }
+
+   return includes;
+}
+
+static void _clang_unit_parse(Edi_Clang_Unit *cache, Edi_Editor *editor);
+
+static void
+_clang_unit_parse_cb(void *data, const Eina_Binbuf *reply)
+{
+   Edi_Clang_Unit *cache = data;
+   Edi_Clang_Message_Reader reader;
+   Edi_Editor *editor;
+   Eina_Hash *includes = NULL;
+   Eina_List *item;
+   unsigned int size = 0;
+   Eina_Bool from_disk;
+
+   from_disk = cache->parsing_disk;
+   cache->parsing = EINA_FALSE;
+   cache->parsed = !!reply;
+   if (reply)
+     {
+        edi_clang_message_reader_init(&reader, reply);
+        if (edi_clang_message_uint_get(&reader, &size))
+          includes = _clang_unit_includes_read(&reader);
+
+        cache->size = (unsigned long) size * 1024;
+        if (includes)
+          {
+             if (cache->includes)
+               eina_hash_free(cache->includes);
+             cache->includes = includes;
+          }
+     }
+
+   // Catch up with the edits that were made while this was parsing
+   EINA_LIST_FOREACH(cache->editors, item, editor)
+     {
+        if (cache->dirty || (from_disk && editor->modified))
+          {
+             cache->dirty = EINA_FALSE;
+             _clang_unit_parse(cache, editor);
+             return;
+          }
+     }
+
+   _clang_units = eina_list_promote_list(_clang_units,
+                                         eina_list_data_find_list(_clang_units, cache));
+   EINA_LIST_FOREACH(cache->editors, item, editor)
+     edi_editor_language_parsed(editor);
+
+   _clang_units_trim();
+}
+
+/* Parse the unit in its helper, which reparses it if it was parsed before.
+ * With an editor its contents are parsed rather than the file on disk. */
+static void
+_clang_unit_parse(Edi_Clang_Unit *cache, Edi_Editor *editor)
+{
+   Eina_Binbuf *payload;
+   Eina_Strbuf *contents;
+   unsigned int i;
+
+   if (cache->parsing)
+     {
+        cache->dirty = EINA_TRUE;
+        return;
+     }
+   if (cache->broken)
+     return;
+
+   if (!cache->worker)
+     cache->worker = edi_language_clang_worker_get();
+   if (!cache->worker)
+     return;
+
+   payload = eina_binbuf_new();
+   edi_clang_message_string_append(payload, cache->path);
+   edi_clang_message_uint_append(payload, cache->command->argc);
+   for (i = 0; i < cache->command->argc; i++)
+     edi_clang_message_string_append(payload, cache->command->args[i]);
+   edi_clang_message_uint_append(payload, !!editor);
+   if (editor)
+     {
+        contents = _clang_contents_get(editor);
+        edi_clang_message_data_append(payload, eina_strbuf_string_get(contents),
+                                      eina_strbuf_length_get(contents));
+        eina_strbuf_free(contents);
+     }
+
+   if (!edi_language_clang_send(cache->worker, EDI_CLANG_MESSAGE_PARSE, cache->id, payload,
+                                _clang_unit_parse_cb, cache))
+     return;
+
+   cache->parsing = EINA_TRUE;
+   cache->parsing_disk = !editor;
+}
+
+/* A helper stopped and has been started again, empty. Parse again the open
+ * files it held, unless one of them is what keeps crashing it. */
+static void
+_clang_worker_restart_cb(void *data EINA_UNUSED, Edi_Language_Clang_Worker *worker, unsigned int unit)
+{
+   Edi_Clang_Unit *cache;
+   Eina_List *item, *next;
+
+   EINA_LIST_FOREACH_SAFE(_clang_units, item, next, cache)
+     {
+        if (cache->worker != worker)
+          continue;
+
+        cache->parsed = EINA_FALSE;
+        if (cache->id == unit && ++cache->crashes >= EDI_CLANG_UNIT_CRASHES_MAX)
+          {
+             WRN("Not parsing %s again until it is saved, the C parsing helper keeps stopping on it", cache->path);
+             cache->broken = EINA_TRUE;
+          }
+
+        // Closed files are parsed again if they are opened
+        if (!cache->editors)
+          {
+             _clang_unit_free(cache);
+             continue;
+          }
+
+        _clang_unit_parse(cache, eina_list_data_get(cache->editors));
+     }
+}
+
+static Eina_Bool
+_clang_editors_visible(Eina_List *editors)
+{
+   Edi_Editor *editor;
+   Eina_List *item;
+
+   EINA_LIST_FOREACH(editors, item, editor)
+     {
+        if (evas_object_visible_get(editor->entry))
+          return EINA_TRUE;
+     }
 
-#if HAVE_LIBCLANG
+   return EINA_FALSE;
+}
 
-static void
-_clang_commands_fallback_get(const char ***args, unsigned int *argc)
+/* A saved header leaves the open files that include it with stale diagnostics
+ * and highlighting, reparse them starting with the ones on screen. */
+static Eina_Bool
+_clang_file_saved_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *event)
 {
-   const char *argstr;
+   Edi_Clang_Unit *cache;
+   Eina_List *item, *visible = NULL, *hidden = NULL;
+   char *path;
+
+   path = ecore_file_realpath(event);
+   if (!path || !path[0])
+     {
+        free(path);
+        return ECORE_CALLBACK_PASS_ON;
+     }
+
+   EINA_LIST_FOREACH(_clang_units, item, cache)
+     {
+        // A file that crashed the helper gets another chance once it is changed
+        if (cache->editors && !strcmp(cache->path, path))
+          {
+             cache->crashes = 0;
+             cache->broken = EINA_FALSE;
+             continue;
+          }
 
-   argstr = "-I/usr/include/ " EFL_CFLAGS " " CLANG_INCLUDES " -Wall -Wextra";
-   *args = (const char **) eina_str_split_full(argstr, " ", 0, argc);
+        // Closed files are reparsed when they are opened again
+        if (!cache->editors || !cache->includes || !eina_hash_find(cache->includes, path))
+          continue;
+
+        if (_clang_editors_visible(cache->editors))
+          visible = eina_list_append(visible, cache);
+        else
+          hidden = eina_list_append(hidden, cache);
+     }
+   free(path);
+
+   // The helpers handle requests in the order they are sent
+   visible = eina_list_merge(visible, hidden);
+   EINA_LIST_FREE(visible, cache)
+     {
+        INF("Reparsing %s for a saved include", cache->path);
+        _clang_unit_parse(cache, eina_list_data_get(cache->editors));
+     }
+
+   return ECORE_CALLBACK_PASS_ON;
 }
 
 static void
-_clang_commands_get(const char *path, const char ***args, unsigned int *argc)
+_clang_autosuggest_setup(Edi_Editor *editor)
 {
-   CXCompilationDatabase_Error error;
-   CXCompilationDatabase database = NULL;
-   CXCompileCommands commands;
-   CXCompileCommand command;
-   char *working;
-   const char** arguments;
-   unsigned int i, numargs, ignored = 0;
+   Edi_Clang_Unit *cache = NULL;
+   Edi_Clang_Command *command;
+   Eina_List *item;
+   Elm_Code *code;
+   const char *path, *key;
 
-   if (edi_project_file_exists("build/compile_commands.json"))
-     working = edi_project_file_path_get("build");
-   else
-     working = strdup(edi_project_get());
+   code = elm_code_widget_code_get(editor->entry);
+   path = elm_code_file_path_get(code->file);
 
-   database = clang_CompilationDatabase_fromDirectory(working, &error);
-   if (database == NULL || error == CXCompilationDatabase_CanNotLoadDatabase)
+   if (!_clang_file_saved_handler)
      {
-        INF("Could not load compile_commands.json in %s", edi_project_get());
-        _clang_commands_fallback_get(args, argc);
-	free(working);
+        _clang_file_saved_handler = ecore_event_handler_add(EDI_EVENT_FILE_SAVED, _clang_file_saved_cb, NULL);
+        edi_language_clang_restart_cb_set(_clang_worker_restart_cb, NULL);
+     }
+
+   command = _clang_commands_get(path);
+   if (!command)
+     {
+        // This is set up again once the compile database has loaded
+        if (!eina_list_data_find(_clang_commands_pending, editor))
+          _clang_commands_pending = eina_list_append(_clang_commands_pending, editor);
         return;
      }
 
-   commands = clang_CompilationDatabase_getCompileCommands(database, path);
-   command = clang_CompileCommands_getCommand(commands, 0);
-   numargs = clang_CompileCommand_getNumArgs(command);
+   path = eina_stringshare_add(path);
+   key = _clang_args_key_get(command);
+   EINA_LIST_FOREACH(_clang_units, item, cache)
+     {
+        if (cache->path == path && cache->args == key)
+          break;
+     }
 
-   if (numargs == 0)
+   if (!item)
      {
-        INF("File %s not found in compile_commands.json", path);
-        _clang_commands_fallback_get(args, argc);
-        free(working);
-        return;
+        cache = calloc(1, sizeof(Edi_Clang_Unit));
+        if (++_clang_unit_next_id == 0)
+          _clang_unit_next_id++;
+        cache->id = _clang_unit_next_id;
+        cache->path = path;
+        cache->args = key;
+        cache->command = command;
+        _clang_units = eina_list_prepend(_clang_units, cache);
+     }
+   else
+     {
+        eina_stringshare_del(path);
+        eina_stringshare_del(key);
+        _clang_command_free(command);
      }
 
-   arguments = malloc(sizeof(char*) * (numargs + 2));
-   INF("Loading clang parameters for %s", path);
+   cache->editors = eina_list_append(cache->editors, editor);
+
+   // Nobody had the file open so it may have changed since it was closed
+   if (eina_list_count(cache->editors) == 1)
+     _clang_unit_parse(cache, NULL);
+}
+
+/* The compile database has (re)loaded, parse again the files whose flags changed */
+static void
+_clang_commands_loaded(void)
+{
+   Edi_Clang_Unit *cache;
+   Edi_Editor *editor;
+   Eina_List *item, *next, *pending, *editors;
 
-   arguments[0] = CLANG_INCLUDES;
-   for(i = 1; i <= numargs; i++ )
+   EINA_LIST_FOREACH_SAFE(_clang_units, item, next, cache)
      {
-        const char *argstr;
-        CXString argument = clang_CompileCommand_getArg(command, i + 1);
-        argstr = clang_getCString(argument);
+        Edi_Clang_Command *command;
+        const char *key;
 
-        if (argstr && strlen(argstr) > 2 && argstr[0] == '-' &&
-            (argstr[1] == 'I' || argstr[1] == 'D'))
-          arguments[i - ignored] = strdup(argstr);
-        else
-          ignored++;
+        if (cache->parsing)
+          continue;
 
-        clang_disposeString(argument);
-     }
+        // The project changed and another database is loading
+        command = _clang_commands_get(cache->path);
+        if (!command)
+          return;
 
-   arguments[i - ignored] = eina_slstr_printf("-working-directory=%s", working);
-   *args = arguments;
-   *argc = numargs + 2 - ignored;
+        key = _clang_args_key_get(command);
+        _clang_command_free(command);
+        if (key == cache->args)
+          {
+             eina_stringshare_del(key);
+             continue;
+          }
+        eina_stringshare_del(key);
 
-   clang_CompilationDatabase_dispose(database);
-   free(working);
+        editors = cache->editors;
+        cache->editors = NULL;
+        _clang_unit_free(cache);
+        EINA_LIST_FREE(editors, editor)
+          _clang_autosuggest_setup(editor);
+     }
+
+   pending = _clang_commands_pending;
+   _clang_commands_pending = NULL;
+   EINA_LIST_FREE(pending, editor)
+     _clang_autosuggest_setup(editor);
 }
 
 static void
-_clang_autosuggest_setup(Edi_Editor *editor)
+_clang_autosuggest_reparse(Edi_Editor *editor)
 {
-   Elm_Code *code;
-   const char *path;
-   const char **args;
-   unsigned int argc;
+   Edi_Clang_Unit *cache;
 
-   code = elm_code_widget_code_get(editor->entry);
-   path = elm_code_file_path_get(code->file);
+   cache = _clang_unit_for_editor_get(editor);
+   if (!cache)
+     {
+        _clang_autosuggest_setup(editor);
+        return;
+     }
 
-   //Initialize Clang
-   _clang_commands_get(path, &args, &argc);
-   editor->clang_idx = clang_createIndex(0, 0);
-   editor->clang_unit = clang_parseTranslationUnit(editor->clang_idx, path,
-                                  args, argc, NULL, 0,
-                                  clang_defaultEditingTranslationUnitOptions() | CXTranslationUnit_DetailedPreprocessingRecord | CXTranslationUnit_KeepGoing);
+   _clang_unit_parse(cache, editor);
 }
 
 static void
 _clang_autosuggest_dispose(Edi_Editor *editor)
 {
-   clang_disposeTranslationUnit(editor->clang_unit);
-   clang_disposeIndex(editor->clang_idx);
+   Edi_Clang_Unit *cache;
+   Edi_Clang_Lookup *lookup;
+   Eina_List *item;
+
+   // Replies that come back for a closed editor are dropped
+   EINA_LIST_FOREACH(_clang_lookups, item, lookup)
+     {
+        if (lookup->editor == editor)
+          lookup->editor = NULL;
+     }
+
+   _clang_commands_pending = eina_list_remove(_clang_commands_pending, editor);
+   if (editor->clang_contents)
+     eina_strbuf_free(editor->clang_contents);
+   editor->clang_contents = NULL;
+
+   cache = _clang_unit_for_editor_get(editor);
+   if (!cache)
+     return;
+
+   cache->editors = eina_list_remove(cache->editors, editor);
+   _clang_units_trim();
+}
+
+/* Wait for the threads of an editor that send requests to the helpers */
+static void
+_clang_editor_threads_wait(Edi_Editor *editor)
+{
+   if (editor->highlight_thread)
+     {
+        editor->highlight_cancel = EINA_TRUE;
+        editor->highlight_again = EINA_FALSE;
+        ecore_thread_cancel(editor->highlight_thread);
+        while ((ecore_thread_wait(editor->highlight_thread, 0.1)) != EINA_TRUE);
+        editor->highlight_thread = NULL;
+     }
+
+   if (editor->suggest_thread)
+     {
+        editor->suggest_pending = EINA_FALSE;
+        ecore_thread_cancel(editor->suggest_thread);
+        while ((ecore_thread_wait(editor->suggest_thread, 0.1)) != EINA_TRUE);
+        editor->suggest_thread = NULL;
+     }
+}
+
+static void
+_clang_shutdown(void)
+{
+   Edi_Clang_Unit *cache;
+   Edi_Clang_Lookup *lookup;
+   Edi_Editor *editor;
+   Eina_List *item, *l;
+
+   // The helpers are stopped first so that no thread is left waiting on a long parse,
+   // then they are only freed once nothing can be using them
+   edi_language_clang_stop();
+   EINA_LIST_FOREACH(_clang_units, item, cache)
+     {
+        cache->parsed = EINA_FALSE;
+        EINA_LIST_FOREACH(cache->editors, l, editor)
+          _clang_editor_threads_wait(editor);
+     }
+   edi_language_clang_shutdown();
+
+   EINA_LIST_FREE(_clang_lookups, lookup)
+     free(lookup);
+
+   while (_clang_units)
+     {
+        Edi_Clang_Unit *cache = eina_list_data_get(_clang_units);
+
+        cache->worker = NULL;
+        _clang_unit_free(cache);
+     }
+
+   if (_clang_file_saved_handler)
+     ecore_event_handler_del(_clang_file_saved_handler);
+   _clang_file_saved_handler = NULL;
+
+   _clang_commands_shutdown();
+}
+
+/* Send a request for the unit of an editor and wait for the reply, from any thread */
+static Eina_Binbuf *
+_clang_unit_call(Edi_Editor *editor, unsigned int type, Eina_Binbuf *payload, double timeout)
+{
+   Edi_Clang_Unit *cache;
+   Edi_Language_Clang_Worker *worker = NULL;
+   unsigned int id = 0;
+
+   ecore_thread_main_loop_begin();
+   cache = _clang_unit_ready_get(editor);
+   if (cache)
+     {
+        worker = cache->worker;
+        id = cache->id;
+     }
+   ecore_thread_main_loop_end();
+
+   if (!worker)
+     {
+        eina_binbuf_free(payload);
+        return NULL;
+     }
+
+   return edi_language_clang_call(worker, type, id, payload, timeout);
+}
+
+Eina_Bool
+edi_language_c_unit_ready(Edi_Editor *editor)
+{
+   return !!_clang_unit_ready_get(editor);
+}
+
+Eina_Bool
+edi_language_c_highlight_get(Edi_Editor *editor, unsigned int first_line, unsigned int last_line,
+                             Edi_Language_Cache *results)
+{
+   Edi_Clang_Message_Reader reader;
+   Eina_Binbuf *payload, *reply;
+   unsigned int count, i, start_line, start_col, end_line, end_col, kind;
+   Elm_Code_Token_Type type;
+
+   payload = eina_binbuf_new();
+   edi_clang_message_uint_append(payload, first_line);
+   edi_clang_message_uint_append(payload, last_line);
+
+   reply = _clang_unit_call(editor, EDI_CLANG_MESSAGE_HIGHLIGHT, payload, 0);
+   if (!reply)
+     return EINA_FALSE;
+
+   edi_clang_message_reader_init(&reader, reply);
+   if (!edi_clang_message_uint_get(&reader, &count))
+     count = 0;
+   for (i = 0; i < count; i++)
+     {
+        if (!edi_clang_message_uint_get(&reader, &start_line) ||
+            !edi_clang_message_uint_get(&reader, &start_col) ||
+            !edi_clang_message_uint_get(&reader, &end_line) ||
+            !edi_clang_message_uint_get(&reader, &end_col) ||
+            !edi_clang_message_uint_get(&reader, &kind))
+          break;
+
+        switch (kind)
+          {
+           case EDI_CLANG_HIGHLIGHT_CLASS:
+              type = ELM_CODE_TOKEN_TYPE_CLASS;
+              break;
+           case EDI_CLANG_HIGHLIGHT_FUNCTION:
+              type = ELM_CODE_TOKEN_TYPE_FUNCTION;
+              break;
+           case EDI_CLANG_HIGHLIGHT_PREPROCESSOR:
+              type = ELM_CODE_TOKEN_TYPE_PREPROCESSOR;
+              break;
+           case EDI_CLANG_HIGHLIGHT_TYPE:
+              type = ELM_CODE_TOKEN_TYPE_TYPE;
+              break;
+           default:
+              continue;
+          }
+
+        edi_language_cache_token_add(results, start_line, start_col, end_line, end_col, type);
+     }
+   eina_binbuf_free(reply);
+
+   return EINA_TRUE;
+}
+
+Eina_Bool
+edi_language_c_diagnostics_get(Edi_Editor *editor, Edi_Language_Cache *results)
+{
+   Edi_Clang_Message_Reader reader;
+   Eina_Binbuf *reply;
+   Elm_Code_Status_Type status;
+   unsigned int count, i, line, severity;
+   char *text;
+
+   reply = _clang_unit_call(editor, EDI_CLANG_MESSAGE_DIAGNOSTICS, eina_binbuf_new(), 0);
+   if (!reply)
+     return EINA_FALSE;
+
+   edi_clang_message_reader_init(&reader, reply);
+   if (!edi_clang_message_uint_get(&reader, &count))
+     count = 0;
+   for (i = 0; i < count; i++)
+     {
+        if (!edi_clang_message_uint_get(&reader, &line) ||
+            !edi_clang_message_uint_get(&reader, &severity))
+          break;
+        text = edi_clang_message_string_get(&reader);
+        if (!text)
+          break;
+
+        switch (severity)
+          {
+           case EDI_CLANG_SEVERITY_IGNORED:
+              status = ELM_CODE_STATUS_TYPE_IGNORED;
+              break;
+           case EDI_CLANG_SEVERITY_NOTE:
+              status = ELM_CODE_STATUS_TYPE_NOTE;
+              break;
+           case EDI_CLANG_SEVERITY_WARNING:
+              status = ELM_CODE_STATUS_TYPE_WARNING;
+              break;
+           case EDI_CLANG_SEVERITY_ERROR:
+              status = ELM_CODE_STATUS_TYPE_ERROR;
+              break;
+           case EDI_CLANG_SEVERITY_FATAL:
+              status = ELM_CODE_STATUS_TYPE_FATAL;
+              break;
+           default:
+              status = ELM_CODE_STATUS_TYPE_DEFAULT;
+              break;
+          }
+
+        if (status != ELM_CODE_STATUS_TYPE_DEFAULT)
+          edi_language_cache_status_add(results, line, status, text);
+        free(text);
+     }
+   eina_binbuf_free(reply);
+
+   return EINA_TRUE;
+}
+
+Eina_Bool
+edi_language_c_unit_depends_get(Edi_Editor *editor, const char **args, Eina_List **includes)
+{
+   Edi_Clang_Unit *cache;
+   Edi_Language_Cache_Include *include;
+   Eina_Iterator *it;
+   Eina_Hash_Tuple *tuple;
+
+   cache = _clang_unit_for_editor_get(editor);
+   if (!cache)
+     return EINA_FALSE;
+
+   *args = eina_stringshare_ref(cache->args);
+   if (!includes)
+     return EINA_TRUE;
+
+   *includes = NULL;
+   if (!cache->includes)
+     return EINA_TRUE;
+
+   it = eina_hash_iterator_tuple_new(cache->includes);
+   EINA_ITERATOR_FOREACH(it, tuple)
+     {
+        include = malloc(sizeof(Edi_Language_Cache_Include));
+        include->path = eina_stringshare_add(tuple->key);
+        include->mtime = *(long long *) tuple->data;
+        *includes = eina_list_append(*includes, include);
+     }
+   eina_iterator_free(it);
+
+   return EINA_TRUE;
 }
 #endif
 
@@ -132,8 +1349,7 @@ void
 _edi_language_c_refresh(Edi_Editor *editor)
 {
 #if HAVE_LIBCLANG
-   _clang_autosuggest_dispose(editor);
-   _clang_autosuggest_setup(editor);
+   _clang_autosuggest_reparse(editor);
 #else
    (void) editor;
 #endif
@@ -149,6 +1365,14 @@ _edi_language_c_del(Edi_Editor *editor)
 #endif
 }
 
+void
+_edi_language_c_shutdown(void)
+{
+#if HAVE_LIBCLANG
+   _clang_shutdown();
+#endif
+}
+
 const char *
 _edi_language_c_mime_name(const char *mime)
 {
@@ -184,20 +1408,12 @@ _edi_language_c_snippet_get(const char *key)
 
 
 #if HAVE_LIBCLANG
-char *
-_edi_suggest_c_detail_get(Edi_Editor *editor, const char *term_str,
-                                 const char *ret_str, const char *param_str)
+static char *
+_edi_suggest_c_detail_get(const char *font, int font_size, Evas_Coord w, const char *term_str,
+                          const char *ret_str, const char *param_str)
 {
    char *format, *display;
-   const char *font;
-   int font_size, displen;
-   unsigned int row, col;
-   Evas_Coord w;
-
-   elm_code_widget_font_get(editor->entry, &font, &font_size);
-   elm_code_widget_cursor_position_get(editor->entry, &row, &col);
-   elm_code_widget_geometry_for_position_get(editor->entry, row, col,
-                                             NULL, NULL, &w, NULL);
+   int displen;
 
    format = "<left_margin=%d><align=left><font='%s'><font_size=%d>%s<br><b>%s</b><br>%s</font_size></font></align></left_margin>";
    displen = strlen(ret_str) + strlen(param_str) + strlen(term_str)
@@ -215,85 +1431,90 @@ _edi_language_c_lookup(Edi_Editor *editor, unsigned int row, unsigned int col)
    Eina_List *list = NULL;
 
 #if HAVE_LIBCLANG
-   CXCodeCompleteResults *res;
-   struct CXUnsavedFile unsaved_file;
-   Elm_Code *code;
-   const char *path = NULL;
+   Edi_Clang_Unit *cache;
+   Edi_Language_Clang_Worker *worker = NULL;
+   Edi_Clang_Message_Reader reader;
+   Eina_Binbuf *payload = NULL, *reply;
+   const char *font = NULL;
+   int font_size;
+   unsigned int cursor_row, cursor_col, id = 0, count, i;
+   Evas_Coord w;
 
-   if (!editor->clang_unit)
-     return list;
+   // This runs in a thread, the editor and the cache are only used from the main loop
+   ecore_thread_main_loop_begin();
 
-   code = elm_code_widget_code_get(editor->entry);
-   if (code->file->file)
-     path = elm_code_file_path_get(code->file);
+   cache = _clang_unit_ready_get(editor);
+   if (cache)
+     {
+        worker = cache->worker;
+        id = cache->id;
+
+        // The buffer is only copied again if it changed since the last lookup
+        if (!editor->clang_contents || editor->clang_revision != editor->revision)
+          {
+             if (editor->clang_contents)
+               eina_strbuf_free(editor->clang_contents);
+             editor->clang_contents = _clang_contents_get(editor);
+             editor->clang_revision = editor->revision;
+          }
 
-   unsaved_file.Filename = path;
-   unsaved_file.Contents = elm_code_widget_text_between_positions_get(
-                                                 editor->entry, 1, 1, row, col);
-   unsaved_file.Length = strlen(unsaved_file.Contents);
+        payload = eina_binbuf_new();
+        edi_clang_message_uint_append(payload, row);
+        edi_clang_message_uint_append(payload, col);
+        edi_clang_message_data_append(payload, eina_strbuf_string_get(editor->clang_contents),
+                                      eina_strbuf_length_get(editor->clang_contents));
+
+        elm_code_widget_font_get(editor->entry, &font, &font_size);
+        font = eina_stringshare_add(font);
+        elm_code_widget_cursor_position_get(editor->entry, &cursor_row, &cursor_col);
+        elm_code_widget_geometry_for_position_get(editor->entry, cursor_row, cursor_col,
+                                                  NULL, NULL, &w, NULL);
+     }
 
-   res = clang_codeCompleteAt(editor->clang_unit, path, row, col,
-                              &unsaved_file, 1,
-                              CXCodeComplete_IncludeMacros |
-                              CXCodeComplete_IncludeCodePatterns);
+   ecore_thread_main_loop_end();
 
-   clang_sortCodeCompletionResults(res->Results, res->NumResults);
+   if (!worker)
+     return list;
 
-   for (unsigned int i = 0; i < res->NumResults; i++)
+   reply = edi_language_clang_call(worker, EDI_CLANG_MESSAGE_COMPLETE, id, payload,
+                                   EDI_CLANG_COMPLETE_TIMEOUT);
+   if (!reply)
      {
-        const CXCompletionString str = res->Results[i].CompletionString;
-        const char *name = NULL, *ret = NULL;
-        char *param = NULL;
-        Edi_Language_Suggest_Item *suggest_it;
-        Eina_Strbuf *buf = NULL;
+        eina_stringshare_del(font);
+        return list;
+     }
 
-        suggest_it = calloc(1, sizeof(Edi_Language_Suggest_Item));
+   edi_clang_message_reader_init(&reader, reply);
+   if (!edi_clang_message_uint_get(&reader, &count))
+     count = 0;
+   for (i = 0; i < count; i++)
+     {
+        Edi_Language_Suggest_Item *suggest_it;
+        char *name, *ret, *param;
 
-        for (unsigned int j = 0; j < clang_getNumCompletionChunks(str); j++)
+        name = edi_clang_message_string_get(&reader);
+        ret = edi_clang_message_string_get(&reader);
+        param = edi_clang_message_string_get(&reader);
+        if (!name || !ret || !param)
           {
-             enum CXCompletionChunkKind ch_kind;
-             const CXString str_out = clang_getCompletionChunkText(str, j);
-
-             ch_kind = clang_getCompletionChunkKind(str, j);
-
-             switch (ch_kind)
-               {
-                case CXCompletionChunk_ResultType:
-                   ret = clang_getCString(str_out);
-                   break;
-                case CXCompletionChunk_TypedText:
-                case CXCompletionChunk_Text:
-                   name = clang_getCString(str_out);
-                   break;
-                case CXCompletionChunk_LeftParen:
-                  // todo buf == eina_strbuf_new();
-                case CXCompletionChunk_Placeholder:
-                case CXCompletionChunk_Comma:
-                case CXCompletionChunk_CurrentParameter:
-                   if (!buf)
-                     buf = eina_strbuf_new();
-                   eina_strbuf_append(buf, clang_getCString(str_out));
-                   break;
-                case CXCompletionChunk_RightParen:
-                   eina_strbuf_append(buf, clang_getCString(str_out));
-                   param = eina_strbuf_string_steal(buf);
-                   eina_strbuf_free(buf);
-                   buf = NULL;
-                   break;
-                default:
-                   break;
-               }
+             free(name);
+             free(ret);
+             free(param);
+             break;
           }
 
-        if (name)
+        suggest_it = calloc(1, sizeof(Edi_Language_Suggest_Item));
+        if (name[0])
           suggest_it->summary = strdup(name);
-        suggest_it->detail = _edi_suggest_c_detail_get(editor, name, ret?ret:"", param?param:"");
-        if (param)
-          free(param);
-
+        suggest_it->detail = _edi_suggest_c_detail_get(font, font_size, w, name, ret, param);
         list = eina_list_append(list, suggest_it);
+
+        free(name);
+        free(ret);
+        free(param);
      }
-   clang_disposeCodeCompleteResults(res);
+   eina_binbuf_free(reply);
+   eina_stringshare_del(font);
 #else
    (void) editor; (void) row; (void) col;
 #endif
@@ -302,216 +1523,159 @@ _edi_language_c_lookup(Edi_Editor *editor, unsigned int row, unsigned int col)
 }
 
 #if HAVE_LIBCLANG
-static void
-_edi_doc_init(Edi_Language_Document *doc)
-{
-   doc->title = eina_strbuf_new();
-   doc->detail = eina_strbuf_new();
-   doc->param = eina_strbuf_new();
-   doc->ret = eina_strbuf_new();
-   doc->see = eina_strbuf_new();
-}
-
+/* Send a request about the symbol at a position, the reply callback frees the lookup */
 static Eina_Bool
-_edi_doc_newline_check(Eina_Strbuf *strbuf)
+_clang_lookup_send(Edi_Clang_Lookup *lookup, unsigned int type, unsigned int row, unsigned int col,
+                   Edi_Language_Clang_Reply_Cb reply_cb)
 {
-   const char *str;
-
-   str = eina_strbuf_string_get(strbuf);
+   Edi_Clang_Unit *cache;
+   Eina_Binbuf *payload;
 
-   if (strlen(str) < 4)
-     return EINA_TRUE;
+   cache = _clang_unit_ready_get(lookup->editor);
+   if (!cache)
+     {
+        free(lookup);
+        return EINA_FALSE;
+     }
 
-   str = str + strlen(str) - 4;
+   payload = eina_binbuf_new();
+   edi_clang_message_uint_append(payload, row);
+   edi_clang_message_uint_append(payload, col);
+   if (!edi_language_clang_send(cache->worker, type, cache->id, payload, reply_cb, lookup))
+     {
+        free(lookup);
+        return EINA_FALSE;
+     }
 
-   if (!strcmp(str, "<br>"))
-     return EINA_FALSE;
-   else
-     return EINA_TRUE;
+   _clang_lookups = eina_list_append(_clang_lookups, lookup);
+   return EINA_TRUE;
 }
 
-static void
-_edi_doc_trim(Eina_Strbuf *strbuf)
+/* Take back a lookup that has its reply, EINA_FALSE if its editor was closed since it was sent */
+static Eina_Bool
+_clang_lookup_done(Edi_Clang_Lookup *lookup)
 {
-   const char *str;
-   int cmp_strlen, ori_strlen;
+   _clang_lookups = eina_list_remove(_clang_lookups, lookup);
 
-   str = eina_strbuf_string_get(strbuf);
-   ori_strlen = strlen(str);
+   return !!lookup->editor;
+}
 
-   if (strlen(str) < 8)
-     return;
+static Eina_Bool
+_edi_doc_field_get(Edi_Clang_Message_Reader *reader, Eina_Strbuf **strbuf)
+{
+   const char *data;
+   unsigned int length;
 
-   cmp_strlen = strlen(str) - 8;
-   str += cmp_strlen;
+   *strbuf = eina_strbuf_new();
+   if (!edi_clang_message_data_get(reader, &data, &length))
+     return EINA_FALSE;
 
-   if (!strcmp(str, "<br><br>"))
-     {
-        eina_strbuf_remove(strbuf, cmp_strlen, ori_strlen);
-        _edi_doc_trim(strbuf);
-     }
-   else
-     return;
+   eina_strbuf_append_length(*strbuf, data, length);
+   return EINA_TRUE;
 }
 
 static void
-_edi_doc_title_get(CXCursor cursor, Eina_Strbuf *strbuf)
+_edi_language_c_lookup_doc_cb(void *data, const Eina_Binbuf *reply)
 {
-   CXCompletionString str;
-   int chunk_num;
+   Edi_Clang_Lookup *lookup = data;
+   Edi_Language_Document *doc = NULL;
+   Edi_Clang_Message_Reader reader;
+   Eina_Bool ok;
 
-   str = clang_getCursorCompletionString(cursor);
-   chunk_num = clang_getNumCompletionChunks(str);
+   if (!_clang_lookup_done(lookup))
+     {
+        free(lookup);
+        return;
+     }
 
-   for (int i = 0; i < chunk_num; i++)
+   if (reply)
      {
-        enum CXCompletionChunkKind kind = clang_getCompletionChunkKind(str, i);
-        switch (kind)
+        doc = malloc(sizeof(Edi_Language_Document));
+
+        edi_clang_message_reader_init(&reader, reply);
+        ok = _edi_doc_field_get(&reader, &doc->title);
+        ok &= _edi_doc_field_get(&reader, &doc->detail);
+        ok &= _edi_doc_field_get(&reader, &doc->param);
+        ok &= _edi_doc_field_get(&reader, &doc->ret);
+        ok &= _edi_doc_field_get(&reader, &doc->see);
+
+        if (!ok)
           {
-           case CXCompletionChunk_ResultType:
-             eina_strbuf_append_printf(strbuf, "<color=#31d12f><b>%s</b></color><br>",
-                        clang_getCString(clang_getCompletionChunkText(str, i)));
-             break;
-           case CXCompletionChunk_Placeholder:
-             eina_strbuf_append_printf(strbuf, "<color=#edd400><b>%s</b></color>",
-                        clang_getCString(clang_getCompletionChunkText(str, i)));
-             break;
-           default:
-             eina_strbuf_append(strbuf,
-                        clang_getCString(clang_getCompletionChunkText(str, i)));
-             break;
+             edi_language_doc_free(doc);
+             free(doc);
+             doc = NULL;
           }
      }
+
+   lookup->doc_cb((void *) lookup->data, doc);
+   free(lookup);
 }
 
 static void
-_edi_doc_dump(Edi_Language_Document *doc, CXComment comment, Eina_Strbuf *strbuf)
+_edi_language_c_symbol_get_cb(void *data, const Eina_Binbuf *reply)
 {
-   const char *str ,*tag;
-   enum CXCommentKind kind = clang_Comment_getKind(comment);
-
-   if (kind == CXComment_Null) return;
+   Edi_Clang_Lookup *lookup = data;
+   Edi_Clang_Message_Reader reader;
+   char *usr = NULL;
 
-   switch (kind)
+   if (!_clang_lookup_done(lookup))
      {
-      case CXComment_Text:
-        str = clang_getCString(clang_TextComment_getText(comment));
+        free(lookup);
+        return;
+     }
 
-        if (doc->see == strbuf)
-          {
-             eina_strbuf_append_printf(strbuf, "   %s", str);
-             break;
-          }
-        if (clang_Comment_isWhitespace(comment))
-          {
-             if (_edi_doc_newline_check(strbuf))
-               {
-                  if (strbuf == doc->detail)
-                    eina_strbuf_append(strbuf, "<br><br>");
-                  else
-                    eina_strbuf_append(strbuf, "<br>");
-               }
-             break;
-          }
-        eina_strbuf_append(strbuf, str);
-        break;
-      case CXComment_InlineCommand:
-        str = clang_getCString(clang_InlineCommandComment_getCommandName(comment));
-
-        if (str[0] == 'p')
-          eina_strbuf_append_printf(strbuf, "<font_style=italic>%s</font_style>",
-             clang_getCString(clang_InlineCommandComment_getArgText(comment, 0)));
-        else if (str[0] == 'c')
-          eina_strbuf_append_printf(strbuf, "<b>%s</b>",
-             clang_getCString(clang_InlineCommandComment_getArgText(comment, 0)));
-        else
-          eina_strbuf_append_printf(strbuf, "@%s", str);
-        break;
-      case CXComment_BlockCommand:
-        tag = clang_getCString(clang_BlockCommandComment_getCommandName(comment));
-
-        if (!strcmp(tag, "return"))
-          strbuf = doc->ret;
-        else if (!strcmp(tag, "see"))
-          strbuf = doc->see;
-
-        break;
-      case CXComment_ParamCommand:
-        str = clang_getCString(clang_ParamCommandComment_getParamName(comment));
-        strbuf = doc->param;
-
-        eina_strbuf_append_printf(strbuf, "<color=#edd400><b>   %s</b></color>",
-                                  str);
-        break;
-      case CXComment_VerbatimBlockLine:
-        str = clang_getCString(clang_VerbatimBlockLineComment_getText(comment));
-
-        if (str[0] == 10)
+   if (reply)
+     {
+        edi_clang_message_reader_init(&reader, reply);
+        usr = edi_clang_message_string_get(&reader);
+        if (usr && !usr[0])
           {
-             eina_strbuf_append(strbuf, "<br>");
-             break;
+             free(usr);
+             usr = NULL;
           }
-        eina_strbuf_append_printf(strbuf, "%s<br>", str);
-        break;
-      case CXComment_VerbatimLine:
-        str = clang_getCString(clang_VerbatimLineComment_getText(comment));
-
-        if (doc->see == strbuf)
-          eina_strbuf_append(strbuf, str);
-        break;
-      default:
-        break;
      }
-   for (unsigned i = 0; i < clang_Comment_getNumChildren(comment); i++)
-     _edi_doc_dump(doc, clang_Comment_getChild(comment, i), strbuf);
+
+   lookup->symbol_cb((void *) lookup->data, usr);
+   free(lookup);
 }
+#endif
 
-static CXCursor
-_edi_doc_cursor_get(Edi_Editor *editor, unsigned int row, unsigned int col)
+static Eina_Bool
+_edi_language_c_lookup_doc(Edi_Editor *editor, unsigned int row, unsigned int col,
+                           Edi_Language_Document_Cb cb, const void *data)
 {
-   CXFile cxfile;
-   CXSourceLocation location;
-   CXCursor cursor;
-   Elm_Code *code;
-   const char *path;
+#if HAVE_LIBCLANG
+   Edi_Clang_Lookup *lookup;
 
-   code = elm_code_widget_code_get(editor->entry);
-   path = elm_code_file_path_get(code->file);
+   lookup = calloc(1, sizeof(Edi_Clang_Lookup));
+   lookup->editor = editor;
+   lookup->doc_cb = cb;
+   lookup->data = data;
 
-   cxfile = clang_getFile(editor->clang_unit, path);
-   location = clang_getLocation(editor->clang_unit, cxfile, row, col);
-   cursor = clang_getCursor(editor->clang_unit, location);
+   return _clang_lookup_send(lookup, EDI_CLANG_MESSAGE_DOCUMENT, row, col, _edi_language_c_lookup_doc_cb);
+#else
+   (void) editor; (void) row; (void) col; (void) cb; (void) data;
 
-   return clang_getCursorReferenced(cursor);
-}
+   return EINA_FALSE;
 #endif
+}
 
-static Edi_Language_Document *
-_edi_language_c_lookup_doc(Edi_Editor *editor, unsigned int row, unsigned int col)
+static Eina_Bool
+_edi_language_c_symbol_get(Edi_Editor *editor, unsigned int row, unsigned int col,
+                           Edi_Language_Symbol_Cb cb, const void *data)
 {
-   Edi_Language_Document *doc = NULL;
 #if HAVE_LIBCLANG
-   CXCursor cursor;
-   CXComment comment;
-
-   cursor = _edi_doc_cursor_get(editor, row, col);
-   comment = clang_Cursor_getParsedComment(cursor);
+   Edi_Clang_Lookup *lookup;
 
-   if (clang_Comment_getKind(comment) == CXComment_Null)
-     {
-        return NULL;
-     }
-
-   doc = malloc(sizeof(Edi_Language_Document));
+   lookup = calloc(1, sizeof(Edi_Clang_Lookup));
+   lookup->editor = editor;
+   lookup->symbol_cb = cb;
+   lookup->data = data;
 
-   _edi_doc_init(doc);
-   _edi_doc_dump(doc, comment, doc->detail);
-   _edi_doc_title_get(cursor, doc->title);
-   _edi_doc_trim(doc->detail);
+   return _clang_lookup_send(lookup, EDI_CLANG_MESSAGE_SYMBOL, row, col, _edi_language_c_symbol_get_cb);
 #else
-   (void) editor; (void) row; (void) col;
-#endif
+   (void) editor; (void) row; (void) col; (void) cb; (void) data;
 
-   return doc;
+   return EINA_FALSE;
+#endif
 }
-
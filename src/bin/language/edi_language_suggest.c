@@ -0,0 +1,266 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
+#include <Eina.h>
+
+#include "edi_language_suggest.h"
+
+#include "edi_private.h"
+
+#define EDI_LANGUAGE_SUGGEST_SCORE_PREFIX 1000
+#define EDI_LANGUAGE_SUGGEST_SCORE_PREFIX_CASELESS 500
+#define EDI_LANGUAGE_SUGGEST_SCORE_ADJACENT 8
+#define EDI_LANGUAGE_SUGGEST_SCORE_BOUNDARY 6
+#define EDI_LANGUAGE_SUGGEST_SCORE_CASE 1
+
+typedef struct _Edi_Language_Suggest_Match
+{
+   unsigned int item;
+   int score;
+} Edi_Language_Suggest_Match;
+
+struct _Edi_Language_Suggest_Index
+{
+   /* Sorted case insensitively so a prefix is one range */
+   Edi_Language_Suggest_Item **items;
+   unsigned int count;
+
+   Edi_Language_Suggest_Match *matches;
+   unsigned int match_count;
+   /* The word the matches were found for */
+   char *word;
+};
+
+void
+edi_language_suggest_item_free(Edi_Language_Suggest_Item *item)
+{
+   free((char *)item->summary);
+   free((char *)item->detail);
+
+   free(item);
+}
+
+static int
+_edi_language_suggest_item_cmp(const void *a, const void *b)
+{
+   const Edi_Language_Suggest_Item *item1 = *(const Edi_Language_Suggest_Item **) a;
+   const Edi_Language_Suggest_Item *item2 = *(const Edi_Language_Suggest_Item **) b;
+   int ret;
+
+   ret = strcasecmp(item1->summary, item2->summary);
+   if (ret)
+     return ret;
+
+   return strcmp(item1->summary, item2->summary);
+}
+
+static int
+_edi_language_suggest_match_cmp(const void *a, const void *b)
+{
+   const Edi_Language_Suggest_Match *match1 = a, *match2 = b;
+
+   if (match1->score != match2->score)
+     return match2->score - match1->score;
+
+   return (int) match1->item - (int) match2->item;
+}
+
+Edi_Language_Suggest_Index *
+edi_language_suggest_index_new(Eina_List *items)
+{
+   Edi_Language_Suggest_Index *index;
+   Edi_Language_Suggest_Item *item;
+   unsigned int i = 0;
+
+   index = calloc(1, sizeof(Edi_Language_Suggest_Index));
+   index->count = eina_list_count(items);
+   index->items = malloc(sizeof(Edi_Language_Suggest_Item *) * (index->count + 1));
+   index->matches = malloc(sizeof(Edi_Language_Suggest_Match) * (index->count + 1));
+
+   EINA_LIST_FREE(items, item)
+     {
+        if (!item->summary)
+          {
+             edi_language_suggest_item_free(item);
+             continue;
+          }
+        index->items[i++] = item;
+     }
+   index->count = i;
+
+   qsort(index->items, index->count, sizeof(Edi_Language_Suggest_Item *),
+         _edi_language_suggest_item_cmp);
+
+   return index;
+}
+
+void
+edi_language_suggest_index_free(Edi_Language_Suggest_Index *index)
+{
+   unsigned int i;
+
+   if (!index)
+     return;
+
+   for (i = 0; i < index->count; i++)
+     edi_language_suggest_item_free(index->items[i]);
+
+   free(index->items);
+   free(index->matches);
+   free(index->word);
+   free(index);
+}
+
+/* The first item that does not sort before the word, comparing only the first
+ * length characters. With upper set the items that start with the word are passed too. */
+static unsigned int
+_edi_language_suggest_bound(const Edi_Language_Suggest_Index *index, const char *word,
+                            size_t length, Eina_Bool upper)
+{
+   unsigned int low = 0, high = index->count, mid;
+   int ret;
+
+   while (low < high)
+     {
+        mid = low + (high - low) / 2;
+        ret = strncasecmp(index->items[mid]->summary, word, length);
+        if (ret < 0 || (upper && !ret))
+          low = mid + 1;
+        else
+          high = mid;
+     }
+
+   return low;
+}
+
+static Eina_Bool
+_edi_language_suggest_boundary(const char *summary, const char *pos)
+{
+   if (pos == summary)
+     return EINA_TRUE;
+
+   if (!isalnum((unsigned char) pos[-1]))
+     return EINA_TRUE;
+
+   return isupper((unsigned char) pos[0]) && islower((unsigned char) pos[-1]);
+}
+
+/* Score how well a summary matches a word, or -1 if it does not contain it in order. */
+static int
+_edi_language_suggest_score(const char *summary, const char *word, size_t length)
+{
+   const char *pos, *last = NULL;
+   size_t i;
+   int score = 0;
+
+   if (!strncmp(summary, word, length))
+     return EDI_LANGUAGE_SUGGEST_SCORE_PREFIX - (int) strlen(summary);
+   if (!strncasecmp(summary, word, length))
+     return EDI_LANGUAGE_SUGGEST_SCORE_PREFIX_CASELESS - (int) strlen(summary);
+
+   pos = summary;
+   for (i = 0; i < length; i++)
+     {
+        while (*pos && tolower((unsigned char) *pos) != tolower((unsigned char) word[i]))
+          pos++;
+        if (!*pos)
+          return -1;
+
+        if (last && pos == last + 1)
+          score += EDI_LANGUAGE_SUGGEST_SCORE_ADJACENT;
+        else if (_edi_language_suggest_boundary(summary, pos))
+          score += EDI_LANGUAGE_SUGGEST_SCORE_BOUNDARY;
+        if (*pos == word[i])
+          score += EDI_LANGUAGE_SUGGEST_SCORE_CASE;
+
+        last = pos++;
+     }
+
+   return score - (int) (pos - summary - length);
+}
+
+unsigned int
+edi_language_suggest_index_match(Edi_Language_Suggest_Index *index, const char *word)
+{
+   Edi_Language_Suggest_Match *match;
+   unsigned int i, count = 0;
+   size_t length;
+   int score;
+
+   length = strlen(word);
+
+   if (index->word && index->word[0] && length > strlen(index->word) &&
+       !strncmp(word, index->word, strlen(index->word)))
+     {
+        /* Anything that matches the longer word matched the shorter one. */
+        for (i = 0; i < index->match_count; i++)
+          {
+             match = &index->matches[i];
+             score = _edi_language_suggest_score(index->items[match->item]->summary, word, length);
+             if (score < 0)
+               continue;
+
+             match->score = score;
+             index->matches[count++] = *match;
+          }
+     }
+   else
+     {
+        /* A match can start anywhere, so the first letter does not narrow the range. */
+        for (i = 0; i < index->count; i++)
+          {
+             score = length ? _edi_language_suggest_score(index->items[i]->summary, word, length) : 0;
+             if (score < 0)
+               continue;
+
+             match = &index->matches[count++];
+             match->item = i;
+             match->score = score;
+          }
+     }
+
+   qsort(index->matches, count, sizeof(Edi_Language_Suggest_Match),
+         _edi_language_suggest_match_cmp);
+
+   index->match_count = count;
+   free(index->word);
+   index->word = strdup(word);
+
+   return count;
+}
+
+Edi_Language_Suggest_Item *
+edi_language_suggest_index_match_get(const Edi_Language_Suggest_Index *index, unsigned int n)
+{
+   if (n >= index->match_count)
+     return NULL;
+
+   return index->items[index->matches[n].item];
+}
+
+Edi_Language_Suggest_Item *
+edi_language_suggest_index_prefix_find(const Edi_Language_Suggest_Index *index, const char *word)
+{
+   Edi_Language_Suggest_Item *item;
+   unsigned int i, last;
+   size_t length;
+
+   length = strlen(word);
+   if (!length)
+     return NULL;
+
+   last = _edi_language_suggest_bound(index, word, length, EINA_TRUE);
+   for (i = _edi_language_suggest_bound(index, word, length, EINA_FALSE); i < last; i++)
+     {
+        item = index->items[i];
+        if (item->summary[length] && !strncmp(item->summary, word, length))
+          return item;
+     }
+
+   return NULL;
+}
@@ -0,0 +1,118 @@
+#ifndef EDI_LANGUAGE_SUGGEST_H_
+# define EDI_LANGUAGE_SUGGEST_H_
+
+#include <Eina.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief These routines are used for ranking suggestions against the word being typed.
+ */
+
+/**
+ * @typedef Edi_Editor_Suggest_Item
+ * A handle for passing a suggest item to the ui and back
+ */
+typedef struct _Edi_Language_Suggest_Item
+{
+   const char *summary;
+   const char *detail;
+} Edi_Language_Suggest_Item;
+
+/**
+ * @typedef Edi_Language_Suggest_Index
+ * The suggestions for a position in a file, sorted for lookup by the typed word.
+ */
+typedef struct _Edi_Language_Suggest_Index Edi_Language_Suggest_Index;
+
+/**
+ * @brief Suggestion ranking functions.
+ * @defgroup Suggest
+ *
+ * @{
+ *
+ * Suggestions are sorted once, case insensitively, when they are looked up.
+ * A suggestion matches a word if it contains the letters of the word in order,
+ * so "evobs" finds "evas_object_show" and "show" finds "evas_object_show".
+ * Matches are ranked so that prefixes come first, followed by matches that
+ * run together or start at word boundaries. As the word grows only the
+ * previous matches are checked again.
+ *
+ */
+
+/**
+ * Free a suggest item.
+ *
+ * @param item the suggest item to free
+ *
+ * @ingroup Suggest
+ */
+void edi_language_suggest_item_free(Edi_Language_Suggest_Item *item);
+
+/**
+ * Create an index of suggestions.
+ *
+ * @param items The Edi_Language_Suggest_Item list to index, this takes ownership.
+ * @return A new index that must be freed with edi_language_suggest_index_free().
+ *
+ * @ingroup Suggest
+ */
+Edi_Language_Suggest_Index *edi_language_suggest_index_new(Eina_List *items);
+
+/**
+ * Free an index and the suggestions within it.
+ *
+ * @param index The index to free.
+ *
+ * @ingroup Suggest
+ */
+void edi_language_suggest_index_free(Edi_Language_Suggest_Index *index);
+
+/**
+ * Find and rank the suggestions that match a word.
+ *
+ * @param index The index to search.
+ * @param word The word being typed, an empty word matches everything.
+ * @return The number of suggestions that match.
+ *
+ * @ingroup Suggest
+ */
+unsigned int edi_language_suggest_index_match(Edi_Language_Suggest_Index *index, const char *word);
+
+/**
+ * Get a suggestion from the last edi_language_suggest_index_match().
+ *
+ * @param index The index that was searched.
+ * @param n The rank of the match, starting at 0 for the best.
+ * @return The suggestion or NULL if there are not that many matches.
+ *
+ * @ingroup Suggest
+ */
+Edi_Language_Suggest_Item *edi_language_suggest_index_match_get(const Edi_Language_Suggest_Index *index,
+                                                                unsigned int n);
+
+/**
+ * Find the first suggestion, in sorted order, that is longer than a word
+ * and starts with it exactly.
+ *
+ * @param index The index to search.
+ * @param word The word being typed.
+ * @return The suggestion or NULL if none completes the word.
+ *
+ * @ingroup Suggest
+ */
+Edi_Language_Suggest_Item *edi_language_suggest_index_prefix_find(const Edi_Language_Suggest_Index *index,
+                                                                  const char *word);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_LANGUAGE_SUGGEST_H_ */
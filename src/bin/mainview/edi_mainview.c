@@ -16,12 +16,21 @@
 #include "edi_content_provider.h"
 #include "edi_searchpanel.h"
 #include "edi_file.h"
+#include "language/edi_language_index.h"
+#include "screens/edi_screens.h"
 
 #include "edi_private.h"
 #include "edi_config.h"
 
 static Evas_Object *_main_win, *_mainview_panel;
 static Evas_Object *_edi_mainview_search_project_popup;
+static Evas_Object *_edi_mainview_symbol_popup;
+static Eina_Bool _edi_mainview_search_project_regex = EINA_FALSE;
+static Eina_Bool _edi_mainview_search_project_caseless = EINA_FALSE;
+static Eina_Bool _edi_mainview_search_project_word = EINA_FALSE;
+static Ecore_Timer *_edi_mainview_search_project_timer = NULL;
+
+#define EDI_MAINVIEW_SEARCH_TYPING_DELAY 0.2
 
 static Edi_Mainview_Panel *_current_panel;
 static Eina_List *_edi_mainview_panels = NULL, *_edi_mainview_wins = NULL;
@@ -121,6 +130,27 @@ edi_mainview_panel_for_path_get(const char *path)
    return NULL;
 }
 
+Edi_Mainview_Item *
+edi_mainview_item_loaded_for_path_get(const char *path)
+{
+   Eina_List *item;
+   Edi_Mainview_Panel *panel;
+   Edi_Mainview_Item *it;
+   int i;
+
+   for (i = 0; i < edi_mainview_panel_count(); i++)
+     {
+        panel = edi_mainview_panel_by_index(i);
+        EINA_LIST_FOREACH(panel->items, item, it)
+          {
+             if (it && it->loaded && !strcmp(it->path, path))
+               return it;
+          }
+     }
+
+   return NULL;
+}
+
 unsigned int
 edi_mainview_panel_index_get(Edi_Mainview_Panel *panel)
 {
@@ -582,14 +612,44 @@ _edi_mainview_project_search_popup_cancel_cb(void *data EINA_UNUSED,
    evas_object_del(_edi_mainview_search_project_popup);
 }
 
+static Edi_Search_Regex_Flags
+_edi_mainview_project_search_flags_get(void)
+{
+   Edi_Search_Regex_Flags flags;
+
+   flags = EDI_SEARCH_REGEX_DEFAULT;
+   if (!_edi_mainview_search_project_regex)
+     flags |= EDI_SEARCH_REGEX_LITERAL;
+   if (_edi_mainview_search_project_caseless)
+     flags |= EDI_SEARCH_REGEX_CASELESS;
+   if (_edi_mainview_search_project_word)
+     flags |= EDI_SEARCH_REGEX_WORD;
+
+   return flags;
+}
+
+static void
+_edi_mainview_project_search_timer_del(void)
+{
+   if (!_edi_mainview_search_project_timer)
+     return;
+
+   ecore_timer_del(_edi_mainview_search_project_timer);
+   _edi_mainview_search_project_timer = NULL;
+}
+
 static void
 _edi_mainview_project_search_cb(void *data,
                              Evas_Object *obj EINA_UNUSED,
                              void *event_info EINA_UNUSED)
 {
+   Edi_Search_Regex *regex;
+   Edi_Search_Regex_Flags flags;
    const char *text_markup;
    char *text;
 
+   _edi_mainview_project_search_timer_del();
+
    text_markup = elm_object_text_get((Evas_Object *) data);
    if (!text_markup || !text_markup[0])
      {
@@ -598,9 +658,19 @@ _edi_mainview_project_search_cb(void *data,
      }
 
    text = elm_entry_markup_to_utf8(text_markup);
+   flags = _edi_mainview_project_search_flags_get();
+
+   regex = edi_search_regex_new(text, flags);
+   if (!regex)
+     {
+        _edi_mainview_popup_message_open(_("Invalid regular expression."));
+        free(text);
+        return;
+     }
+   edi_search_regex_free(regex);
 
    edi_searchpanel_show();
-   edi_searchpanel_find(text);
+   edi_searchpanel_find_full(text, flags);
 
    free(text);
    evas_object_del(_edi_mainview_search_project_popup);
@@ -619,15 +689,63 @@ _edi_mainview_project_search_popup_key_up_cb(void *data EINA_UNUSED, Evas *e EIN
      _edi_mainview_project_search_cb(obj, NULL, NULL);
 }
 
+/* Search as the user types, the search panel refines the last results while the term grows. */
+static Eina_Bool
+_edi_mainview_project_search_typing_cb(void *data)
+{
+   Edi_Search_Regex *regex;
+   Edi_Search_Regex_Flags flags;
+   const char *text_markup;
+   char *text;
+
+   _edi_mainview_search_project_timer = NULL;
+
+   text_markup = elm_object_text_get((Evas_Object *) data);
+   if (!text_markup || !text_markup[0])
+     return ECORE_CALLBACK_CANCEL;
+
+   text = elm_entry_markup_to_utf8(text_markup);
+   flags = _edi_mainview_project_search_flags_get();
+
+   /* An incomplete expression is expected while typing, just wait for more. */
+   regex = edi_search_regex_new(text, flags);
+   if (regex)
+     {
+        edi_search_regex_free(regex);
+        edi_searchpanel_show();
+        edi_searchpanel_find_full(text, flags);
+     }
+
+   free(text);
+   return ECORE_CALLBACK_CANCEL;
+}
+
+static void
+_edi_mainview_project_search_changed_cb(void *data EINA_UNUSED, Evas_Object *obj,
+                                        void *event_info EINA_UNUSED)
+{
+   _edi_mainview_project_search_timer_del();
+   _edi_mainview_search_project_timer =
+      ecore_timer_add(EDI_MAINVIEW_SEARCH_TYPING_DELAY, _edi_mainview_project_search_typing_cb, obj);
+}
+
+static void
+_edi_mainview_project_search_popup_del_cb(void *data EINA_UNUSED, Evas *e EINA_UNUSED,
+                                          Evas_Object *obj EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   _edi_mainview_project_search_timer_del();
+}
+
 void
 edi_mainview_project_search_popup_show(void)
 {
-   Evas_Object *popup, *frame, *box, *input, *button, *label;
+   Evas_Object *popup, *frame, *box, *input, *button, *label, *check;
 
    popup = elm_popup_add(_main_win);
    _edi_mainview_search_project_popup = popup;
    elm_object_part_text_set(popup, "title,text",
                             _("Search for (whole project)"));
+   evas_object_event_callback_add(popup, EVAS_CALLBACK_DEL, _edi_mainview_project_search_popup_del_cb, NULL);
 
    box = elm_box_add(popup);
    evas_object_show(box);
@@ -644,8 +762,30 @@ edi_mainview_project_search_popup_show(void)
    evas_object_size_hint_weight_set(input, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
    evas_object_size_hint_align_set(input, EVAS_HINT_FILL, EVAS_HINT_FILL);
    evas_object_event_callback_add(input, EVAS_CALLBACK_KEY_UP, _edi_mainview_project_search_popup_key_up_cb, NULL);
+   evas_object_smart_callback_add(input, "changed,user", _edi_mainview_project_search_changed_cb, NULL);
    evas_object_show(input);
    elm_box_pack_end(box, input);
+
+   check = elm_check_add(box);
+   elm_object_text_set(check, _("Regular expression"));
+   elm_check_state_pointer_set(check, &_edi_mainview_search_project_regex);
+   evas_object_size_hint_align_set(check, 0.0, 0.5);
+   evas_object_show(check);
+   elm_box_pack_end(box, check);
+
+   check = elm_check_add(box);
+   elm_object_text_set(check, _("Ignore case"));
+   elm_check_state_pointer_set(check, &_edi_mainview_search_project_caseless);
+   evas_object_size_hint_align_set(check, 0.0, 0.5);
+   evas_object_show(check);
+   elm_box_pack_end(box, check);
+
+   check = elm_check_add(box);
+   elm_object_text_set(check, _("Whole word"));
+   elm_check_state_pointer_set(check, &_edi_mainview_search_project_word);
+   evas_object_size_hint_align_set(check, 0.0, 0.5);
+   evas_object_show(check);
+   elm_box_pack_end(box, check);
    evas_object_show(box);
 
    frame = elm_frame_add(box);
@@ -670,6 +810,140 @@ edi_mainview_project_search_popup_show(void)
    elm_object_focus_set(input, EINA_TRUE);
 }
 
+static void
+_edi_mainview_symbol_popup_cancel_cb(void *data EINA_UNUSED,
+                                     Evas_Object *obj EINA_UNUSED,
+                                     void *event_info EINA_UNUSED)
+{
+   evas_object_del(_edi_mainview_symbol_popup);
+}
+
+static void
+_edi_mainview_symbol_find_cb(void *data,
+                             Evas_Object *obj EINA_UNUSED,
+                             void *event_info EINA_UNUSED)
+{
+   Eina_List *locations;
+   const char *text_markup;
+   char *text;
+
+   text_markup = elm_object_text_get((Evas_Object *) data);
+   if (!text_markup || !text_markup[0])
+     {
+        _edi_mainview_popup_message_open(_("Please enter a valid symbol name."));
+        return;
+     }
+
+   text = elm_entry_markup_to_utf8(text_markup);
+   locations = edi_language_index_name_find(text, EDI_LANGUAGE_INDEX_DEFINITION |
+                                            EDI_LANGUAGE_INDEX_DECLARATION, EINA_FALSE);
+   free(text);
+
+   evas_object_del(_edi_mainview_symbol_popup);
+   if (!locations)
+     {
+        _edi_mainview_popup_message_open(_("No matching symbols found."));
+        return;
+     }
+
+   edi_searchpanel_show();
+   edi_searchpanel_locations_show(locations);
+   edi_language_index_locations_free(locations);
+}
+
+static void
+_edi_mainview_symbol_popup_key_up_cb(void *data EINA_UNUSED, Evas *e EINA_UNUSED,
+                                     Evas_Object *obj, void *event_info)
+{
+   Evas_Event_Key_Up *ev = (Evas_Event_Key_Up *)event_info;
+   const char *str;
+
+   str = elm_object_text_get(obj);
+
+   if (strlen(str) && (!strcmp(ev->key, "KP_Enter") || !strcmp(ev->key, "Return")))
+     _edi_mainview_symbol_find_cb(obj, NULL, NULL);
+}
+
+void
+edi_mainview_symbol_popup_show(void)
+{
+   Evas_Object *popup, *box, *input, *button, *label;
+
+   popup = elm_popup_add(_main_win);
+   _edi_mainview_symbol_popup = popup;
+   elm_object_part_text_set(popup, "title,text",
+                            _("Find symbol (whole project)"));
+
+   box = elm_box_add(popup);
+   evas_object_show(box);
+
+   label = elm_label_add(popup);
+   elm_object_text_set(label, _("Please enter part of the name of a<br> function, type or variable.<br>"));
+   evas_object_show(label);
+   elm_box_pack_end(box, label);
+
+   input = elm_entry_add(box);
+   elm_entry_single_line_set(input, EINA_TRUE);
+   elm_entry_editable_set(input, EINA_TRUE);
+   elm_entry_scrollable_set(input, EINA_TRUE);
+   evas_object_size_hint_weight_set(input, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+   evas_object_size_hint_align_set(input, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   evas_object_event_callback_add(input, EVAS_CALLBACK_KEY_UP, _edi_mainview_symbol_popup_key_up_cb, NULL);
+   evas_object_show(input);
+   elm_box_pack_end(box, input);
+
+   elm_object_content_set(popup, box);
+
+   button = elm_button_add(popup);
+   elm_object_text_set(button, _("Cancel"));
+   elm_object_part_content_set(popup, "button1", button);
+   evas_object_smart_callback_add(button, "clicked",
+                                  _edi_mainview_symbol_popup_cancel_cb, NULL);
+
+   button = elm_button_add(popup);
+   elm_object_text_set(button, _("Find"));
+   elm_object_part_content_set(popup, "button2", button);
+   evas_object_smart_callback_add(button, "clicked",
+                                  _edi_mainview_symbol_find_cb, input);
+
+   evas_object_show(popup);
+   elm_object_focus_set(input, EINA_TRUE);
+}
+
+static Edi_Editor *
+_edi_mainview_editor_current_get(void)
+{
+   Edi_Mainview_Item *item;
+
+   if (edi_mainview_is_empty()) return NULL;
+
+   item = edi_mainview_item_current_get();
+   if (!item)
+     return NULL;
+
+   return (Edi_Editor *)evas_object_data_get(item->view, "editor");
+}
+
+void
+edi_mainview_definition_goto(void)
+{
+   Edi_Editor *editor;
+
+   editor = _edi_mainview_editor_current_get();
+   if (editor)
+     edi_editor_definition_goto(editor);
+}
+
+void
+edi_mainview_references_find(void)
+{
+   Edi_Editor *editor;
+
+   editor = _edi_mainview_editor_current_get();
+   if (editor)
+     edi_editor_references_find(editor);
+}
+
 static void
 _edi_mainview_project_replace_cb(void *data,
                              Evas_Object *obj,
@@ -701,7 +975,7 @@ _edi_mainview_project_replace_cb(void *data,
    search = elm_entry_markup_to_utf8(search_markup);
    replace = elm_entry_markup_to_utf8(replace_markup);
 
-   edi_file_text_replace_all(search, replace);
+   edi_replace_preview_show(_main_win, search, replace);
 
    free(search);
    free(replace);
@@ -253,6 +253,27 @@ void edi_mainview_project_search_popup_show();
  */
 void edi_mainview_project_replace_popup_show();
 
+/**
+ * Present a popup that will search the project for symbols by name.
+ *
+ * @ingroup Content
+ */
+void edi_mainview_symbol_popup_show(void);
+
+/**
+ * Go to the definition of the symbol under the cursor in the current view.
+ *
+ * @ingroup Content
+ */
+void edi_mainview_definition_goto(void);
+
+/**
+ * List everywhere in the project that the symbol under the cursor in the current view is used.
+ *
+ * @ingroup Content
+ */
+void edi_mainview_references_find(void);
+
 /**
  * @}
  *
@@ -352,6 +373,17 @@ Edi_Mainview_Panel *edi_mainview_panel_for_item_get(Edi_Mainview_Item *item);
  */
 Edi_Mainview_Panel *edi_mainview_panel_for_path_get(const char *path);
 
+/**
+ * Return the item that has a path open in an editor, in any panel.
+ * Tabs that have not been shown yet have no editor and are not returned.
+ *
+ * @param path the path of the file to look for.
+ * @return the loaded mainview item for the path, or NULL if there is none.
+ *
+ * @ingroup Panels
+ */
+Edi_Mainview_Item *edi_mainview_item_loaded_for_path_get(const char *path);
+
 /*
  * Return panel object from it's numeric index.
  *
@@ -0,0 +1,480 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <Elementary.h>
+#include <Ecore.h>
+
+#include "edi_screens.h"
+#include "edi_config.h"
+#include "editor/edi_editor.h"
+#include "mainview/edi_mainview.h"
+#include "search/edi_search_replace.h"
+
+#include "edi_private.h"
+
+typedef struct _Edi_Replace_Preview
+{
+   Evas_Object *parent, *win, *list, *status, *apply;
+   Elm_Genlist_Item_Class *file_itc, *hunk_itc;
+
+   Edi_Search_Replace *preview;
+   Eina_List *files;
+} Edi_Replace_Preview;
+
+typedef struct _Edi_Replace_Applied
+{
+   Evas_Object *parent;
+   unsigned int files, hunks, skipped;
+} Edi_Replace_Applied;
+
+static Edi_Search_Replace *_edi_replace_undo = NULL;
+
+static char *
+_edi_replace_journal_get(void)
+{
+   return edi_path_append(_edi_project_config_dir_get(), "replace");
+}
+
+static void
+_edi_replace_exit(void *data, Evas_Object *obj EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   evas_object_del(data);
+}
+
+static void
+_edi_replace_del_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   Edi_Replace_Preview *preview = data;
+   Edi_Search_Replace_File *file;
+
+   edi_search_replace_cancel(preview->preview);
+   EINA_LIST_FREE(preview->files, file)
+     edi_search_replace_file_free(file);
+
+   elm_genlist_item_class_free(preview->file_itc);
+   elm_genlist_item_class_free(preview->hunk_itc);
+   free(preview);
+}
+
+static char *
+_edi_replace_file_text_get(void *data, Evas_Object *obj EINA_UNUSED, const char *source EINA_UNUSED)
+{
+   Edi_Search_Replace_File *file = data;
+   const char *path, *project;
+   size_t length;
+
+   path = file->path;
+   project = edi_project_get();
+   length = strlen(project);
+   if (!strncmp(path, project, length) && path[length] == '/')
+     path += length + 1;
+
+   return strdup(eina_slstr_printf("%s (%u)", path, eina_list_count(file->hunks)));
+}
+
+static char *
+_edi_replace_hunk_text_get(void *data, Evas_Object *obj EINA_UNUSED, const char *source)
+{
+   Edi_Search_Replace_Hunk *hunk = data;
+   const char *text, *prefix;
+   char *line, *markup;
+   size_t length;
+
+   if (!strcmp(source, "elm.text.sub"))
+     {
+        text = hunk->after;
+        prefix = "+";
+     }
+   else
+     {
+        text = hunk->before;
+        prefix = eina_slstr_printf("%u -", hunk->line);
+     }
+
+   length = strlen(text);
+   if (length && text[length - 1] == '\r')
+     length--;
+   line = strndup(text, length);
+   markup = elm_entry_utf8_to_markup(line);
+   free(line);
+
+   text = eina_slstr_printf("%s %s", prefix, markup ? markup : "");
+   free(markup);
+   return strdup(text);
+}
+
+static Evas_Object *
+_edi_replace_check_add(Evas_Object *obj, Eina_Bool *state)
+{
+   Evas_Object *check;
+
+   check = elm_check_add(obj);
+   elm_check_state_pointer_set(check, state);
+   evas_object_show(check);
+
+   return check;
+}
+
+static Evas_Object *
+_edi_replace_file_content_get(void *data, Evas_Object *obj, const char *source)
+{
+   Edi_Search_Replace_File *file = data;
+
+   if (strcmp(source, "elm.swallow.icon"))
+     return NULL;
+
+   return _edi_replace_check_add(obj, &file->apply);
+}
+
+static Evas_Object *
+_edi_replace_hunk_content_get(void *data, Evas_Object *obj, const char *source)
+{
+   Edi_Search_Replace_Hunk *hunk = data;
+
+   if (strcmp(source, "elm.swallow.icon"))
+     return NULL;
+
+   return _edi_replace_check_add(obj, &hunk->apply);
+}
+
+static void
+_edi_replace_expand_request_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info)
+{
+   elm_genlist_item_expanded_set(event_info, EINA_TRUE);
+}
+
+static void
+_edi_replace_contract_request_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info)
+{
+   elm_genlist_item_expanded_set(event_info, EINA_FALSE);
+}
+
+static void
+_edi_replace_expanded_cb(void *data, Evas_Object *obj, void *event_info)
+{
+   Edi_Replace_Preview *preview = data;
+   Edi_Search_Replace_File *file;
+   Edi_Search_Replace_Hunk *hunk;
+   Elm_Object_Item *it = event_info;
+   Eina_List *item;
+
+   file = elm_object_item_data_get(it);
+   EINA_LIST_FOREACH(file->hunks, item, hunk)
+     elm_genlist_item_append(obj, preview->hunk_itc, hunk, it, ELM_GENLIST_ITEM_NONE, NULL, NULL);
+}
+
+static void
+_edi_replace_contracted_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info)
+{
+   elm_genlist_item_subitems_clear(event_info);
+}
+
+static void
+_edi_replace_file_cb(void *data, Edi_Search_Replace_File *file)
+{
+   Edi_Replace_Preview *preview = data;
+
+   preview->files = eina_list_append(preview->files, file);
+   elm_genlist_item_append(preview->list, preview->file_itc, file, NULL,
+                           ELM_GENLIST_ITEM_TREE, NULL, NULL);
+}
+
+static void
+_edi_replace_preview_done_cb(void *data, unsigned int files, unsigned int hunks)
+{
+   Edi_Replace_Preview *preview = data;
+
+   preview->preview = NULL;
+   if (!files)
+     {
+        elm_object_text_set(preview->status, _("No lines to change were found."));
+        return;
+     }
+
+   elm_object_text_set(preview->status,
+                       eina_slstr_printf(_("%u lines will change in %u files."), hunks, files));
+   elm_object_disabled_set(preview->apply, EINA_FALSE);
+}
+
+static void
+_edi_replace_apply_done_cb(void *data, unsigned int files, unsigned int hunks)
+{
+   Edi_Replace_Applied *applied = data;
+
+   files += applied->files;
+   hunks += applied->hunks;
+   if (applied->skipped)
+     edi_screens_message(applied->parent, _("Replace"),
+                         eina_slstr_printf(_("Changed %u lines in %u files, %u lines were skipped as they changed since the preview."),
+                                           hunks, files, applied->skipped));
+   else
+     edi_screens_message(applied->parent, _("Replace"),
+                         eina_slstr_printf(_("Changed %u lines in %u files."), hunks, files));
+   free(applied);
+}
+
+static Edi_Editor *
+_edi_replace_editor_get(const char *path)
+{
+   Edi_Mainview_Item *item;
+
+   item = edi_mainview_item_loaded_for_path_get(path);
+   if (!item)
+     return NULL;
+
+   return (Edi_Editor *)evas_object_data_get(item->view, "editor");
+}
+
+/* Change the lines in the editor, those that moved are found by their content. Lines that cannot
+ * be found any more are skipped and unselected, the others keep the line they were changed at. */
+static unsigned int
+_edi_replace_editor_apply(Edi_Editor *editor, Edi_Search_Replace_File *file, unsigned int *skipped)
+{
+   Edi_Search_Replace_Hunk *hunk;
+   Eina_List *l;
+   unsigned int changed = 0, line;
+
+   EINA_LIST_FOREACH(file->hunks, l, hunk)
+     {
+        if (!hunk->apply)
+          continue;
+
+        line = edi_editor_line_replace(editor, hunk->line, hunk->before, hunk->after);
+        if (!line)
+          {
+             hunk->apply = EINA_FALSE;
+             (*skipped)++;
+             continue;
+          }
+
+        hunk->line = line;
+        changed++;
+     }
+
+   return changed;
+}
+
+static void
+_edi_replace_apply_cb(void *data, Evas_Object *obj EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   Edi_Replace_Preview *preview = data;
+   Edi_Replace_Applied *applied;
+   Edi_Search_Replace_File *file;
+   Edi_Editor *editor;
+   Eina_List *l, *l_next;
+   unsigned int changed;
+   char *journal;
+
+   journal = _edi_replace_journal_get();
+   if (!edi_search_replace_journal_reset(journal))
+     {
+        edi_screens_message(preview->parent, _("Replace"),
+                            _("Unable to create the journal to undo the replace, nothing was changed."));
+        free(journal);
+        evas_object_del(preview->win);
+        return;
+     }
+
+   applied = calloc(1, sizeof(Edi_Replace_Applied));
+   applied->parent = preview->parent;
+
+   // Files open in an editor are changed in the buffer, writing them would force a reload.
+   EINA_LIST_FOREACH_SAFE(preview->files, l, l_next, file)
+     {
+        if (!file->apply)
+          continue;
+
+        editor = _edi_replace_editor_get(file->path);
+        if (!editor)
+          continue;
+
+        changed = _edi_replace_editor_apply(editor, file, &applied->skipped);
+        if (changed)
+          {
+             applied->files++;
+             applied->hunks += changed;
+             edi_search_replace_journal_buffer_add(journal, file);
+          }
+
+        preview->files = eina_list_remove_list(preview->files, l);
+        edi_search_replace_file_free(file);
+     }
+
+   if (preview->files)
+     {
+        edi_search_replace_apply(preview->files, journal, _edi_replace_apply_done_cb, applied);
+        preview->files = NULL;
+     }
+   else
+     _edi_replace_apply_done_cb(applied, 0, 0);
+
+   free(journal);
+   evas_object_del(preview->win);
+}
+
+Evas_Object *
+edi_replace_preview_show(Evas_Object *mainwin, const char *search, const char *replace)
+{
+   Edi_Replace_Preview *preview;
+   Evas_Object *win, *bg, *box, *list, *label, *buttonbox, *button;
+
+   win = elm_win_add(mainwin, "replace", ELM_WIN_BASIC);
+   if (!win) return NULL;
+
+   preview = calloc(1, sizeof(Edi_Replace_Preview));
+   preview->parent = mainwin;
+   preview->win = win;
+
+   elm_win_title_set(win, _("Replace in project"));
+   elm_win_focus_highlight_enabled_set(win, EINA_TRUE);
+   evas_object_smart_callback_add(win, "delete,request", _edi_replace_exit, win);
+   evas_object_event_callback_add(win, EVAS_CALLBACK_DEL, _edi_replace_del_cb, preview);
+
+   bg = elm_bg_add(win);
+   evas_object_size_hint_weight_set(bg, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+   evas_object_size_hint_align_set(bg, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   elm_win_resize_object_add(win, bg);
+   evas_object_show(bg);
+
+   box = elm_box_add(win);
+   evas_object_size_hint_weight_set(box, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+   evas_object_size_hint_align_set(box, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   elm_win_resize_object_add(win, box);
+   evas_object_show(box);
+
+   label = elm_label_add(box);
+   elm_object_text_set(label, _("Searching..."));
+   evas_object_size_hint_align_set(label, 0.0, 0.5);
+   elm_box_pack_end(box, label);
+   evas_object_show(label);
+   preview->status = label;
+
+   preview->file_itc = elm_genlist_item_class_new();
+   preview->file_itc->item_style = "default";
+   preview->file_itc->func.text_get = _edi_replace_file_text_get;
+   preview->file_itc->func.content_get = _edi_replace_file_content_get;
+
+   preview->hunk_itc = elm_genlist_item_class_new();
+   preview->hunk_itc->item_style = "double_label";
+   preview->hunk_itc->func.text_get = _edi_replace_hunk_text_get;
+   preview->hunk_itc->func.content_get = _edi_replace_hunk_content_get;
+
+   list = elm_genlist_add(box);
+   elm_genlist_mode_set(list, ELM_LIST_COMPRESS);
+   elm_genlist_select_mode_set(list, ELM_OBJECT_SELECT_MODE_NONE);
+   evas_object_size_hint_weight_set(list, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+   evas_object_size_hint_align_set(list, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   evas_object_smart_callback_add(list, "expand,request", _edi_replace_expand_request_cb, preview);
+   evas_object_smart_callback_add(list, "contract,request", _edi_replace_contract_request_cb, preview);
+   evas_object_smart_callback_add(list, "expanded", _edi_replace_expanded_cb, preview);
+   evas_object_smart_callback_add(list, "contracted", _edi_replace_contracted_cb, preview);
+   elm_box_pack_end(box, list);
+   evas_object_show(list);
+   preview->list = list;
+
+   buttonbox = elm_box_add(box);
+   elm_box_horizontal_set(buttonbox, EINA_TRUE);
+   evas_object_size_hint_align_set(buttonbox, 1.0, 0.5);
+   elm_box_pack_end(box, buttonbox);
+   evas_object_show(buttonbox);
+
+   button = elm_button_add(buttonbox);
+   elm_object_text_set(button, _("Cancel"));
+   evas_object_smart_callback_add(button, "clicked", _edi_replace_exit, win);
+   elm_box_pack_end(buttonbox, button);
+   evas_object_show(button);
+
+   button = elm_button_add(buttonbox);
+   elm_object_text_set(button, _("Apply"));
+   elm_object_disabled_set(button, EINA_TRUE);
+   evas_object_smart_callback_add(button, "clicked", _edi_replace_apply_cb, preview);
+   elm_box_pack_end(buttonbox, button);
+   evas_object_show(button);
+   preview->apply = button;
+
+   evas_object_resize(win, 640 * elm_config_scale_get(), 480 * elm_config_scale_get());
+   evas_object_show(win);
+
+   preview->preview = edi_search_replace_preview(search, replace, _edi_replace_file_cb,
+                                                 _edi_replace_preview_done_cb, preview);
+   if (!preview->preview)
+     elm_object_text_set(preview->status, _("Please enter a valid search string."));
+
+   return win;
+}
+
+static Eina_Bool
+_edi_replace_undo_buffer_cb(void *data EINA_UNUSED, const char *path, Eina_List *hunks)
+{
+   Edi_Search_Replace_Hunk *hunk;
+   Edi_Editor *editor;
+   Eina_List *l;
+
+   editor = _edi_replace_editor_get(path);
+   if (!editor)
+     return EINA_FALSE;
+
+   EINA_LIST_REVERSE_FOREACH(hunks, l, hunk)
+     {
+        if (!edi_editor_line_replace(editor, hunk->line, hunk->after, hunk->before))
+          hunk->apply = EINA_FALSE;
+     }
+
+   return EINA_TRUE;
+}
+
+static void
+_edi_replace_undo_done_cb(void *data, unsigned int files, unsigned int skipped)
+{
+   Evas_Object *parent = data;
+
+   _edi_replace_undo = NULL;
+   if (skipped)
+     edi_screens_message(parent, _("Undo Replace"),
+                         eina_slstr_printf(_("Restored %u files, %u files were skipped as they changed since the replace."),
+                                           files, skipped));
+   else
+     edi_screens_message(parent, _("Undo Replace"),
+                         eina_slstr_printf(_("Restored %u files."), files));
+}
+
+static void
+_edi_replace_undo_confirm_cb(void *data)
+{
+   char *journal;
+
+   if (_edi_replace_undo)
+     return;
+
+   journal = _edi_replace_journal_get();
+   _edi_replace_undo = edi_search_replace_undo(journal, _edi_replace_undo_buffer_cb,
+                                               _edi_replace_undo_done_cb, data);
+   free(journal);
+}
+
+void
+edi_replace_undo(Evas_Object *mainwin)
+{
+   char *journal;
+   Eina_Bool available;
+
+   if (_edi_replace_undo)
+     {
+        edi_screens_message(mainwin, _("Undo Replace"), _("The last replace is already being undone."));
+        return;
+     }
+
+   journal = _edi_replace_journal_get();
+   available = edi_search_replace_undo_available(journal);
+   free(journal);
+
+   if (!available)
+     {
+        edi_screens_message(mainwin, _("Undo Replace"), _("There is no replace to undo."));
+        return;
+     }
+
+   edi_screens_message_confirm(mainwin, _("Put back every file changed by the last replace in project?"),
+                               _edi_replace_undo_confirm_cb, mainwin);
+}
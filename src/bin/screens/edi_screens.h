@@ -60,6 +60,28 @@ Evas_Object *edi_settings_show(Evas_Object *mainwin);
 
 void edi_settings_font_add(Evas_Object *parent);
 
+/**
+ * Initialise a new Edi replace preview window and display it.
+ * The changes are found in the background and listed as they arrive.
+ *
+ * @param mainwin The window the preview belongs to.
+ * @param search The text to be replaced.
+ * @param replace The text that will replace it.
+ * @return The replace preview window that is created
+ *
+ * @ingroup UI
+ */
+Evas_Object *edi_replace_preview_show(Evas_Object *mainwin, const char *search, const char *replace);
+
+/**
+ * Offer to undo the last project replace, if there is one.
+ *
+ * @param mainwin The window to show the confirmation in.
+ *
+ * @ingroup UI
+ */
+void edi_replace_undo(Evas_Object *mainwin);
+
 /**
  * Create a a confirmation dialogue and add it to the parent obj.
  *
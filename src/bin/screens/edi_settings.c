@@ -416,12 +416,27 @@ _edi_settings_project_name_cb(void *data EINA_UNUSED, Evas_Object *obj,
    _edi_project_config_save();
 }
 
+static void
+_edi_settings_project_tasks_cb(void *data EINA_UNUSED, Evas_Object *obj,
+                               void *event EINA_UNUSED)
+{
+   Evas_Object *entry;
+
+   entry = (Evas_Object *)obj;
+
+   if (_edi_project_config->tasks.markers)
+     eina_stringshare_del(_edi_project_config->tasks.markers);
+
+   _edi_project_config->tasks.markers = eina_stringshare_add(elm_object_text_get(entry));
+   _edi_project_config_save();
+}
+
 static Evas_Object *
 _edi_settings_project_create(Evas_Object *parent)
 {
    Edi_Scm_Engine *engine = NULL;
    Evas_Object *box, *frames, *frame, *hbox, *label, *entry_name, *entry_email;
-   Evas_Object *entry_remote;
+   Evas_Object *entry_remote, *entry_tasks;
    Eina_Strbuf *text;
 
    frames = elm_box_add(parent);
@@ -482,6 +497,31 @@ _edi_settings_project_create(Evas_Object *parent)
    evas_object_smart_callback_add(entry_email, "changed",
                                   _edi_settings_project_email_cb, NULL);
 
+   hbox = elm_box_add(parent);
+   elm_box_horizontal_set(hbox, EINA_TRUE);
+   evas_object_size_hint_weight_set(hbox, EVAS_HINT_EXPAND, 0.0);
+   evas_object_size_hint_align_set(hbox, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   elm_box_pack_end(box, hbox);
+   evas_object_show(hbox);
+
+   label = elm_label_add(hbox);
+   elm_object_text_set(label, _("Task Markers"));
+   evas_object_size_hint_weight_set(label, 0.0, 0.0);
+   evas_object_size_hint_align_set(label, 0.0, EVAS_HINT_FILL);
+   elm_box_pack_end(hbox, label);
+   evas_object_show(label);
+
+   entry_tasks = elm_entry_add(hbox);
+   elm_object_text_set(entry_tasks, _edi_project_config->tasks.markers);
+   elm_entry_single_line_set(entry_tasks, EINA_TRUE);
+   elm_entry_scrollable_set(entry_tasks, EINA_TRUE);
+   evas_object_size_hint_weight_set(entry_tasks, 0.75, 0.0);
+   evas_object_size_hint_align_set(entry_tasks, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   elm_box_pack_end(hbox, entry_tasks);
+   evas_object_show(entry_tasks);
+   evas_object_smart_callback_add(entry_tasks, "changed",
+                                  _edi_settings_project_tasks_cb, NULL);
+
    if (!edi_scm_enabled())
      return frames;
 
@@ -549,10 +589,21 @@ _edi_settings_behaviour_trim_whitespace_cb(void *data EINA_UNUSED, Evas_Object *
    _edi_config_save();
 }
 
+static void
+_edi_settings_behaviour_clang_cache_cb(void *data EINA_UNUSED, Evas_Object *obj,
+                                       void *event EINA_UNUSED)
+{
+   Evas_Object *spinner;
+
+   spinner = (Evas_Object *)obj;
+   _edi_config->clang_cache_size = (unsigned int) elm_spinner_value_get(spinner);
+   _edi_config_save();
+}
+
 static Evas_Object *
 _edi_settings_behaviour_create(Evas_Object *parent)
 {
-   Evas_Object *box, *frame, *check;
+   Evas_Object *box, *frame, *check, *hbox, *label, *spinner;
 
    frame = _edi_settings_panel_create(parent, _("Behaviour"));
    box = elm_object_part_content_get(frame, "default");
@@ -577,6 +628,32 @@ _edi_settings_behaviour_create(Evas_Object *parent)
                                   _edi_settings_behaviour_trim_whitespace_cb, NULL);
    evas_object_show(check);
 
+   hbox = elm_box_add(box);
+   elm_box_horizontal_set(hbox, EINA_TRUE);
+   evas_object_size_hint_weight_set(hbox, EVAS_HINT_EXPAND, 0.0);
+   evas_object_size_hint_align_set(hbox, EVAS_HINT_FILL, 0.5);
+   elm_box_pack_end(box, hbox);
+   evas_object_show(hbox);
+
+   label = elm_label_add(hbox);
+   elm_object_text_set(label, _("Code parser memory (MB)"));
+   evas_object_size_hint_align_set(label, 0.0, 0.5);
+   elm_box_pack_end(hbox, label);
+   evas_object_show(label);
+
+   spinner = elm_spinner_add(hbox);
+   elm_spinner_value_set(spinner, _edi_config->clang_cache_size);
+   elm_spinner_editable_set(spinner, EINA_TRUE);
+   elm_spinner_step_set(spinner, 64);
+   elm_spinner_wrap_set(spinner, EINA_FALSE);
+   elm_spinner_min_max_set(spinner, 0, 16384);
+   evas_object_size_hint_weight_set(spinner, EVAS_HINT_EXPAND, 0.0);
+   evas_object_size_hint_align_set(spinner, 0.0, 0.95);
+   evas_object_smart_callback_add(spinner, "changed",
+                                  _edi_settings_behaviour_clang_cache_cb, NULL);
+   elm_box_pack_end(hbox, spinner);
+   evas_object_show(spinner);
+
    return frame;
 }
 
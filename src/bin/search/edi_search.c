@@ -0,0 +1,456 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <Eina.h>
+#include <Ecore.h>
+#include <Ecore_File.h>
+
+#include "Edi.h"
+#include "edi_search.h"
+
+#include "edi_private.h"
+
+#define EDI_SEARCH_WORKERS_MAX 16
+#define EDI_SEARCH_WAIT_TIMEOUT 0.05
+
+typedef struct _Edi_Search_Task
+{
+   char *path;
+   Eina_List *matches;
+   Eina_Bool done;
+} Edi_Search_Task;
+
+typedef struct _Edi_Search_Worker
+{
+   Edi_Search *search;
+   Eina_Thread thread;
+
+   Eina_Lock lock;
+   Edi_Search_Task **queue;
+   unsigned int head, count, size;
+} Edi_Search_Worker;
+
+struct _Edi_Search
+{
+   Ecore_Thread *thread;
+   Edi_Search_File_Cb file_cb;
+   Edi_Search_Result_Cb result_cb;
+   Edi_Search_Free_Cb free_cb;
+   void *data;
+
+   Edi_Search_Worker *workers;
+   unsigned int worker_count;
+   unsigned int next_worker;
+
+   Eina_Lock lock;
+   Eina_Condition work_cond;
+   Eina_Condition done_cond;
+   unsigned int pending;
+   Eina_Bool crawl_done;
+   Eina_Bool cancel;
+
+   /* Only accessed from the search thread, in crawl order */
+   Edi_Search_Task **tasks;
+   unsigned int task_count, task_size;
+   unsigned int emitted;
+};
+
+void
+edi_search_matches_free(Eina_List *matches)
+{
+   Edi_Search_Match *match;
+
+   EINA_LIST_FREE(matches, match)
+     {
+        free(match->text);
+        free(match);
+     }
+}
+
+static void
+_edi_search_task_free(Edi_Search *search, Edi_Search_Task *task)
+{
+   if (task->matches)
+     search->free_cb(task->matches);
+   free(task->path);
+   free(task);
+}
+
+static void
+_edi_search_worker_push(Edi_Search_Worker *worker, Edi_Search_Task *task)
+{
+   eina_lock_take(&worker->lock);
+   if (worker->count == worker->size)
+     {
+        Edi_Search_Task **queue;
+        unsigned int i, size;
+
+        size = worker->size ? worker->size * 2 : 64;
+        queue = malloc(sizeof(Edi_Search_Task *) * size);
+        for (i = 0; i < worker->count; i++)
+          queue[i] = worker->queue[(worker->head + i) % worker->size];
+
+        free(worker->queue);
+        worker->queue = queue;
+        worker->size = size;
+        worker->head = 0;
+     }
+
+   worker->queue[(worker->head + worker->count) % worker->size] = task;
+   worker->count++;
+   eina_lock_release(&worker->lock);
+}
+
+/* The owner takes from the front so files are scanned roughly in crawl order. */
+static Edi_Search_Task *
+_edi_search_worker_pop(Edi_Search_Worker *worker)
+{
+   Edi_Search_Task *task = NULL;
+
+   eina_lock_take(&worker->lock);
+   if (worker->count)
+     {
+        task = worker->queue[worker->head];
+        worker->head = (worker->head + 1) % worker->size;
+        worker->count--;
+     }
+   eina_lock_release(&worker->lock);
+
+   return task;
+}
+
+/* Thieves take from the back, away from where the owner is working. */
+static Edi_Search_Task *
+_edi_search_worker_steal(Edi_Search_Worker *thief)
+{
+   Edi_Search *search = thief->search;
+   Edi_Search_Worker *victim;
+   Edi_Search_Task *task = NULL;
+   unsigned int i, id;
+
+   id = thief - search->workers;
+   for (i = 1; i < search->worker_count && !task; i++)
+     {
+        victim = &search->workers[(id + i) % search->worker_count];
+
+        eina_lock_take(&victim->lock);
+        if (victim->count)
+          {
+             victim->count--;
+             task = victim->queue[(victim->head + victim->count) % victim->size];
+          }
+        eina_lock_release(&victim->lock);
+     }
+
+   return task;
+}
+
+/* The flag is written by the search thread and read by the workers, so only under the lock. */
+static Eina_Bool
+_edi_search_cancelled(Edi_Search *search)
+{
+   Eina_Bool cancel;
+
+   eina_lock_take(&search->lock);
+   cancel = search->cancel;
+   eina_lock_release(&search->lock);
+
+   return cancel;
+}
+
+static void *
+_edi_search_worker_main(void *data, Eina_Thread thread EINA_UNUSED)
+{
+   Edi_Search_Worker *worker = data;
+   Edi_Search *search = worker->search;
+   Edi_Search_Task *task;
+
+   while (!_edi_search_cancelled(search))
+     {
+        task = _edi_search_worker_pop(worker);
+        if (!task)
+          task = _edi_search_worker_steal(worker);
+
+        if (!task)
+          {
+             eina_lock_take(&search->lock);
+             if (search->crawl_done && !search->pending)
+               {
+                  eina_lock_release(&search->lock);
+                  break;
+               }
+             eina_condition_timedwait(&search->work_cond, EDI_SEARCH_WAIT_TIMEOUT);
+             eina_lock_release(&search->lock);
+             continue;
+          }
+
+        task->matches = search->file_cb(task->path, search->data);
+
+        eina_lock_take(&search->lock);
+        task->done = EINA_TRUE;
+        search->pending--;
+        eina_condition_broadcast(&search->done_cond);
+        eina_lock_release(&search->lock);
+     }
+
+   return NULL;
+}
+
+static void
+_edi_search_cancel(Edi_Search *search)
+{
+   eina_lock_take(&search->lock);
+   search->cancel = EINA_TRUE;
+   eina_condition_broadcast(&search->work_cond);
+   eina_lock_release(&search->lock);
+}
+
+static Eina_Bool
+_edi_search_check(Edi_Search *search)
+{
+   if (_edi_search_cancelled(search))
+     return EINA_TRUE;
+
+   if (ecore_thread_check(search->thread))
+     {
+        _edi_search_cancel(search);
+        return EINA_TRUE;
+     }
+
+   return EINA_FALSE;
+}
+
+/* Deliver completed files in crawl order, optionally waiting for the rest. */
+static void
+_edi_search_flush(Edi_Search *search, Eina_Bool wait)
+{
+   Edi_Search_Task *task;
+   Eina_Bool done;
+
+   while (search->emitted < search->task_count)
+     {
+        task = search->tasks[search->emitted];
+
+        eina_lock_take(&search->lock);
+        while (!(done = task->done) && wait && !search->cancel)
+          {
+             eina_condition_timedwait(&search->done_cond, EDI_SEARCH_WAIT_TIMEOUT);
+             if (ecore_thread_check(search->thread))
+               {
+                  search->cancel = EINA_TRUE;
+                  eina_condition_broadcast(&search->work_cond);
+               }
+          }
+        eina_lock_release(&search->lock);
+
+        if (!done || _edi_search_check(search))
+          return;
+
+        search->tasks[search->emitted++] = NULL;
+        if (task->matches)
+          search->result_cb(search->data, task->path, task->matches);
+        task->matches = NULL;
+        _edi_search_task_free(search, task);
+     }
+}
+
+static void
+_edi_search_task_add(Edi_Search *search, char *path)
+{
+   Edi_Search_Task *task;
+
+   task = calloc(1, sizeof(Edi_Search_Task));
+   task->path = path;
+
+   if (search->task_count == search->task_size)
+     {
+        search->task_size = search->task_size ? search->task_size * 2 : 256;
+        search->tasks = realloc(search->tasks, sizeof(Edi_Search_Task *) * search->task_size);
+     }
+   search->tasks[search->task_count++] = task;
+
+   eina_lock_take(&search->lock);
+   search->pending++;
+   eina_lock_release(&search->lock);
+
+   _edi_search_worker_push(&search->workers[search->next_worker], task);
+   search->next_worker = (search->next_worker + 1) % search->worker_count;
+
+   eina_lock_take(&search->lock);
+   eina_condition_signal(&search->work_cond);
+   eina_lock_release(&search->lock);
+}
+
+static Eina_Bool
+_edi_search_crawl_cb(void *data, const char *path, Eina_Bool directory)
+{
+   Edi_Search *search = data;
+
+   if (_edi_search_check(search))
+     return EINA_FALSE;
+
+   /* Hand over what has finished so far as we move on to each directory. */
+   if (directory)
+     _edi_search_flush(search, EINA_FALSE);
+   else
+     _edi_search_task_add(search, strdup(path));
+
+   return EINA_TRUE;
+}
+
+static void
+_edi_search_crawl(Edi_Search *search, const char *directory)
+{
+   Edi_Walker *walker;
+
+   walker = edi_walker_new(edi_project_get());
+   edi_walker_walk(walker, directory, _edi_search_crawl_cb, search);
+   edi_walker_free(walker);
+}
+
+Edi_Search *
+edi_search_add(Ecore_Thread *thread, Edi_Search_File_Cb file_cb,
+               Edi_Search_Result_Cb result_cb, const void *data)
+{
+   Edi_Search *search;
+
+   search = calloc(1, sizeof(Edi_Search));
+   search->thread = thread;
+   search->file_cb = file_cb;
+   search->result_cb = result_cb;
+   search->free_cb = edi_search_matches_free;
+   search->data = (void *) data;
+
+   eina_lock_new(&search->lock);
+   eina_condition_new(&search->work_cond, &search->lock);
+   eina_condition_new(&search->done_cond, &search->lock);
+
+   return search;
+}
+
+void
+edi_search_free_cb_set(Edi_Search *search, Edi_Search_Free_Cb free_cb)
+{
+   search->free_cb = free_cb;
+}
+
+static unsigned int
+_edi_search_workers_start(Edi_Search *search)
+{
+   Edi_Search_Worker *worker;
+   unsigned int i, started = 0;
+
+   search->worker_count = eina_cpu_count();
+   if (search->worker_count < 1)
+     search->worker_count = 1;
+   else if (search->worker_count > EDI_SEARCH_WORKERS_MAX)
+     search->worker_count = EDI_SEARCH_WORKERS_MAX;
+
+   search->workers = calloc(search->worker_count, sizeof(Edi_Search_Worker));
+   for (i = 0; i < search->worker_count; i++)
+     {
+        worker = &search->workers[i];
+        worker->search = search;
+        eina_lock_new(&worker->lock);
+     }
+
+   for (i = 0; i < search->worker_count; i++)
+     {
+        worker = &search->workers[i];
+        if (!eina_thread_create(&worker->thread, EINA_THREAD_BACKGROUND, -1,
+                                _edi_search_worker_main, worker))
+          {
+             ERR("Could not create search worker %d", i);
+             break;
+          }
+        started++;
+     }
+
+   if (!started)
+     _edi_search_cancel(search);
+
+   return started;
+}
+
+static Eina_Bool
+_edi_search_workers_finish(Edi_Search *search, unsigned int started)
+{
+   unsigned int i;
+
+   if (started)
+     {
+        eina_lock_take(&search->lock);
+        search->crawl_done = EINA_TRUE;
+        eina_condition_broadcast(&search->work_cond);
+        eina_lock_release(&search->lock);
+
+        _edi_search_flush(search, EINA_TRUE);
+     }
+
+   for (i = 0; i < started; i++)
+     eina_thread_join(search->workers[i].thread);
+
+   return !_edi_search_cancelled(search);
+}
+
+Eina_Bool
+edi_search_project_run(Edi_Search *search, const char *directory)
+{
+   unsigned int started;
+
+   started = _edi_search_workers_start(search);
+   if (started)
+     _edi_search_crawl(search, directory);
+
+   return _edi_search_workers_finish(search, started);
+}
+
+Eina_Bool
+edi_search_files_run(Edi_Search *search, Eina_List *files)
+{
+   unsigned int started;
+   char *path;
+
+   started = _edi_search_workers_start(search);
+
+   EINA_LIST_FREE(files, path)
+     {
+        if (!started || _edi_search_check(search))
+          {
+             free(path);
+             continue;
+          }
+
+        _edi_search_task_add(search, path);
+     }
+
+   return _edi_search_workers_finish(search, started);
+}
+
+void
+edi_search_free(Edi_Search *search)
+{
+   Edi_Search_Worker *worker;
+   unsigned int i;
+
+   if (!search)
+     return;
+
+   for (i = search->emitted; i < search->task_count; i++)
+     _edi_search_task_free(search, search->tasks[i]);
+   free(search->tasks);
+
+   for (i = 0; i < search->worker_count; i++)
+     {
+        worker = &search->workers[i];
+        eina_lock_free(&worker->lock);
+        free(worker->queue);
+     }
+   free(search->workers);
+
+   eina_condition_free(&search->done_cond);
+   eina_condition_free(&search->work_cond);
+   eina_lock_free(&search->lock);
+   free(search);
+}
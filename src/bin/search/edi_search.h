@@ -0,0 +1,152 @@
+#ifndef EDI_SEARCH_H_
+# define EDI_SEARCH_H_
+
+#include <Eina.h>
+#include <Ecore.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief These routines are used for searching the content of a whole project.
+ */
+
+/**
+ * @typedef Edi_Search
+ * A handle for a running project search.
+ */
+typedef struct _Edi_Search Edi_Search;
+
+/**
+ * @struct _Edi_Search_Match
+ * A single match found within a file.
+ */
+typedef struct _Edi_Search_Match
+{
+   unsigned int line; /**< The line number of the match, starting at 1 */
+   unsigned int col; /**< The column of the match within the line, starting at 1 */
+   size_t offset; /**< The byte offset of the start of the line within the file */
+   char *text; /**< The rendered summary of the line containing the match */
+} Edi_Search_Match;
+
+/**
+ * Scan a single file - this is called from a worker thread so must not
+ * touch any UI or main loop state.
+ *
+ * @param path The path of the file to scan.
+ * @param data The data passed to edi_search_add().
+ * @return A list of Edi_Search_Match for the file, NULL if nothing was found.
+ */
+typedef Eina_List *(*Edi_Search_File_Cb)(const char *path, void *data);
+
+/**
+ * Receive the matches for a single file. Results are delivered in the order
+ * the files were crawled, regardless of which worker completed them.
+ * This is called from the thread running the search and takes ownership
+ * of the matches list.
+ *
+ * @param data The data passed to edi_search_add().
+ * @param path The path of the file that matched.
+ * @param matches A list of Edi_Search_Match.
+ */
+typedef void (*Edi_Search_Result_Cb)(void *data, const char *path, Eina_List *matches);
+
+/**
+ * Free a list of results returned by an Edi_Search_File_Cb that was never
+ * delivered, because the search was cancelled.
+ *
+ * @param matches The list of results to free.
+ */
+typedef void (*Edi_Search_Free_Cb)(Eina_List *matches);
+
+/**
+ * @brief Project search engine.
+ * @defgroup Search
+ *
+ * @{
+ *
+ * A directory crawler feeding a pool of worker threads, one per core.
+ * Each worker has its own queue of files and will steal from the others
+ * when it runs dry so a single deep subtree cannot stall the search.
+ *
+ */
+
+/**
+ * Create a new search to be run from within an Ecore_Thread.
+ *
+ * @param thread The thread the search will run in, checked for cancellation.
+ * @param file_cb The function used to scan each file.
+ * @param result_cb The function that receives results for each file.
+ * @param data User data passed to the callbacks.
+ * @return A new search handle.
+ *
+ * @ingroup Search
+ */
+Edi_Search *edi_search_add(Ecore_Thread *thread, Edi_Search_File_Cb file_cb,
+                           Edi_Search_Result_Cb result_cb, const void *data);
+
+/**
+ * Crawl the directory and scan all files that are not hidden.
+ * This blocks until all files are scanned or the thread is cancelled.
+ *
+ * @param search The search handle to run.
+ * @param directory The directory to crawl.
+ * @return EINA_TRUE if the search completed, EINA_FALSE if it was cancelled.
+ *
+ * @ingroup Search
+ */
+Eina_Bool edi_search_project_run(Edi_Search *search, const char *directory);
+
+/**
+ * Scan a known set of files rather than crawling a directory.
+ * This blocks until all files are scanned or the thread is cancelled.
+ *
+ * @param search The search handle to run.
+ * @param files A list of file paths, the search takes ownership of the list and its strings.
+ * @return EINA_TRUE if the search completed, EINA_FALSE if it was cancelled.
+ *
+ * @ingroup Search
+ */
+Eina_Bool edi_search_files_run(Edi_Search *search, Eina_List *files);
+
+/**
+ * Set the function used to free results that are not delivered, for file
+ * functions that return something other than a list of Edi_Search_Match.
+ * The default is edi_search_matches_free().
+ *
+ * @param search The search handle.
+ * @param free_cb The function to free a list of results.
+ *
+ * @ingroup Search
+ */
+void edi_search_free_cb_set(Edi_Search *search, Edi_Search_Free_Cb free_cb);
+
+/**
+ * Free a search and any results that were not delivered.
+ *
+ * @param search The search handle to free.
+ *
+ * @ingroup Search
+ */
+void edi_search_free(Edi_Search *search);
+
+/**
+ * Free a list of matches as delivered to an Edi_Search_Result_Cb.
+ *
+ * @param matches The list of Edi_Search_Match to free.
+ *
+ * @ingroup Search
+ */
+void edi_search_matches_free(Eina_List *matches);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_SEARCH_H_ */
@@ -0,0 +1,930 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <sys/stat.h>
+#include <string.h>
+
+#include <Eina.h>
+#include <Ecore.h>
+#include <Ecore_File.h>
+#include <Eet.h>
+#include <Eio.h>
+
+#include "Edi.h"
+#include "edi_search_index.h"
+#include "edi_search.h"
+#include "edi_config.h"
+
+#include "edi_private.h"
+
+#define EDI_SEARCH_INDEX_NAME "search"
+#define EDI_SEARCH_INDEX_VERSION 2
+#define EDI_SEARCH_INDEX_FILE_MAX (8 * 1024 * 1024)
+#define EDI_SEARCH_INDEX_UPDATE_DELAY 0.5
+#define EDI_SEARCH_INDEX_GRAMS (1 << 24)
+
+typedef struct _Edi_Search_Index_File
+{
+   char *path;
+   long long mtime;
+   long long size;
+
+   unsigned int *grams;
+   unsigned int gram_count;
+   Eina_Bool unindexed; /* too large or unreadable, always a candidate */
+} Edi_Search_Index_File;
+
+typedef struct _Edi_Search_Index
+{
+   char *directory;
+   char *cache;
+   Edi_Walker *walker;
+
+   /* Written only by the index thread, read by searches once ready */
+   Eina_Lock lock;
+   Edi_Search_Index_File **files;
+   unsigned int file_count, file_size, removed_count;
+   Eina_Hash *paths;
+   Eina_Hash *postings;
+   Eina_Bool ready;
+   Eina_Bool dirty;
+
+   /* Only accessed from the main loop, or the index thread while it runs */
+   Ecore_Thread *thread;
+   Ecore_Timer *timer;
+   Eina_Hash *queued;
+   Eina_List *updating;
+   Eina_List *dirs;
+   Eina_Hash *monitors;
+   Eina_List *handlers;
+} Edi_Search_Index;
+
+static Edi_Search_Index *_edi_search_index = NULL;
+
+static inline unsigned char
+_edi_search_index_fold(unsigned char c)
+{
+   if (c >= 'A' && c <= 'Z')
+     return c + ('a' - 'A');
+
+   return c;
+}
+
+static int
+_edi_search_index_gram_cmp(const void *a, const void *b)
+{
+   unsigned int ga = *(const unsigned int *)a, gb = *(const unsigned int *)b;
+
+   return (ga > gb) - (ga < gb);
+}
+
+/*
+ * Collect the distinct case folded trigrams of a block of text.
+ * Trigrams spanning a line ending are skipped as searches are within a line.
+ * The seen bitmap has a bit per possible trigram and is left cleared.
+ */
+static unsigned int *
+_edi_search_index_grams_get(const char *text, size_t length, unsigned char *seen,
+                            unsigned int *count)
+{
+   unsigned int *grams = NULL;
+   unsigned int gram = 0, valid = 0, n = 0, size = 0, i;
+   size_t pos;
+
+   for (pos = 0; pos < length; pos++)
+     {
+        if (text[pos] == '\n')
+          {
+             valid = 0;
+             continue;
+          }
+
+        gram = ((gram << 8) | _edi_search_index_fold(text[pos])) & (EDI_SEARCH_INDEX_GRAMS - 1);
+        if (++valid < 3)
+          continue;
+
+        if (seen[gram >> 3] & (1 << (gram & 7)))
+          continue;
+        seen[gram >> 3] |= 1 << (gram & 7);
+
+        if (n == size)
+          {
+             size = size ? size * 2 : 256;
+             grams = realloc(grams, sizeof(unsigned int) * size);
+          }
+        grams[n++] = gram;
+     }
+
+   for (i = 0; i < n; i++)
+     seen[grams[i] >> 3] = 0;
+
+   if (n)
+     qsort(grams, n, sizeof(unsigned int), _edi_search_index_gram_cmp);
+
+   *count = n;
+   return grams;
+}
+
+static void
+_edi_search_index_file_free(Edi_Search_Index_File *file)
+{
+   free(file->grams);
+   free(file->path);
+   free(file);
+}
+
+static Edi_Search_Index_File *
+_edi_search_index_file_new(const char *path, const struct stat *st, unsigned char *seen)
+{
+   Edi_Search_Index_File *file;
+   Eina_File *f;
+   const char *map;
+
+   file = calloc(1, sizeof(Edi_Search_Index_File));
+   file->path = strdup(path);
+   file->mtime = st->st_mtime;
+   file->size = st->st_size;
+   file->unindexed = EINA_TRUE;
+
+   if (st->st_size > EDI_SEARCH_INDEX_FILE_MAX)
+     return file;
+
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return file;
+
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (map)
+     {
+        /* Binary files are never scanned so they never need to be a candidate. */
+        if (!edi_walker_binary_is(map, eina_file_size_get(f)))
+          file->grams = _edi_search_index_grams_get(map, eina_file_size_get(f), seen, &file->gram_count);
+        file->unindexed = EINA_FALSE;
+        eina_file_map_free(f, (void *) map);
+     }
+
+   eina_file_close(f);
+   return file;
+}
+
+static Edi_Search_Index_File *
+_edi_search_index_file_find(Edi_Search_Index *index, const char *path, unsigned int *id)
+{
+   uintptr_t found;
+
+   found = (uintptr_t) eina_hash_find(index->paths, path);
+   if (!found)
+     return NULL;
+
+   if (id)
+     *id = found - 1;
+   return index->files[found - 1];
+}
+
+static void
+_edi_search_index_postings_free_cb(void *data)
+{
+   eina_inarray_free(data);
+}
+
+static void
+_edi_search_index_file_remove(Edi_Search_Index *index, const char *path)
+{
+   Edi_Search_Index_File *file;
+   unsigned int id;
+
+   file = _edi_search_index_file_find(index, path, &id);
+   if (!file)
+     return;
+
+   eina_lock_take(&index->lock);
+   eina_hash_del_by_key(index->paths, path);
+   index->files[id] = NULL;
+   index->removed_count++;
+   index->dirty = EINA_TRUE;
+   eina_lock_release(&index->lock);
+
+   _edi_search_index_file_free(file);
+}
+
+static void
+_edi_search_index_file_add(Edi_Search_Index *index, Edi_Search_Index_File *file)
+{
+   Eina_Inarray *posting;
+   unsigned int i, id;
+
+   _edi_search_index_file_remove(index, file->path);
+
+   eina_lock_take(&index->lock);
+   if (index->file_count == index->file_size)
+     {
+        index->file_size = index->file_size ? index->file_size * 2 : 1024;
+        index->files = realloc(index->files, sizeof(Edi_Search_Index_File *) * index->file_size);
+     }
+
+   id = index->file_count++;
+   index->files[id] = file;
+   eina_hash_add(index->paths, file->path, (void *)(uintptr_t)(id + 1));
+
+   for (i = 0; i < file->gram_count; i++)
+     {
+        posting = eina_hash_find(index->postings, &file->grams[i]);
+        if (!posting)
+          {
+             posting = eina_inarray_new(sizeof(unsigned int), 16);
+             eina_hash_add(index->postings, &file->grams[i], posting);
+          }
+        eina_inarray_push(posting, &id);
+     }
+   eina_lock_release(&index->lock);
+}
+
+static void
+_edi_search_index_clear(Edi_Search_Index *index)
+{
+   unsigned int i;
+
+   for (i = 0; i < index->file_count; i++)
+     if (index->files[i])
+       _edi_search_index_file_free(index->files[i]);
+
+   free(index->files);
+   index->files = NULL;
+   index->file_count = index->file_size = index->removed_count = 0;
+
+   eina_hash_free_buckets(index->paths);
+   eina_hash_free_buckets(index->postings);
+}
+
+/* Renumber the live files so postings stop referring to removed entries. */
+static void
+_edi_search_index_compact(Edi_Search_Index *index)
+{
+   Edi_Search_Index_File **files;
+   unsigned int i, count;
+
+   eina_lock_take(&index->lock);
+   index->ready = EINA_FALSE;
+   eina_lock_release(&index->lock);
+
+   files = index->files;
+   count = index->file_count;
+   index->files = NULL;
+   index->file_count = index->file_size = index->removed_count = 0;
+   eina_hash_free_buckets(index->paths);
+   eina_hash_free_buckets(index->postings);
+
+   for (i = 0; i < count; i++)
+     if (files[i])
+       _edi_search_index_file_add(index, files[i]);
+   free(files);
+
+   eina_lock_take(&index->lock);
+   index->ready = EINA_TRUE;
+   eina_lock_release(&index->lock);
+}
+
+static Eina_Bool
+_edi_search_index_read(const char **ptr, const char *end, void *out, size_t length)
+{
+   if ((size_t)(end - *ptr) < length)
+     return EINA_FALSE;
+
+   memcpy(out, *ptr, length);
+   *ptr += length;
+   return EINA_TRUE;
+}
+
+static void
+_edi_search_index_previous_free(Eina_Hash *previous)
+{
+   Eina_Iterator *it;
+   Eina_List *files = NULL;
+   Edi_Search_Index_File *file;
+
+   it = eina_hash_iterator_data_new(previous);
+   EINA_ITERATOR_FOREACH(it, file)
+     files = eina_list_append(files, file);
+   eina_iterator_free(it);
+   eina_hash_free(previous);
+
+   EINA_LIST_FREE(files, file)
+     _edi_search_index_file_free(file);
+}
+
+static Eina_Hash *
+_edi_search_index_load(Edi_Search_Index *index)
+{
+   Edi_Search_Index_File *file;
+   Eina_Hash *files;
+   Eet_File *ef;
+   char path[PATH_MAX];
+   const char *ptr, *end;
+   char *data;
+   int *version, size;
+   unsigned int length;
+   unsigned char unindexed;
+
+   snprintf(path, sizeof(path), "%s/%s.idx", index->cache, EDI_SEARCH_INDEX_NAME);
+   ef = eet_open(path, EET_FILE_MODE_READ);
+   if (!ef)
+     return NULL;
+
+   version = eet_read(ef, "version", &size);
+   if (!version || size != sizeof(int) || *version != EDI_SEARCH_INDEX_VERSION)
+     {
+        INF("Discarding search index with an unknown version");
+        free(version);
+        eet_close(ef);
+        return NULL;
+     }
+   free(version);
+
+   data = eet_read(ef, "files", &size);
+   eet_close(ef);
+   if (!data)
+     return NULL;
+
+   files = eina_hash_string_superfast_new(NULL);
+   ptr = data;
+   end = data + size;
+   while (ptr < end)
+     {
+        if (!_edi_search_index_read(&ptr, end, &length, sizeof(length)) ||
+            length >= PATH_MAX || (size_t)(end - ptr) < length)
+          break;
+
+        file = calloc(1, sizeof(Edi_Search_Index_File));
+        file->path = strndup(ptr, length);
+        ptr += length;
+
+        if (!_edi_search_index_read(&ptr, end, &file->mtime, sizeof(file->mtime)) ||
+            !_edi_search_index_read(&ptr, end, &file->size, sizeof(file->size)) ||
+            !_edi_search_index_read(&ptr, end, &unindexed, sizeof(unindexed)) ||
+            !_edi_search_index_read(&ptr, end, &file->gram_count, sizeof(file->gram_count)) ||
+            (size_t)(end - ptr) / sizeof(unsigned int) < file->gram_count)
+          {
+             _edi_search_index_file_free(file);
+             break;
+          }
+
+        file->unindexed = !!unindexed;
+        if (file->gram_count)
+          {
+             file->grams = malloc(sizeof(unsigned int) * file->gram_count);
+             _edi_search_index_read(&ptr, end, file->grams, sizeof(unsigned int) * file->gram_count);
+          }
+
+        eina_hash_direct_add(files, file->path, file);
+     }
+
+   free(data);
+   return files;
+}
+
+static void
+_edi_search_index_save(Edi_Search_Index *index)
+{
+   Edi_Search_Index_File *file;
+   Eina_Binbuf *buf;
+   Eet_File *ef;
+   char path[PATH_MAX], tmp[PATH_MAX];
+   unsigned int i, length;
+   unsigned char unindexed;
+   int version = EDI_SEARCH_INDEX_VERSION;
+
+   if (!ecore_file_exists(index->cache))
+     ecore_file_mkpath(index->cache);
+
+   buf = eina_binbuf_new();
+   for (i = 0; i < index->file_count; i++)
+     {
+        file = index->files[i];
+        if (!file)
+          continue;
+
+        length = strlen(file->path);
+        unindexed = file->unindexed;
+        eina_binbuf_append_length(buf, (unsigned char *) &length, sizeof(length));
+        eina_binbuf_append_length(buf, (unsigned char *) file->path, length);
+        eina_binbuf_append_length(buf, (unsigned char *) &file->mtime, sizeof(file->mtime));
+        eina_binbuf_append_length(buf, (unsigned char *) &file->size, sizeof(file->size));
+        eina_binbuf_append_length(buf, &unindexed, sizeof(unindexed));
+        eina_binbuf_append_length(buf, (unsigned char *) &file->gram_count, sizeof(file->gram_count));
+        eina_binbuf_append_length(buf, (unsigned char *) file->grams, sizeof(unsigned int) * file->gram_count);
+     }
+
+   snprintf(tmp, sizeof(tmp), "%s/%s.tmp", index->cache, EDI_SEARCH_INDEX_NAME);
+   snprintf(path, sizeof(path), "%s/%s.idx", index->cache, EDI_SEARCH_INDEX_NAME);
+   ef = eet_open(tmp, EET_FILE_MODE_WRITE);
+   if (ef)
+     {
+        eet_write(ef, "version", &version, sizeof(version), 0);
+        eet_write(ef, "files", eina_binbuf_string_get(buf), eina_binbuf_length_get(buf), 1);
+        if (eet_close(ef) == EET_ERROR_NONE && ecore_file_mv(tmp, path))
+          index->dirty = EINA_FALSE;
+        else
+          ERR("Could not save search index to %s", path);
+     }
+
+   eina_binbuf_free(buf);
+}
+
+/*
+ * Bring a single file up to date. When a previously saved index is given
+ * its entry is reused if the file has not been modified since.
+ */
+static void
+_edi_search_index_file_refresh(Edi_Search_Index *index, const char *path, const struct stat *st,
+                               Eina_Hash *previous, unsigned char *seen)
+{
+   Edi_Search_Index_File *file = NULL;
+
+   if (previous && (file = eina_hash_find(previous, path)))
+     {
+        eina_hash_del_by_key(previous, path);
+        if (file->mtime != st->st_mtime || file->size != st->st_size)
+          {
+             _edi_search_index_file_free(file);
+             file = NULL;
+          }
+     }
+   else
+     {
+        file = _edi_search_index_file_find(index, path, NULL);
+        if (file && file->mtime == st->st_mtime && file->size == st->st_size)
+          return;
+        file = NULL;
+     }
+
+   if (!file)
+     {
+        file = _edi_search_index_file_new(path, st, seen);
+        index->dirty = EINA_TRUE;
+     }
+
+   _edi_search_index_file_add(index, file);
+}
+
+typedef struct _Edi_Search_Index_Crawl
+{
+   Edi_Search_Index *index;
+   Ecore_Thread *thread;
+   Eina_Hash *previous;
+   unsigned char *seen;
+} Edi_Search_Index_Crawl;
+
+static Eina_Bool
+_edi_search_index_crawl_cb(void *data, const char *path, Eina_Bool directory)
+{
+   Edi_Search_Index_Crawl *crawl = data;
+   struct stat st;
+
+   if (ecore_thread_check(crawl->thread))
+     return EINA_FALSE;
+
+   if (directory)
+     crawl->index->dirs = eina_list_append(crawl->index->dirs, strdup(path));
+   else if (!stat(path, &st) && S_ISREG(st.st_mode))
+     _edi_search_index_file_refresh(crawl->index, path, &st, crawl->previous, crawl->seen);
+
+   return EINA_TRUE;
+}
+
+static void
+_edi_search_index_crawl(Edi_Search_Index *index, Ecore_Thread *thread, const char *directory,
+                        Eina_Hash *previous, unsigned char *seen)
+{
+   Edi_Search_Index_Crawl crawl;
+
+   crawl.index = index;
+   crawl.thread = thread;
+   crawl.previous = previous;
+   crawl.seen = seen;
+
+   index->dirs = eina_list_append(index->dirs, strdup(directory));
+   edi_walker_walk(index->walker, directory, _edi_search_index_crawl_cb, &crawl);
+}
+
+/* Remove a path that has gone, along with anything beneath it if it was a directory. */
+static void
+_edi_search_index_path_remove(Edi_Search_Index *index, const char *path)
+{
+   Edi_Search_Index_File *file;
+   Eina_List *removed = NULL;
+   char *prefix, *remove;
+   unsigned int i, length;
+
+   _edi_search_index_file_remove(index, path);
+
+   prefix = edi_path_append(path, "");
+   length = strlen(prefix);
+   for (i = 0; i < index->file_count; i++)
+     {
+        file = index->files[i];
+        if (file && !strncmp(file->path, prefix, length))
+          removed = eina_list_append(removed, strdup(file->path));
+     }
+   free(prefix);
+
+   EINA_LIST_FREE(removed, remove)
+     {
+        _edi_search_index_file_remove(index, remove);
+        free(remove);
+     }
+}
+
+/* Drop files below a directory that are now ignored, after its ignore rules changed. */
+static void
+_edi_search_index_path_prune(Edi_Search_Index *index, const char *directory)
+{
+   Edi_Search_Index_File *file;
+   Eina_List *removed = NULL;
+   char *prefix, *remove;
+   unsigned int i, length;
+
+   prefix = edi_path_append(directory, "");
+   length = strlen(prefix);
+   for (i = 0; i < index->file_count; i++)
+     {
+        file = index->files[i];
+        if (file && !strncmp(file->path, prefix, length) &&
+            edi_walker_path_ignored(index->walker, file->path, EINA_FALSE))
+          removed = eina_list_append(removed, strdup(file->path));
+     }
+   free(prefix);
+
+   EINA_LIST_FREE(removed, remove)
+     {
+        _edi_search_index_file_remove(index, remove);
+        free(remove);
+     }
+}
+
+static void
+_edi_search_index_path_update(Edi_Search_Index *index, Ecore_Thread *thread, const char *path,
+                              unsigned char *seen)
+{
+   struct stat st;
+
+   if (stat(path, &st) || edi_walker_path_ignored(index->walker, path, S_ISDIR(st.st_mode)))
+     _edi_search_index_path_remove(index, path);
+   else if (S_ISDIR(st.st_mode))
+     {
+        _edi_search_index_path_prune(index, path);
+        _edi_search_index_crawl(index, thread, path, NULL, seen);
+     }
+   else if (S_ISREG(st.st_mode))
+     _edi_search_index_file_refresh(index, path, &st, NULL, seen);
+}
+
+static void
+_edi_search_index_build_cb(void *data, Ecore_Thread *thread)
+{
+   Edi_Search_Index *index = data;
+   Eina_Hash *previous;
+   unsigned char *seen;
+
+   seen = calloc(EDI_SEARCH_INDEX_GRAMS / 8, 1);
+   previous = _edi_search_index_load(index);
+
+   _edi_search_index_crawl(index, thread, index->directory, previous, seen);
+   free(seen);
+
+   if (previous)
+     {
+        if (eina_hash_population(previous))
+          index->dirty = EINA_TRUE;
+        _edi_search_index_previous_free(previous);
+     }
+   else
+     {
+        index->dirty = EINA_TRUE;
+     }
+
+   if (ecore_thread_check(thread))
+     return;
+
+   eina_lock_take(&index->lock);
+   index->ready = EINA_TRUE;
+   eina_lock_release(&index->lock);
+
+   INF("Search index ready with %d files", index->file_count);
+   if (index->dirty)
+     _edi_search_index_save(index);
+}
+
+static void
+_edi_search_index_update_cb(void *data, Ecore_Thread *thread)
+{
+   Edi_Search_Index *index = data;
+   Eina_List *item;
+   unsigned char *seen;
+   const char *path;
+
+   seen = calloc(EDI_SEARCH_INDEX_GRAMS / 8, 1);
+   EINA_LIST_FOREACH(index->updating, item, path)
+     {
+        if (ecore_thread_check(thread))
+          break;
+
+        _edi_search_index_path_update(index, thread, path, seen);
+     }
+   free(seen);
+
+   if (index->removed_count > index->file_count / 4)
+     _edi_search_index_compact(index);
+
+   if (index->dirty && !ecore_thread_check(thread))
+     _edi_search_index_save(index);
+}
+
+static Eina_Bool _edi_search_index_update_timer_cb(void *data);
+
+static void
+_edi_search_index_thread_end_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Search_Index *index = data;
+   char *path;
+
+   index->thread = NULL;
+
+   EINA_LIST_FREE(index->updating, path)
+     free(path);
+
+   EINA_LIST_FREE(index->dirs, path)
+     {
+        if (!eina_hash_find(index->monitors, path))
+          eina_hash_add(index->monitors, path, eio_monitor_add(path));
+        free(path);
+     }
+
+   if (eina_hash_population(index->queued) && !index->timer)
+     index->timer = ecore_timer_add(EDI_SEARCH_INDEX_UPDATE_DELAY, _edi_search_index_update_timer_cb, index);
+}
+
+static Eina_Bool
+_edi_search_index_update_timer_cb(void *data)
+{
+   Edi_Search_Index *index = data;
+   Eina_Iterator *it;
+   const char *path;
+
+   index->timer = NULL;
+   if (index->thread)
+     return ECORE_CALLBACK_CANCEL;
+
+   it = eina_hash_iterator_key_new(index->queued);
+   EINA_ITERATOR_FOREACH(it, path)
+     index->updating = eina_list_append(index->updating, strdup(path));
+   eina_iterator_free(it);
+   eina_hash_free_buckets(index->queued);
+
+   index->thread = ecore_thread_run(_edi_search_index_update_cb, _edi_search_index_thread_end_cb,
+                                    _edi_search_index_thread_end_cb, index);
+
+   return ECORE_CALLBACK_CANCEL;
+}
+
+static Eina_Bool
+_edi_search_index_monitor_cb(void *data EINA_UNUSED, int type, void *event)
+{
+   Edi_Search_Index *index = _edi_search_index;
+   Eio_Monitor_Event *ev = event;
+   Eina_Bool directory;
+   char *dir;
+   size_t length;
+
+   if (!index)
+     return ECORE_CALLBACK_PASS_ON;
+
+   length = strlen(index->directory);
+   if (strncmp(ev->filename, index->directory, length) || ev->filename[length] != '/')
+     return ECORE_CALLBACK_PASS_ON;
+
+   /* New ignore rules apply to everything in the directory holding them. */
+   if (!strcmp(ecore_file_file_get(ev->filename), ".gitignore"))
+     {
+        edi_walker_reset(index->walker);
+        dir = ecore_file_dir_get(ev->filename);
+        edi_search_index_file_update(dir);
+        free(dir);
+        return ECORE_CALLBACK_PASS_ON;
+     }
+
+   directory = type == EIO_MONITOR_DIRECTORY_CREATED || type == EIO_MONITOR_DIRECTORY_DELETED;
+   if (edi_walker_path_ignored(index->walker, ev->filename, directory))
+     return ECORE_CALLBACK_PASS_ON;
+
+   if (type == EIO_MONITOR_DIRECTORY_DELETED)
+     eina_hash_del_by_key(index->monitors, ev->filename);
+
+   edi_search_index_file_update(ev->filename);
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+static void
+_edi_search_index_monitor_free_cb(void *data)
+{
+   if (data)
+     eio_monitor_del(data);
+}
+
+void
+edi_search_index_file_update(const char *path)
+{
+   Edi_Search_Index *index = _edi_search_index;
+
+   if (!index || !path)
+     return;
+
+   if (!eina_hash_find(index->queued, path))
+     eina_hash_add(index->queued, path, index);
+
+   if (index->timer)
+     ecore_timer_reset(index->timer);
+   else if (!index->thread)
+     index->timer = ecore_timer_add(EDI_SEARCH_INDEX_UPDATE_DELAY, _edi_search_index_update_timer_cb, index);
+}
+
+void
+edi_search_index_init(const char *directory)
+{
+   Edi_Search_Index *index;
+   int types[] = { EIO_MONITOR_FILE_CREATED, EIO_MONITOR_FILE_MODIFIED, EIO_MONITOR_FILE_DELETED,
+                   EIO_MONITOR_DIRECTORY_CREATED, EIO_MONITOR_DIRECTORY_DELETED };
+   unsigned int i;
+
+   if (_edi_search_index)
+     edi_search_index_shutdown();
+
+   index = calloc(1, sizeof(Edi_Search_Index));
+   index->directory = strdup(directory);
+   index->cache = strdup(_edi_project_config_dir_get());
+   index->walker = edi_walker_new(directory);
+
+   eina_lock_new(&index->lock);
+   index->paths = eina_hash_string_superfast_new(NULL);
+   index->postings = eina_hash_int32_new(_edi_search_index_postings_free_cb);
+   index->queued = eina_hash_string_superfast_new(NULL);
+   index->monitors = eina_hash_string_superfast_new(_edi_search_index_monitor_free_cb);
+
+   for (i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+     index->handlers = eina_list_append(index->handlers,
+                                        ecore_event_handler_add(types[i], _edi_search_index_monitor_cb, NULL));
+
+   _edi_search_index = index;
+   index->thread = ecore_thread_run(_edi_search_index_build_cb, _edi_search_index_thread_end_cb,
+                                    _edi_search_index_thread_end_cb, index);
+}
+
+void
+edi_search_index_shutdown(void)
+{
+   Edi_Search_Index *index = _edi_search_index;
+   Ecore_Event_Handler *handler;
+
+   if (!index)
+     return;
+
+   _edi_search_index = NULL;
+   if (index->timer)
+     ecore_timer_del(index->timer);
+
+   if (index->thread)
+     {
+        ecore_thread_cancel(index->thread);
+        while ((ecore_thread_wait(index->thread, 0.1)) != EINA_TRUE);
+     }
+
+   if (index->ready && index->dirty)
+     _edi_search_index_save(index);
+
+   EINA_LIST_FREE(index->handlers, handler)
+     ecore_event_handler_del(handler);
+
+   eina_list_free(index->updating);
+   eina_list_free(index->dirs);
+   eina_hash_free(index->monitors);
+   eina_hash_free(index->queued);
+
+   _edi_search_index_clear(index);
+   eina_hash_free(index->paths);
+   eina_hash_free(index->postings);
+   eina_lock_free(&index->lock);
+
+   edi_walker_free(index->walker);
+   free(index->cache);
+   free(index->directory);
+   free(index);
+}
+
+static unsigned int
+_edi_search_index_intersect(unsigned int *ids, unsigned int count, const Eina_Inarray *posting)
+{
+   const unsigned int *other = posting->members;
+   unsigned int i = 0, j = 0, n = 0;
+
+   while (i < count && j < posting->len)
+     {
+        if (ids[i] < other[j])
+          i++;
+        else if (ids[i] > other[j])
+          j++;
+        else
+          {
+             ids[n++] = ids[i];
+             i++;
+             j++;
+          }
+     }
+
+   return n;
+}
+
+static int
+_edi_search_index_posting_cmp(const void *a, const void *b)
+{
+   const Eina_Inarray *pa = *(const Eina_Inarray **)a, *pb = *(const Eina_Inarray **)b;
+
+   return (pa->len > pb->len) - (pa->len < pb->len);
+}
+
+Eina_Bool
+edi_search_index_candidates_get(const char *term, Eina_List **files)
+{
+   Edi_Search_Index *index = _edi_search_index;
+   Edi_Search_Index_File *file;
+   Eina_Inarray **postings;
+   unsigned int *grams, *ids = NULL;
+   unsigned int gram = 0, gram_count = 0, id_count = 0, length, i, j;
+
+   *files = NULL;
+   if (!index || !term || (length = strlen(term)) < 3)
+     return EINA_FALSE;
+
+   grams = malloc(sizeof(unsigned int) * length);
+   for (i = 0; i < length; i++)
+     {
+        gram = ((gram << 8) | _edi_search_index_fold(term[i])) & (EDI_SEARCH_INDEX_GRAMS - 1);
+        if (i >= 2)
+          grams[gram_count++] = gram;
+     }
+   qsort(grams, gram_count, sizeof(unsigned int), _edi_search_index_gram_cmp);
+
+   eina_lock_take(&index->lock);
+   if (!index->ready)
+     {
+        eina_lock_release(&index->lock);
+        free(grams);
+        return EINA_FALSE;
+     }
+
+   postings = malloc(sizeof(Eina_Inarray *) * gram_count);
+   for (i = 0, j = 0; i < gram_count; i++)
+     {
+        if (i && grams[i] == grams[i - 1])
+          continue;
+
+        postings[j] = eina_hash_find(index->postings, &grams[i]);
+        if (!postings[j])
+          break;
+        j++;
+     }
+
+   /* Start from the rarest trigram so the candidate set only shrinks */
+   if (i == gram_count)
+     {
+        qsort(postings, j, sizeof(Eina_Inarray *), _edi_search_index_posting_cmp);
+
+        id_count = postings[0]->len;
+        ids = malloc(sizeof(unsigned int) * id_count);
+        memcpy(ids, postings[0]->members, sizeof(unsigned int) * id_count);
+        for (i = 1; i < j && id_count; i++)
+          id_count = _edi_search_index_intersect(ids, id_count, postings[i]);
+     }
+
+   for (i = 0; i < id_count; i++)
+     {
+        file = index->files[ids[i]];
+        if (file)
+          *files = eina_list_append(*files, strdup(file->path));
+     }
+
+   for (i = 0; i < index->file_count; i++)
+     {
+        file = index->files[i];
+        if (file && file->unindexed)
+          *files = eina_list_append(*files, strdup(file->path));
+     }
+   eina_lock_release(&index->lock);
+
+   free(ids);
+   free(postings);
+   free(grams);
+
+   *files = eina_list_sort(*files, 0, EINA_COMPARE_CB(strcmp));
+   return EINA_TRUE;
+}
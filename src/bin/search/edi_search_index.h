@@ -0,0 +1,79 @@
+#ifndef EDI_SEARCH_INDEX_H_
+# define EDI_SEARCH_INDEX_H_
+
+#include <Eina.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief These routines are used for maintaining a persistent index of project content.
+ */
+
+/**
+ * @brief Project index functions.
+ * @defgroup Index
+ *
+ * @{
+ *
+ * A trigram index of every file in the project that is not hidden.
+ * Each distinct (case folded) sequence of three bytes maps to the files
+ * containing it so that a search only needs to scan files that contain
+ * every trigram of the search term.
+ * The index is saved in the project config directory, checked against
+ * file modification times when loaded and kept up to date by monitoring
+ * the project directories.
+ *
+ */
+
+/**
+ * Load or build the index for a project in the background and start
+ * monitoring the project for changes.
+ *
+ * @param directory The root directory of the project.
+ *
+ * @ingroup Index
+ */
+void edi_search_index_init(const char *directory);
+
+/**
+ * Stop monitoring the project, save any changes and free the index.
+ *
+ * @ingroup Index
+ */
+void edi_search_index_shutdown(void);
+
+/**
+ * Request that a file be indexed again, or removed if it no longer exists.
+ * Requests are batched and processed in the background.
+ *
+ * @param path The path of the file or directory that changed.
+ *
+ * @ingroup Index
+ */
+void edi_search_index_file_update(const char *path);
+
+/**
+ * Look up the files that may contain the given text.
+ * This may be called from any thread.
+ *
+ * @param term The text that will be searched for.
+ * @param files A pointer to receive a list of candidate file paths that the caller must free.
+ * @return EINA_FALSE if the index cannot narrow the search, either because
+ *         it is not ready or the term is too short, so all files must be searched.
+ *
+ * @ingroup Index
+ */
+Eina_Bool edi_search_index_candidates_get(const char *term, Eina_List **files);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_SEARCH_INDEX_H_ */
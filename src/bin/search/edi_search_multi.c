@@ -0,0 +1,197 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+
+#include <Eina.h>
+
+#include "Edi.h"
+#include "edi_search_multi.h"
+
+#include "edi_private.h"
+
+struct _Edi_Search_Multi
+{
+   /* A full transition table, failure links are resolved when it is built */
+   unsigned int *next;
+   /* Length of the longest term ending at each state, 0 if none */
+   unsigned int *output;
+   unsigned int state_count;
+};
+
+static void
+_edi_search_multi_term_add(Edi_Search_Multi *multi, const char *term)
+{
+   const unsigned char *c;
+   unsigned int state = 0, *next;
+
+   for (c = (const unsigned char *) term; *c; c++)
+     {
+        next = &multi->next[state * 256 + *c];
+        if (!*next)
+          *next = multi->state_count++;
+        state = *next;
+     }
+
+   multi->output[state] = strlen(term);
+}
+
+/* Visit states breadth first so each failure link is known before it is needed. */
+static void
+_edi_search_multi_links_build(Edi_Search_Multi *multi)
+{
+   unsigned int *fail, *queue;
+   unsigned int head = 0, tail = 0, state, target, c;
+
+   fail = calloc(multi->state_count, sizeof(unsigned int));
+   queue = malloc(sizeof(unsigned int) * multi->state_count);
+
+   for (c = 0; c < 256; c++)
+     {
+        target = multi->next[c];
+        if (target)
+          queue[tail++] = target;
+     }
+
+   while (head < tail)
+     {
+        state = queue[head++];
+        for (c = 0; c < 256; c++)
+          {
+             target = multi->next[state * 256 + c];
+             if (!target)
+               {
+                  multi->next[state * 256 + c] = multi->next[fail[state] * 256 + c];
+                  continue;
+               }
+
+             fail[target] = multi->next[fail[state] * 256 + c];
+             if (!multi->output[target])
+               multi->output[target] = multi->output[fail[target]];
+             queue[tail++] = target;
+          }
+     }
+
+   free(queue);
+   free(fail);
+}
+
+Edi_Search_Multi *
+edi_search_multi_new(const Eina_List *terms)
+{
+   Edi_Search_Multi *multi;
+   const Eina_List *item;
+   const char *term;
+   unsigned int states = 1;
+
+   EINA_LIST_FOREACH(terms, item, term)
+     {
+        if (term)
+          states += strlen(term);
+     }
+
+   if (states == 1)
+     return NULL;
+
+   multi = calloc(1, sizeof(Edi_Search_Multi));
+   multi->next = calloc((size_t) states * 256, sizeof(unsigned int));
+   multi->output = calloc(states, sizeof(unsigned int));
+   multi->state_count = 1;
+
+   EINA_LIST_FOREACH(terms, item, term)
+     {
+        if (term && term[0])
+          _edi_search_multi_term_add(multi, term);
+     }
+
+   _edi_search_multi_links_build(multi);
+
+   return multi;
+}
+
+void
+edi_search_multi_free(Edi_Search_Multi *multi)
+{
+   if (!multi)
+     return;
+
+   free(multi->next);
+   free(multi->output);
+   free(multi);
+}
+
+unsigned int
+edi_search_multi_scan(const Edi_Search_Multi *multi, const char *text, size_t length,
+                      Edi_Search_Scanner_Cb cb, void *data)
+{
+   const unsigned char *pos, *end;
+   const char *hit, *counted, *line_start, *line_end;
+   unsigned int state = 0, number = 1, found = 0, line_len;
+
+   pos = (const unsigned char *) text;
+   end = pos + length;
+   counted = text;
+
+   while (pos < end)
+     {
+        state = multi->next[state * 256 + *pos];
+        if (!multi->output[state])
+          {
+             pos++;
+             continue;
+          }
+
+        hit = (const char *) pos - multi->output[state] + 1;
+        number += edi_search_scanner_lines_count(counted, hit - counted);
+        counted = hit;
+
+        line_start = hit;
+        while (line_start > text && line_start[-1] != '\n')
+          line_start--;
+
+        line_end = memchr(pos, '\n', end - pos);
+        if (!line_end)
+          line_end = (const char *) end;
+
+        line_len = line_end - line_start;
+        if (line_len && line_start[line_len - 1] == '\r')
+          line_len--;
+
+        found++;
+        if (!cb(data, line_start, line_len, number, hit - line_start + 1))
+          break;
+
+        /* Only the first term on each line is reported. */
+        pos = (const unsigned char *) line_end + 1;
+        state = 0;
+     }
+
+   return found;
+}
+
+unsigned int
+edi_search_multi_file_scan(const Edi_Search_Multi *multi, const char *path,
+                           Edi_Search_Scanner_Cb cb, void *data)
+{
+   Eina_File *f;
+   const char *map;
+   size_t length;
+   unsigned int found = 0;
+
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return 0;
+
+   length = eina_file_size_get(f);
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (map)
+     {
+        if (!edi_walker_binary_is(map, length))
+          found = edi_search_multi_scan(multi, map, length, cb, data);
+        eina_file_map_free(f, (void *) map);
+     }
+
+   eina_file_close(f);
+   return found;
+}
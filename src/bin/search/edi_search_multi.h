@@ -0,0 +1,91 @@
+#ifndef EDI_SEARCH_MULTI_H_
+# define EDI_SEARCH_MULTI_H_
+
+#include <Eina.h>
+
+#include "edi_search_scanner.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief These routines are used for finding any of several words within mapped files.
+ */
+
+/**
+ * @typedef Edi_Search_Multi
+ * A prepared search for a set of literal terms that can be shared between threads.
+ */
+typedef struct _Edi_Search_Multi Edi_Search_Multi;
+
+/**
+ * @brief Multiple term scanning functions.
+ * @defgroup Multi
+ *
+ * @{
+ *
+ * Literal search for many terms at once. The terms are compiled into an
+ * Aho-Corasick automaton so each byte of the text is examined once no
+ * matter how many terms there are.
+ *
+ */
+
+/**
+ * Prepare a search for a list of terms.
+ *
+ * @param terms A list of strings to search for, empty strings are skipped.
+ * @return A new multiple term search or NULL if there were no terms.
+ *
+ * @ingroup Multi
+ */
+Edi_Search_Multi *edi_search_multi_new(const Eina_List *terms);
+
+/**
+ * Free a multiple term search.
+ *
+ * @param multi The search to free.
+ *
+ * @ingroup Multi
+ */
+void edi_search_multi_free(Edi_Search_Multi *multi);
+
+/**
+ * Scan a block of memory reporting each line that contains any of the terms.
+ *
+ * @param multi The search to use.
+ * @param text The memory to search.
+ * @param length The length of the memory to search.
+ * @param cb The function called for each matching line, with the column of the first term found.
+ * @param data User data passed to the callback.
+ * @return The number of matching lines reported.
+ *
+ * @ingroup Multi
+ */
+unsigned int edi_search_multi_scan(const Edi_Search_Multi *multi, const char *text, size_t length,
+                                   Edi_Search_Scanner_Cb cb, void *data);
+
+/**
+ * Map a file and scan it, reporting each line that contains any of the terms.
+ *
+ * @param multi The search to use.
+ * @param path The path of the file to scan.
+ * @param cb The function called for each matching line.
+ * @param data User data passed to the callback.
+ * @return The number of matching lines reported.
+ *
+ * @ingroup Multi
+ */
+unsigned int edi_search_multi_file_scan(const Edi_Search_Multi *multi, const char *path,
+                                        Edi_Search_Scanner_Cb cb, void *data);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_SEARCH_MULTI_H_ */
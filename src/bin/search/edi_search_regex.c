@@ -0,0 +1,1845 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+
+#include <Eina.h>
+
+#include "Edi.h"
+#include "edi_search_regex.h"
+
+#include "edi_private.h"
+
+#define EDI_SEARCH_REGEX_NODES_MAX 65536
+#define EDI_SEARCH_REGEX_REPEAT_MAX 1000
+#define EDI_SEARCH_REGEX_DEPTH_MAX 256
+#define EDI_SEARCH_REGEX_STATES_MAX 4096
+
+/* The pseudo symbol stepped on at the end of a line */
+#define EDI_SEARCH_REGEX_EOL 256
+
+typedef enum
+{
+   EDI_SEARCH_REGEX_AST_EMPTY,
+   EDI_SEARCH_REGEX_AST_SET,
+   EDI_SEARCH_REGEX_AST_CONCAT,
+   EDI_SEARCH_REGEX_AST_ALT,
+   EDI_SEARCH_REGEX_AST_REPEAT,
+   EDI_SEARCH_REGEX_AST_ASSERT,
+} Edi_Search_Regex_Ast_Type;
+
+typedef enum
+{
+   EDI_SEARCH_REGEX_ASSERT_LINE_START,
+   EDI_SEARCH_REGEX_ASSERT_LINE_END,
+   EDI_SEARCH_REGEX_ASSERT_WORD_BOUNDARY,
+   EDI_SEARCH_REGEX_ASSERT_NOT_WORD_BOUNDARY,
+   EDI_SEARCH_REGEX_ASSERT_NOT_WORD_BEFORE,
+   EDI_SEARCH_REGEX_ASSERT_NOT_WORD_AFTER,
+} Edi_Search_Regex_Assert;
+
+typedef enum
+{
+   EDI_SEARCH_REGEX_NODE_SET,
+   EDI_SEARCH_REGEX_NODE_SPLIT,
+   EDI_SEARCH_REGEX_NODE_ASSERT,
+   EDI_SEARCH_REGEX_NODE_MATCH,
+} Edi_Search_Regex_Node_Type;
+
+typedef struct _Edi_Search_Regex_Set
+{
+   unsigned int bits[8];
+} Edi_Search_Regex_Set;
+
+/* The characters from one code point to another */
+typedef struct _Edi_Search_Regex_Range
+{
+   unsigned int from, to;
+} Edi_Search_Regex_Range;
+
+/* The members of a bracketed class, ASCII bytes in a set and multi byte characters as ranges */
+typedef struct _Edi_Search_Regex_Class
+{
+   Edi_Search_Regex_Set set;
+   Edi_Search_Regex_Range *ranges;
+   unsigned int count, size;
+   /* Every multi byte character is a member */
+   Eina_Bool multibyte;
+} Edi_Search_Regex_Class;
+
+typedef struct _Edi_Search_Regex_Ast Edi_Search_Regex_Ast;
+struct _Edi_Search_Regex_Ast
+{
+   Edi_Search_Regex_Ast_Type type;
+   Edi_Search_Regex_Ast *left, *right;
+   Edi_Search_Regex_Set set;
+   Edi_Search_Regex_Assert assert;
+   int min, max;
+};
+
+typedef struct _Edi_Search_Regex_Parser
+{
+   const char *pos;
+   Edi_Search_Regex_Flags flags;
+   Eina_List *nodes;
+   const char *error;
+   int depth;
+} Edi_Search_Regex_Parser;
+
+typedef struct _Edi_Search_Regex_Node
+{
+   Edi_Search_Regex_Node_Type type;
+   Edi_Search_Regex_Assert assert;
+   int out, out1;
+   Edi_Search_Regex_Set set;
+} Edi_Search_Regex_Node;
+
+typedef struct _Edi_Search_Regex_Prog
+{
+   Edi_Search_Regex_Node *nodes;
+   unsigned int count, size;
+   int start;
+   Eina_Bool overflow;
+} Edi_Search_Regex_Prog;
+
+typedef enum
+{
+   EDI_SEARCH_REGEX_STATE_START = 1 << 0, /* nothing has been consumed yet */
+   EDI_SEARCH_REGEX_STATE_WORD  = 1 << 1, /* the previous byte was a word character */
+} Edi_Search_Regex_State_Flags;
+
+typedef struct _Edi_Search_Regex_State
+{
+   unsigned int hash;
+   int chain;
+   unsigned int flags;
+   unsigned int count;
+   int *nodes;
+   /* Encoded as (next state << 1) | matched before this symbol, -1 when not yet known */
+   int next[EDI_SEARCH_REGEX_EOL + 1];
+} Edi_Search_Regex_State;
+
+typedef struct _Edi_Search_Regex_Dfa
+{
+   const Edi_Search_Regex_Prog *prog;
+
+   Edi_Search_Regex_State **states;
+   unsigned int count, size;
+   int *buckets;
+   unsigned int bucket_count;
+
+   int *stack, *closure, *targets;
+   unsigned int *mark;
+   unsigned int generation;
+} Edi_Search_Regex_Dfa;
+
+typedef struct _Edi_Search_Regex_Matcher
+{
+   Edi_Search_Regex_Dfa forward;
+   Edi_Search_Regex_Dfa reverse;
+} Edi_Search_Regex_Matcher;
+
+struct _Edi_Search_Regex
+{
+   Edi_Search_Regex_Prog forward;
+   Edi_Search_Regex_Prog reverse;
+
+   Edi_Search_Scanner *prefilter;
+   char *literal;
+
+   Eina_Lock lock;
+   Eina_List *matchers;
+};
+
+typedef struct _Edi_Search_Regex_Literal
+{
+   char *exact;
+   char *prefix;
+   char *suffix;
+   char *required;
+} Edi_Search_Regex_Literal;
+
+typedef struct _Edi_Search_Regex_Scan
+{
+   Edi_Search_Regex *regex;
+   Edi_Search_Regex_Matcher *matcher;
+   Edi_Search_Scanner_Cb cb;
+   void *data;
+   unsigned int found;
+} Edi_Search_Regex_Scan;
+
+static inline Eina_Bool
+_edi_search_regex_word_is(unsigned int c)
+{
+   return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+          c == '_' || (c >= 0x80 && c < EDI_SEARCH_REGEX_EOL);
+}
+
+static inline void
+_edi_search_regex_set_add(Edi_Search_Regex_Set *set, unsigned char c)
+{
+   set->bits[c >> 5] |= 1u << (c & 31);
+}
+
+static inline Eina_Bool
+_edi_search_regex_set_has(const Edi_Search_Regex_Set *set, unsigned char c)
+{
+   return !!(set->bits[c >> 5] & (1u << (c & 31)));
+}
+
+static void
+_edi_search_regex_set_range_add(Edi_Search_Regex_Set *set, unsigned char from, unsigned char to)
+{
+   unsigned int c;
+
+   for (c = from; c <= to; c++)
+     _edi_search_regex_set_add(set, c);
+}
+
+/* Add the other case of every ASCII letter in the set. */
+static void
+_edi_search_regex_set_fold(Edi_Search_Regex_Set *set)
+{
+   unsigned char c;
+
+   for (c = 'a'; c <= 'z'; c++)
+     {
+        if (_edi_search_regex_set_has(set, c) || _edi_search_regex_set_has(set, c - ('a' - 'A')))
+          {
+             _edi_search_regex_set_add(set, c);
+             _edi_search_regex_set_add(set, c - ('a' - 'A'));
+          }
+     }
+}
+
+/* Find the single byte matched by a set, ignoring case if requested. */
+static Eina_Bool
+_edi_search_regex_set_literal_get(const Edi_Search_Regex_Set *set, Eina_Bool caseless, char *out)
+{
+   unsigned int c, count = 0;
+   unsigned char found[2];
+
+   for (c = 0; c < 256; c++)
+     {
+        if (!_edi_search_regex_set_has(set, c))
+          continue;
+        if (count == 2)
+          return EINA_FALSE;
+        found[count++] = c;
+     }
+
+   if (count == 1)
+     {
+        *out = found[0];
+        return EINA_TRUE;
+     }
+
+   if (count == 2 && caseless && found[0] >= 'A' && found[0] <= 'Z' &&
+       found[1] == found[0] + ('a' - 'A'))
+     {
+        *out = found[1];
+        return EINA_TRUE;
+     }
+
+   return EINA_FALSE;
+}
+
+static Edi_Search_Regex_Ast *
+_edi_search_regex_ast_new(Edi_Search_Regex_Parser *parser, Edi_Search_Regex_Ast_Type type,
+                          Edi_Search_Regex_Ast *left, Edi_Search_Regex_Ast *right)
+{
+   Edi_Search_Regex_Ast *ast;
+
+   ast = calloc(1, sizeof(Edi_Search_Regex_Ast));
+   ast->type = type;
+   ast->left = left;
+   ast->right = right;
+   parser->nodes = eina_list_append(parser->nodes, ast);
+
+   return ast;
+}
+
+static Edi_Search_Regex_Ast *
+_edi_search_regex_ast_set_new(Edi_Search_Regex_Parser *parser, const Edi_Search_Regex_Set *set)
+{
+   Edi_Search_Regex_Ast *ast;
+
+   ast = _edi_search_regex_ast_new(parser, EDI_SEARCH_REGEX_AST_SET, NULL, NULL);
+   ast->set = *set;
+   if (parser->flags & EDI_SEARCH_REGEX_CASELESS)
+     _edi_search_regex_set_fold(&ast->set);
+
+   return ast;
+}
+
+static Edi_Search_Regex_Ast *
+_edi_search_regex_ast_range_new(Edi_Search_Regex_Parser *parser, unsigned char from, unsigned char to)
+{
+   Edi_Search_Regex_Set set;
+
+   memset(&set, 0, sizeof(set));
+   _edi_search_regex_set_range_add(&set, from, to);
+
+   return _edi_search_regex_ast_set_new(parser, &set);
+}
+
+static Edi_Search_Regex_Ast *
+_edi_search_regex_ast_assert_new(Edi_Search_Regex_Parser *parser, Edi_Search_Regex_Assert assert)
+{
+   Edi_Search_Regex_Ast *ast;
+
+   ast = _edi_search_regex_ast_new(parser, EDI_SEARCH_REGEX_AST_ASSERT, NULL, NULL);
+   ast->assert = assert;
+
+   return ast;
+}
+
+static Edi_Search_Regex_Ast *
+_edi_search_regex_ast_concat(Edi_Search_Regex_Parser *parser, Edi_Search_Regex_Ast *left,
+                             Edi_Search_Regex_Ast *right)
+{
+   if (!left || left->type == EDI_SEARCH_REGEX_AST_EMPTY)
+     return right;
+   if (!right || right->type == EDI_SEARCH_REGEX_AST_EMPTY)
+     return left;
+
+   return _edi_search_regex_ast_new(parser, EDI_SEARCH_REGEX_AST_CONCAT, left, right);
+}
+
+static Edi_Search_Regex_Ast *
+_edi_search_regex_ast_alt(Edi_Search_Regex_Parser *parser, Edi_Search_Regex_Ast *left,
+                          Edi_Search_Regex_Ast *right)
+{
+   if (!left)
+     return right;
+   if (!right)
+     return left;
+
+   return _edi_search_regex_ast_new(parser, EDI_SEARCH_REGEX_AST_ALT, left, right);
+}
+
+/* A single byte that cannot start a UTF-8 sequence. */
+static Edi_Search_Regex_Ast *
+_edi_search_regex_ast_invalid_new(Edi_Search_Regex_Parser *parser)
+{
+   Edi_Search_Regex_Set set;
+
+   memset(&set, 0, sizeof(set));
+   _edi_search_regex_set_range_add(&set, 0x80, 0xc1);
+   _edi_search_regex_set_range_add(&set, 0xf5, 0xff);
+
+   return _edi_search_regex_ast_set_new(parser, &set);
+}
+
+/*
+ * Any multi byte UTF-8 sequence, or a single byte that cannot start one, so
+ * that . and negated classes step over whole characters.
+ */
+static Edi_Search_Regex_Ast *
+_edi_search_regex_ast_multibyte_new(Edi_Search_Regex_Parser *parser)
+{
+   Edi_Search_Regex_Ast *two, *three, *four;
+
+   two = _edi_search_regex_ast_concat(parser, _edi_search_regex_ast_range_new(parser, 0xc2, 0xdf),
+                                      _edi_search_regex_ast_range_new(parser, 0x80, 0xbf));
+
+   three = _edi_search_regex_ast_concat(parser, _edi_search_regex_ast_range_new(parser, 0xe0, 0xef),
+                                        _edi_search_regex_ast_range_new(parser, 0x80, 0xbf));
+   three = _edi_search_regex_ast_concat(parser, three, _edi_search_regex_ast_range_new(parser, 0x80, 0xbf));
+
+   four = _edi_search_regex_ast_concat(parser, _edi_search_regex_ast_range_new(parser, 0xf0, 0xf4),
+                                       _edi_search_regex_ast_range_new(parser, 0x80, 0xbf));
+   four = _edi_search_regex_ast_concat(parser, four, _edi_search_regex_ast_range_new(parser, 0x80, 0xbf));
+   four = _edi_search_regex_ast_concat(parser, four, _edi_search_regex_ast_range_new(parser, 0x80, 0xbf));
+
+   return _edi_search_regex_ast_new(parser, EDI_SEARCH_REGEX_AST_ALT,
+            _edi_search_regex_ast_new(parser, EDI_SEARCH_REGEX_AST_ALT, two, three),
+            _edi_search_regex_ast_new(parser, EDI_SEARCH_REGEX_AST_ALT, four,
+                                      _edi_search_regex_ast_invalid_new(parser)));
+}
+
+static unsigned int
+_edi_search_regex_utf8_encode(unsigned int value, unsigned char *out)
+{
+   if (value < 0x800)
+     {
+        out[0] = 0xc0 | (value >> 6);
+        out[1] = 0x80 | (value & 0x3f);
+        return 2;
+     }
+   if (value < 0x10000)
+     {
+        out[0] = 0xe0 | (value >> 12);
+        out[1] = 0x80 | ((value >> 6) & 0x3f);
+        out[2] = 0x80 | (value & 0x3f);
+        return 3;
+     }
+
+   out[0] = 0xf0 | (value >> 18);
+   out[1] = 0x80 | ((value >> 12) & 0x3f);
+   out[2] = 0x80 | ((value >> 6) & 0x3f);
+   out[3] = 0x80 | (value & 0x3f);
+   return 4;
+}
+
+/*
+ * The UTF-8 sequences of the multi byte characters from one code point to
+ * another. The range is split until both ends encode to the same length and
+ * only differ in bytes that run over every continuation, then each byte of
+ * the sequence is a range of its own.
+ */
+static Edi_Search_Regex_Ast *
+_edi_search_regex_ast_utf8_new(Edi_Search_Regex_Parser *parser, unsigned int from, unsigned int to)
+{
+   static const unsigned int lengths[] = { 0x7ff, 0xffff };
+   Edi_Search_Regex_Ast *ast = NULL;
+   unsigned char first[4], last[4];
+   unsigned int mask, length, i;
+
+   if (from > to)
+     return NULL;
+
+   // Surrogates are not characters
+   if (from <= 0xdfff && to >= 0xd800)
+     return _edi_search_regex_ast_alt(parser,
+              from < 0xd800 ? _edi_search_regex_ast_utf8_new(parser, from, 0xd7ff) : NULL,
+              to > 0xdfff ? _edi_search_regex_ast_utf8_new(parser, 0xe000, to) : NULL);
+
+   for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+     {
+        if (from <= lengths[i] && to > lengths[i])
+          return _edi_search_regex_ast_alt(parser, _edi_search_regex_ast_utf8_new(parser, from, lengths[i]),
+                                           _edi_search_regex_ast_utf8_new(parser, lengths[i] + 1, to));
+     }
+
+   for (i = 1; i < 4; i++)
+     {
+        mask = (1u << (6 * i)) - 1;
+        if ((from & ~mask) == (to & ~mask))
+          continue;
+
+        if (from & mask)
+          return _edi_search_regex_ast_alt(parser, _edi_search_regex_ast_utf8_new(parser, from, from | mask),
+                                           _edi_search_regex_ast_utf8_new(parser, (from | mask) + 1, to));
+        if ((to & mask) != mask)
+          return _edi_search_regex_ast_alt(parser, _edi_search_regex_ast_utf8_new(parser, from, (to & ~mask) - 1),
+                                           _edi_search_regex_ast_utf8_new(parser, to & ~mask, to));
+     }
+
+   length = _edi_search_regex_utf8_encode(from, first);
+   _edi_search_regex_utf8_encode(to, last);
+   for (i = 0; i < length; i++)
+     ast = _edi_search_regex_ast_concat(parser, ast, _edi_search_regex_ast_range_new(parser, first[i], last[i]));
+
+   return ast;
+}
+
+/* A set of ASCII bytes, which when negated also matches any multi byte character. */
+static Edi_Search_Regex_Ast *
+_edi_search_regex_ast_class_new(Edi_Search_Regex_Parser *parser, Edi_Search_Regex_Set *set,
+                                Eina_Bool negate)
+{
+   Edi_Search_Regex_Set ascii;
+   unsigned int i;
+
+   if (parser->flags & EDI_SEARCH_REGEX_CASELESS)
+     _edi_search_regex_set_fold(set);
+
+   if (!negate)
+     return _edi_search_regex_ast_set_new(parser, set);
+
+   memset(&ascii, 0, sizeof(ascii));
+   for (i = 0; i < 4; i++)
+     ascii.bits[i] = ~set->bits[i];
+   ascii.bits['\n' >> 5] &= ~(1u << ('\n' & 31));
+
+   return _edi_search_regex_ast_new(parser, EDI_SEARCH_REGEX_AST_ALT,
+                                    _edi_search_regex_ast_set_new(parser, &ascii),
+                                    _edi_search_regex_ast_multibyte_new(parser));
+}
+
+static int
+_edi_search_regex_range_cmp(const void *a, const void *b)
+{
+   const Edi_Search_Regex_Range *first = a, *second = b;
+
+   if (first->from < second->from)
+     return -1;
+
+   return first->from > second->from;
+}
+
+/* A bracketed class, whose multi byte members are alternatives to its set of ASCII bytes. */
+static Edi_Search_Regex_Ast *
+_edi_search_regex_ast_class_members_new(Edi_Search_Regex_Parser *parser, Edi_Search_Regex_Class *cls,
+                                        Eina_Bool negate)
+{
+   Edi_Search_Regex_Ast *ast;
+   Edi_Search_Regex_Set set;
+   unsigned int next = 0x80, i;
+
+   if (!cls->multibyte && !cls->count)
+     return _edi_search_regex_ast_class_new(parser, &cls->set, negate);
+
+   if (parser->flags & EDI_SEARCH_REGEX_CASELESS)
+     _edi_search_regex_set_fold(&cls->set);
+
+   set = cls->set;
+   if (negate)
+     {
+        memset(&set, 0, sizeof(set));
+        for (i = 0; i < 4; i++)
+          set.bits[i] = ~cls->set.bits[i];
+        set.bits['\n' >> 5] &= ~(1u << ('\n' & 31));
+     }
+   ast = _edi_search_regex_ast_set_new(parser, &set);
+
+   if (cls->multibyte)
+     return negate ? ast : _edi_search_regex_ast_alt(parser, ast, _edi_search_regex_ast_multibyte_new(parser));
+
+   if (!negate)
+     {
+        for (i = 0; i < cls->count; i++)
+          ast = _edi_search_regex_ast_alt(parser, ast,
+                                          _edi_search_regex_ast_utf8_new(parser, cls->ranges[i].from, cls->ranges[i].to));
+        return ast;
+     }
+
+   // Match the characters between the members, and bytes that are not UTF-8
+   qsort(cls->ranges, cls->count, sizeof(Edi_Search_Regex_Range), _edi_search_regex_range_cmp);
+   for (i = 0; i < cls->count; i++)
+     {
+        if (cls->ranges[i].from > next)
+          ast = _edi_search_regex_ast_alt(parser, ast,
+                                          _edi_search_regex_ast_utf8_new(parser, next, cls->ranges[i].from - 1));
+        if (cls->ranges[i].to >= next)
+          next = cls->ranges[i].to + 1;
+     }
+   ast = _edi_search_regex_ast_alt(parser, ast, _edi_search_regex_ast_utf8_new(parser, next, 0x10ffff));
+
+   return _edi_search_regex_ast_alt(parser, ast, _edi_search_regex_ast_invalid_new(parser));
+}
+
+static void
+_edi_search_regex_set_escape_add(Edi_Search_Regex_Set *set, char escape)
+{
+   switch (escape)
+     {
+      case 'd':
+        _edi_search_regex_set_range_add(set, '0', '9');
+        break;
+      case 'w':
+        _edi_search_regex_set_range_add(set, 'a', 'z');
+        _edi_search_regex_set_range_add(set, 'A', 'Z');
+        _edi_search_regex_set_range_add(set, '0', '9');
+        _edi_search_regex_set_add(set, '_');
+        break;
+      case 's':
+        _edi_search_regex_set_add(set, ' ');
+        _edi_search_regex_set_range_add(set, '\t', '\r');
+        break;
+     }
+}
+
+static Eina_Bool
+_edi_search_regex_escape_char_get(const char **pos, unsigned char *out)
+{
+   const char *ptr = *pos;
+   unsigned int value = 0, i;
+
+   switch (*ptr)
+     {
+      case 'n': *out = '\n'; break;
+      case 't': *out = '\t'; break;
+      case 'r': *out = '\r'; break;
+      case 'f': *out = '\f'; break;
+      case 'v': *out = '\v'; break;
+      case 'e': *out = 0x1b; break;
+      case '0': *out = '\0'; break;
+      case 'x':
+        for (i = 1; i <= 2; i++)
+          {
+             if (ptr[i] >= '0' && ptr[i] <= '9')
+               value = value * 16 + ptr[i] - '0';
+             else if (ptr[i] >= 'a' && ptr[i] <= 'f')
+               value = value * 16 + ptr[i] - 'a' + 10;
+             else if (ptr[i] >= 'A' && ptr[i] <= 'F')
+               value = value * 16 + ptr[i] - 'A' + 10;
+             else
+               return EINA_FALSE;
+          }
+        *out = value;
+        *pos += 2;
+        break;
+      default:
+        if ((*ptr >= 'a' && *ptr <= 'z') || (*ptr >= 'A' && *ptr <= 'Z') || (*ptr >= '0' && *ptr <= '9'))
+          return EINA_FALSE;
+        *out = *ptr;
+     }
+
+   (*pos)++;
+   return EINA_TRUE;
+}
+
+static const struct
+{
+   const char *name;
+   const char *ranges;
+} _edi_search_regex_classes[] =
+{
+   { "alpha",  "azAZ" },
+   { "digit",  "09" },
+   { "alnum",  "azAZ09" },
+   { "upper",  "AZ" },
+   { "lower",  "az" },
+   { "space",  "  \t\r" },
+   { "blank",  "  \t\t" },
+   { "xdigit", "09afAF" },
+   { "punct",  "!/:@[`{~" },
+   { "word",   "azAZ09__" },
+   { NULL, NULL }
+};
+
+static Eina_Bool
+_edi_search_regex_posix_class_add(Edi_Search_Regex_Parser *parser, Edi_Search_Regex_Set *set)
+{
+   const char *end, *ranges;
+   size_t length;
+   int i;
+
+   end = strstr(parser->pos + 2, ":]");
+   if (!end)
+     return EINA_FALSE;
+
+   length = end - (parser->pos + 2);
+   for (i = 0; _edi_search_regex_classes[i].name; i++)
+     {
+        if (strlen(_edi_search_regex_classes[i].name) != length ||
+            strncmp(_edi_search_regex_classes[i].name, parser->pos + 2, length))
+          continue;
+
+        for (ranges = _edi_search_regex_classes[i].ranges; *ranges; ranges += 2)
+          _edi_search_regex_set_range_add(set, ranges[0], ranges[1]);
+
+        parser->pos = end + 2;
+        return EINA_TRUE;
+     }
+
+   parser->error = "unknown character class";
+   return EINA_FALSE;
+}
+
+/* Decode a multi byte UTF-8 character, refusing overlong and invalid sequences. */
+static Eina_Bool
+_edi_search_regex_utf8_get(const char **pos, unsigned int *out)
+{
+   const unsigned char *ptr = (const unsigned char *) *pos;
+   unsigned int value, length, i;
+
+   if (ptr[0] >= 0xc2 && ptr[0] <= 0xdf)
+     {
+        value = ptr[0] & 0x1f;
+        length = 2;
+     }
+   else if (ptr[0] >= 0xe0 && ptr[0] <= 0xef)
+     {
+        value = ptr[0] & 0x0f;
+        length = 3;
+     }
+   else if (ptr[0] >= 0xf0 && ptr[0] <= 0xf4)
+     {
+        value = ptr[0] & 0x07;
+        length = 4;
+     }
+   else
+     return EINA_FALSE;
+
+   for (i = 1; i < length; i++)
+     {
+        if ((ptr[i] & 0xc0) != 0x80)
+          return EINA_FALSE;
+        value = (value << 6) | (ptr[i] & 0x3f);
+     }
+
+   if ((length == 3 && value < 0x800) || (length == 4 && value < 0x10000) ||
+       value > 0x10ffff || (value >= 0xd800 && value <= 0xdfff))
+     return EINA_FALSE;
+
+   *out = value;
+   *pos += length;
+   return EINA_TRUE;
+}
+
+static void
+_edi_search_regex_class_range_add(Edi_Search_Regex_Class *cls, unsigned int from, unsigned int to)
+{
+   if (from < 0x80)
+     {
+        _edi_search_regex_set_range_add(&cls->set, from, to < 0x80 ? to : 0x7f);
+        from = 0x80;
+     }
+   if (to < from)
+     return;
+
+   if (cls->count == cls->size)
+     {
+        cls->size = cls->size ? cls->size * 2 : 8;
+        cls->ranges = realloc(cls->ranges, sizeof(Edi_Search_Regex_Range) * cls->size);
+     }
+
+   cls->ranges[cls->count].from = from;
+   cls->ranges[cls->count].to = to;
+   cls->count++;
+}
+
+/* A byte, from an escape or ASCII, or a whole multi byte character in a class. */
+static Eina_Bool
+_edi_search_regex_class_char_get(Edi_Search_Regex_Parser *parser, unsigned int *out, Eina_Bool *multibyte)
+{
+   unsigned char c;
+
+   *multibyte = EINA_FALSE;
+   c = *parser->pos;
+   if (c == '\\')
+     {
+        parser->pos++;
+        if (!_edi_search_regex_escape_char_get(&parser->pos, &c))
+          {
+             parser->error = "invalid escape in class";
+             return EINA_FALSE;
+          }
+        *out = c;
+        return EINA_TRUE;
+     }
+
+   if (c < 0x80)
+     {
+        parser->pos++;
+        *out = c;
+        return EINA_TRUE;
+     }
+
+   if (!_edi_search_regex_utf8_get(&parser->pos, out))
+     {
+        parser->error = "invalid UTF-8 in class";
+        return EINA_FALSE;
+     }
+   *multibyte = EINA_TRUE;
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edi_search_regex_parse_class_members(Edi_Search_Regex_Parser *parser, Edi_Search_Regex_Class *cls)
+{
+   Edi_Search_Regex_Set other;
+   Eina_Bool first = EINA_TRUE, from_multibyte, to_multibyte;
+   unsigned int from, to, i;
+
+   while (*parser->pos && (first || *parser->pos != ']'))
+     {
+        first = EINA_FALSE;
+
+        if (!strncmp(parser->pos, "[:", 2))
+          {
+             if (_edi_search_regex_posix_class_add(parser, &cls->set))
+               continue;
+             if (parser->error)
+               return EINA_FALSE;
+          }
+
+        if (parser->pos[0] == '\\' && parser->pos[1] && strchr("dwsDWS", parser->pos[1]))
+          {
+             memset(&other, 0, sizeof(other));
+             _edi_search_regex_set_escape_add(&other, parser->pos[1] | 0x20);
+             if (parser->pos[1] >= 'A' && parser->pos[1] <= 'Z')
+               {
+                  // As outside a class, these also match every multi byte character
+                  for (i = 0; i < 4; i++)
+                    other.bits[i] = ~other.bits[i];
+                  cls->multibyte = EINA_TRUE;
+               }
+             for (i = 0; i < 8; i++)
+               cls->set.bits[i] |= other.bits[i];
+             parser->pos += 2;
+             continue;
+          }
+
+        if (!_edi_search_regex_class_char_get(parser, &from, &from_multibyte))
+          return EINA_FALSE;
+
+        to = from;
+        to_multibyte = from_multibyte;
+        if (parser->pos[0] == '-' && parser->pos[1] && parser->pos[1] != ']')
+          {
+             parser->pos++;
+             if (!_edi_search_regex_class_char_get(parser, &to, &to_multibyte))
+               return EINA_FALSE;
+             if (to < from)
+               {
+                  parser->error = "invalid range in class";
+                  return EINA_FALSE;
+               }
+          }
+
+        // Escaped bytes stay bytes, unless they are the end of a range of characters
+        if (from_multibyte || to_multibyte)
+          _edi_search_regex_class_range_add(cls, from, to);
+        else
+          _edi_search_regex_set_range_add(&cls->set, from, to);
+     }
+
+   if (*parser->pos != ']')
+     {
+        parser->error = "unterminated class";
+        return EINA_FALSE;
+     }
+   parser->pos++;
+
+   return EINA_TRUE;
+}
+
+static Edi_Search_Regex_Ast *
+_edi_search_regex_parse_class(Edi_Search_Regex_Parser *parser)
+{
+   Edi_Search_Regex_Ast *ast = NULL;
+   Edi_Search_Regex_Class cls;
+   Eina_Bool negate = EINA_FALSE;
+
+   memset(&cls, 0, sizeof(cls));
+   if (*parser->pos == '^')
+     {
+        negate = EINA_TRUE;
+        parser->pos++;
+     }
+
+   if (_edi_search_regex_parse_class_members(parser, &cls))
+     ast = _edi_search_regex_ast_class_members_new(parser, &cls, negate);
+   free(cls.ranges);
+
+   return ast;
+}
+
+static Edi_Search_Regex_Ast *_edi_search_regex_parse_alt(Edi_Search_Regex_Parser *parser);
+
+/* A single literal character, keeping multi byte UTF-8 sequences together. */
+static Edi_Search_Regex_Ast *
+_edi_search_regex_parse_literal(Edi_Search_Regex_Parser *parser)
+{
+   Edi_Search_Regex_Ast *ast;
+   unsigned char c;
+
+   c = *parser->pos++;
+   ast = _edi_search_regex_ast_range_new(parser, c, c);
+   if (c < 0xc0)
+     return ast;
+
+   while ((*parser->pos & 0xc0) == 0x80)
+     {
+        c = *parser->pos++;
+        ast = _edi_search_regex_ast_concat(parser, ast, _edi_search_regex_ast_range_new(parser, c, c));
+     }
+
+   return ast;
+}
+
+static Edi_Search_Regex_Ast *
+_edi_search_regex_parse_atom(Edi_Search_Regex_Parser *parser)
+{
+   Edi_Search_Regex_Ast *ast;
+   Edi_Search_Regex_Set set;
+   unsigned char c;
+
+   if (parser->flags & EDI_SEARCH_REGEX_LITERAL)
+     return _edi_search_regex_parse_literal(parser);
+
+   switch (*parser->pos)
+     {
+      case '(':
+        parser->pos++;
+        if (!strncmp(parser->pos, "?:", 2))
+          parser->pos += 2;
+        if (++parser->depth > EDI_SEARCH_REGEX_DEPTH_MAX)
+          {
+             parser->error = "too many nested groups";
+             return NULL;
+          }
+        ast = _edi_search_regex_parse_alt(parser);
+        parser->depth--;
+        if (!ast)
+          return NULL;
+        if (*parser->pos != ')')
+          {
+             parser->error = "missing )";
+             return NULL;
+          }
+        parser->pos++;
+        return ast;
+      case '[':
+        parser->pos++;
+        return _edi_search_regex_parse_class(parser);
+      case '.':
+        parser->pos++;
+        memset(&set, 0, sizeof(set));
+        _edi_search_regex_set_range_add(&set, 0, 0x7f);
+        set.bits['\n' >> 5] &= ~(1u << ('\n' & 31));
+        return _edi_search_regex_ast_new(parser, EDI_SEARCH_REGEX_AST_ALT,
+                                         _edi_search_regex_ast_set_new(parser, &set),
+                                         _edi_search_regex_ast_multibyte_new(parser));
+      case '^':
+        parser->pos++;
+        return _edi_search_regex_ast_assert_new(parser, EDI_SEARCH_REGEX_ASSERT_LINE_START);
+      case '$':
+        parser->pos++;
+        return _edi_search_regex_ast_assert_new(parser, EDI_SEARCH_REGEX_ASSERT_LINE_END);
+      case '*':
+      case '+':
+      case '?':
+        parser->error = "nothing to repeat";
+        return NULL;
+      case '\\':
+        parser->pos++;
+        switch (*parser->pos)
+          {
+           case '\0':
+             parser->error = "trailing \\";
+             return NULL;
+           case 'b':
+             parser->pos++;
+             return _edi_search_regex_ast_assert_new(parser, EDI_SEARCH_REGEX_ASSERT_WORD_BOUNDARY);
+           case 'B':
+             parser->pos++;
+             return _edi_search_regex_ast_assert_new(parser, EDI_SEARCH_REGEX_ASSERT_NOT_WORD_BOUNDARY);
+           case 'd':
+           case 'w':
+           case 's':
+           case 'D':
+           case 'W':
+           case 'S':
+             memset(&set, 0, sizeof(set));
+             _edi_search_regex_set_escape_add(&set, *parser->pos | 0x20);
+             c = *parser->pos++;
+             return _edi_search_regex_ast_class_new(parser, &set, c >= 'A' && c <= 'Z');
+          }
+        if (!_edi_search_regex_escape_char_get(&parser->pos, &c))
+          {
+             parser->error = "unknown escape";
+             return NULL;
+          }
+        return _edi_search_regex_ast_range_new(parser, c, c);
+     }
+
+   return _edi_search_regex_parse_literal(parser);
+}
+
+static Eina_Bool
+_edi_search_regex_parse_count(const char **pos, int *value)
+{
+   const char *ptr = *pos;
+
+   if (*ptr < '0' || *ptr > '9')
+     return EINA_FALSE;
+
+   *value = 0;
+   while (*ptr >= '0' && *ptr <= '9')
+     {
+        if (*value <= EDI_SEARCH_REGEX_REPEAT_MAX)
+          *value = *value * 10 + (*ptr - '0');
+        ptr++;
+     }
+
+   *pos = ptr;
+   return EINA_TRUE;
+}
+
+/* Parse {m}, {m,} or {m,n}, leaving the position alone if it is not one. */
+static Eina_Bool
+_edi_search_regex_parse_braces(Edi_Search_Regex_Parser *parser, int *min, int *max)
+{
+   const char *ptr = parser->pos + 1;
+
+   if (!_edi_search_regex_parse_count(&ptr, min))
+     return EINA_FALSE;
+
+   *max = *min;
+   if (*ptr == ',')
+     {
+        ptr++;
+        if (!_edi_search_regex_parse_count(&ptr, max))
+          *max = -1;
+     }
+
+   if (*ptr != '}')
+     return EINA_FALSE;
+
+   parser->pos = ptr + 1;
+   return EINA_TRUE;
+}
+
+static Edi_Search_Regex_Ast *
+_edi_search_regex_parse_repeat(Edi_Search_Regex_Parser *parser)
+{
+   Edi_Search_Regex_Ast *ast, *repeat;
+   int min, max;
+
+   ast = _edi_search_regex_parse_atom(parser);
+   if (!ast || (parser->flags & EDI_SEARCH_REGEX_LITERAL))
+     return ast;
+
+   while (1)
+     {
+        if (*parser->pos == '*' || *parser->pos == '+' || *parser->pos == '?')
+          {
+             min = (*parser->pos == '+') ? 1 : 0;
+             max = (*parser->pos == '?') ? 1 : -1;
+             parser->pos++;
+          }
+        else if (*parser->pos != '{' || !_edi_search_regex_parse_braces(parser, &min, &max))
+          {
+             break;
+          }
+
+        if (min > EDI_SEARCH_REGEX_REPEAT_MAX || max > EDI_SEARCH_REGEX_REPEAT_MAX ||
+            (max >= 0 && max < min))
+          {
+             parser->error = "invalid repetition count";
+             return NULL;
+          }
+
+        /* Laziness makes no difference to which lines match */
+        if (*parser->pos == '?')
+          parser->pos++;
+
+        repeat = _edi_search_regex_ast_new(parser, EDI_SEARCH_REGEX_AST_REPEAT, ast, NULL);
+        repeat->min = min;
+        repeat->max = max;
+        ast = repeat;
+     }
+
+   return ast;
+}
+
+static Edi_Search_Regex_Ast *
+_edi_search_regex_parse_concat(Edi_Search_Regex_Parser *parser)
+{
+   Edi_Search_Regex_Ast *ast, *item;
+
+   ast = _edi_search_regex_ast_new(parser, EDI_SEARCH_REGEX_AST_EMPTY, NULL, NULL);
+   while (*parser->pos)
+     {
+        if (!(parser->flags & EDI_SEARCH_REGEX_LITERAL) &&
+            (*parser->pos == '|' || *parser->pos == ')'))
+          break;
+
+        item = _edi_search_regex_parse_repeat(parser);
+        if (!item)
+          return NULL;
+
+        ast = _edi_search_regex_ast_concat(parser, ast, item);
+     }
+
+   return ast;
+}
+
+static Edi_Search_Regex_Ast *
+_edi_search_regex_parse_alt(Edi_Search_Regex_Parser *parser)
+{
+   Edi_Search_Regex_Ast *ast, *right;
+
+   ast = _edi_search_regex_parse_concat(parser);
+   while (ast && *parser->pos == '|')
+     {
+        parser->pos++;
+        right = _edi_search_regex_parse_concat(parser);
+        if (!right)
+          return NULL;
+
+        ast = _edi_search_regex_ast_new(parser, EDI_SEARCH_REGEX_AST_ALT, ast, right);
+     }
+
+   return ast;
+}
+
+static int
+_edi_search_regex_prog_node_add(Edi_Search_Regex_Prog *prog, Edi_Search_Regex_Node_Type type)
+{
+   Edi_Search_Regex_Node *node;
+
+   if (prog->count >= EDI_SEARCH_REGEX_NODES_MAX)
+     {
+        prog->overflow = EINA_TRUE;
+        return 0;
+     }
+
+   if (prog->count == prog->size)
+     {
+        prog->size = prog->size ? prog->size * 2 : 64;
+        prog->nodes = realloc(prog->nodes, sizeof(Edi_Search_Regex_Node) * prog->size);
+     }
+
+   node = &prog->nodes[prog->count];
+   memset(node, 0, sizeof(Edi_Search_Regex_Node));
+   node->type = type;
+   node->out = node->out1 = -1;
+
+   return prog->count++;
+}
+
+static Edi_Search_Regex_Assert
+_edi_search_regex_assert_reverse(Edi_Search_Regex_Assert assert)
+{
+   switch (assert)
+     {
+      case EDI_SEARCH_REGEX_ASSERT_LINE_START:
+        return EDI_SEARCH_REGEX_ASSERT_LINE_END;
+      case EDI_SEARCH_REGEX_ASSERT_LINE_END:
+        return EDI_SEARCH_REGEX_ASSERT_LINE_START;
+      case EDI_SEARCH_REGEX_ASSERT_NOT_WORD_BEFORE:
+        return EDI_SEARCH_REGEX_ASSERT_NOT_WORD_AFTER;
+      case EDI_SEARCH_REGEX_ASSERT_NOT_WORD_AFTER:
+        return EDI_SEARCH_REGEX_ASSERT_NOT_WORD_BEFORE;
+      default:
+        return assert;
+     }
+}
+
+/*
+ * Compile a Thompson NFA for the tree working back from the node that
+ * follows it. The reverse program matches the same text read backwards.
+ */
+static int
+_edi_search_regex_compile(Edi_Search_Regex_Prog *prog, const Edi_Search_Regex_Ast *ast,
+                          int next, Eina_Bool reverse)
+{
+   int start, body, split, i;
+
+   if (prog->overflow)
+     return next;
+
+   switch (ast->type)
+     {
+      case EDI_SEARCH_REGEX_AST_EMPTY:
+        return next;
+      case EDI_SEARCH_REGEX_AST_SET:
+        start = _edi_search_regex_prog_node_add(prog, EDI_SEARCH_REGEX_NODE_SET);
+        prog->nodes[start].set = ast->set;
+        prog->nodes[start].out = next;
+        return start;
+      case EDI_SEARCH_REGEX_AST_ASSERT:
+        start = _edi_search_regex_prog_node_add(prog, EDI_SEARCH_REGEX_NODE_ASSERT);
+        prog->nodes[start].assert = reverse ? _edi_search_regex_assert_reverse(ast->assert) : ast->assert;
+        prog->nodes[start].out = next;
+        return start;
+      case EDI_SEARCH_REGEX_AST_CONCAT:
+        if (reverse)
+          return _edi_search_regex_compile(prog, ast->right,
+                   _edi_search_regex_compile(prog, ast->left, next, reverse), reverse);
+        return _edi_search_regex_compile(prog, ast->left,
+                 _edi_search_regex_compile(prog, ast->right, next, reverse), reverse);
+      case EDI_SEARCH_REGEX_AST_ALT:
+        body = _edi_search_regex_compile(prog, ast->left, next, reverse);
+        start = _edi_search_regex_compile(prog, ast->right, next, reverse);
+        split = _edi_search_regex_prog_node_add(prog, EDI_SEARCH_REGEX_NODE_SPLIT);
+        prog->nodes[split].out = body;
+        prog->nodes[split].out1 = start;
+        return split;
+      case EDI_SEARCH_REGEX_AST_REPEAT:
+        start = next;
+        if (ast->max < 0)
+          {
+             split = _edi_search_regex_prog_node_add(prog, EDI_SEARCH_REGEX_NODE_SPLIT);
+             body = _edi_search_regex_compile(prog, ast->left, split, reverse);
+             prog->nodes[split].out = body;
+             prog->nodes[split].out1 = next;
+             start = split;
+          }
+        else
+          {
+             for (i = ast->min; i < ast->max && !prog->overflow; i++)
+               {
+                  body = _edi_search_regex_compile(prog, ast->left, start, reverse);
+                  split = _edi_search_regex_prog_node_add(prog, EDI_SEARCH_REGEX_NODE_SPLIT);
+                  prog->nodes[split].out = body;
+                  prog->nodes[split].out1 = next;
+                  start = split;
+               }
+          }
+
+        for (i = 0; i < ast->min && !prog->overflow; i++)
+          start = _edi_search_regex_compile(prog, ast->left, start, reverse);
+        return start;
+     }
+
+   return next;
+}
+
+static char *
+_edi_search_regex_string_join(const char *first, const char *second)
+{
+   char *joined;
+   size_t length;
+
+   length = strlen(first);
+   joined = malloc(length + strlen(second) + 1);
+   memcpy(joined, first, length);
+   strcpy(joined + length, second);
+
+   return joined;
+}
+
+static char *
+_edi_search_regex_string_longest(char *first, char *second)
+{
+   if (!first)
+     return second;
+   if (!second)
+     return first;
+
+   if (strlen(second) > strlen(first))
+     {
+        free(first);
+        return second;
+     }
+
+   free(second);
+   return first;
+}
+
+static void
+_edi_search_regex_literal_clear(Edi_Search_Regex_Literal *lit)
+{
+   free(lit->exact);
+   free(lit->prefix);
+   free(lit->suffix);
+   free(lit->required);
+}
+
+/*
+ * Work out the literal text that every match of the tree must contain.
+ * Alongside the longest required run we track any text a match must start
+ * or end with so that runs can be joined across concatenation.
+ */
+static void
+_edi_search_regex_literal_get(const Edi_Search_Regex_Ast *ast, Eina_Bool caseless,
+                              Edi_Search_Regex_Literal *lit)
+{
+   Edi_Search_Regex_Literal left, right;
+   char c[2] = { 0, 0 };
+
+   memset(lit, 0, sizeof(Edi_Search_Regex_Literal));
+   switch (ast->type)
+     {
+      case EDI_SEARCH_REGEX_AST_EMPTY:
+      case EDI_SEARCH_REGEX_AST_ASSERT:
+        lit->exact = strdup("");
+        break;
+      case EDI_SEARCH_REGEX_AST_SET:
+        if (_edi_search_regex_set_literal_get(&ast->set, caseless, &c[0]) && c[0])
+          {
+             lit->exact = strdup(c);
+             lit->prefix = strdup(c);
+             lit->suffix = strdup(c);
+             lit->required = strdup(c);
+             return;
+          }
+        break;
+      case EDI_SEARCH_REGEX_AST_CONCAT:
+        _edi_search_regex_literal_get(ast->left, caseless, &left);
+        _edi_search_regex_literal_get(ast->right, caseless, &right);
+
+        if (left.exact && right.exact)
+          lit->exact = _edi_search_regex_string_join(left.exact, right.exact);
+        lit->prefix = left.exact ? _edi_search_regex_string_join(left.exact, right.prefix) : strdup(left.prefix);
+        lit->suffix = right.exact ? _edi_search_regex_string_join(left.suffix, right.exact) : strdup(right.suffix);
+
+        lit->required = _edi_search_regex_string_join(left.suffix, right.prefix);
+        lit->required = _edi_search_regex_string_longest(lit->required, left.required);
+        lit->required = _edi_search_regex_string_longest(lit->required, right.required);
+        left.required = right.required = NULL;
+
+        _edi_search_regex_literal_clear(&left);
+        _edi_search_regex_literal_clear(&right);
+        return;
+      case EDI_SEARCH_REGEX_AST_ALT:
+        break;
+      case EDI_SEARCH_REGEX_AST_REPEAT:
+        if (ast->min == 0)
+          {
+             if (ast->max == 0)
+               lit->exact = strdup("");
+             break;
+          }
+
+        _edi_search_regex_literal_get(ast->left, caseless, lit);
+        if (ast->max != 1)
+          {
+             free(lit->exact);
+             lit->exact = NULL;
+          }
+        return;
+     }
+
+   lit->prefix = strdup("");
+   lit->suffix = strdup("");
+}
+
+static void
+_edi_search_regex_dfa_init(Edi_Search_Regex_Dfa *dfa, const Edi_Search_Regex_Prog *prog)
+{
+   memset(dfa, 0, sizeof(Edi_Search_Regex_Dfa));
+   dfa->prog = prog;
+   dfa->stack = malloc(sizeof(int) * prog->count * 3);
+   dfa->closure = malloc(sizeof(int) * prog->count);
+   dfa->targets = malloc(sizeof(int) * prog->count);
+   dfa->mark = calloc(prog->count, sizeof(unsigned int));
+}
+
+static void
+_edi_search_regex_dfa_clear(Edi_Search_Regex_Dfa *dfa)
+{
+   unsigned int i;
+
+   for (i = 0; i < dfa->count; i++)
+     {
+        free(dfa->states[i]->nodes);
+        free(dfa->states[i]);
+     }
+
+   free(dfa->states);
+   free(dfa->buckets);
+   dfa->states = NULL;
+   dfa->buckets = NULL;
+   dfa->count = dfa->size = dfa->bucket_count = 0;
+}
+
+static void
+_edi_search_regex_dfa_free(Edi_Search_Regex_Dfa *dfa)
+{
+   _edi_search_regex_dfa_clear(dfa);
+   free(dfa->stack);
+   free(dfa->closure);
+   free(dfa->targets);
+   free(dfa->mark);
+}
+
+static unsigned int
+_edi_search_regex_state_hash(const int *nodes, unsigned int count, unsigned int flags)
+{
+   unsigned int hash = 2166136261u ^ flags, i;
+
+   for (i = 0; i < count; i++)
+     hash = (hash ^ (unsigned int) nodes[i]) * 16777619u;
+
+   return hash;
+}
+
+static void
+_edi_search_regex_dfa_rehash(Edi_Search_Regex_Dfa *dfa)
+{
+   Edi_Search_Regex_State *state;
+   unsigned int i, bucket;
+
+   dfa->bucket_count = dfa->bucket_count ? dfa->bucket_count * 2 : 64;
+   free(dfa->buckets);
+   dfa->buckets = malloc(sizeof(int) * dfa->bucket_count);
+   memset(dfa->buckets, 0xff, sizeof(int) * dfa->bucket_count);
+
+   for (i = 0; i < dfa->count; i++)
+     {
+        state = dfa->states[i];
+        bucket = state->hash & (dfa->bucket_count - 1);
+        state->chain = dfa->buckets[bucket];
+        dfa->buckets[bucket] = i;
+     }
+}
+
+/* Find or create the state for a sorted set of NFA nodes. */
+static unsigned int
+_edi_search_regex_dfa_state_get(Edi_Search_Regex_Dfa *dfa, const int *nodes, unsigned int count,
+                                unsigned int flags)
+{
+   Edi_Search_Regex_State *state;
+   unsigned int hash, bucket;
+   int id;
+
+   hash = _edi_search_regex_state_hash(nodes, count, flags);
+   if (dfa->bucket_count)
+     {
+        for (id = dfa->buckets[hash & (dfa->bucket_count - 1)]; id >= 0; id = state->chain)
+          {
+             state = dfa->states[id];
+             if (state->hash == hash && state->flags == flags && state->count == count &&
+                 !memcmp(state->nodes, nodes, sizeof(int) * count))
+               return id;
+          }
+     }
+
+   state = malloc(sizeof(Edi_Search_Regex_State));
+   state->hash = hash;
+   state->flags = flags;
+   state->count = count;
+   state->nodes = malloc(sizeof(int) * (count ? count : 1));
+   memcpy(state->nodes, nodes, sizeof(int) * count);
+   memset(state->next, 0xff, sizeof(state->next));
+
+   if (dfa->count == dfa->size)
+     {
+        dfa->size = dfa->size ? dfa->size * 2 : 64;
+        dfa->states = realloc(dfa->states, sizeof(Edi_Search_Regex_State *) * dfa->size);
+     }
+   id = dfa->count++;
+   dfa->states[id] = state;
+
+   if (dfa->count > dfa->bucket_count)
+     {
+        _edi_search_regex_dfa_rehash(dfa);
+     }
+   else
+     {
+        bucket = hash & (dfa->bucket_count - 1);
+        state->chain = dfa->buckets[bucket];
+        dfa->buckets[bucket] = id;
+     }
+
+   return id;
+}
+
+static int
+_edi_search_regex_int_cmp(const void *a, const void *b)
+{
+   return *(const int *)a - *(const int *)b;
+}
+
+static Eina_Bool
+_edi_search_regex_assert_check(Edi_Search_Regex_Assert assert, unsigned int flags, unsigned int symbol)
+{
+   Eina_Bool before, after;
+
+   before = !!(flags & EDI_SEARCH_REGEX_STATE_WORD);
+   after = _edi_search_regex_word_is(symbol);
+
+   switch (assert)
+     {
+      case EDI_SEARCH_REGEX_ASSERT_LINE_START:
+        return !!(flags & EDI_SEARCH_REGEX_STATE_START);
+      case EDI_SEARCH_REGEX_ASSERT_LINE_END:
+        return symbol == EDI_SEARCH_REGEX_EOL;
+      case EDI_SEARCH_REGEX_ASSERT_WORD_BOUNDARY:
+        return before != after;
+      case EDI_SEARCH_REGEX_ASSERT_NOT_WORD_BOUNDARY:
+        return before == after;
+      case EDI_SEARCH_REGEX_ASSERT_NOT_WORD_BEFORE:
+        return !before;
+      case EDI_SEARCH_REGEX_ASSERT_NOT_WORD_AFTER:
+        return !after;
+     }
+
+   return EINA_FALSE;
+}
+
+/*
+ * Calculate a transition the first time it is needed. Zero width assertions
+ * are only resolved here, once the symbol that follows is known, so states
+ * hold the nodes reached directly by the last byte.
+ * If the cache is full it is thrown away and the current state recreated.
+ */
+static int
+_edi_search_regex_dfa_step(Edi_Search_Regex_Dfa *dfa, unsigned int *current, unsigned int symbol)
+{
+   const Edi_Search_Regex_Prog *prog = dfa->prog;
+   const Edi_Search_Regex_Node *node;
+   Edi_Search_Regex_State *state;
+   unsigned int closure_count = 0, target_count = 0, sp = 0, i, flags, copy_flags;
+   Eina_Bool matched = EINA_FALSE;
+   int id, next, *copy;
+
+   state = dfa->states[*current];
+   dfa->generation++;
+   for (i = 0; i < state->count; i++)
+     dfa->stack[sp++] = state->nodes[i];
+
+   while (sp)
+     {
+        id = dfa->stack[--sp];
+        if (id < 0 || dfa->mark[id] == dfa->generation)
+          continue;
+        dfa->mark[id] = dfa->generation;
+
+        node = &prog->nodes[id];
+        switch (node->type)
+          {
+           case EDI_SEARCH_REGEX_NODE_SET:
+             dfa->closure[closure_count++] = id;
+             break;
+           case EDI_SEARCH_REGEX_NODE_SPLIT:
+             dfa->stack[sp++] = node->out1;
+             dfa->stack[sp++] = node->out;
+             break;
+           case EDI_SEARCH_REGEX_NODE_ASSERT:
+             if (_edi_search_regex_assert_check(node->assert, state->flags, symbol))
+               dfa->stack[sp++] = node->out;
+             break;
+           case EDI_SEARCH_REGEX_NODE_MATCH:
+             matched = EINA_TRUE;
+             break;
+          }
+     }
+
+   if (symbol == EDI_SEARCH_REGEX_EOL)
+     {
+        state->next[symbol] = matched;
+        return matched;
+     }
+
+   dfa->generation++;
+   for (i = 0; i < closure_count; i++)
+     {
+        node = &prog->nodes[dfa->closure[i]];
+        if (!_edi_search_regex_set_has(&node->set, symbol) || node->out < 0 ||
+            dfa->mark[node->out] == dfa->generation)
+          continue;
+
+        dfa->mark[node->out] = dfa->generation;
+        dfa->targets[target_count++] = node->out;
+     }
+   qsort(dfa->targets, target_count, sizeof(int), _edi_search_regex_int_cmp);
+   flags = _edi_search_regex_word_is(symbol) ? EDI_SEARCH_REGEX_STATE_WORD : 0;
+
+   if (dfa->count >= EDI_SEARCH_REGEX_STATES_MAX)
+     {
+        copy = malloc(sizeof(int) * (state->count ? state->count : 1));
+        memcpy(copy, state->nodes, sizeof(int) * state->count);
+        copy_flags = state->flags;
+        i = state->count;
+
+        _edi_search_regex_dfa_clear(dfa);
+        *current = _edi_search_regex_dfa_state_get(dfa, copy, i, copy_flags);
+        free(copy);
+     }
+
+   next = _edi_search_regex_dfa_state_get(dfa, dfa->targets, target_count, flags);
+   dfa->states[*current]->next[symbol] = (next << 1) | matched;
+
+   return dfa->states[*current]->next[symbol];
+}
+
+static inline int
+_edi_search_regex_dfa_next(Edi_Search_Regex_Dfa *dfa, unsigned int *current, unsigned int symbol)
+{
+   int next;
+
+   next = dfa->states[*current]->next[symbol];
+   if (next < 0)
+     next = _edi_search_regex_dfa_step(dfa, current, symbol);
+
+   return next;
+}
+
+/* Run the forward automaton, stopping as soon as any match has ended. */
+static Eina_Bool
+_edi_search_regex_dfa_find(Edi_Search_Regex_Dfa *dfa, const char *line, size_t length)
+{
+   unsigned int current;
+   size_t i;
+   int next;
+
+   current = _edi_search_regex_dfa_state_get(dfa, &dfa->prog->start, 1, EDI_SEARCH_REGEX_STATE_START);
+   for (i = 0; i < length; i++)
+     {
+        next = _edi_search_regex_dfa_next(dfa, &current, (unsigned char) line[i]);
+        if (next & 1)
+          return EINA_TRUE;
+        current = next >> 1;
+     }
+
+   return _edi_search_regex_dfa_next(dfa, &current, EDI_SEARCH_REGEX_EOL);
+}
+
+/*
+ * Run the reverse automaton over the whole line, from the end, to find the
+ * leftmost position that a match can start from.
+ */
+static size_t
+_edi_search_regex_dfa_rfind(Edi_Search_Regex_Dfa *dfa, const char *line, size_t length)
+{
+   unsigned int current;
+   size_t i, start = length;
+   int next;
+
+   current = _edi_search_regex_dfa_state_get(dfa, &dfa->prog->start, 1, EDI_SEARCH_REGEX_STATE_START);
+   for (i = length; i > 0; i--)
+     {
+        next = _edi_search_regex_dfa_next(dfa, &current, (unsigned char) line[i - 1]);
+        if (next & 1)
+          start = i;
+        current = next >> 1;
+     }
+
+   if (_edi_search_regex_dfa_next(dfa, &current, EDI_SEARCH_REGEX_EOL))
+     start = 0;
+
+   return start;
+}
+
+static Edi_Search_Regex_Matcher *
+_edi_search_regex_matcher_get(Edi_Search_Regex *regex)
+{
+   Edi_Search_Regex_Matcher *matcher;
+
+   eina_lock_take(&regex->lock);
+   matcher = eina_list_data_get(regex->matchers);
+   regex->matchers = eina_list_remove_list(regex->matchers, regex->matchers);
+   eina_lock_release(&regex->lock);
+
+   if (matcher)
+     return matcher;
+
+   matcher = malloc(sizeof(Edi_Search_Regex_Matcher));
+   _edi_search_regex_dfa_init(&matcher->forward, &regex->forward);
+   _edi_search_regex_dfa_init(&matcher->reverse, &regex->reverse);
+
+   return matcher;
+}
+
+static void
+_edi_search_regex_matcher_release(Edi_Search_Regex *regex, Edi_Search_Regex_Matcher *matcher)
+{
+   eina_lock_take(&regex->lock);
+   regex->matchers = eina_list_prepend(regex->matchers, matcher);
+   eina_lock_release(&regex->lock);
+}
+
+static Eina_Bool
+_edi_search_regex_line_match(Edi_Search_Regex_Matcher *matcher, const char *line, size_t length,
+                             unsigned int *start)
+{
+   if (!_edi_search_regex_dfa_find(&matcher->forward, line, length))
+     return EINA_FALSE;
+
+   if (start)
+     *start = _edi_search_regex_dfa_rfind(&matcher->reverse, line, length);
+
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edi_search_regex_prog_build(Edi_Search_Regex_Prog *prog, const Edi_Search_Regex_Ast *ast,
+                             Eina_Bool reverse)
+{
+   int match, loop, any;
+
+   match = _edi_search_regex_prog_node_add(prog, EDI_SEARCH_REGEX_NODE_MATCH);
+   prog->start = _edi_search_regex_compile(prog, ast, match, reverse);
+
+   /* Matching is unanchored, so allow any bytes before the pattern */
+   loop = _edi_search_regex_prog_node_add(prog, EDI_SEARCH_REGEX_NODE_SPLIT);
+   any = _edi_search_regex_prog_node_add(prog, EDI_SEARCH_REGEX_NODE_SET);
+   if (!prog->overflow)
+     {
+        memset(&prog->nodes[any].set, 0xff, sizeof(Edi_Search_Regex_Set));
+        prog->nodes[any].out = loop;
+        prog->nodes[loop].out = prog->start;
+        prog->nodes[loop].out1 = any;
+        prog->start = loop;
+     }
+
+   return !prog->overflow;
+}
+
+Edi_Search_Regex *
+edi_search_regex_new(const char *pattern, Edi_Search_Regex_Flags flags)
+{
+   Edi_Search_Regex *regex;
+   Edi_Search_Regex_Parser parser;
+   Edi_Search_Regex_Ast *ast;
+   Edi_Search_Regex_Literal lit;
+   Eina_Bool caseless;
+
+   if (!pattern)
+     return NULL;
+
+   memset(&parser, 0, sizeof(parser));
+   parser.pos = pattern;
+   parser.flags = flags;
+
+   ast = _edi_search_regex_parse_alt(&parser);
+   if (ast && *parser.pos)
+     {
+        parser.error = "unmatched )";
+        ast = NULL;
+     }
+
+   if (!ast)
+     {
+        INF("Invalid search pattern \"%s\": %s", pattern, parser.error);
+        EINA_LIST_FREE(parser.nodes, ast)
+          free(ast);
+        return NULL;
+     }
+
+   if (flags & EDI_SEARCH_REGEX_WORD)
+     {
+        ast = _edi_search_regex_ast_concat(&parser,
+                 _edi_search_regex_ast_assert_new(&parser, EDI_SEARCH_REGEX_ASSERT_NOT_WORD_BEFORE), ast);
+        ast = _edi_search_regex_ast_concat(&parser, ast,
+                 _edi_search_regex_ast_assert_new(&parser, EDI_SEARCH_REGEX_ASSERT_NOT_WORD_AFTER));
+     }
+
+   regex = calloc(1, sizeof(Edi_Search_Regex));
+   if (!_edi_search_regex_prog_build(&regex->forward, ast, EINA_FALSE) ||
+       !_edi_search_regex_prog_build(&regex->reverse, ast, EINA_TRUE))
+     {
+        INF("Search pattern \"%s\" is too large", pattern);
+        free(regex->forward.nodes);
+        free(regex->reverse.nodes);
+        free(regex);
+        EINA_LIST_FREE(parser.nodes, ast)
+          free(ast);
+        return NULL;
+     }
+
+   caseless = !!(flags & EDI_SEARCH_REGEX_CASELESS);
+   _edi_search_regex_literal_get(ast, caseless, &lit);
+   if (lit.required && lit.required[0])
+     {
+        regex->literal = lit.required;
+        lit.required = NULL;
+        if (caseless)
+          regex->prefilter = edi_search_scanner_caseless_new(regex->literal);
+        else
+          regex->prefilter = edi_search_scanner_new(regex->literal);
+     }
+   _edi_search_regex_literal_clear(&lit);
+
+   EINA_LIST_FREE(parser.nodes, ast)
+     free(ast);
+
+   eina_lock_new(&regex->lock);
+   return regex;
+}
+
+void
+edi_search_regex_free(Edi_Search_Regex *regex)
+{
+   Edi_Search_Regex_Matcher *matcher;
+
+   if (!regex)
+     return;
+
+   EINA_LIST_FREE(regex->matchers, matcher)
+     {
+        _edi_search_regex_dfa_free(&matcher->forward);
+        _edi_search_regex_dfa_free(&matcher->reverse);
+        free(matcher);
+     }
+
+   edi_search_scanner_free(regex->prefilter);
+   free(regex->literal);
+   free(regex->forward.nodes);
+   free(regex->reverse.nodes);
+   eina_lock_free(&regex->lock);
+   free(regex);
+}
+
+const char *
+edi_search_regex_literal_get(const Edi_Search_Regex *regex)
+{
+   return regex->literal;
+}
+
+Eina_Bool
+edi_search_regex_match(Edi_Search_Regex *regex, const char *line, size_t length,
+                       unsigned int *start)
+{
+   Edi_Search_Regex_Matcher *matcher;
+   Eina_Bool matched;
+
+   matcher = _edi_search_regex_matcher_get(regex);
+   matched = _edi_search_regex_line_match(matcher, line, length, start);
+   _edi_search_regex_matcher_release(regex, matcher);
+
+   return matched;
+}
+
+static Eina_Bool
+_edi_search_regex_prefilter_line_cb(void *data, const char *line, unsigned int length,
+                                    unsigned int number, unsigned int col EINA_UNUSED)
+{
+   Edi_Search_Regex_Scan *scan = data;
+   unsigned int start;
+
+   if (!_edi_search_regex_line_match(scan->matcher, line, length, &start))
+     return EINA_TRUE;
+
+   scan->found++;
+   return scan->cb(scan->data, line, length, number, start + 1);
+}
+
+unsigned int
+edi_search_regex_scan(Edi_Search_Regex *regex, const char *text, size_t length,
+                      Edi_Search_Scanner_Cb cb, void *data)
+{
+   Edi_Search_Regex_Scan scan;
+   const char *pos, *end, *line_end;
+   unsigned int number = 1, start, line_len;
+
+   scan.regex = regex;
+   scan.matcher = _edi_search_regex_matcher_get(regex);
+   scan.cb = cb;
+   scan.data = data;
+   scan.found = 0;
+
+   if (regex->prefilter)
+     {
+        edi_search_scanner_scan(regex->prefilter, text, length, _edi_search_regex_prefilter_line_cb, &scan);
+     }
+   else
+     {
+        pos = text;
+        end = text + length;
+        for (; pos < end; pos = line_end + 1, number++)
+          {
+             line_end = memchr(pos, '\n', end - pos);
+             if (!line_end)
+               line_end = end;
+
+             line_len = line_end - pos;
+             if (line_len && pos[line_len - 1] == '\r')
+               line_len--;
+
+             if (!_edi_search_regex_line_match(scan.matcher, pos, line_len, &start))
+               continue;
+
+             scan.found++;
+             if (!cb(data, pos, line_len, number, start + 1))
+               break;
+          }
+     }
+
+   _edi_search_regex_matcher_release(regex, scan.matcher);
+   return scan.found;
+}
+
+unsigned int
+edi_search_regex_file_scan(Edi_Search_Regex *regex, const char *path,
+                           Edi_Search_Scanner_Cb cb, void *data)
+{
+   Eina_File *f;
+   const char *map;
+   unsigned int found = 0;
+
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return 0;
+
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (map)
+     {
+        if (!edi_walker_binary_is(map, eina_file_size_get(f)))
+          found = edi_search_regex_scan(regex, map, eina_file_size_get(f), cb, data);
+        eina_file_map_free(f, (void *) map);
+     }
+
+   eina_file_close(f);
+   return found;
+}
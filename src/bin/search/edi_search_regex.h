@@ -0,0 +1,137 @@
+#ifndef EDI_SEARCH_REGEX_H_
+# define EDI_SEARCH_REGEX_H_
+
+#include <Eina.h>
+
+#include "edi_search_scanner.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief These routines are used for matching regular expressions within files.
+ */
+
+/**
+ * @typedef Edi_Search_Regex
+ * A compiled regular expression that can be shared between threads.
+ */
+typedef struct _Edi_Search_Regex Edi_Search_Regex;
+
+/**
+ * @enum _Edi_Search_Regex_Flags
+ * Options that change how a pattern is compiled.
+ */
+typedef enum _Edi_Search_Regex_Flags
+{
+   EDI_SEARCH_REGEX_DEFAULT  = 0,      /**< Match the pattern as a regular expression */
+   EDI_SEARCH_REGEX_LITERAL  = 1 << 0, /**< Match the pattern as plain text */
+   EDI_SEARCH_REGEX_CASELESS = 1 << 1, /**< Ignore the case of ASCII letters */
+   EDI_SEARCH_REGEX_WORD     = 1 << 2, /**< Only match where not surrounded by word characters */
+} Edi_Search_Regex_Flags;
+
+/**
+ * @brief Regular expression functions.
+ * @defgroup Regex
+ *
+ * @{
+ *
+ * Patterns are compiled to an automaton once and matched a line at a time
+ * by a lazily built DFA, so matching is linear in the length of the text.
+ * Any literal text that every match must contain is found with a scanner
+ * first so lines that cannot match are skipped.
+ *
+ * The supported syntax is the common subset of extended regular expressions:
+ * literals, ., [] classes (including [:alpha:] and friends), groups,
+ * alternation, the *, +, ? and {m,n} repetitions, the ^ and $ line anchors,
+ * \\b and \\B word boundaries and the \\d, \\w, \\s escapes and their negations.
+ * Classes may hold UTF-8 characters and ranges of them, but only ASCII
+ * letters are matched without case.
+ *
+ */
+
+/**
+ * Compile a pattern.
+ *
+ * @param pattern The pattern to compile.
+ * @param flags Options for how the pattern is matched.
+ * @return A new regex or NULL if the pattern was not valid.
+ *
+ * @ingroup Regex
+ */
+Edi_Search_Regex *edi_search_regex_new(const char *pattern, Edi_Search_Regex_Flags flags);
+
+/**
+ * Free a compiled regex.
+ *
+ * @param regex The regex to free.
+ *
+ * @ingroup Regex
+ */
+void edi_search_regex_free(Edi_Search_Regex *regex);
+
+/**
+ * Get the literal text that any match must contain.
+ *
+ * @param regex The regex to query.
+ * @return The longest required literal or NULL if there is none.
+ *         If the regex is caseless the literal must be matched ignoring case.
+ *
+ * @ingroup Regex
+ */
+const char *edi_search_regex_literal_get(const Edi_Search_Regex *regex);
+
+/**
+ * Find the first match within a single line.
+ *
+ * @param regex The regex to use.
+ * @param line The line to search, without its line ending.
+ * @param length The length of the line.
+ * @param start A pointer to receive the offset of the leftmost match, may be NULL.
+ * @return EINA_TRUE if the line matched.
+ *
+ * @ingroup Regex
+ */
+Eina_Bool edi_search_regex_match(Edi_Search_Regex *regex, const char *line, size_t length,
+                                 unsigned int *start);
+
+/**
+ * Scan a block of memory reporting each line that contains a match.
+ *
+ * @param regex The regex to use.
+ * @param text The memory to search.
+ * @param length The length of the memory to search.
+ * @param cb The function called for each matching line.
+ * @param data User data passed to the callback.
+ * @return The number of matching lines reported.
+ *
+ * @ingroup Regex
+ */
+unsigned int edi_search_regex_scan(Edi_Search_Regex *regex, const char *text, size_t length,
+                                   Edi_Search_Scanner_Cb cb, void *data);
+
+/**
+ * Map a file and scan it, reporting each line that contains a match.
+ *
+ * @param regex The regex to use.
+ * @param path The path of the file to scan.
+ * @param cb The function called for each matching line.
+ * @param data User data passed to the callback.
+ * @return The number of matching lines reported.
+ *
+ * @ingroup Regex
+ */
+unsigned int edi_search_regex_file_scan(Edi_Search_Regex *regex, const char *path,
+                                        Edi_Search_Scanner_Cb cb, void *data);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_SEARCH_REGEX_H_ */
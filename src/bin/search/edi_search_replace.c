@@ -0,0 +1,933 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include <Eina.h>
+#include <Ecore.h>
+#include <Ecore_File.h>
+
+#include "Edi.h"
+#include "edi_file.h"
+#include "edi_search.h"
+#include "edi_search_index.h"
+#include "edi_search_replace.h"
+#include "edi_search_scanner.h"
+
+#include "edi_private.h"
+
+#define EDI_SEARCH_REPLACE_JOURNAL_FILES "files"
+
+// The kinds of journal entry, a whole file written to disk or lines changed in an editor
+#define EDI_SEARCH_REPLACE_JOURNAL_FILE "file"
+#define EDI_SEARCH_REPLACE_JOURNAL_BUFFER "buffer"
+
+struct _Edi_Search_Replace
+{
+   char *search;
+   char *replace;
+   Edi_Search_Scanner *scanner;
+   size_t search_len;
+
+   Eina_List *files;
+   /* The files to apply by path, for the search workers */
+   Eina_Hash *paths;
+   char *journal;
+   unsigned int journal_count;
+
+   Ecore_Thread *thread;
+   Edi_Search_Replace_File_Cb file_cb;
+   Edi_Search_Replace_Done_Cb done_cb;
+   Edi_Search_Replace_Buffer_Cb buffer_cb;
+   Edi_Search_Replace_Undo_Cb undo_cb;
+   void *data;
+
+   /* Guards the journal and the counts while an apply runs in the search workers */
+   Eina_Lock lock;
+   unsigned int file_count;
+   unsigned int hunk_count;
+   unsigned int skip_count;
+};
+
+/* A file open in an editor, whose lines are put back from the main loop during an undo */
+typedef struct _Edi_Search_Replace_Undo_Buffer
+{
+   Edi_Search_Replace *replace;
+   const char *path;
+   Eina_List *hunks;
+   Eina_Bool open;
+} Edi_Search_Replace_Undo_Buffer;
+
+static void
+_edi_search_replace_hunk_free(Edi_Search_Replace_Hunk *hunk)
+{
+   free(hunk->before);
+   free(hunk->after);
+   free(hunk);
+}
+
+static void
+_edi_search_replace_hunks_free(Eina_List *hunks)
+{
+   Edi_Search_Replace_Hunk *hunk;
+
+   EINA_LIST_FREE(hunks, hunk)
+     _edi_search_replace_hunk_free(hunk);
+}
+
+void
+edi_search_replace_file_free(Edi_Search_Replace_File *file)
+{
+   if (!file)
+     return;
+
+   _edi_search_replace_hunks_free(file->hunks);
+   free(file->path);
+   free(file);
+}
+
+static void
+_edi_search_replace_free(Edi_Search_Replace *replace)
+{
+   Edi_Search_Replace_File *file;
+
+   EINA_LIST_FREE(replace->files, file)
+     edi_search_replace_file_free(file);
+   if (replace->paths)
+     eina_hash_free(replace->paths);
+
+   if (replace->scanner)
+     edi_search_scanner_free(replace->scanner);
+   free(replace->journal);
+   free(replace->search);
+   free(replace->replace);
+   eina_lock_free(&replace->lock);
+   free(replace);
+}
+
+/* Build the new content of a line, the search text never spans lines. */
+static char *
+_edi_search_replace_line(Edi_Search_Replace *replace, const char *start, const char *end,
+                         const char *found)
+{
+   Eina_Strbuf *buf;
+   const char *pos = start;
+
+   buf = eina_strbuf_new();
+   while (found)
+     {
+        eina_strbuf_append_length(buf, pos, found - pos);
+        eina_strbuf_append(buf, replace->replace);
+
+        pos = found + replace->search_len;
+        found = edi_search_scanner_find(replace->scanner, pos, end - pos);
+     }
+   eina_strbuf_append_length(buf, pos, end - pos);
+
+   return eina_strbuf_string_steal(buf);
+}
+
+static Eina_List *
+_edi_search_replace_preview_file_cb(const char *path, void *data)
+{
+   Edi_Search_Replace *replace = data;
+   Edi_Search_Replace_Hunk *hunk;
+   Eina_List *hunks = NULL;
+   Eina_File *f;
+   const char *map, *end, *found, *line, *line_end, *counted;
+   unsigned int number = 1;
+   size_t len;
+
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return NULL;
+
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (!map)
+     {
+        eina_file_close(f);
+        return NULL;
+     }
+
+   len = eina_file_size_get(f);
+   end = map + len;
+   counted = map;
+   found = NULL;
+   if (len && !edi_walker_binary_is(map, len))
+     found = edi_search_scanner_find(replace->scanner, map, len);
+
+   while (found)
+     {
+        line = found;
+        while (line > map && line[-1] != '\n')
+          line--;
+        line_end = memchr(found, '\n', end - found);
+        if (!line_end)
+          line_end = end;
+
+        number += edi_search_scanner_lines_count(counted, line - counted);
+        counted = line;
+
+        hunk = calloc(1, sizeof(Edi_Search_Replace_Hunk));
+        hunk->line = number;
+        hunk->offset = line - map;
+        hunk->before = strndup(line, line_end - line);
+        hunk->after = _edi_search_replace_line(replace, line, line_end, found);
+        hunk->apply = EINA_TRUE;
+        hunks = eina_list_append(hunks, hunk);
+
+        found = edi_search_scanner_find(replace->scanner, line_end, end - line_end);
+     }
+
+   eina_file_map_free(f, (void *) map);
+   eina_file_close(f);
+   return hunks;
+}
+
+static void
+_edi_search_replace_preview_result_cb(void *data, const char *path, Eina_List *hunks)
+{
+   Edi_Search_Replace *replace = data;
+   Edi_Search_Replace_File *file;
+
+   file = malloc(sizeof(Edi_Search_Replace_File));
+   file->path = strdup(path);
+   file->hunks = hunks;
+   file->apply = EINA_TRUE;
+
+   if (!ecore_thread_feedback(replace->thread, file))
+     edi_search_replace_file_free(file);
+}
+
+static void
+_edi_search_replace_preview_run_cb(void *data, Ecore_Thread *thread)
+{
+   Edi_Search_Replace *replace = data;
+   Edi_Search *search;
+   Eina_List *files = NULL;
+
+   search = edi_search_add(thread, _edi_search_replace_preview_file_cb,
+                           _edi_search_replace_preview_result_cb, replace);
+   edi_search_free_cb_set(search, _edi_search_replace_hunks_free);
+
+   if (edi_search_index_candidates_get(replace->search, &files))
+     edi_search_files_run(search, files);
+   else
+     edi_search_project_run(search, edi_project_get());
+
+   edi_search_free(search);
+}
+
+static void
+_edi_search_replace_preview_feedback_cb(void *data, Ecore_Thread *thread, void *msg)
+{
+   Edi_Search_Replace *replace = data;
+   Edi_Search_Replace_File *file = msg;
+
+   if (ecore_thread_check(thread))
+     {
+        edi_search_replace_file_free(file);
+        return;
+     }
+
+   replace->file_count++;
+   replace->hunk_count += eina_list_count(file->hunks);
+   replace->file_cb(replace->data, file);
+}
+
+static void
+_edi_search_replace_end_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Search_Replace *replace = data;
+
+   if (replace->done_cb)
+     replace->done_cb(replace->data, replace->file_count, replace->hunk_count);
+
+   _edi_search_replace_free(replace);
+}
+
+static void
+_edi_search_replace_cancel_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   _edi_search_replace_free(data);
+}
+
+Edi_Search_Replace *
+edi_search_replace_preview(const char *search, const char *replace_text,
+                           Edi_Search_Replace_File_Cb file_cb,
+                           Edi_Search_Replace_Done_Cb done_cb, const void *data)
+{
+   Edi_Search_Replace *replace;
+   Edi_Search_Scanner *scanner;
+
+   scanner = edi_search_scanner_new(search);
+   if (!scanner)
+     return NULL;
+
+   replace = calloc(1, sizeof(Edi_Search_Replace));
+   replace->search = strdup(search);
+   replace->replace = strdup(replace_text);
+   replace->search_len = strlen(search);
+   replace->scanner = scanner;
+   replace->file_cb = file_cb;
+   replace->done_cb = done_cb;
+   replace->data = (void *) data;
+   eina_lock_new(&replace->lock);
+
+   replace->thread = ecore_thread_feedback_run(_edi_search_replace_preview_run_cb,
+                                               _edi_search_replace_preview_feedback_cb,
+                                               _edi_search_replace_end_cb,
+                                               _edi_search_replace_cancel_cb,
+                                               replace, EINA_FALSE);
+   return replace;
+}
+
+/* Every previewed line must still be exactly as it was when it was found. */
+static Eina_Bool
+_edi_search_replace_file_check(const Edi_Search_Replace_File *file, const char *map, size_t len)
+{
+   const Edi_Search_Replace_Hunk *hunk;
+   const Eina_List *item;
+   size_t length;
+
+   EINA_LIST_FOREACH(file->hunks, item, hunk)
+     {
+        length = strlen(hunk->before);
+        if (hunk->offset + length > len || memcmp(map + hunk->offset, hunk->before, length))
+          return EINA_FALSE;
+        if (hunk->offset + length < len && map[hunk->offset + length] != '\n')
+          return EINA_FALSE;
+     }
+
+   return EINA_TRUE;
+}
+
+/* The entries are numbered in the order they are added, the next one follows the index. */
+static unsigned int
+_edi_search_replace_journal_count(const char *journal)
+{
+   char *path, buf[PATH_MAX + 32];
+   FILE *f;
+   unsigned int count = 0;
+
+   path = edi_path_append(journal, EDI_SEARCH_REPLACE_JOURNAL_FILES);
+   f = fopen(path, "r");
+   free(path);
+   if (!f)
+     return 0;
+
+   while (fgets(buf, sizeof(buf), f))
+     {
+        if (strchr(buf, '\n'))
+          count++;
+     }
+   fclose(f);
+
+   return count;
+}
+
+static Eina_Bool
+_edi_search_replace_journal_write(const char *journal, unsigned int number, const char *kind,
+                                  const char *path, const char *data, size_t len)
+{
+   char name[16], *backup;
+   FILE *f;
+   Eina_Bool ok;
+
+   snprintf(name, sizeof(name), "%u", number);
+   backup = edi_path_append(journal, name);
+   f = fopen(backup, "wb");
+   free(backup);
+   if (!f)
+     return EINA_FALSE;
+
+   ok = fwrite(data, 1, len, f) == len;
+   if (fclose(f))
+     ok = EINA_FALSE;
+   if (!ok)
+     return EINA_FALSE;
+
+   backup = edi_path_append(journal, EDI_SEARCH_REPLACE_JOURNAL_FILES);
+   f = fopen(backup, "a");
+   free(backup);
+   if (!f)
+     return EINA_FALSE;
+
+   fprintf(f, "%s %s %s\n", name, kind, path);
+   return !fclose(f);
+}
+
+/* A file entry also records what was written, so undo can tell if the file changed since. */
+static Eina_Bool
+_edi_search_replace_journal_add(Edi_Search_Replace *replace, const char *path,
+                                const char *map, size_t len, const Eina_Strbuf *written)
+{
+   char kind[64];
+
+   snprintf(kind, sizeof(kind), "%s %zu %08x", EDI_SEARCH_REPLACE_JOURNAL_FILE,
+            eina_strbuf_length_get(written),
+            (unsigned int) eina_hash_superfast(eina_strbuf_string_get(written),
+                                               eina_strbuf_length_get(written)));
+   return _edi_search_replace_journal_write(replace->journal, replace->journal_count++,
+                                            kind, path, map, len);
+}
+
+Eina_Bool
+edi_search_replace_journal_reset(const char *journal)
+{
+   ecore_file_recursive_rm(journal);
+   if (!ecore_file_mkpath(journal))
+     {
+        ERR("Unable to create the replace journal %s", journal);
+        return EINA_FALSE;
+     }
+
+   return EINA_TRUE;
+}
+
+Eina_Bool
+edi_search_replace_journal_buffer_add(const char *journal, const Edi_Search_Replace_File *file)
+{
+   const Edi_Search_Replace_Hunk *hunk;
+   const Eina_List *item;
+   Eina_Strbuf *buf;
+   Eina_Bool ok;
+
+   buf = eina_strbuf_new();
+   EINA_LIST_FOREACH(file->hunks, item, hunk)
+     {
+        if (hunk->apply)
+          eina_strbuf_append_printf(buf, "%u\n%s\n%s\n", hunk->line, hunk->before, hunk->after);
+     }
+
+   ok = _edi_search_replace_journal_write(journal, _edi_search_replace_journal_count(journal),
+                                          EDI_SEARCH_REPLACE_JOURNAL_BUFFER, file->path,
+                                          eina_strbuf_string_get(buf), eina_strbuf_length_get(buf));
+   eina_strbuf_free(buf);
+
+   if (!ok)
+     ERR("Unable to record %s in the replace journal", file->path);
+   return ok;
+}
+
+static void
+_edi_search_replace_apply_file(Edi_Search_Replace *replace, Edi_Search_Replace_File *file)
+{
+   Edi_Search_Replace_Hunk *hunk;
+   Eina_List *item;
+   Eina_File *f;
+   Eina_Strbuf *buf = NULL;
+   const char *map, *pos;
+   char *temppath;
+   size_t len;
+   unsigned int count = 0;
+   Eina_Bool ok;
+   int fd;
+
+   EINA_LIST_FOREACH(file->hunks, item, hunk)
+     {
+        if (hunk->apply)
+          count++;
+     }
+   if (!file->apply || !count)
+     return;
+
+   f = eina_file_open(file->path, EINA_FALSE);
+   if (!f)
+     return;
+
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   len = eina_file_size_get(f);
+   if (!map || !_edi_search_replace_file_check(file, map, len))
+     {
+        WRN("Not replacing in %s as it changed since the preview", file->path);
+        goto done;
+     }
+
+   buf = eina_strbuf_new();
+   pos = map;
+   EINA_LIST_FOREACH(file->hunks, item, hunk)
+     {
+        if (!hunk->apply)
+          continue;
+
+        eina_strbuf_append_length(buf, pos, (map + hunk->offset) - pos);
+        eina_strbuf_append(buf, hunk->after);
+        pos = map + hunk->offset + strlen(hunk->before);
+     }
+   eina_strbuf_append_length(buf, pos, (map + len) - pos);
+
+   eina_lock_take(&replace->lock);
+   ok = _edi_search_replace_journal_add(replace, file->path, map, len, buf);
+   eina_lock_release(&replace->lock);
+   if (!ok)
+     {
+        ERR("Unable to record %s in the replace journal", file->path);
+        goto done;
+     }
+
+   fd = edi_file_atomic_open(file->path, &temppath);
+   if (fd < 0)
+     goto done;
+
+   ok = edi_file_write_all(fd, eina_strbuf_string_get(buf), eina_strbuf_length_get(buf));
+   if (edi_file_atomic_close(fd, temppath, file->path, ok))
+     {
+        eina_lock_take(&replace->lock);
+        replace->file_count++;
+        replace->hunk_count += count;
+        eina_lock_release(&replace->lock);
+     }
+
+done:
+   if (buf)
+     eina_strbuf_free(buf);
+   if (map)
+     eina_file_map_free(f, (void *) map);
+   eina_file_close(f);
+}
+
+/* Files are written by the search workers, nothing is handed back for them. */
+static Eina_List *
+_edi_search_replace_apply_file_cb(const char *path, void *data)
+{
+   Edi_Search_Replace *replace = data;
+   Edi_Search_Replace_File *file;
+
+   file = eina_hash_find(replace->paths, path);
+   if (file)
+     _edi_search_replace_apply_file(replace, file);
+
+   return NULL;
+}
+
+static void
+_edi_search_replace_apply_run_cb(void *data, Ecore_Thread *thread)
+{
+   Edi_Search_Replace *replace = data;
+   Edi_Search_Replace_File *file;
+   Edi_Search *search;
+   Eina_List *item, *paths = NULL;
+
+   if (!ecore_file_is_dir(replace->journal))
+     {
+        ERR("The replace journal %s has not been created", replace->journal);
+        return;
+     }
+
+   replace->journal_count = _edi_search_replace_journal_count(replace->journal);
+   replace->paths = eina_hash_string_superfast_new(NULL);
+   EINA_LIST_FOREACH(replace->files, item, file)
+     {
+        if (!file->apply || eina_hash_find(replace->paths, file->path))
+          continue;
+
+        eina_hash_add(replace->paths, file->path, file);
+        paths = eina_list_append(paths, strdup(file->path));
+     }
+
+   search = edi_search_add(thread, _edi_search_replace_apply_file_cb, NULL, replace);
+   edi_search_files_run(search, paths);
+   edi_search_free(search);
+}
+
+Edi_Search_Replace *
+edi_search_replace_apply(Eina_List *files, const char *journal,
+                         Edi_Search_Replace_Done_Cb done_cb, const void *data)
+{
+   Edi_Search_Replace *replace;
+
+   replace = calloc(1, sizeof(Edi_Search_Replace));
+   replace->files = files;
+   replace->journal = strdup(journal);
+   replace->done_cb = done_cb;
+   replace->data = (void *) data;
+   eina_lock_new(&replace->lock);
+
+   replace->thread = ecore_thread_run(_edi_search_replace_apply_run_cb,
+                                      _edi_search_replace_end_cb,
+                                      _edi_search_replace_cancel_cb, replace);
+   return replace;
+}
+
+void
+edi_search_replace_cancel(Edi_Search_Replace *replace)
+{
+   if (!replace)
+     return;
+
+   ecore_thread_cancel(replace->thread);
+}
+
+// A byte that continues a UTF-8 character rather than starting one
+#define EDI_SEARCH_REPLACE_UTF8_CONTINUATION(c) (((unsigned char) (c) & 0xc0) == 0x80)
+
+void
+edi_search_replace_line_diff(const char *before, size_t before_length, const char *after,
+                             size_t after_length, size_t *prefix, size_t *suffix)
+{
+   size_t start = 0, end = 0;
+
+   while (start < before_length && start < after_length && before[start] == after[start])
+     start++;
+   while (start && ((start < before_length && EDI_SEARCH_REPLACE_UTF8_CONTINUATION(before[start])) ||
+                    (start < after_length && EDI_SEARCH_REPLACE_UTF8_CONTINUATION(after[start]))))
+     start--;
+
+   while (end < before_length - start && end < after_length - start &&
+          before[before_length - end - 1] == after[after_length - end - 1])
+     end++;
+   while (end && EDI_SEARCH_REPLACE_UTF8_CONTINUATION(before[before_length - end]))
+     end--;
+
+   *prefix = start;
+   *suffix = end;
+}
+
+Eina_Bool
+edi_search_replace_undo_available(const char *journal)
+{
+   char *path;
+   Eina_Bool available;
+
+   path = edi_path_append(journal, EDI_SEARCH_REPLACE_JOURNAL_FILES);
+   available = ecore_file_exists(path);
+   free(path);
+
+   return available;
+}
+
+/* The file must still hold exactly what the replace wrote, anything else was changed since. */
+static Eina_Bool
+_edi_search_replace_undo_file_check(const char *path, size_t size, unsigned int hash)
+{
+   Eina_File *f;
+   const char *map;
+   Eina_Bool ok = EINA_FALSE;
+
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return EINA_FALSE;
+
+   if (eina_file_size_get(f) == size)
+     {
+        if (!size)
+          ok = EINA_TRUE;
+        else if ((map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL)))
+          {
+             ok = (unsigned int) eina_hash_superfast(map, size) == hash;
+             eina_file_map_free(f, (void *) map);
+          }
+     }
+
+   eina_file_close(f);
+   return ok;
+}
+
+static Eina_Bool
+_edi_search_replace_undo_file(const char *journal, const char *name, const char *entry)
+{
+   Eina_File *f;
+   const char *map, *path;
+   char *backup, *temppath, *end;
+   size_t len, size;
+   unsigned int hash;
+   Eina_Bool ok = EINA_FALSE;
+   int fd;
+
+   size = strtoul(entry, &end, 10);
+   if (end == entry || *end != ' ')
+     return EINA_FALSE;
+   entry = end + 1;
+   hash = strtoul(entry, &end, 16);
+   if (end == entry || *end != ' ')
+     return EINA_FALSE;
+   path = end + 1;
+
+   if (!_edi_search_replace_undo_file_check(path, size, hash))
+     {
+        WRN("Not restoring %s as it changed since the replace", path);
+        return EINA_FALSE;
+     }
+
+   backup = edi_path_append(journal, name);
+   f = eina_file_open(backup, EINA_FALSE);
+   free(backup);
+   if (!f)
+     return EINA_FALSE;
+
+   len = eina_file_size_get(f);
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (map || !len)
+     {
+        fd = edi_file_atomic_open(path, &temppath);
+        if (fd >= 0)
+          ok = edi_file_atomic_close(fd, temppath, path, edi_file_write_all(fd, map, len));
+     }
+
+   if (map)
+     eina_file_map_free(f, (void *) map);
+   eina_file_close(f);
+   return ok;
+}
+
+/* Read back the lines recorded by edi_search_replace_journal_buffer_add(). */
+static Eina_List *
+_edi_search_replace_undo_hunks_get(const char *journal, const char *name)
+{
+   Edi_Search_Replace_Hunk *hunk;
+   Eina_List *hunks = NULL;
+   Eina_File *f;
+   const char *map, *end, *pos, *fields[3];
+   char *backup;
+   unsigned int i;
+
+   backup = edi_path_append(journal, name);
+   f = eina_file_open(backup, EINA_FALSE);
+   free(backup);
+   if (!f)
+     return NULL;
+
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (!map)
+     {
+        eina_file_close(f);
+        return NULL;
+     }
+
+   pos = map;
+   end = map + eina_file_size_get(f);
+   while (pos < end)
+     {
+        for (i = 0; i < 3; i++)
+          {
+             fields[i] = pos;
+             pos = memchr(pos, '\n', end - pos);
+             if (!pos)
+               break;
+             pos++;
+          }
+        if (i < 3)
+          break;
+
+        hunk = calloc(1, sizeof(Edi_Search_Replace_Hunk));
+        hunk->line = strtoul(fields[0], NULL, 10);
+        hunk->before = strndup(fields[1], fields[2] - fields[1] - 1);
+        hunk->after = strndup(fields[2], pos - fields[2] - 1);
+        hunk->apply = EINA_TRUE;
+        hunks = eina_list_append(hunks, hunk);
+     }
+
+   eina_file_map_free(f, (void *) map);
+   eina_file_close(f);
+   return hunks;
+}
+
+/* Put the lines of a file that is not open back on disk, only if they all still hold the replaced text. */
+static Eina_Bool
+_edi_search_replace_undo_lines(const char *path, Eina_List *hunks)
+{
+   Edi_Search_Replace_Hunk *hunk;
+   Eina_List *item;
+   Eina_File *f;
+   Eina_Strbuf *buf;
+   const char *map, *end, *line, *line_end;
+   char *temppath;
+   unsigned int number = 1;
+   size_t len;
+   Eina_Bool ok = EINA_TRUE;
+   int fd;
+
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return EINA_FALSE;
+
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (!map)
+     {
+        eina_file_close(f);
+        return EINA_FALSE;
+     }
+
+   buf = eina_strbuf_new();
+   end = map + eina_file_size_get(f);
+   line = map;
+   item = hunks;
+   while (ok && item && line < end)
+     {
+        line_end = memchr(line, '\n', end - line);
+        if (!line_end)
+          line_end = end;
+
+        hunk = eina_list_data_get(item);
+        if (hunk->line == number)
+          {
+             len = strlen(hunk->after);
+             ok = (size_t)(line_end - line) == len && !memcmp(line, hunk->after, len);
+             eina_strbuf_append(buf, hunk->before);
+             eina_strbuf_append_length(buf, line_end, line_end < end ? 1 : 0);
+             item = eina_list_next(item);
+          }
+        else
+          eina_strbuf_append_length(buf, line, line_end - line + (line_end < end ? 1 : 0));
+
+        line = line_end + 1;
+        number++;
+     }
+
+   if (ok && !item)
+     {
+        if (line < end)
+          eina_strbuf_append_length(buf, line, end - line);
+
+        fd = edi_file_atomic_open(path, &temppath);
+        ok = fd >= 0 &&
+             edi_file_atomic_close(fd, temppath, path,
+                                   edi_file_write_all(fd, eina_strbuf_string_get(buf),
+                                                      eina_strbuf_length_get(buf)));
+     }
+   else
+     ok = EINA_FALSE;
+
+   eina_strbuf_free(buf);
+   eina_file_map_free(f, (void *) map);
+   eina_file_close(f);
+   return ok;
+}
+
+static int
+_edi_search_replace_hunk_line_cmp(const void *a, const void *b)
+{
+   const Edi_Search_Replace_Hunk *hunk_a = a, *hunk_b = b;
+
+   return (int) hunk_a->line - (int) hunk_b->line;
+}
+
+static void *
+_edi_search_replace_undo_buffer_call(void *data)
+{
+   Edi_Search_Replace_Undo_Buffer *call = data;
+   Edi_Search_Replace *replace = call->replace;
+
+   call->open = replace->buffer_cb(replace->data, call->path, call->hunks);
+   return NULL;
+}
+
+static Eina_Bool
+_edi_search_replace_undo_buffer(Edi_Search_Replace *replace, const char *name, const char *path)
+{
+   Edi_Search_Replace_Undo_Buffer call;
+   Edi_Search_Replace_Hunk *hunk;
+   Eina_List *hunks, *item;
+   Eina_Bool ok;
+
+   hunks = _edi_search_replace_undo_hunks_get(replace->journal, name);
+   if (!hunks)
+     return EINA_FALSE;
+
+   call.replace = replace;
+   call.path = path;
+   call.hunks = hunks;
+   call.open = EINA_FALSE;
+   // Editors can only be changed from the main loop, wait there for the answer
+   if (replace->buffer_cb)
+     ecore_main_loop_thread_safe_call_sync(_edi_search_replace_undo_buffer_call, &call);
+
+   if (call.open)
+     {
+        ok = EINA_TRUE;
+        EINA_LIST_FOREACH(hunks, item, hunk)
+          {
+             if (!hunk->apply)
+               ok = EINA_FALSE;
+          }
+     }
+   else
+     {
+        hunks = eina_list_sort(hunks, 0, _edi_search_replace_hunk_line_cmp);
+        ok = _edi_search_replace_undo_lines(path, hunks);
+     }
+
+   _edi_search_replace_hunks_free(hunks);
+   return ok;
+}
+
+static void
+_edi_search_replace_undo_run_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Search_Replace *replace = data;
+   char *path, *kind, *sep, buf[PATH_MAX + 32];
+   FILE *f;
+   size_t len;
+   Eina_Bool ok;
+
+   path = edi_path_append(replace->journal, EDI_SEARCH_REPLACE_JOURNAL_FILES);
+   f = fopen(path, "r");
+   free(path);
+   if (!f)
+     return;
+
+   while (fgets(buf, sizeof(buf), f))
+     {
+        len = strlen(buf);
+        if (len && buf[len - 1] == '\n')
+          buf[len - 1] = '\0';
+
+        kind = strchr(buf, ' ');
+        if (!kind)
+          continue;
+        *kind++ = '\0';
+        sep = strchr(kind, ' ');
+        if (!sep)
+          continue;
+        *sep = '\0';
+
+        if (!strcmp(kind, EDI_SEARCH_REPLACE_JOURNAL_BUFFER))
+          ok = _edi_search_replace_undo_buffer(replace, buf, sep + 1);
+        else
+          ok = _edi_search_replace_undo_file(replace->journal, buf, sep + 1);
+
+        if (ok)
+          replace->file_count++;
+        else
+          {
+             WRN("Unable to restore entry %s from the replace journal", buf);
+             replace->skip_count++;
+          }
+     }
+   fclose(f);
+
+   ecore_file_recursive_rm(replace->journal);
+}
+
+static void
+_edi_search_replace_undo_end_cb(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Edi_Search_Replace *replace = data;
+
+   if (replace->undo_cb)
+     replace->undo_cb(replace->data, replace->file_count, replace->skip_count);
+
+   _edi_search_replace_free(replace);
+}
+
+Edi_Search_Replace *
+edi_search_replace_undo(const char *journal, Edi_Search_Replace_Buffer_Cb buffer_cb,
+                        Edi_Search_Replace_Undo_Cb undo_cb, const void *data)
+{
+   Edi_Search_Replace *replace;
+
+   replace = calloc(1, sizeof(Edi_Search_Replace));
+   replace->journal = strdup(journal);
+   replace->buffer_cb = buffer_cb;
+   replace->undo_cb = undo_cb;
+   replace->data = (void *) data;
+   eina_lock_new(&replace->lock);
+
+   replace->thread = ecore_thread_run(_edi_search_replace_undo_run_cb,
+                                      _edi_search_replace_undo_end_cb,
+                                      _edi_search_replace_cancel_cb, replace);
+   return replace;
+}
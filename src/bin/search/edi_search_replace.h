@@ -0,0 +1,220 @@
+#ifndef EDI_SEARCH_REPLACE_H_
+# define EDI_SEARCH_REPLACE_H_
+
+#include <Eina.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief These routines are used for previewing, applying and undoing a project replace.
+ */
+
+/**
+ * @typedef Edi_Search_Replace
+ * A handle for a preview or apply running in the background.
+ */
+typedef struct _Edi_Search_Replace Edi_Search_Replace;
+
+/**
+ * @typedef Edi_Search_Replace_Hunk
+ * A single line that will change.
+ */
+typedef struct _Edi_Search_Replace_Hunk
+{
+   unsigned int line; /**< The line number, starting at 1 */
+   size_t offset; /**< The byte offset of the start of the line within the file */
+   char *before; /**< The current content of the line, without the newline */
+   char *after; /**< The content of the line once every occurrence is replaced */
+   Eina_Bool apply; /**< Whether or not this line should be changed */
+} Edi_Search_Replace_Hunk;
+
+/**
+ * @typedef Edi_Search_Replace_File
+ * A file that will change and the lines within it.
+ */
+typedef struct _Edi_Search_Replace_File
+{
+   char *path; /**< The full path of the file */
+   Eina_List *hunks; /**< The Edi_Search_Replace_Hunk list, in file order */
+   Eina_Bool apply; /**< Whether or not this file should be changed at all */
+} Edi_Search_Replace_File;
+
+/**
+ * Receive a file from a preview, called in the main loop.
+ *
+ * @param data The data passed to edi_search_replace_preview().
+ * @param file The planned changes, owned by the receiver.
+ */
+typedef void (*Edi_Search_Replace_File_Cb)(void *data, Edi_Search_Replace_File *file);
+
+/**
+ * Called in the main loop when a preview or apply has finished.
+ * This is not called if the operation was cancelled.
+ *
+ * @param data The data passed when the operation was started.
+ * @param files The number of files found or changed.
+ * @param hunks The number of lines found or changed.
+ */
+typedef void (*Edi_Search_Replace_Done_Cb)(void *data, unsigned int files, unsigned int hunks);
+
+/**
+ * Put back lines of a file that were replaced in an editor, called in the main loop.
+ * Each hunk holds the line as it was replaced, the after content is to be
+ * changed back to before. A line that cannot be found has its apply set to EINA_FALSE.
+ *
+ * @param data The data passed to edi_search_replace_undo().
+ * @param path The full path of the file.
+ * @param hunks The Edi_Search_Replace_Hunk list that was replaced.
+ * @return EINA_FALSE if the file is not open, the lines are then put back on disk.
+ */
+typedef Eina_Bool (*Edi_Search_Replace_Buffer_Cb)(void *data, const char *path, Eina_List *hunks);
+
+/**
+ * Called in the main loop when an undo has finished.
+ *
+ * @param data The data passed to edi_search_replace_undo().
+ * @param restored The number of files put back.
+ * @param skipped The number of files that could not be put back.
+ */
+typedef void (*Edi_Search_Replace_Undo_Cb)(void *data, unsigned int restored, unsigned int skipped);
+
+/**
+ * @brief Project replace functions.
+ * @defgroup Replace
+ *
+ * @{
+ *
+ * A project wide replace is planned first, producing the changed lines of
+ * each file as they are found so they can be reviewed. Only the lines left
+ * selected are then written. The original content of every file that is
+ * written, and the lines changed in files open in an editor, are kept in a
+ * journal so the whole replace can be undone at once.
+ *
+ */
+
+/**
+ * Find every line in the project that a replace would change.
+ *
+ * @param search The text to be replaced.
+ * @param replace The text that will replace it.
+ * @param file_cb The function that receives each file with changes.
+ * @param done_cb The function called once every file has been checked.
+ * @param data User data passed to the callbacks.
+ * @return A handle that can be cancelled until done_cb is called, or NULL on failure.
+ *
+ * @ingroup Replace
+ */
+Edi_Search_Replace *edi_search_replace_preview(const char *search, const char *replace,
+                                               Edi_Search_Replace_File_Cb file_cb,
+                                               Edi_Search_Replace_Done_Cb done_cb, const void *data);
+
+/**
+ * Write the selected lines of a preview, spreading the files over the search
+ * workers. A file that has changed since it was previewed is left alone.
+ *
+ * @param files The list of Edi_Search_Replace_File to apply, this takes ownership.
+ * @param journal The directory to keep the original files in, set up by edi_search_replace_journal_reset().
+ * @param done_cb The function called once every file has been written.
+ * @param data User data passed to the callback.
+ * @return A handle that can be cancelled until done_cb is called.
+ *
+ * @ingroup Replace
+ */
+Edi_Search_Replace *edi_search_replace_apply(Eina_List *files, const char *journal,
+                                             Edi_Search_Replace_Done_Cb done_cb, const void *data);
+
+/**
+ * Start a new journal for a replace, dropping what an earlier replace recorded.
+ *
+ * @param journal The journal directory.
+ * @return EINA_FALSE if the journal could not be created.
+ *
+ * @ingroup Replace
+ */
+Eina_Bool edi_search_replace_journal_reset(const char *journal);
+
+/**
+ * Record the lines of a file that were replaced in an editor rather than on disk.
+ *
+ * @param journal The journal directory.
+ * @param file The file whose hunks to record, those with apply set and the line they were found at.
+ * @return EINA_FALSE if the lines could not be recorded.
+ *
+ * @ingroup Replace
+ */
+Eina_Bool edi_search_replace_journal_buffer_add(const char *journal, const Edi_Search_Replace_File *file);
+
+/**
+ * Stop a preview or apply, the callbacks will not be called again.
+ * Files already written by an apply stay written and are in the journal.
+ *
+ * @param replace The operation to cancel.
+ *
+ * @ingroup Replace
+ */
+void edi_search_replace_cancel(Edi_Search_Replace *replace);
+
+/**
+ * Free a file received from a preview.
+ *
+ * @param file The file to free.
+ *
+ * @ingroup Replace
+ */
+void edi_search_replace_file_free(Edi_Search_Replace_File *file);
+
+/**
+ * Find the part of a line that differs after a replace, so only that needs editing.
+ * Both ends fall between UTF-8 characters, never inside one.
+ *
+ * @param before The line before it was replaced.
+ * @param before_length The length of before in bytes.
+ * @param after The line after it was replaced.
+ * @param after_length The length of after in bytes.
+ * @param prefix Set to the number of bytes both lines start with.
+ * @param suffix Set to the number of bytes both lines end with, after the prefix.
+ *
+ * @ingroup Replace
+ */
+void edi_search_replace_line_diff(const char *before, size_t before_length, const char *after,
+                                  size_t after_length, size_t *prefix, size_t *suffix);
+
+/**
+ * Find if there is a replace that can be undone.
+ *
+ * @param journal The journal directory passed to edi_search_replace_apply().
+ * @return EINA_TRUE if the journal holds any files.
+ *
+ * @ingroup Replace
+ */
+Eina_Bool edi_search_replace_undo_available(const char *journal);
+
+/**
+ * Put back the original content of every file changed by the last replace
+ * and remove the journal, in the background. A file that no longer holds
+ * what the replace wrote has been changed since, it is skipped rather than
+ * losing those changes.
+ *
+ * @param journal The journal directory passed to edi_search_replace_apply().
+ * @param buffer_cb The function that puts back lines replaced in an editor, may be NULL.
+ * @param undo_cb The function called once every file has been restored.
+ * @param data User data passed to the callbacks.
+ * @return A handle that can be cancelled until undo_cb is called.
+ *
+ * @ingroup Replace
+ */
+Edi_Search_Replace *edi_search_replace_undo(const char *journal, Edi_Search_Replace_Buffer_Cb buffer_cb,
+                                            Edi_Search_Replace_Undo_Cb undo_cb, const void *data);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_SEARCH_REPLACE_H_ */
@@ -0,0 +1,265 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+
+#include <Eina.h>
+
+#include "edi_search_results.h"
+
+#include "edi_private.h"
+
+#define EDI_SEARCH_RESULTS_TEXT_MAX 1024
+#define EDI_SEARCH_RESULTS_COMPACT_MIN 4096
+
+struct _Edi_Search_Results
+{
+   Eina_Inarray *files;
+   Eina_Inarray *results;
+   Eina_Hash *paths;
+
+   /* The file that new results are added to */
+   unsigned int current;
+   /* Results left behind when a file was replaced */
+   unsigned int dead;
+
+   /* Rows are drawn a screen at a time, mostly from the same file */
+   Eina_File *cached;
+   unsigned int cached_file;
+};
+
+static void
+_edi_search_results_cache_drop(Edi_Search_Results *results)
+{
+   if (results->cached)
+     eina_file_close(results->cached);
+   results->cached = NULL;
+}
+
+Edi_Search_Results *
+edi_search_results_new(void)
+{
+   Edi_Search_Results *results;
+
+   results = calloc(1, sizeof(Edi_Search_Results));
+   results->files = eina_inarray_new(sizeof(Edi_Search_Result_File), 64);
+   results->results = eina_inarray_new(sizeof(Edi_Search_Result), 1024);
+   results->paths = eina_hash_stringshared_new(NULL);
+
+   return results;
+}
+
+void
+edi_search_results_clear(Edi_Search_Results *results)
+{
+   Edi_Search_Result_File *file;
+
+   _edi_search_results_cache_drop(results);
+
+   eina_hash_free_buckets(results->paths);
+   EINA_INARRAY_FOREACH(results->files, file)
+     eina_stringshare_del(file->path);
+
+   eina_inarray_flush(results->files);
+   eina_inarray_flush(results->results);
+   results->current = 0;
+   results->dead = 0;
+}
+
+void
+edi_search_results_free(Edi_Search_Results *results)
+{
+   if (!results)
+     return;
+
+   edi_search_results_clear(results);
+   eina_inarray_free(results->files);
+   eina_inarray_free(results->results);
+   eina_hash_free(results->paths);
+   free(results);
+}
+
+unsigned int
+edi_search_results_file_add(Edi_Search_Results *results, const char *path)
+{
+   Edi_Search_Result_File file;
+
+   file.path = eina_stringshare_add(path);
+   file.first = eina_inarray_count(results->results);
+   file.count = 0;
+
+   results->current = eina_inarray_push(results->files, &file);
+   eina_hash_add(results->paths, file.path, (void *)(uintptr_t) (results->current + 1));
+
+   return results->current;
+}
+
+int
+edi_search_results_file_find(const Edi_Search_Results *results, const char *path)
+{
+   Eina_Stringshare *shared;
+   uintptr_t found;
+
+   shared = eina_stringshare_add(path);
+   found = (uintptr_t) eina_hash_find(results->paths, shared);
+   eina_stringshare_del(shared);
+
+   return (int) found - 1;
+}
+
+void
+edi_search_results_file_reset(Edi_Search_Results *results, unsigned int file)
+{
+   Edi_Search_Result_File *record;
+
+   record = eina_inarray_nth(results->files, file);
+   if (!record)
+     return;
+
+   if (results->cached_file == file)
+     _edi_search_results_cache_drop(results);
+
+   /* The old results stay where they are until the store is compacted. */
+   results->dead += record->count;
+   record->first = eina_inarray_count(results->results);
+   record->count = 0;
+   results->current = file;
+}
+
+Eina_Bool
+edi_search_results_compact(Edi_Search_Results *results)
+{
+   Edi_Search_Result_File *file;
+   Eina_Inarray *compacted;
+   unsigned int index;
+
+   if (results->dead < EDI_SEARCH_RESULTS_COMPACT_MIN ||
+       results->dead < eina_inarray_count(results->results) / 2)
+     return EINA_FALSE;
+
+   compacted = eina_inarray_new(sizeof(Edi_Search_Result), 1024);
+   EINA_INARRAY_FOREACH(results->files, file)
+     {
+        index = eina_inarray_count(compacted);
+        if (file->count)
+          {
+             eina_inarray_grow(compacted, file->count);
+             memcpy(eina_inarray_nth(compacted, index),
+                    eina_inarray_nth(results->results, file->first),
+                    sizeof(Edi_Search_Result) * file->count);
+          }
+        file->first = index;
+     }
+
+   eina_inarray_free(results->results);
+   results->results = compacted;
+   results->dead = 0;
+
+   return EINA_TRUE;
+}
+
+unsigned int
+edi_search_results_add(Edi_Search_Results *results, unsigned int line,
+                       unsigned int col, size_t offset)
+{
+   Edi_Search_Result_File *file;
+   Edi_Search_Result result;
+
+   file = eina_inarray_nth(results->files, results->current);
+   if (!file)
+     return 0;
+   file->count++;
+
+   result.file = results->current;
+   result.line = line;
+   result.col = col;
+   result.offset = offset;
+
+   return eina_inarray_push(results->results, &result);
+}
+
+unsigned int
+edi_search_results_file_count(const Edi_Search_Results *results)
+{
+   return eina_inarray_count(results->files);
+}
+
+unsigned int
+edi_search_results_count(const Edi_Search_Results *results)
+{
+   return eina_inarray_count(results->results);
+}
+
+const Edi_Search_Result_File *
+edi_search_results_file_get(const Edi_Search_Results *results, unsigned int file)
+{
+   if (file >= eina_inarray_count(results->files))
+     return NULL;
+
+   return eina_inarray_nth(results->files, file);
+}
+
+const Edi_Search_Result *
+edi_search_results_get(const Edi_Search_Results *results, unsigned int index)
+{
+   if (index >= eina_inarray_count(results->results))
+     return NULL;
+
+   return eina_inarray_nth(results->results, index);
+}
+
+char *
+edi_search_results_text_get(Edi_Search_Results *results, unsigned int index,
+                            unsigned int *length)
+{
+   const Edi_Search_Result_File *file;
+   const Edi_Search_Result *result;
+   const char *map, *line, *end;
+   char *text;
+   size_t size;
+   unsigned int len;
+
+   result = edi_search_results_get(results, index);
+   if (!result)
+     return NULL;
+
+   if (!results->cached || results->cached_file != result->file)
+     {
+        _edi_search_results_cache_drop(results);
+
+        file = edi_search_results_file_get(results, result->file);
+        results->cached = eina_file_open(file->path, EINA_FALSE);
+        results->cached_file = result->file;
+        if (!results->cached)
+          return NULL;
+     }
+
+   size = eina_file_size_get(results->cached);
+   if (result->offset >= size)
+     return NULL;
+
+   map = eina_file_map_all(results->cached, EINA_FILE_RANDOM);
+   if (!map)
+     return NULL;
+
+   line = map + result->offset;
+   end = memchr(line, '\n', size - result->offset);
+   if (!end)
+     end = map + size;
+
+   len = end - line;
+   if (len && line[len - 1] == '\r')
+     len--;
+   if (len > EDI_SEARCH_RESULTS_TEXT_MAX)
+     len = EDI_SEARCH_RESULTS_TEXT_MAX;
+
+   text = malloc(len + 1);
+   memcpy(text, line, len);
+   text[len] = '\0';
+   eina_file_map_free(results->cached, (void *) map);
+
+   if (length)
+     *length = len;
+   return text;
+}
@@ -0,0 +1,207 @@
+#ifndef EDI_SEARCH_RESULTS_H_
+# define EDI_SEARCH_RESULTS_H_
+
+#include <Eina.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief These routines are used for storing the results of a project search.
+ */
+
+/**
+ * @typedef Edi_Search_Results
+ * A compact store of search results, grouped by file.
+ */
+typedef struct _Edi_Search_Results Edi_Search_Results;
+
+/**
+ * @typedef Edi_Search_Result
+ * A single match, the text of the line is read from the file when needed.
+ */
+typedef struct _Edi_Search_Result
+{
+   unsigned int file; /**< The index of the file containing the match */
+   unsigned int line; /**< The line number of the match, starting at 1 */
+   unsigned int col; /**< The column of the match within the line, starting at 1 */
+   size_t offset; /**< The byte offset of the start of the line within the file */
+} Edi_Search_Result;
+
+/**
+ * @typedef Edi_Search_Result_File
+ * A file with matches, its results are stored next to each other.
+ */
+typedef struct _Edi_Search_Result_File
+{
+   Eina_Stringshare *path; /**< The full path of the file */
+   unsigned int first; /**< The index of the first result in this file */
+   unsigned int count; /**< The number of results in this file */
+} Edi_Search_Result_File;
+
+/**
+ * @brief Search result storage functions.
+ * @defgroup Results
+ *
+ * @{
+ *
+ * Results are kept as small fixed size records in arrays rather than as
+ * rendered strings, so very large result sets stay cheap. Each file's
+ * results must be added together, directly after the file is added or reset.
+ *
+ */
+
+/**
+ * Create an empty result store.
+ *
+ * @return A new store that must be freed with edi_search_results_free().
+ *
+ * @ingroup Results
+ */
+Edi_Search_Results *edi_search_results_new(void);
+
+/**
+ * Free a result store.
+ *
+ * @param results The store to free.
+ *
+ * @ingroup Results
+ */
+void edi_search_results_free(Edi_Search_Results *results);
+
+/**
+ * Remove all files and results from a store.
+ *
+ * @param results The store to clear.
+ *
+ * @ingroup Results
+ */
+void edi_search_results_clear(Edi_Search_Results *results);
+
+/**
+ * Add a file to the store, the results that follow belong to it.
+ *
+ * @param results The store to add to.
+ * @param path The full path of the file.
+ * @return The index of the new file.
+ *
+ * @ingroup Results
+ */
+unsigned int edi_search_results_file_add(Edi_Search_Results *results, const char *path);
+
+/**
+ * Find the file in a store for a path.
+ *
+ * @param results The store to query.
+ * @param path The full path of the file.
+ * @return The index of the file or -1 if it is not in the store.
+ *
+ * @ingroup Results
+ */
+int edi_search_results_file_find(const Edi_Search_Results *results, const char *path);
+
+/**
+ * Drop the results of a file so new ones can be added for it.
+ * The file keeps its index and place amongst the other files.
+ *
+ * @param results The store to update.
+ * @param file The index of the file.
+ *
+ * @ingroup Results
+ */
+void edi_search_results_file_reset(Edi_Search_Results *results, unsigned int file);
+
+/**
+ * Reclaim the space of results dropped by edi_search_results_file_reset(),
+ * if there is enough of it to be worth moving the remaining results.
+ *
+ * @param results The store to compact.
+ * @return EINA_TRUE if results moved and any result indices held must be looked up again.
+ *
+ * @ingroup Results
+ */
+Eina_Bool edi_search_results_compact(Edi_Search_Results *results);
+
+/**
+ * Add a result to the file most recently added or reset.
+ *
+ * @param results The store to add to.
+ * @param line The line number of the match.
+ * @param col The column of the match.
+ * @param offset The byte offset of the start of the line.
+ * @return The index of the new result.
+ *
+ * @ingroup Results
+ */
+unsigned int edi_search_results_add(Edi_Search_Results *results, unsigned int line,
+                                    unsigned int col, size_t offset);
+
+/**
+ * Get the number of files in a store.
+ *
+ * @param results The store to query.
+ * @return The number of files with results.
+ *
+ * @ingroup Results
+ */
+unsigned int edi_search_results_file_count(const Edi_Search_Results *results);
+
+/**
+ * Get the number of results in a store.
+ *
+ * @param results The store to query.
+ * @return The number of results over all files.
+ *
+ * @ingroup Results
+ */
+unsigned int edi_search_results_count(const Edi_Search_Results *results);
+
+/**
+ * Get a file from the store.
+ *
+ * @param results The store to query.
+ * @param file The index of the file.
+ * @return The file or NULL if the index is out of range.
+ *
+ * @ingroup Results
+ */
+const Edi_Search_Result_File *edi_search_results_file_get(const Edi_Search_Results *results,
+                                                          unsigned int file);
+
+/**
+ * Get a result from the store.
+ *
+ * @param results The store to query.
+ * @param index The index of the result.
+ * @return The result or NULL if the index is out of range.
+ *
+ * @ingroup Results
+ */
+const Edi_Search_Result *edi_search_results_get(const Edi_Search_Results *results,
+                                                unsigned int index);
+
+/**
+ * Read the text of the line containing a result from its file.
+ *
+ * @param results The store to query.
+ * @param index The index of the result.
+ * @param length Set to the length of the text returned.
+ * @return The text of the line, without the line ending, which must be freed,
+ *         or NULL if the line could not be read.
+ *
+ * @ingroup Results
+ */
+char *edi_search_results_text_get(Edi_Search_Results *results, unsigned int index,
+                                  unsigned int *length);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_SEARCH_RESULTS_H_ */
@@ -0,0 +1,438 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define EDI_SEARCH_SCANNER_X86 1
+# include <immintrin.h>
+#endif
+
+#include <Eina.h>
+
+#include "Edi.h"
+#include "edi_search_scanner.h"
+
+#include "edi_private.h"
+
+typedef const char *(*Edi_Search_Scanner_Find_Cb)(const char *text, size_t length,
+                                                  const char *needle, size_t needle_len);
+
+struct _Edi_Search_Scanner
+{
+   char *needle;
+   size_t length;
+
+   Edi_Search_Scanner_Find_Cb find;
+};
+
+static const char *
+_edi_search_scanner_find_scalar(const char *text, size_t length,
+                                const char *needle, size_t needle_len)
+{
+   const char *ptr, *last;
+
+   if (needle_len > length)
+     return NULL;
+
+   if (needle_len == 1)
+     return memchr(text, needle[0], length);
+
+   ptr = text;
+   last = text + length - needle_len;
+   while (ptr <= last)
+     {
+        ptr = memchr(ptr, needle[0], last - ptr + 1);
+        if (!ptr)
+          return NULL;
+        if (ptr[needle_len - 1] == needle[needle_len - 1] &&
+            !memcmp(ptr + 1, needle + 1, needle_len - 2))
+          return ptr;
+        ptr++;
+     }
+
+   return NULL;
+}
+
+static inline unsigned char
+_edi_search_scanner_fold(unsigned char c)
+{
+   if (c >= 'A' && c <= 'Z')
+     return c + ('a' - 'A');
+
+   return c;
+}
+
+/* The needle is already folded to lower case. */
+static Eina_Bool
+_edi_search_scanner_caseless_equal(const char *text, const char *needle, size_t length)
+{
+   size_t i;
+
+   for (i = 0; i < length; i++)
+     if (_edi_search_scanner_fold(text[i]) != (unsigned char) needle[i])
+       return EINA_FALSE;
+
+   return EINA_TRUE;
+}
+
+static const char *
+_edi_search_scanner_caseless_find_scalar(const char *text, size_t length,
+                                         const char *needle, size_t needle_len)
+{
+   const char *ptr, *last;
+   unsigned char first, final;
+
+   if (needle_len > length)
+     return NULL;
+
+   first = needle[0];
+   final = needle[needle_len - 1];
+   last = text + length - needle_len;
+   for (ptr = text; ptr <= last; ptr++)
+     {
+        if (_edi_search_scanner_fold(ptr[0]) == first &&
+            _edi_search_scanner_fold(ptr[needle_len - 1]) == final &&
+            _edi_search_scanner_caseless_equal(ptr + 1, needle + 1, needle_len - 1))
+          return ptr;
+     }
+
+   return NULL;
+}
+
+#ifdef EDI_SEARCH_SCANNER_X86
+/*
+ * Compare the first and last byte of the needle against 16 (or 32) candidate
+ * positions at once, only checking the middle of the needle where both agree.
+ */
+__attribute__((target("sse2")))
+static const char *
+_edi_search_scanner_find_sse2(const char *text, size_t length,
+                              const char *needle, size_t needle_len)
+{
+   __m128i first, last, block_first, block_last;
+   unsigned int mask, bit;
+   size_t i = 0;
+
+   if (needle_len < 2)
+     return _edi_search_scanner_find_scalar(text, length, needle, needle_len);
+
+   first = _mm_set1_epi8(needle[0]);
+   last = _mm_set1_epi8(needle[needle_len - 1]);
+
+   for (; i + needle_len - 1 + 16 <= length; i += 16)
+     {
+        block_first = _mm_loadu_si128((const __m128i *)(text + i));
+        block_last = _mm_loadu_si128((const __m128i *)(text + i + needle_len - 1));
+
+        mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+                                               _mm_cmpeq_epi8(last, block_last)));
+        while (mask)
+          {
+             bit = __builtin_ctz(mask);
+             if (!memcmp(text + i + bit + 1, needle + 1, needle_len - 2))
+               return text + i + bit;
+             mask &= mask - 1;
+          }
+     }
+
+   return _edi_search_scanner_find_scalar(text + i, length - i, needle, needle_len);
+}
+
+__attribute__((target("avx2")))
+static const char *
+_edi_search_scanner_find_avx2(const char *text, size_t length,
+                              const char *needle, size_t needle_len)
+{
+   __m256i first, last, block_first, block_last;
+   unsigned int mask, bit;
+   size_t i = 0;
+
+   if (needle_len < 2)
+     return _edi_search_scanner_find_scalar(text, length, needle, needle_len);
+
+   first = _mm256_set1_epi8(needle[0]);
+   last = _mm256_set1_epi8(needle[needle_len - 1]);
+
+   for (; i + needle_len - 1 + 32 <= length; i += 32)
+     {
+        block_first = _mm256_loadu_si256((const __m256i *)(text + i));
+        block_last = _mm256_loadu_si256((const __m256i *)(text + i + needle_len - 1));
+
+        mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+                                                     _mm256_cmpeq_epi8(last, block_last)));
+        while (mask)
+          {
+             bit = __builtin_ctz(mask);
+             if (!memcmp(text + i + bit + 1, needle + 1, needle_len - 2))
+               return text + i + bit;
+             mask &= mask - 1;
+          }
+     }
+
+   return _edi_search_scanner_find_sse2(text + i, length - i, needle, needle_len);
+}
+
+static inline unsigned char
+_edi_search_scanner_upper(unsigned char c)
+{
+   if (c >= 'a' && c <= 'z')
+     return c - ('a' - 'A');
+
+   return c;
+}
+
+/* As above but each end of the needle is compared against both of its cases. */
+__attribute__((target("sse2")))
+static const char *
+_edi_search_scanner_caseless_find_sse2(const char *text, size_t length,
+                                       const char *needle, size_t needle_len)
+{
+   __m128i first, first_up, last, last_up, block_first, block_last;
+   unsigned int mask, bit;
+   size_t i = 0;
+
+   if (needle_len < 2)
+     return _edi_search_scanner_caseless_find_scalar(text, length, needle, needle_len);
+
+   first = _mm_set1_epi8(needle[0]);
+   first_up = _mm_set1_epi8(_edi_search_scanner_upper(needle[0]));
+   last = _mm_set1_epi8(needle[needle_len - 1]);
+   last_up = _mm_set1_epi8(_edi_search_scanner_upper(needle[needle_len - 1]));
+
+   for (; i + needle_len - 1 + 16 <= length; i += 16)
+     {
+        block_first = _mm_loadu_si128((const __m128i *)(text + i));
+        block_last = _mm_loadu_si128((const __m128i *)(text + i + needle_len - 1));
+
+        mask = _mm_movemask_epi8(_mm_and_si128(_mm_or_si128(_mm_cmpeq_epi8(first, block_first),
+                                                            _mm_cmpeq_epi8(first_up, block_first)),
+                                               _mm_or_si128(_mm_cmpeq_epi8(last, block_last),
+                                                            _mm_cmpeq_epi8(last_up, block_last))));
+        while (mask)
+          {
+             bit = __builtin_ctz(mask);
+             if (_edi_search_scanner_caseless_equal(text + i + bit + 1, needle + 1, needle_len - 2))
+               return text + i + bit;
+             mask &= mask - 1;
+          }
+     }
+
+   return _edi_search_scanner_caseless_find_scalar(text + i, length - i, needle, needle_len);
+}
+
+__attribute__((target("avx2")))
+static const char *
+_edi_search_scanner_caseless_find_avx2(const char *text, size_t length,
+                                       const char *needle, size_t needle_len)
+{
+   __m256i first, first_up, last, last_up, block_first, block_last;
+   unsigned int mask, bit;
+   size_t i = 0;
+
+   if (needle_len < 2)
+     return _edi_search_scanner_caseless_find_scalar(text, length, needle, needle_len);
+
+   first = _mm256_set1_epi8(needle[0]);
+   first_up = _mm256_set1_epi8(_edi_search_scanner_upper(needle[0]));
+   last = _mm256_set1_epi8(needle[needle_len - 1]);
+   last_up = _mm256_set1_epi8(_edi_search_scanner_upper(needle[needle_len - 1]));
+
+   for (; i + needle_len - 1 + 32 <= length; i += 32)
+     {
+        block_first = _mm256_loadu_si256((const __m256i *)(text + i));
+        block_last = _mm256_loadu_si256((const __m256i *)(text + i + needle_len - 1));
+
+        mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_or_si256(_mm256_cmpeq_epi8(first, block_first),
+                                                                     _mm256_cmpeq_epi8(first_up, block_first)),
+                                                     _mm256_or_si256(_mm256_cmpeq_epi8(last, block_last),
+                                                                     _mm256_cmpeq_epi8(last_up, block_last))));
+        while (mask)
+          {
+             bit = __builtin_ctz(mask);
+             if (_edi_search_scanner_caseless_equal(text + i + bit + 1, needle + 1, needle_len - 2))
+               return text + i + bit;
+             mask &= mask - 1;
+          }
+     }
+
+   return _edi_search_scanner_caseless_find_sse2(text + i, length - i, needle, needle_len);
+}
+
+__attribute__((target("sse2")))
+static unsigned int
+_edi_search_scanner_lines_count_sse2(const char *text, size_t length)
+{
+   __m128i newline, block;
+   unsigned int count = 0;
+   size_t i = 0;
+
+   newline = _mm_set1_epi8('\n');
+   for (; i + 16 <= length; i += 16)
+     {
+        block = _mm_loadu_si128((const __m128i *)(text + i));
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(newline, block)));
+     }
+
+   for (; i < length; i++)
+     if (text[i] == '\n')
+       count++;
+
+   return count;
+}
+#endif
+
+unsigned int
+edi_search_scanner_lines_count(const char *text, size_t length)
+{
+   const char *ptr, *end;
+   unsigned int count = 0;
+
+#ifdef EDI_SEARCH_SCANNER_X86
+   if (__builtin_cpu_supports("sse2"))
+     return _edi_search_scanner_lines_count_sse2(text, length);
+#endif
+
+   ptr = text;
+   end = text + length;
+   while (ptr < end && (ptr = memchr(ptr, '\n', end - ptr)))
+     {
+        count++;
+        ptr++;
+     }
+
+   return count;
+}
+
+static Edi_Search_Scanner *
+_edi_search_scanner_add(const char *needle, Eina_Bool caseless)
+{
+   Edi_Search_Scanner *scanner;
+   size_t i;
+
+   if (!needle || !needle[0])
+     return NULL;
+
+   scanner = calloc(1, sizeof(Edi_Search_Scanner));
+   scanner->needle = strdup(needle);
+   scanner->length = strlen(needle);
+
+   if (caseless)
+     {
+        for (i = 0; i < scanner->length; i++)
+          scanner->needle[i] = _edi_search_scanner_fold(scanner->needle[i]);
+        scanner->find = _edi_search_scanner_caseless_find_scalar;
+     }
+   else
+     {
+        scanner->find = _edi_search_scanner_find_scalar;
+     }
+
+#ifdef EDI_SEARCH_SCANNER_X86
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+     scanner->find = caseless ? _edi_search_scanner_caseless_find_avx2 : _edi_search_scanner_find_avx2;
+   else if (__builtin_cpu_supports("sse2"))
+     scanner->find = caseless ? _edi_search_scanner_caseless_find_sse2 : _edi_search_scanner_find_sse2;
+#endif
+
+   return scanner;
+}
+
+Edi_Search_Scanner *
+edi_search_scanner_new(const char *needle)
+{
+   return _edi_search_scanner_add(needle, EINA_FALSE);
+}
+
+Edi_Search_Scanner *
+edi_search_scanner_caseless_new(const char *needle)
+{
+   return _edi_search_scanner_add(needle, EINA_TRUE);
+}
+
+void
+edi_search_scanner_free(Edi_Search_Scanner *scanner)
+{
+   if (!scanner)
+     return;
+
+   free(scanner->needle);
+   free(scanner);
+}
+
+const char *
+edi_search_scanner_find(const Edi_Search_Scanner *scanner, const char *text, size_t length)
+{
+   return scanner->find(text, length, scanner->needle, scanner->length);
+}
+
+unsigned int
+edi_search_scanner_scan(const Edi_Search_Scanner *scanner, const char *text, size_t length,
+                        Edi_Search_Scanner_Cb cb, void *data)
+{
+   const char *pos, *end, *hit, *counted, *line_start, *line_end;
+   unsigned int number = 1, found = 0, line_len;
+
+   pos = counted = text;
+   end = text + length;
+
+   while (pos < end && (hit = scanner->find(pos, end - pos, scanner->needle, scanner->length)))
+     {
+        number += edi_search_scanner_lines_count(counted, hit - counted);
+        counted = hit;
+
+        line_start = hit;
+        while (line_start > text && line_start[-1] != '\n')
+          line_start--;
+
+        line_end = memchr(hit, '\n', end - hit);
+        if (!line_end)
+          line_end = end;
+
+        line_len = line_end - line_start;
+        if (line_len && line_start[line_len - 1] == '\r')
+          line_len--;
+
+        found++;
+        if (!cb(data, line_start, line_len, number, hit - line_start + 1))
+          break;
+
+        pos = line_end + 1;
+     }
+
+   return found;
+}
+
+unsigned int
+edi_search_scanner_file_scan(const Edi_Search_Scanner *scanner, const char *path,
+                             Edi_Search_Scanner_Cb cb, void *data)
+{
+   Eina_File *f;
+   const char *map;
+   size_t length;
+   unsigned int found = 0;
+
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return 0;
+
+   length = eina_file_size_get(f);
+   if (length < scanner->length)
+     {
+        eina_file_close(f);
+        return 0;
+     }
+
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (map)
+     {
+        if (!edi_walker_binary_is(map, length))
+          found = edi_search_scanner_scan(scanner, map, length, cb, data);
+        eina_file_map_free(f, (void *) map);
+     }
+
+   eina_file_close(f);
+   return found;
+}
@@ -0,0 +1,135 @@
+#ifndef EDI_SEARCH_SCANNER_H_
+# define EDI_SEARCH_SCANNER_H_
+
+#include <Eina.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief These routines are used for finding text within mapped files.
+ */
+
+/**
+ * @typedef Edi_Search_Scanner
+ * A prepared literal search that can be shared between threads.
+ */
+typedef struct _Edi_Search_Scanner Edi_Search_Scanner;
+
+/**
+ * Receive a line that contains a match.
+ *
+ * @param data The data passed to the scan function.
+ * @param line The start of the line containing the match, not nul terminated.
+ * @param length The length of the line excluding line ending.
+ * @param number The line number, starting at 1.
+ * @param col The column of the first match within the line, starting at 1.
+ * @return EINA_TRUE to continue scanning, EINA_FALSE to stop.
+ */
+typedef Eina_Bool (*Edi_Search_Scanner_Cb)(void *data, const char *line, unsigned int length,
+                                           unsigned int number, unsigned int col);
+
+/**
+ * @brief Scanning functions.
+ * @defgroup Scanner
+ *
+ * @{
+ *
+ * Literal substring search over raw bytes. Candidate positions are found
+ * using a vectorised first and last byte filter where the CPU supports it
+ * and line numbers are only calculated around actual hits.
+ *
+ */
+
+/**
+ * Prepare a scanner for a literal search term.
+ *
+ * @param needle The text to search for.
+ * @return A new scanner or NULL if the needle was empty.
+ *
+ * @ingroup Scanner
+ */
+Edi_Search_Scanner *edi_search_scanner_new(const char *needle);
+
+/**
+ * Prepare a scanner that ignores the case of ASCII letters.
+ *
+ * @param needle The text to search for.
+ * @return A new scanner or NULL if the needle was empty.
+ *
+ * @ingroup Scanner
+ */
+Edi_Search_Scanner *edi_search_scanner_caseless_new(const char *needle);
+
+/**
+ * Free a scanner.
+ *
+ * @param scanner The scanner to free.
+ *
+ * @ingroup Scanner
+ */
+void edi_search_scanner_free(Edi_Search_Scanner *scanner);
+
+/**
+ * Find the first occurrence of the scanner term within a block of memory.
+ *
+ * @param scanner The scanner to use.
+ * @param text The memory to search.
+ * @param length The length of the memory to search.
+ * @return A pointer to the first match or NULL if there was none.
+ *
+ * @ingroup Scanner
+ */
+const char *edi_search_scanner_find(const Edi_Search_Scanner *scanner, const char *text, size_t length);
+
+/**
+ * Scan a block of memory reporting each line that contains a match.
+ *
+ * @param scanner The scanner to use.
+ * @param text The memory to search.
+ * @param length The length of the memory to search.
+ * @param cb The function called for each matching line.
+ * @param data User data passed to the callback.
+ * @return The number of matching lines reported.
+ *
+ * @ingroup Scanner
+ */
+unsigned int edi_search_scanner_scan(const Edi_Search_Scanner *scanner, const char *text, size_t length,
+                                     Edi_Search_Scanner_Cb cb, void *data);
+
+/**
+ * Map a file and scan it, reporting each line that contains a match.
+ *
+ * @param scanner The scanner to use.
+ * @param path The path of the file to scan.
+ * @param cb The function called for each matching line.
+ * @param data User data passed to the callback.
+ * @return The number of matching lines reported.
+ *
+ * @ingroup Scanner
+ */
+unsigned int edi_search_scanner_file_scan(const Edi_Search_Scanner *scanner, const char *path,
+                                          Edi_Search_Scanner_Cb cb, void *data);
+
+/**
+ * Count the line endings within a block of memory.
+ *
+ * @param text The memory to count within.
+ * @param length The length of the memory.
+ * @return The number of newline characters found.
+ *
+ * @ingroup Scanner
+ */
+unsigned int edi_search_scanner_lines_count(const char *text, size_t length);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_SEARCH_SCANNER_H_ */
@@ -0,0 +1,656 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include <Eina.h>
+#include <Ecore_File.h>
+
+#include "Edi.h"
+#include "edi_path.h"
+#include "edi_walker.h"
+
+#include "edi_private.h"
+
+/* The same amount git reads when deciding if a file is binary. */
+#define EDI_WALKER_SNIFF_SIZE 8000
+
+typedef enum _Edi_Walker_Rule_Type
+{
+   EDI_WALKER_RULE_LITERAL,
+   EDI_WALKER_RULE_SUFFIX,
+   EDI_WALKER_RULE_GLOB,
+} Edi_Walker_Rule_Type;
+
+typedef struct _Edi_Walker_Rule
+{
+   Edi_Walker_Rule_Type type;
+   char *pattern;
+   unsigned int length;
+
+   Eina_Bool negate;
+   Eina_Bool directory;
+   Eina_Bool anchored;
+} Edi_Walker_Rule;
+
+typedef struct _Edi_Walker_Rules
+{
+   Edi_Walker_Rule *rules;
+   unsigned int count, size;
+} Edi_Walker_Rules;
+
+struct _Edi_Walker
+{
+   char *root;
+   unsigned int root_length;
+   Edi_Build_Provider *provider;
+
+   Edi_Walker_Rules *excludes;
+   Eina_Hash *rules;
+   Eina_Hash *decisions;
+
+   Eina_Lock lock;
+};
+
+#define EDI_WALKER_DECISION_KEEP   ((void *) 1)
+#define EDI_WALKER_DECISION_IGNORE ((void *) 2)
+
+static Eina_Bool
+_edi_walker_class_match(const char **pattern, char c)
+{
+   const char *p = *pattern + 1;
+   Eina_Bool negate = EINA_FALSE, found = EINA_FALSE;
+   char first, last;
+
+   if (*p == '!' || *p == '^')
+     {
+        negate = EINA_TRUE;
+        p++;
+     }
+
+   /* A ] straight after the opening bracket is part of the class. */
+   if (*p == ']')
+     {
+        found = (c == ']');
+        p++;
+     }
+
+   while (*p && *p != ']')
+     {
+        if (*p == '\\' && p[1])
+          p++;
+        first = *p++;
+        last = first;
+        if (*p == '-' && p[1] && p[1] != ']')
+          {
+             p++;
+             if (*p == '\\' && p[1])
+               p++;
+             last = *p++;
+          }
+
+        if (c >= first && c <= last)
+          found = EINA_TRUE;
+     }
+
+   /* An unterminated class matches a literal [. */
+   if (!*p)
+     {
+        *pattern += 1;
+        return c == '[';
+     }
+
+   *pattern = p + 1;
+   return found != negate;
+}
+
+/* Match a gitignore glob where * and ? stop at a / and ** may cross directories. */
+static Eina_Bool
+_edi_walker_glob_match(const char *start, const char *pattern, const char *string)
+{
+   const char *p = pattern, *s = string;
+
+   while (*p)
+     {
+        if (p[0] == '*' && p[1] == '*' && (p == start || p[-1] == '/') &&
+            (p[2] == '/' || !p[2]))
+          {
+             if (!p[2])
+               return EINA_TRUE;
+
+             p += 3;
+             while (EINA_TRUE)
+               {
+                  if (_edi_walker_glob_match(start, p, s))
+                    return EINA_TRUE;
+                  s = strchr(s, '/');
+                  if (!s)
+                    return EINA_FALSE;
+                  s++;
+               }
+          }
+
+        switch (*p)
+          {
+           case '*':
+             while (*p == '*')
+               p++;
+             while (EINA_TRUE)
+               {
+                  if (_edi_walker_glob_match(start, p, s))
+                    return EINA_TRUE;
+                  if (!*s || *s == '/')
+                    return EINA_FALSE;
+                  s++;
+               }
+           case '?':
+             if (!*s || *s == '/')
+               return EINA_FALSE;
+             p++;
+             s++;
+             break;
+           case '[':
+             if (!*s || *s == '/' || !_edi_walker_class_match(&p, *s))
+               return EINA_FALSE;
+             s++;
+             break;
+           case '\\':
+             if (p[1])
+               p++;
+             /* fall through */
+           default:
+             if (*p != *s)
+               return EINA_FALSE;
+             p++;
+             s++;
+          }
+     }
+
+   return !*s;
+}
+
+static void
+_edi_walker_rule_add(Edi_Walker_Rules *rules, const char *line, unsigned int length)
+{
+   Edi_Walker_Rule *rule;
+   const char *wild;
+   char *pattern;
+
+   /* Trailing spaces are ignored unless escaped. */
+   while (length && (line[length - 1] == ' ' || line[length - 1] == '\t') &&
+          !(length > 1 && line[length - 2] == '\\'))
+     length--;
+
+   if (!length || line[0] == '#')
+     return;
+
+   if (rules->count == rules->size)
+     {
+        rules->size = rules->size ? rules->size * 2 : 16;
+        rules->rules = realloc(rules->rules, sizeof(Edi_Walker_Rule) * rules->size);
+     }
+   rule = &rules->rules[rules->count];
+   memset(rule, 0, sizeof(Edi_Walker_Rule));
+
+   if (line[0] == '!')
+     {
+        rule->negate = EINA_TRUE;
+        line++;
+        length--;
+     }
+   else if (line[0] == '\\' && length > 1 && (line[1] == '!' || line[1] == '#'))
+     {
+        line++;
+        length--;
+     }
+
+   if (length && line[length - 1] == '/')
+     {
+        rule->directory = EINA_TRUE;
+        length--;
+     }
+
+   /* Any other slash ties the pattern to the directory of the ignore file. */
+   if (memchr(line, '/', length))
+     rule->anchored = EINA_TRUE;
+   if (length && line[0] == '/')
+     {
+        line++;
+        length--;
+     }
+
+   if (!length)
+     return;
+
+   pattern = malloc(length + 1);
+   memcpy(pattern, line, length);
+   pattern[length] = '\0';
+
+   wild = strpbrk(pattern, "*?[\\");
+   if (!wild)
+     rule->type = EDI_WALKER_RULE_LITERAL;
+   else if (!rule->anchored && wild == pattern && pattern[1] &&
+            !strpbrk(pattern + 1, "*?[\\"))
+     rule->type = EDI_WALKER_RULE_SUFFIX;
+   else
+     rule->type = EDI_WALKER_RULE_GLOB;
+
+   if (rule->type == EDI_WALKER_RULE_SUFFIX)
+     {
+        memmove(pattern, pattern + 1, length);
+        length--;
+     }
+
+   rule->pattern = pattern;
+   rule->length = length;
+   rules->count++;
+}
+
+static Edi_Walker_Rules *
+_edi_walker_rules_load(Edi_Walker_Rules *rules, const char *path)
+{
+   Eina_File *f;
+   const char *map, *line, *end, *eol;
+
+   f = eina_file_open(path, EINA_FALSE);
+   if (!f)
+     return rules;
+
+   map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+   if (!map)
+     {
+        eina_file_close(f);
+        return rules;
+     }
+
+   if (!rules)
+     rules = calloc(1, sizeof(Edi_Walker_Rules));
+
+   line = map;
+   end = map + eina_file_size_get(f);
+   while (line < end)
+     {
+        eol = memchr(line, '\n', end - line);
+        if (!eol)
+          eol = end;
+
+        _edi_walker_rule_add(rules, line, (eol > line && eol[-1] == '\r') ? eol - line - 1 : eol - line);
+        line = eol + 1;
+     }
+
+   eina_file_map_free(f, (void *) map);
+   eina_file_close(f);
+
+   return rules;
+}
+
+static void
+_edi_walker_rules_free(Edi_Walker_Rules *rules)
+{
+   unsigned int i;
+
+   if (!rules)
+     return;
+
+   for (i = 0; i < rules->count; i++)
+     free(rules->rules[i].pattern);
+   free(rules->rules);
+   free(rules);
+}
+
+static void
+_edi_walker_rules_hash_free(void *data)
+{
+   _edi_walker_rules_free(data);
+}
+
+/* Find the global excludes file as git would, from core.excludesFile or the XDG default. */
+static char *
+_edi_walker_global_excludes_path(void)
+{
+   const char *home, *config;
+   char *gitconfig, *path = NULL;
+   char line[PATH_MAX], *key, *value, *end;
+   FILE *f;
+
+   home = eina_environment_home_get();
+   if (!home)
+     return NULL;
+
+   gitconfig = edi_path_append(home, ".gitconfig");
+   f = fopen(gitconfig, "r");
+   free(gitconfig);
+   if (f)
+     {
+        while (!path && fgets(line, sizeof(line), f))
+          {
+             key = line + strspn(line, " \t");
+             if (strncasecmp(key, "excludesfile", 12))
+               continue;
+
+             value = strchr(key + 12, '=');
+             if (!value)
+               continue;
+             value += 1 + strspn(value + 1, " \t\"");
+             end = value + strcspn(value, "\"\r\n");
+             while (end > value && (end[-1] == ' ' || end[-1] == '\t'))
+               end--;
+             *end = '\0';
+
+             if (!strncmp(value, "~/", 2))
+               path = edi_path_append(home, value + 2);
+             else if (value[0])
+               path = strdup(value);
+          }
+        fclose(f);
+     }
+
+   if (path)
+     return path;
+
+   config = getenv("XDG_CONFIG_HOME");
+   if (config && config[0])
+     return edi_path_append(config, "git/ignore");
+
+   return edi_path_append(home, ".config/git/ignore");
+}
+
+static void
+_edi_walker_excludes_load(Edi_Walker *walker)
+{
+   char *path;
+
+   path = _edi_walker_global_excludes_path();
+   if (path)
+     {
+        walker->excludes = _edi_walker_rules_load(walker->excludes, path);
+        free(path);
+     }
+
+   path = edi_path_append(walker->root, ".git/info/exclude");
+   walker->excludes = _edi_walker_rules_load(walker->excludes, path);
+   free(path);
+}
+
+static Edi_Walker_Rules *
+_edi_walker_rules_get(Edi_Walker *walker, const char *directory)
+{
+   Edi_Walker_Rules *rules;
+   char *path;
+
+   rules = eina_hash_find(walker->rules, directory);
+   if (rules)
+     return rules;
+
+   path = edi_path_append(directory, ".gitignore");
+   rules = _edi_walker_rules_load(NULL, path);
+   free(path);
+
+   /* Cache directories without rules too so we only look once. */
+   if (!rules)
+     rules = calloc(1, sizeof(Edi_Walker_Rules));
+   eina_hash_add(walker->rules, directory, rules);
+
+   return rules;
+}
+
+static void
+_edi_walker_rules_apply(Edi_Walker_Rules *rules, const char *relative, const char *name,
+                        Eina_Bool directory, Eina_Bool *ignored)
+{
+   Edi_Walker_Rule *rule;
+   const char *target;
+   unsigned int i, length;
+   Eina_Bool match;
+
+   if (!rules)
+     return;
+
+   for (i = 0; i < rules->count; i++)
+     {
+        rule = &rules->rules[i];
+        if (rule->directory && !directory)
+          continue;
+        /* Skip rules that cannot change the outcome. */
+        if (rule->negate == !*ignored)
+          continue;
+
+        target = rule->anchored ? relative : name;
+        switch (rule->type)
+          {
+           case EDI_WALKER_RULE_LITERAL:
+             match = !strcmp(rule->pattern, target);
+             break;
+           case EDI_WALKER_RULE_SUFFIX:
+             length = strlen(target);
+             match = length >= rule->length &&
+               !memcmp(target + length - rule->length, rule->pattern, rule->length);
+             break;
+           default:
+             match = _edi_walker_glob_match(rule->pattern, rule->pattern, target);
+          }
+
+        if (match)
+          *ignored = !rule->negate;
+     }
+}
+
+/* Decide on one path, assuming the directories containing it are not ignored. */
+static Eina_Bool
+_edi_walker_entry_ignored(Edi_Walker *walker, const char *path, Eina_Bool directory)
+{
+   const char *name, *slash;
+   char *parent;
+   Eina_Bool ignored = EINA_FALSE;
+
+   name = ecore_file_file_get(path);
+   if (name[0] == '.')
+     return EINA_TRUE;
+
+   if (walker->provider && walker->provider->file_hidden_is(path))
+     return EINA_TRUE;
+
+   if (strncmp(path, walker->root, walker->root_length) || path[walker->root_length] != '/')
+     return EINA_FALSE;
+
+   _edi_walker_rules_apply(walker->excludes, path + walker->root_length + 1, name,
+                           directory, &ignored);
+
+   /* Each .gitignore from the root down overrides the ones above it. */
+   parent = strdup(path);
+   slash = path + walker->root_length;
+   while (slash)
+     {
+        parent[slash - path] = '\0';
+        _edi_walker_rules_apply(_edi_walker_rules_get(walker, parent), slash + 1, name,
+                                directory, &ignored);
+        parent[slash - path] = '/';
+
+        slash = strchr(slash + 1, '/');
+     }
+   free(parent);
+
+   return ignored;
+}
+
+static Eina_Bool
+_edi_walker_directory_ignored(Edi_Walker *walker, const char *path)
+{
+   void *decision;
+   Eina_Bool ignored;
+
+   decision = eina_hash_find(walker->decisions, path);
+   if (decision)
+     return decision == EDI_WALKER_DECISION_IGNORE;
+
+   ignored = _edi_walker_entry_ignored(walker, path, EINA_TRUE);
+   eina_hash_add(walker->decisions, path,
+                 ignored ? EDI_WALKER_DECISION_IGNORE : EDI_WALKER_DECISION_KEEP);
+
+   return ignored;
+}
+
+EAPI Edi_Walker *
+edi_walker_new(const char *directory)
+{
+   Edi_Walker *walker;
+
+   walker = calloc(1, sizeof(Edi_Walker));
+   walker->root = strdup(directory);
+   walker->root_length = strlen(walker->root);
+   while (walker->root_length > 1 && walker->root[walker->root_length - 1] == '/')
+     walker->root[--walker->root_length] = '\0';
+   walker->provider = edi_build_provider_for_project_path_get(walker->root);
+
+   walker->rules = eina_hash_string_superfast_new(_edi_walker_rules_hash_free);
+   walker->decisions = eina_hash_string_superfast_new(NULL);
+   eina_lock_new(&walker->lock);
+
+   _edi_walker_excludes_load(walker);
+
+   return walker;
+}
+
+EAPI void
+edi_walker_free(Edi_Walker *walker)
+{
+   if (!walker)
+     return;
+
+   eina_hash_free(walker->rules);
+   eina_hash_free(walker->decisions);
+   _edi_walker_rules_free(walker->excludes);
+   eina_lock_free(&walker->lock);
+   free(walker->root);
+   free(walker);
+}
+
+EAPI void
+edi_walker_reset(Edi_Walker *walker)
+{
+   eina_lock_take(&walker->lock);
+
+   eina_hash_free_buckets(walker->rules);
+   eina_hash_free_buckets(walker->decisions);
+   _edi_walker_rules_free(walker->excludes);
+   walker->excludes = NULL;
+   _edi_walker_excludes_load(walker);
+
+   eina_lock_release(&walker->lock);
+}
+
+EAPI Eina_Bool
+edi_walker_path_ignored(Edi_Walker *walker, const char *path, Eina_Bool directory)
+{
+   char *copy, *slash;
+   Eina_Bool ignored = EINA_FALSE;
+
+   if (strncmp(path, walker->root, walker->root_length) || path[walker->root_length] != '/')
+     return EINA_FALSE;
+
+   eina_lock_take(&walker->lock);
+
+   copy = strdup(path);
+   slash = strchr(copy + walker->root_length + 1, '/');
+   while (!ignored && slash)
+     {
+        *slash = '\0';
+        ignored = _edi_walker_directory_ignored(walker, copy);
+        *slash = '/';
+
+        slash = strchr(slash + 1, '/');
+     }
+   free(copy);
+
+   if (!ignored)
+     {
+        if (directory)
+          ignored = _edi_walker_directory_ignored(walker, path);
+        else
+          ignored = _edi_walker_entry_ignored(walker, path, EINA_FALSE);
+     }
+
+   eina_lock_release(&walker->lock);
+
+   return ignored;
+}
+
+static Eina_Bool
+_edi_walker_walk(Edi_Walker *walker, const char *directory, Edi_Walker_Cb cb, void *data)
+{
+   Eina_List *files;
+   char *file, *path;
+   Eina_Bool directory_is, ignored, running = EINA_TRUE;
+
+   files = ecore_file_ls(directory);
+
+   EINA_LIST_FREE(files, file)
+     {
+        if (!running)
+          {
+             free(file);
+             continue;
+          }
+
+        path = edi_path_append(directory, file);
+        free(file);
+
+        directory_is = ecore_file_is_dir(path);
+
+        eina_lock_take(&walker->lock);
+        if (directory_is)
+          ignored = _edi_walker_directory_ignored(walker, path);
+        else
+          ignored = _edi_walker_entry_ignored(walker, path, EINA_FALSE);
+        eina_lock_release(&walker->lock);
+
+        if (!ignored)
+          {
+             running = cb(data, path, directory_is);
+             if (running && directory_is)
+               running = _edi_walker_walk(walker, path, cb, data);
+          }
+
+        free(path);
+     }
+
+   return running;
+}
+
+EAPI Eina_Bool
+edi_walker_walk(Edi_Walker *walker, const char *directory, Edi_Walker_Cb cb, void *data)
+{
+   if (edi_walker_path_ignored(walker, directory, EINA_TRUE))
+     return EINA_TRUE;
+
+   return _edi_walker_walk(walker, directory, cb, data);
+}
+
+EAPI Eina_Bool
+edi_walker_binary_is(const char *data, size_t length)
+{
+   if (length > EDI_WALKER_SNIFF_SIZE)
+     length = EDI_WALKER_SNIFF_SIZE;
+
+   return memchr(data, '\0', length) != NULL;
+}
+
+EAPI Eina_Bool
+edi_walker_file_binary_is(const char *path)
+{
+   char buf[EDI_WALKER_SNIFF_SIZE];
+   size_t length;
+   FILE *f;
+
+   f = fopen(path, "rb");
+   if (!f)
+     return EINA_FALSE;
+
+   length = fread(buf, 1, sizeof(buf), f);
+   fclose(f);
+
+   return edi_walker_binary_is(buf, length);
+}
@@ -0,0 +1,136 @@
+#ifndef EDI_WALKER_H_
+# define EDI_WALKER_H_
+
+#include <Eina.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * @brief These routines are used for walking the files of an Edi project.
+ */
+
+/**
+ * @typedef Edi_Walker
+ * A project walker holding the compiled ignore rules and cached decisions
+ * for a project directory. A walker can be shared between threads.
+ */
+typedef struct _Edi_Walker Edi_Walker;
+
+/**
+ * @typedef Edi_Walker_Cb
+ * Function called for each path visited by a walk.
+ * Directories are reported before their contents are walked.
+ *
+ * @param data The user data passed to the walk.
+ * @param path The full path of the file or directory found.
+ * @param directory EINA_TRUE if the path is a directory.
+ * @return EINA_FALSE to stop the walk.
+ */
+typedef Eina_Bool (*Edi_Walker_Cb)(void *data, const char *path, Eina_Bool directory);
+
+/**
+ * @brief Project walker functions.
+ * @defgroup Walker
+ *
+ * @{
+ *
+ * Walking the files of a project while skipping those that are not wanted.
+ * Hidden files, files hidden by the build provider and any path excluded
+ * by a .gitignore, .git/info/exclude or the user's global git excludes
+ * are never visited. The rules for each directory are compiled once and
+ * the decision for each directory is cached.
+ *
+ */
+
+/**
+ * Create a walker for a project.
+ *
+ * @param directory The root directory of the project.
+ *
+ * @return A new walker that must be freed with edi_walker_free().
+ *
+ * @ingroup Walker
+ */
+EAPI Edi_Walker *edi_walker_new(const char *directory);
+
+/**
+ * Free a walker and its cached rules.
+ *
+ * @param walker The walker to free.
+ *
+ * @ingroup Walker
+ */
+EAPI void edi_walker_free(Edi_Walker *walker);
+
+/**
+ * Forget all cached rules and decisions, for example after an ignore file changes.
+ *
+ * @param walker The walker to reset.
+ *
+ * @ingroup Walker
+ */
+EAPI void edi_walker_reset(Edi_Walker *walker);
+
+/**
+ * Walk a directory within the project, reporting every path that is not ignored.
+ *
+ * @param walker The walker for the project.
+ * @param directory The directory to walk, the project root or a directory below it.
+ * @param cb The function to call for each path found.
+ * @param data User data passed to the callback.
+ *
+ * @return EINA_FALSE if the callback stopped the walk.
+ *
+ * @ingroup Walker
+ */
+EAPI Eina_Bool edi_walker_walk(Edi_Walker *walker, const char *directory, Edi_Walker_Cb cb, void *data);
+
+/**
+ * Find if a path within the project is ignored, either itself or because
+ * one of the directories containing it is ignored.
+ *
+ * @param walker The walker for the project.
+ * @param path The full path to check.
+ * @param directory EINA_TRUE if the path is a directory.
+ *
+ * @return Whether or not the path would be skipped by a walk.
+ *
+ * @ingroup Walker
+ */
+EAPI Eina_Bool edi_walker_path_ignored(Edi_Walker *walker, const char *path, Eina_Bool directory);
+
+/**
+ * Find if some file content looks binary, that is there is a NUL byte in the first block.
+ *
+ * @param data The start of the file content.
+ * @param length The length of the content available.
+ *
+ * @return Whether or not the content should be treated as binary.
+ *
+ * @ingroup Walker
+ */
+EAPI Eina_Bool edi_walker_binary_is(const char *data, size_t length);
+
+/**
+ * Find if a file looks binary by reading its first block.
+ *
+ * @param path The path of the file to check.
+ *
+ * @return Whether or not the file should be treated as binary.
+ *
+ * @ingroup Walker
+ */
+EAPI Eina_Bool edi_walker_file_binary_is(const char *path);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDI_WALKER_H_ */
@@ -21,7 +21,10 @@ static const struct {
   { "exe", edi_test_exe },
   { "content_provider", edi_test_content_provider },
   { "language_provider", edi_test_language_provider },
-  { "language_provider_c", edi_test_language_provider_c }
+  { "language_provider_c", edi_test_language_provider_c },
+  { "language_suggest", edi_test_language_suggest },
+  { "walker", edi_test_walker },
+  { "search", edi_test_search }
 };
 
 START_TEST(edi_initialization)
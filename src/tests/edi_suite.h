@@ -13,5 +13,8 @@ void edi_test_exe(TCase *tc);
 void edi_test_content_provider(TCase *tc);
 void edi_test_language_provider(TCase *tc);
 void edi_test_language_provider_c(TCase *tc);
+void edi_test_language_suggest(TCase *tc);
+void edi_test_walker(TCase *tc);
+void edi_test_search(TCase *tc);
 
 #endif /* _EDI_SUITE_H */
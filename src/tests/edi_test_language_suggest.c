@@ -0,0 +1,131 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <Eina.h>
+
+#include "language/edi_language_suggest.h"
+
+#include "edi_suite.h"
+
+static Edi_Language_Suggest_Index *
+_edi_test_language_suggest_index_new(void)
+{
+   const char *summaries[] = { "show_all", "evas_object_show", "Evas", "elm_win_add", "evas_object_hide" };
+   Edi_Language_Suggest_Item *item;
+   Eina_List *items = NULL;
+   unsigned int i;
+
+   for (i = 0; i < sizeof(summaries) / sizeof(summaries[0]); i++)
+     {
+        item = calloc(1, sizeof(Edi_Language_Suggest_Item));
+        item->summary = strdup(summaries[i]);
+        items = eina_list_append(items, item);
+     }
+
+   return edi_language_suggest_index_new(items);
+}
+
+static const char *
+_edi_test_language_suggest_match_get(const Edi_Language_Suggest_Index *index, unsigned int n)
+{
+   Edi_Language_Suggest_Item *item;
+
+   item = edi_language_suggest_index_match_get(index, n);
+   ck_assert(item);
+   if (!item)
+     return NULL;
+
+   return item->summary;
+}
+
+START_TEST (edi_test_language_suggest_match)
+{
+   Edi_Language_Suggest_Index *index;
+
+   index = _edi_test_language_suggest_index_new();
+
+   ck_assert_int_eq(edi_language_suggest_index_match(index, ""), 5);
+
+   ck_assert_int_eq(edi_language_suggest_index_match(index, "evobs"), 1);
+   ck_assert_str_eq(_edi_test_language_suggest_match_get(index, 0), "evas_object_show");
+   ck_assert(!edi_language_suggest_index_match_get(index, 1));
+
+   // Matches do not have to share the first letter of the word
+   ck_assert_int_eq(edi_language_suggest_index_match(index, "show"), 2);
+   ck_assert_str_eq(_edi_test_language_suggest_match_get(index, 0), "show_all");
+   ck_assert_str_eq(_edi_test_language_suggest_match_get(index, 1), "evas_object_show");
+
+   ck_assert_int_eq(edi_language_suggest_index_match(index, "xyz"), 0);
+   ck_assert(!edi_language_suggest_index_match_get(index, 0));
+
+   edi_language_suggest_index_free(index);
+}
+END_TEST
+
+START_TEST (edi_test_language_suggest_rank)
+{
+   Edi_Language_Suggest_Index *index;
+
+   index = _edi_test_language_suggest_index_new();
+
+   // Exact prefixes come before caseless ones, equal scores keep sorted order
+   ck_assert_int_eq(edi_language_suggest_index_match(index, "ev"), 3);
+   ck_assert_str_eq(_edi_test_language_suggest_match_get(index, 0), "evas_object_hide");
+   ck_assert_str_eq(_edi_test_language_suggest_match_get(index, 1), "evas_object_show");
+   ck_assert_str_eq(_edi_test_language_suggest_match_get(index, 2), "Evas");
+
+   edi_language_suggest_index_free(index);
+}
+END_TEST
+
+START_TEST (edi_test_language_suggest_refine)
+{
+   Edi_Language_Suggest_Index *index;
+
+   index = _edi_test_language_suggest_index_new();
+
+   ck_assert_int_eq(edi_language_suggest_index_match(index, "e"), 4);
+   ck_assert_int_eq(edi_language_suggest_index_match(index, "eo"), 2);
+   ck_assert_int_eq(edi_language_suggest_index_match(index, "eoh"), 2);
+   ck_assert_int_eq(edi_language_suggest_index_match(index, "eohi"), 1);
+   ck_assert_str_eq(_edi_test_language_suggest_match_get(index, 0), "evas_object_hide");
+
+   // A shorter word searches everything again
+   ck_assert_int_eq(edi_language_suggest_index_match(index, "a"), 5);
+
+   edi_language_suggest_index_free(index);
+}
+END_TEST
+
+START_TEST (edi_test_language_suggest_prefix)
+{
+   Edi_Language_Suggest_Index *index;
+   Edi_Language_Suggest_Item *item;
+
+   index = _edi_test_language_suggest_index_new();
+
+   item = edi_language_suggest_index_prefix_find(index, "evas");
+   ck_assert(item);
+   ck_assert_str_eq(item->summary, "evas_object_hide");
+
+   item = edi_language_suggest_index_prefix_find(index, "evas_object_s");
+   ck_assert(item);
+   ck_assert_str_eq(item->summary, "evas_object_show");
+
+   // Only longer suggestions that match exactly complete a word
+   ck_assert(!edi_language_suggest_index_prefix_find(index, "Evas"));
+   ck_assert(!edi_language_suggest_index_prefix_find(index, "show_all"));
+   ck_assert(!edi_language_suggest_index_prefix_find(index, ""));
+
+   edi_language_suggest_index_free(index);
+}
+END_TEST
+
+void edi_test_language_suggest(TCase *tc)
+{
+   tcase_add_test(tc, edi_test_language_suggest_match);
+   tcase_add_test(tc, edi_test_language_suggest_rank);
+   tcase_add_test(tc, edi_test_language_suggest_refine);
+   tcase_add_test(tc, edi_test_language_suggest_prefix);
+}
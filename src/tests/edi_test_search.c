@@ -0,0 +1,357 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <unistd.h>
+
+#include <Ecore.h>
+#include <Ecore_File.h>
+#include <Eio.h>
+
+#include "search/edi_search_scanner.h"
+#include "search/edi_search_regex.h"
+#include "search/edi_search_multi.h"
+#include "search/edi_search_index.h"
+#include "search/edi_search_replace.h"
+
+#include "edi_suite.h"
+
+typedef struct _Edi_Test_Search_Hits
+{
+   unsigned int count;
+   unsigned int numbers[8];
+   unsigned int cols[8];
+} Edi_Test_Search_Hits;
+
+static Eina_Bool
+_edi_test_search_hit_cb(void *data, const char *line EINA_UNUSED, unsigned int length EINA_UNUSED,
+                        unsigned int number, unsigned int col)
+{
+   Edi_Test_Search_Hits *hits = data;
+
+   if (hits->count < 8)
+     {
+        hits->numbers[hits->count] = number;
+        hits->cols[hits->count] = col;
+     }
+   hits->count++;
+
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edi_test_search_regex_matches(const char *pattern, Edi_Search_Regex_Flags flags, const char *line,
+                               unsigned int *start)
+{
+   Edi_Search_Regex *regex;
+   Eina_Bool ret;
+
+   regex = edi_search_regex_new(pattern, flags);
+   ck_assert(regex);
+   if (!regex)
+     return EINA_FALSE;
+
+   ret = edi_search_regex_match(regex, line, strlen(line), start);
+   edi_search_regex_free(regex);
+
+   return ret;
+}
+
+START_TEST (edi_test_search_scanner_find)
+{
+   Edi_Search_Scanner *scanner;
+   const char *text = "a needle in a haystack, another needle";
+
+   ck_assert(!edi_search_scanner_new(""));
+
+   scanner = edi_search_scanner_new("needle");
+   ck_assert_ptr_eq(edi_search_scanner_find(scanner, text, strlen(text)), text + 2);
+   ck_assert(!edi_search_scanner_find(scanner, text, 7));
+   ck_assert(!edi_search_scanner_find(scanner, "Needle", 6));
+   edi_search_scanner_free(scanner);
+
+   scanner = edi_search_scanner_caseless_new("NEEDLE");
+   ck_assert_ptr_eq(edi_search_scanner_find(scanner, text, strlen(text)), text + 2);
+   edi_search_scanner_free(scanner);
+}
+END_TEST
+
+START_TEST (edi_test_search_scanner_scan)
+{
+   Edi_Search_Scanner *scanner;
+   Edi_Test_Search_Hits hits;
+   const char *text = "one\nfind me, find me\nnothing\n  find\n";
+
+   memset(&hits, 0, sizeof(hits));
+   scanner = edi_search_scanner_new("find");
+   ck_assert_int_eq(edi_search_scanner_scan(scanner, text, strlen(text), _edi_test_search_hit_cb, &hits), 2);
+   ck_assert_int_eq(hits.count, 2);
+   ck_assert_int_eq(hits.numbers[0], 2);
+   ck_assert_int_eq(hits.cols[0], 1);
+   ck_assert_int_eq(hits.numbers[1], 4);
+   ck_assert_int_eq(hits.cols[1], 3);
+   edi_search_scanner_free(scanner);
+
+   ck_assert_int_eq(edi_search_scanner_lines_count(text, strlen(text)), 4);
+}
+END_TEST
+
+START_TEST (edi_test_search_regex_syntax)
+{
+   unsigned int start;
+
+   ck_assert(_edi_test_search_regex_matches("fo+bar", 0, "xx foooobar", &start));
+   ck_assert_int_eq(start, 3);
+   ck_assert(!_edi_test_search_regex_matches("fo+bar", 0, "fbar", NULL));
+   ck_assert(_edi_test_search_regex_matches("colou?r", 0, "color", NULL));
+   ck_assert(_edi_test_search_regex_matches("(cat|dog)s", 0, "hot dogs", &start));
+   ck_assert_int_eq(start, 4);
+   ck_assert(_edi_test_search_regex_matches("a{2,3}b", 0, "caaab", NULL));
+   ck_assert(!_edi_test_search_regex_matches("^a{2,3}b", 0, "ab", NULL));
+   ck_assert(_edi_test_search_regex_matches("^int", 0, "int main", NULL));
+   ck_assert(!_edi_test_search_regex_matches("^int", 0, " int main", NULL));
+   ck_assert(_edi_test_search_regex_matches("main$", 0, "int main", NULL));
+   ck_assert(_edi_test_search_regex_matches("[a-c]x", 0, "zzbx", &start));
+   ck_assert_int_eq(start, 2);
+   ck_assert(!_edi_test_search_regex_matches("[^a-c]x", 0, "bx", NULL));
+   ck_assert(_edi_test_search_regex_matches("\\d+\\.\\d", 0, "v1.2", &start));
+   ck_assert_int_eq(start, 1);
+
+   ck_assert(!edi_search_regex_new("(unclosed", 0));
+   ck_assert(!edi_search_regex_new("[[:nope:]]", 0));
+}
+END_TEST
+
+START_TEST (edi_test_search_regex_classes)
+{
+   unsigned int start;
+
+   ck_assert(_edi_test_search_regex_matches("a[[:space:]]b", 0, "a b", NULL));
+   ck_assert(_edi_test_search_regex_matches("a[[:space:]]b", 0, "a\tb", NULL));
+   ck_assert(_edi_test_search_regex_matches("a[[:space:]]b", 0, "a\vb", NULL));
+   ck_assert(!_edi_test_search_regex_matches("a[[:space:]]b", 0, "a_b", NULL));
+   ck_assert(!_edi_test_search_regex_matches("[[:space:]]", 0, "abc!", NULL));
+   ck_assert(_edi_test_search_regex_matches("[[:blank:]]", 0, "x\ty", &start));
+   ck_assert_int_eq(start, 1);
+   ck_assert(_edi_test_search_regex_matches("[[:digit:]][[:alpha:]]", 0, "--7z", &start));
+   ck_assert_int_eq(start, 2);
+   ck_assert(_edi_test_search_regex_matches("[[:xdigit:]]+", 0, "0xBEEF", NULL));
+   ck_assert(_edi_test_search_regex_matches("[[:punct:]]", 0, "ab;", &start));
+   ck_assert_int_eq(start, 2);
+   ck_assert(!_edi_test_search_regex_matches("[[:upper:]]", 0, "lower", NULL));
+}
+END_TEST
+
+START_TEST (edi_test_search_regex_classes_multibyte)
+{
+   unsigned int start;
+
+   ck_assert(_edi_test_search_regex_matches("[\xc3\xa9]", 0, "caf\xc3\xa9", &start));
+   ck_assert_int_eq(start, 3);
+   ck_assert(!_edi_test_search_regex_matches("x[\xc3\xa9]y", 0, "x\xc3\xa8y", NULL));
+   ck_assert(_edi_test_search_regex_matches("^[^\xc3\xa9]$", 0, "\xc3\xa8", NULL));
+   ck_assert(!_edi_test_search_regex_matches("^[^\xc3\xa9]$", 0, "\xc3\xa9", NULL));
+
+   // α-ω
+   ck_assert(_edi_test_search_regex_matches("[\xce\xb1-\xcf\x89]+", 0, "ab \xce\xbb\xce\xbc", &start));
+   ck_assert_int_eq(start, 3);
+   ck_assert(!_edi_test_search_regex_matches("[\xce\xb1-\xcf\x89]", 0, "abc \xd1\x91", NULL));
+   ck_assert(!_edi_test_search_regex_matches("^[^\xce\xb1-\xcf\x89]$", 0, "\xce\xbb", NULL));
+   ck_assert(_edi_test_search_regex_matches("^[^\xce\xb1-\xcf\x89]$", 0, "\xf0\x9f\x98\x80", NULL));
+
+   // The negated escapes hold every multi byte character, as they do outside a class
+   ck_assert(_edi_test_search_regex_matches("[\\W]", 0, "abc\xc3\xa9", &start));
+   ck_assert_int_eq(start, 3);
+   ck_assert(_edi_test_search_regex_matches("^[\\S]$", 0, "\xc3\xbc", NULL));
+   ck_assert(!_edi_test_search_regex_matches("[^\\W]", 0, "\xc3\xa9-\xc3\xa9", NULL));
+
+   ck_assert(!edi_search_regex_new("[\xc3]", 0));
+   ck_assert(!edi_search_regex_new("[\xcf\x89-\xce\xb1]", 0));
+}
+END_TEST
+
+START_TEST (edi_test_search_regex_flags)
+{
+   unsigned int start;
+
+   ck_assert(_edi_test_search_regex_matches("a.c", EDI_SEARCH_REGEX_LITERAL, "xa.c", &start));
+   ck_assert_int_eq(start, 1);
+   ck_assert(!_edi_test_search_regex_matches("a.c", EDI_SEARCH_REGEX_LITERAL, "abc", NULL));
+   ck_assert(_edi_test_search_regex_matches("hello", EDI_SEARCH_REGEX_CASELESS, "Say HeLLo", NULL));
+   ck_assert(!_edi_test_search_regex_matches("hello", 0, "Say HeLLo", NULL));
+   ck_assert(_edi_test_search_regex_matches("cat", EDI_SEARCH_REGEX_WORD, "a cat.", NULL));
+   ck_assert(!_edi_test_search_regex_matches("cat", EDI_SEARCH_REGEX_WORD, "concatenate", NULL));
+   ck_assert(_edi_test_search_regex_matches("\\bcat\\b", 0, "(cat)", NULL));
+   ck_assert(!_edi_test_search_regex_matches("\\bcat\\b", 0, "cats", NULL));
+}
+END_TEST
+
+START_TEST (edi_test_search_regex_scan)
+{
+   Edi_Search_Regex *regex;
+   Edi_Test_Search_Hits hits;
+   const char *text = "int a;\nchar *name_get(void);\nint b;\nstatic int name_set(int v);\n";
+
+   memset(&hits, 0, sizeof(hits));
+   regex = edi_search_regex_new("name_(get|set)\\(", 0);
+   ck_assert_str_eq(edi_search_regex_literal_get(regex), "name_");
+   ck_assert_int_eq(edi_search_regex_scan(regex, text, strlen(text), _edi_test_search_hit_cb, &hits), 2);
+   ck_assert_int_eq(hits.numbers[0], 2);
+   ck_assert_int_eq(hits.cols[0], 7);
+   ck_assert_int_eq(hits.numbers[1], 4);
+   ck_assert_int_eq(hits.cols[1], 12);
+   edi_search_regex_free(regex);
+}
+END_TEST
+
+START_TEST (edi_test_search_multi_scan)
+{
+   Edi_Search_Multi *multi;
+   Edi_Test_Search_Hits hits;
+   Eina_List *terms = NULL;
+   const char *text = "alpha\nbeta gamma\ndelta\ngamma beta\n";
+
+   ck_assert(!edi_search_multi_new(NULL));
+
+   terms = eina_list_append(terms, "gamma");
+   terms = eina_list_append(terms, "");
+   terms = eina_list_append(terms, "alpha");
+   multi = edi_search_multi_new(terms);
+   eina_list_free(terms);
+
+   memset(&hits, 0, sizeof(hits));
+   ck_assert_int_eq(edi_search_multi_scan(multi, text, strlen(text), _edi_test_search_hit_cb, &hits), 3);
+   ck_assert_int_eq(hits.numbers[0], 1);
+   ck_assert_int_eq(hits.cols[0], 1);
+   ck_assert_int_eq(hits.numbers[1], 2);
+   ck_assert_int_eq(hits.cols[1], 6);
+   ck_assert_int_eq(hits.numbers[2], 4);
+   ck_assert_int_eq(hits.cols[2], 1);
+   edi_search_multi_free(multi);
+}
+END_TEST
+
+static const char *_edi_test_search_config_dir = NULL;
+
+/* The index keeps its cache with the project config, use a scratch directory instead */
+const char *
+_edi_project_config_dir_get(void)
+{
+   return _edi_test_search_config_dir;
+}
+
+static void
+_edi_test_search_file_write(const char *dir, const char *name, const char *content)
+{
+   char path[PATH_MAX];
+   FILE *f;
+
+   snprintf(path, sizeof(path), "%s/%s", dir, name);
+   f = fopen(path, "w");
+   ck_assert(f);
+   fputs(content, f);
+   fclose(f);
+}
+
+static Eina_List *
+_edi_test_search_index_candidates_wait(const char *term)
+{
+   Eina_List *files = NULL;
+   double end;
+
+   end = ecore_time_get() + 10.0;
+   while (!edi_search_index_candidates_get(term, &files) && ecore_time_get() < end)
+     {
+        ecore_main_loop_iterate();
+        usleep(10000);
+     }
+
+   return files;
+}
+
+START_TEST (edi_test_search_index_candidates)
+{
+   Eina_List *files;
+   char dir[PATH_MAX], config[PATH_MAX];
+   char *file;
+
+   ecore_init();
+   ecore_file_init();
+   eio_init();
+
+   snprintf(dir, sizeof(dir), "%s/edi_test_search_XXXXXX", eina_environment_tmp_get());
+   ck_assert(mkdtemp(dir));
+   snprintf(config, sizeof(config), "%s/edi_test_search_config_XXXXXX", eina_environment_tmp_get());
+   ck_assert(mkdtemp(config));
+   _edi_test_search_config_dir = config;
+   _edi_test_search_file_write(dir, "one.c", "int needle_function(void);\n");
+   _edi_test_search_file_write(dir, "two.c", "int haystack;\n");
+
+   edi_search_index_init(dir);
+
+   files = _edi_test_search_index_candidates_wait("needle");
+   ck_assert_int_eq(eina_list_count(files), 1);
+   ck_assert_str_eq(ecore_file_file_get(eina_list_data_get(files)), "one.c");
+   EINA_LIST_FREE(files, file)
+     free(file);
+
+   // Trigrams are case folded, so caseless searches are narrowed too
+   ck_assert(edi_search_index_candidates_get("HAYSTACK", &files));
+   ck_assert_int_eq(eina_list_count(files), 1);
+   EINA_LIST_FREE(files, file)
+     free(file);
+
+   ck_assert(edi_search_index_candidates_get("missing", &files));
+   ck_assert(!files);
+
+   // Too short to narrow the search
+   ck_assert(!edi_search_index_candidates_get("ne", &files));
+
+   edi_search_index_shutdown();
+   ecore_file_recursive_rm(dir);
+   ecore_file_recursive_rm(config);
+   _edi_test_search_config_dir = NULL;
+
+   eio_shutdown();
+   ecore_file_shutdown();
+   ecore_shutdown();
+}
+END_TEST
+
+START_TEST (edi_test_search_replace_line_diff)
+{
+   size_t prefix, suffix;
+
+   edi_search_replace_line_diff("int old;", 8, "int new;", 8, &prefix, &suffix);
+   ck_assert_int_eq(prefix, 4);
+   ck_assert_int_eq(suffix, 1);
+
+   // "é" and "è" share a lead byte, which must not be split from the rest of the character
+   edi_search_replace_line_diff("h\xc3\xa9llo", 6, "h\xc3\xa8llo", 6, &prefix, &suffix);
+   ck_assert_int_eq(prefix, 1);
+   ck_assert_int_eq(suffix, 3);
+
+   // "©" and "é" share a continuation byte instead
+   edi_search_replace_line_diff("a\xc2\xa9" "b", 4, "a\xc3\xa9" "b", 4, &prefix, &suffix);
+   ck_assert_int_eq(prefix, 1);
+   ck_assert_int_eq(suffix, 1);
+
+   edi_search_replace_line_diff("same", 4, "same", 4, &prefix, &suffix);
+   ck_assert_int_eq(prefix, 4);
+   ck_assert_int_eq(suffix, 0);
+}
+END_TEST
+
+void edi_test_search(TCase *tc)
+{
+   tcase_add_test(tc, edi_test_search_scanner_find);
+   tcase_add_test(tc, edi_test_search_scanner_scan);
+   tcase_add_test(tc, edi_test_search_regex_syntax);
+   tcase_add_test(tc, edi_test_search_regex_classes);
+   tcase_add_test(tc, edi_test_search_regex_classes_multibyte);
+   tcase_add_test(tc, edi_test_search_regex_flags);
+   tcase_add_test(tc, edi_test_search_regex_scan);
+   tcase_add_test(tc, edi_test_search_multi_scan);
+   tcase_add_test(tc, edi_test_search_index_candidates);
+   tcase_add_test(tc, edi_test_search_replace_line_diff);
+}
@@ -0,0 +1,129 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <Ecore_File.h>
+
+#include "edi_suite.h"
+
+static void
+_edi_test_walker_file_write(const char *root, const char *file, const char *content)
+{
+   char *path;
+   FILE *f;
+
+   path = edi_path_append(root, file);
+   f = fopen(path, "w");
+   ck_assert(f != NULL);
+   fputs(content, f);
+   fclose(f);
+   free(path);
+}
+
+static char *
+_edi_test_walker_project_create(void)
+{
+   char *root, *path;
+
+   root = edi_path_append(eina_environment_tmp_get(), "edi_test_walker");
+   ecore_file_recursive_rm(root);
+
+   path = edi_path_append(root, "src/generated");
+   ck_assert(ecore_file_mkpath(path));
+   free(path);
+   path = edi_path_append(root, "build");
+   ck_assert(ecore_file_mkpath(path));
+   free(path);
+
+   _edi_test_walker_file_write(root, ".gitignore", "*.o\n/build/\n*.log\n!keep.log\n");
+   _edi_test_walker_file_write(root, "src/.gitignore", "generated/\n");
+   _edi_test_walker_file_write(root, "main.c", "int main;\n");
+   _edi_test_walker_file_write(root, "main.o", "object\n");
+   _edi_test_walker_file_write(root, "debug.log", "log\n");
+   _edi_test_walker_file_write(root, "keep.log", "log\n");
+   _edi_test_walker_file_write(root, "build/out.c", "int out;\n");
+   _edi_test_walker_file_write(root, "src/util.c", "int util;\n");
+   _edi_test_walker_file_write(root, "src/generated/gen.c", "int gen;\n");
+
+   return root;
+}
+
+static Eina_Bool
+_edi_test_walker_count_cb(void *data, const char *path EINA_UNUSED, Eina_Bool directory)
+{
+   int *count = data;
+
+   if (!directory)
+     (*count)++;
+
+   return EINA_TRUE;
+}
+
+START_TEST (edi_test_walker_ignored)
+{
+   Edi_Walker *walker;
+   char *root, *path;
+
+   edi_init();
+   root = _edi_test_walker_project_create();
+   walker = edi_walker_new(root);
+
+   path = edi_path_append(root, "main.c");
+   ck_assert(!edi_walker_path_ignored(walker, path, EINA_FALSE));
+   free(path);
+   path = edi_path_append(root, "main.o");
+   ck_assert(edi_walker_path_ignored(walker, path, EINA_FALSE));
+   free(path);
+   path = edi_path_append(root, "keep.log");
+   ck_assert(!edi_walker_path_ignored(walker, path, EINA_FALSE));
+   free(path);
+   path = edi_path_append(root, "build/out.c");
+   ck_assert(edi_walker_path_ignored(walker, path, EINA_FALSE));
+   free(path);
+   path = edi_path_append(root, "src/generated/gen.c");
+   ck_assert(edi_walker_path_ignored(walker, path, EINA_FALSE));
+   free(path);
+   path = edi_path_append(root, ".gitignore");
+   ck_assert(edi_walker_path_ignored(walker, path, EINA_FALSE));
+   free(path);
+
+   edi_walker_free(walker);
+   ecore_file_recursive_rm(root);
+   free(root);
+   edi_shutdown();
+}
+END_TEST
+
+START_TEST (edi_test_walker_walk)
+{
+   Edi_Walker *walker;
+   char *root;
+   int count = 0;
+
+   edi_init();
+   root = _edi_test_walker_project_create();
+   walker = edi_walker_new(root);
+
+   ck_assert(edi_walker_walk(walker, root, _edi_test_walker_count_cb, &count));
+   ck_assert_int_eq(count, 3);
+
+   edi_walker_free(walker);
+   ecore_file_recursive_rm(root);
+   free(root);
+   edi_shutdown();
+}
+END_TEST
+
+START_TEST (edi_test_walker_binary)
+{
+   ck_assert(!edi_walker_binary_is("int main;\n", 10));
+   ck_assert(edi_walker_binary_is("\177ELF\0\0", 6));
+}
+END_TEST
+
+void edi_test_walker(TCase *tc)
+{
+   tcase_add_test(tc, edi_test_walker_ignored);
+   tcase_add_test(tc, edi_test_walker_walk);
+   tcase_add_test(tc, edi_test_walker_binary);
+}